@@ -0,0 +1,27 @@
+/**
+ * @file bloom_combine.frag
+ * @authors quak
+ * @brief Second pass of the multi-pass bloom demo. Adds the glow made by
+ * bloom_extract.frag to the darkened output image.
+ */
+
+#version 430 core
+out vec4 f_color;
+
+in vec2 uv;
+
+// Glow from the previous pass
+uniform sampler2D u_texture;
+// Output image before post-processing
+uniform sampler2D u_source;
+
+// Strength of the bloom effect
+const float bloom_strength = 0.85f;
+// How much to "dull" colors that don't cross the bloom threshold
+const float dulling = 0.5f;
+
+void main() {
+  vec4 glow = texture(u_texture, uv);
+  vec4 base = texture(u_source, uv);
+  f_color = vec4(dulling * base.rgb + bloom_strength * glow.rgb, 1.0f);
+}
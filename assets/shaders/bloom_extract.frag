@@ -0,0 +1,55 @@
+/**
+ * @file bloom_extract.frag
+ * @authors quak
+ * @brief First pass of the multi-pass bloom demo. Keeps colors that pass the
+ * brightness threshold and blurs them. Meant to run at a reduced scale, which
+ * also widens the blur for free.
+ */
+
+#version 430 core
+out vec4 f_color;
+
+in vec2 uv;
+
+uniform sampler2D u_texture;
+uniform vec2 u_texel_size;
+
+// Offsets of adjacent texels, scaled by u_texel_size
+const vec2 kernel_offsets[9] = {
+    vec2(-1.0f, 1.0f),   // top left
+    vec2(0.0f, 1.0f),    // top center
+    vec2(1.0f, 1.0f),    // top right
+    vec2(-1.0f, 0.0f),   // center left
+    vec2(0.0f, 0.0f),    // center center
+    vec2(1.0f, 0.0f),    // center right
+    vec2(-1.0f, -1.0f),  // bottom left
+    vec2(0.0f, -1.0f),   // bottom center
+    vec2(1.0f, -1.0f),   // bottom right
+};
+
+// How bright a pixel needs to be to glow
+const float threshold = 0.65f;
+
+/**
+ * @brief Returns the given color if it is above the brightness threshold,
+ * otherwise returns black.
+ */
+vec3 clamp_brightness(vec3 color) {
+  float brightness = (color.r + color.g + color.b) / 3.0f;
+  return step(threshold, brightness) * color;
+}
+
+void main() {
+  // Gaussian blur kernel
+  float gaussian[9] = {
+      1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,  //
+      2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,  //
+      1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f,  //
+  };
+  vec3 gaussian_result = vec3(0.0f);
+  for (int i = 0; i < 9; ++i) {
+    vec4 color = texture(u_texture, uv + kernel_offsets[i] * u_texel_size);
+    gaussian_result += clamp_brightness(vec3(color)) * gaussian[i];
+  }
+  f_color = vec4(gaussian_result, 1.0f);
+}
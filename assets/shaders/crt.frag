@@ -11,19 +11,20 @@ out vec4 f_color;
 in vec2 uv;
 
 uniform sampler2D u_texture;
+uniform vec2 u_texel_size;
 uniform float u_time;
 
-const float kernel_step = 1.0f / 320.0f;
+// Offsets of adjacent texels, scaled by u_texel_size
 const vec2 kernel_offsets[9] = {
-    vec2(-kernel_step, kernel_step),   // top left
-    vec2(0.0f, kernel_step),           // top center
-    vec2(kernel_step, kernel_step),    // top right
-    vec2(-kernel_step, 0.0f),          // center left
-    vec2(0.0f, 0.0f),                  // center center
-    vec2(kernel_step, 0.0f),           // center right
-    vec2(-kernel_step, -kernel_step),  // bottom left
-    vec2(0.0f, -kernel_step),          // bottom center
-    vec2(kernel_step, -kernel_step),   // bottom right
+    vec2(-1.0f, 1.0f),   // top left
+    vec2(0.0f, 1.0f),    // top center
+    vec2(1.0f, 1.0f),    // top right
+    vec2(-1.0f, 0.0f),   // center left
+    vec2(0.0f, 0.0f),    // center center
+    vec2(1.0f, 0.0f),    // center right
+    vec2(-1.0f, -1.0f),  // bottom left
+    vec2(0.0f, -1.0f),   // bottom center
+    vec2(1.0f, -1.0f),   // bottom right
 };
 
 const float scan_scroll_rate = 2.5f;
@@ -34,7 +35,7 @@ void kernels() {
   // Sample adjacent colors
   vec3 adjacent[9];
   for (int i = 0; i < 9; ++i) {
-    vec4 color = texture(u_texture, uv + kernel_offsets[i]);
+    vec4 color = texture(u_texture, uv + kernel_offsets[i] * u_texel_size);
     adjacent[i] = vec3(color);
   }
 
@@ -0,0 +1,208 @@
+/**
+ * @file main.cpp
+ * @authors quak
+ * @brief Benchmarks loading and rendering procedurally generated maps of
+ * increasing size. Each map is also loaded from the UDMF format, to compare
+ * its text parser with the binary loader. The stages of loading the largest
+ * map are timed separately, and drawing is timed with increasing numbers of
+ * sprites. Pass "--no-render" to skip benchmarks that need a window.
+ */
+
+#include "map_generator.hpp" /* woop::MapGenerator */
+#include "wad_builder.hpp"   /* woop::WadBuilder */
+#include "level.hpp"         /* woop::Level */
+#include "log.hpp"           /* woop::log_fatal */
+#include "window.hpp"        /* woop::Window */
+#include "camera.hpp"        /* woop::Camera */
+#include "renderer.hpp"      /* woop::Renderer */
+#include "player.hpp"        /* woop::Player */
+#include "sprite.hpp"        /* woop::SpriteSet */
+#include <chrono>            /* std::chrono::steady_clock */
+#include <cstdio>            /* std::printf */
+#include <cstring>           /* std::memcpy */
+#include <optional>          /* std::optional */
+#include <sstream>           /* std::stringstream */
+#include <string_view>       /* std::string_view */
+#include <vector>            /* std::vector */
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Returns the average time (in milliseconds) taken to run a function.
+ */
+template <typename Fn>
+double time_ms(unsigned iterations, Fn&& fn) {
+  Clock::time_point start = Clock::now();
+  for (unsigned i = 0; i < iterations; ++i)
+    fn();
+  std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+/**
+ * @brief Returns the configuration of a benchmarked map.
+ */
+woop::MapGeneratorConfig get_map_config(unsigned sectors,
+                                        int16_t room_size,
+                                        unsigned wall_detail) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = sectors;
+  cfg.open_area_size = room_size;
+  cfg.wall_detail = wall_detail;
+  return cfg;
+}
+
+/**
+ * @brief Map sizes to benchmark. Linedef counts range from ~100 up to the
+ * limits of the vanilla map format.
+ */
+const woop::MapGeneratorConfig map_sizes[] = {
+    get_map_config(16, 256, 2),   get_map_config(64, 256, 2),
+    get_map_config(256, 256, 4),  get_map_config(1024, 128, 4),
+    get_map_config(2048, 128, 3), get_map_config(1024, 256, 7),
+};
+
+/**
+ * @brief Returns a wad holding a solid 32x56 sprite, seen from every angle,
+ * for the things that maps scatter (former humans).
+ */
+woop::Wad make_sprite_wad() {
+  constexpr int16_t width = 32;
+  constexpr int16_t height = 56;
+  std::vector<uint8_t> data;
+  auto push_int = [&](auto value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+  };
+  push_int(width);
+  push_int(height);
+  push_int(static_cast<int16_t>(width / 2));
+  push_int(static_cast<int16_t>(height - 4));
+  // Each column is a single post covering the whole height
+  const std::size_t column_size = 5 + height;
+  for (int16_t x = 0; x < width; ++x) {
+    push_int(static_cast<int32_t>(8 + width * 4 + x * column_size));
+  }
+  for (int16_t x = 0; x < width; ++x) {
+    data.insert(data.end(), {0, static_cast<uint8_t>(height), 0});
+    data.insert(data.end(), height, 1);
+    data.insert(data.end(), {0, 0xff});
+  }
+
+  std::vector<std::byte> patch(data.size());
+  std::memcpy(patch.data(), data.data(), data.size());
+  woop::WadBuilder builder;
+  builder.add_lump("S_START").add_lump("POSSA0", patch).add_lump("S_END");
+  return builder.build();
+}
+
+/**
+ * @brief Returns the average time (in milliseconds) taken to draw a level,
+ * with the camera turning in place at the player start.
+ */
+double time_draw(woop::Renderer& renderer,
+                 woop::Camera& camera,
+                 const woop::Level& level) {
+  constexpr unsigned frames = 100;
+  woop::Player player(camera, level, woop::PlayerConfig{});
+  player.tick(0.0f);
+  player.interpolate(1.0f);
+  double draw_ms = 0.0;
+  for (unsigned i = 0; i < frames; ++i) {
+    camera.set_rotation(camera.get_rotation() + 360.0f / frames);
+    woop::Frame frame = renderer.begin_frame();
+    draw_ms += time_ms(1, [&]() { frame.draw(woop::DrawMode::Solid, level); });
+  }
+  return draw_ms / frames;
+}
+
+void run_benchmarks(bool render) {
+  std::printf("%10s %10s %12s %12s %12s %12s\n", "sectors", "linedefs",
+              "Wad::open", "Level::open", "UDMF open", "Frame::draw");
+
+  std::vector<woop::TaskTiming> stages;
+  std::optional<woop::Window> window;
+  std::optional<woop::Camera> camera;
+  std::optional<woop::Renderer> renderer;
+  if (render) {
+    woop::WindowConfig window_cfg;
+    window_cfg.title = "Woop Benchmark";
+    window.emplace(window_cfg);
+    camera.emplace(*window);
+    renderer.emplace(*window, *camera);
+  }
+
+  for (const auto& cfg : map_sizes) {
+    woop::WadBuilder builder;
+    woop::MapGenerator(cfg).generate(builder, "MAP01");
+    std::stringstream stream;
+    builder.write(stream);
+    woop::Wad wad;
+    double wad_ms = time_ms(10, [&]() {
+      stream.seekg(0);
+      wad.open(stream);
+    });
+
+    std::size_t linedefs = wad.get_lump("MAP01", "LINEDEFS").data.size() /
+                           sizeof(woop::Level::RawLinedef);
+    woop::Level level;
+    double level_ms = time_ms(10, [&]() { level.open(wad, "MAP01"); });
+    stages = level.get_load_timings();
+
+    // The same map, with its geometry in a TEXTMAP lump
+    woop::MapGeneratorConfig udmf_cfg = cfg;
+    udmf_cfg.format = woop::MapFormat::Udmf;
+    woop::WadBuilder udmf_builder;
+    woop::MapGenerator(udmf_cfg).generate(udmf_builder, "MAP01");
+    woop::Wad udmf_wad = udmf_builder.build();
+    woop::Level udmf_level;
+    double udmf_ms =
+        time_ms(10, [&]() { udmf_level.open(udmf_wad, "MAP01"); });
+
+    // Only drawing is timed (not presenting the frame)
+    double draw_ms = render ? time_draw(*renderer, *camera, level) : 0.0;
+
+    std::printf("%10u %10zu %10.3fms %10.3fms %10.3fms %10.3fms\n",
+                cfg.sector_count, linedefs, wad_ms, level_ms, udmf_ms,
+                draw_ms);
+  }
+
+  // Stages that ran in parallel overlap, so their durations add up to more
+  // than the time taken to open the level
+  std::printf("\n%12s %12s %12s\n", "stage", "start", "duration");
+  for (const woop::TaskTiming& stage : stages) {
+    std::printf("%12s %10.3fms %10.3fms\n", stage.name, stage.start_ms,
+                stage.duration_ms);
+  }
+  if (!render)
+    return;
+
+  // Sprites are only clipped by the walls drawn in their own columns, so
+  // drawing time should grow with the number of things rather than with
+  // things times walls
+  woop::Wad sprite_wad = make_sprite_wad();
+  woop::SpriteSet sprites(sprite_wad);
+  renderer->set_sprites(sprites);
+  std::printf("\n%10s %12s\n", "things", "Frame::draw");
+  for (unsigned things : {0u, 250u, 1000u, 4000u}) {
+    woop::MapGeneratorConfig cfg = get_map_config(256, 256, 4);
+    cfg.thing_count = things;
+    woop::WadBuilder builder;
+    woop::MapGenerator(cfg).generate(builder, "MAP01");
+    woop::Wad wad = builder.build();
+    woop::Level level(wad, "MAP01");
+    std::printf("%10u %10.3fms\n", things,
+                time_draw(*renderer, *camera, level));
+  }
+}
+
+int main(int argc, const char* argv[]) {
+  bool render = !(argc > 1 && std::string_view(argv[1]) == "--no-render");
+  try {
+    run_benchmarks(render);
+  } catch (woop::Exception& exception) {
+    woop::log_fatal("Exception caught: ", exception.what());
+    return 1;
+  }
+  return 0;
+}
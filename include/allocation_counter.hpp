@@ -0,0 +1,33 @@
+/**
+ * @file allocation_counter.hpp
+ * @authors quak
+ * @brief Declares a counter of global heap allocations, used to check that
+ * hot loops don't allocate.
+ *
+ * Allocations are only counted when WOOP_TRACK_ALLOCATIONS is defined, which
+ * replaces the global operator new.
+ */
+
+#pragma once
+
+#include <cstdint> /* uint64_t */
+
+namespace woop {
+/**
+ * @brief Global access to the number of heap allocations.
+ */
+class AllocationCounter {
+ public:
+#ifdef WOOP_TRACK_ALLOCATIONS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  /**
+   * @brief Returns the number of times operator new has been called, or 0 if
+   * allocations aren't tracked.
+   */
+  static uint64_t get_count() noexcept;
+};
+}  // namespace woop
@@ -0,0 +1,107 @@
+/**
+ * @file blockmap.hpp
+ * @authors quak
+ * @brief Declares the Blockmap class, a grid that lists the linedefs passing
+ * through each 128x128 block of a level.
+ */
+
+#pragma once
+
+#include "wad.hpp"      /* woop::Lump */
+#include "glm/vec2.hpp" /* glm::vec2 */
+#include <cmath>        /* std::floor */
+#include <cstdint>      /* uint16_t, uint32_t */
+#include <vector>       /* std::vector */
+
+namespace woop {
+struct Linedef;
+
+/**
+ * @brief Spatial grid over a level's linedefs, so that collision checks only
+ * look at the lines near a position (https://doomwiki.org/wiki/Blockmap).
+ * Blocks are stored in compressed rows: the lines of block i are
+ * lines[offsets[i]] to lines[offsets[i + 1]].
+ */
+class Blockmap {
+ public:
+  // Width and height of a block, in map units
+  static constexpr float block_size = 128.0f;
+
+  Blockmap();
+
+  /**
+   * @brief Reads a BLOCKMAP lump. Throws a LevelException if the lump is
+   * malformed or refers to lines that don't exist.
+   */
+  static Blockmap from_lump(const Lump& lump, std::size_t linedef_count);
+  /**
+   * @brief Builds a blockmap from a level's linedefs, for levels without a
+   * BLOCKMAP lump.
+   */
+  static Blockmap build(const std::vector<Linedef>& linedefs);
+
+  /**
+   * @brief Returns the blockmap in the BLOCKMAP lump format.
+   */
+  std::vector<uint16_t> to_lump() const;
+
+  /**
+   * @brief Calls a function with the index of every linedef in the blocks
+   * overlapping a box. Lines that cross several blocks may be visited more
+   * than once.
+   */
+  template <typename Fn>
+  void for_each_line(const glm::vec2& min,
+                     const glm::vec2& max,
+                     Fn&& fn) const {
+    if (columns == 0 || rows == 0)
+      return;
+    int col_start = get_block(min.x - origin.x, columns);
+    int col_end = get_block(max.x - origin.x, columns);
+    int row_start = get_block(min.y - origin.y, rows);
+    int row_end = get_block(max.y - origin.y, rows);
+    for (int row = row_start; row <= row_end; ++row) {
+      for (int col = col_start; col <= col_end; ++col) {
+        std::size_t block = static_cast<std::size_t>(row) * columns +
+                            static_cast<std::size_t>(col);
+        for (uint32_t i = offsets[block]; i < offsets[block + 1]; ++i)
+          fn(lines[i]);
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the position of the grid's bottom left corner.
+   */
+  glm::vec2 get_origin() const noexcept { return origin; }
+  unsigned get_columns() const noexcept { return columns; }
+  unsigned get_rows() const noexcept { return rows; }
+  /**
+   * @brief Returns the number of lines listed in a block.
+   */
+  std::size_t get_line_count(unsigned column, unsigned row) const {
+    std::size_t block = static_cast<std::size_t>(row) * columns + column;
+    return offsets.at(block + 1) - offsets.at(block);
+  }
+
+ private:
+  /**
+   * @brief Returns the block containing an offset from the origin, clamped to
+   * the grid.
+   */
+  static int get_block(float offset, unsigned count) noexcept {
+    float block = std::floor(offset / block_size);
+    if (block < 0.0f)
+      return 0;
+    if (block >= static_cast<float>(count))
+      return static_cast<int>(count) - 1;
+    return static_cast<int>(block);
+  }
+
+  glm::vec2 origin;
+  unsigned columns;
+  unsigned rows;
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> lines;
+};
+}  // namespace woop
@@ -52,6 +52,15 @@ class Node {
    */
   Child get_nearest_child(const glm::vec2& point) const noexcept;
 
+  /**
+   * @brief Returns the points the partition line passes through. The right
+   * child lies to the right of the line when going from start to end.
+   */
+  const glm::vec2& get_partition_start() const noexcept {
+    return partition_start;
+  }
+  const glm::vec2& get_partition_end() const noexcept { return partition_end; }
+
   /**
    * @brief Returns whether a child holds a node.
    */
@@ -0,0 +1,85 @@
+/**
+ * @file collision.hpp
+ * @authors quak
+ * @brief Declares the Collider class, which moves a body through a level
+ * without passing through its walls.
+ */
+
+#pragma once
+
+#include "level.hpp"    /* woop::Level, woop::Linedef */
+#include "glm/vec2.hpp" /* glm::vec2 */
+#include <limits>       /* std::numeric_limits */
+
+namespace woop {
+/**
+ * @brief Dimensions of a body moving through a level, in map units. The
+ * defaults match the player in the original game.
+ */
+struct Body {
+  float radius = 16.0f;
+  float height = 56.0f;
+  // Tallest ledge that can be walked onto
+  float max_step = 24.0f;
+  // Deepest ledge that can be walked off
+  float max_drop_off = std::numeric_limits<float>::infinity();
+};
+
+/**
+ * @brief The result of checking whether a body fits at a position.
+ */
+struct PositionCheck {
+  // Whether the body can't be at the position
+  bool blocked = false;
+  // The line the body would be stopped by, if it was stopped by one
+  const Linedef* blocking_line = nullptr;
+  // Highest floor and lowest ceiling under the body
+  float floor = 0.0f;
+  float ceiling = 0.0f;
+};
+
+/**
+ * @brief Checks and moves a circular body against a level's linedefs.
+ *
+ * Only the lines in the blockmap blocks around the body are checked. A line
+ * blocks the body if it is one-sided or impassable, or if the opening between
+ * its sectors is too short, too high to step up to, or too deep to drop into.
+ */
+class Collider {
+ public:
+  Collider(const Level& level, const Body& body = Body{});
+
+  /**
+   * @brief Checks whether the body fits at a position.
+   * @param position Center of the body
+   * @param z Height of the bottom of the body
+   */
+  PositionCheck check_position(const glm::vec2& position, float z) const;
+
+  /**
+   * @brief Moves the body as far as it can go, sliding along the walls that
+   * stop it. Returns the body's new position.
+   * @param from Center of the body before moving
+   * @param delta Movement
+   * @param z Height of the bottom of the body
+   */
+  glm::vec2 slide_move(const glm::vec2& from,
+                       const glm::vec2& delta,
+                       float z) const;
+
+  const Body& get_body() const noexcept { return body; }
+  void set_level(const Level& lvl) noexcept { level = &lvl; }
+
+ private:
+  /**
+   * @brief Moves a position by a step, unless the body doesn't fit there.
+   * Returns the result of the check at the new position.
+   */
+  PositionCheck try_move(glm::vec2& position,
+                         const glm::vec2& step,
+                         float z) const;
+
+  const Level* level;
+  Body body;
+};
+}  // namespace woop
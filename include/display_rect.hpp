@@ -1,8 +1,13 @@
 #pragma once
 
-#include "shader.hpp"   /* woop::Shader */
-#include "glad/glad.h"  /* OpenGL */
-#include "glm/vec2.hpp" /* glm::vec2 */
+#include "gpu_timer.hpp"    /* woop::GpuTimer */
+#include "post_process.hpp" /* woop::PostChain, woop::EngineUniforms */
+#include "shader.hpp"       /* woop::Shader */
+#include "text_overlay.hpp" /* woop::TextOverlay */
+#include "glad/glad.h"      /* OpenGL */
+#include "glm/vec2.hpp"     /* glm::vec2 */
+#include <string>           /* std::string */
+#include <vector>           /* std::vector */
 
 namespace woop {
 class Renderer;
@@ -11,23 +16,45 @@ class Renderer;
  */
 class DisplayRect {
  public:
-  DisplayRect(const Renderer& renderer, Shader&& shader);
+  /**
+   * @param shader Shader that draws the (post-processed) image to the screen
+   * @param post_passes Post-processing passes run before the shader
+   */
+  DisplayRect(const Renderer& renderer,
+              Shader&& shader,
+              const std::vector<PostPassConfig>& post_passes = {});
   DisplayRect(const DisplayRect& other) = delete;
   ~DisplayRect();
 
   DisplayRect& operator=(const DisplayRect& other) = delete;
 
   /**
-   * @brief Returns a Frame, which can be used to write to the output
-   * frame.
+   * @brief Runs the post-processing chain over the output image, then draws
+   * the result to the screen. The display shader gets the same automatic
+   * uniforms as post-processing passes (see PostChain), and engine data is
+   * uploaded to the WoopEngine uniform buffer once per draw.
    */
-  void draw() const noexcept;
+  void draw() noexcept;
 
   void bind_texture() const noexcept;
 
   const Shader& get_shader() const noexcept { return shader; }
   Shader& get_shader() noexcept { return shader; }
 
+  /**
+   * @brief Returns the text overlay, which is composited over the output image
+   * when the display rect is drawn.
+   */
+  const TextOverlay& get_overlay() const noexcept { return overlay; }
+  TextOverlay& get_overlay() noexcept { return overlay; }
+
+  const PostChain& get_post_chain() const noexcept { return post_chain; }
+  /**
+   * @brief Returns the GPU time of each post-processing pass and of the final
+   * draw to the screen, one per line.
+   */
+  std::string get_timing_summary() const;
+
  private:
   void gen_texture();
   void gen_quad();
@@ -35,6 +62,11 @@ class DisplayRect {
   void gen_vertex_array();
 
   void bind_vertices() const noexcept;
+  /**
+   * @brief Uploads this frame's engine data (time, resolution, first view's
+   * camera) to the uniform buffer.
+   */
+  void update_engine_uniforms(float time, glm::vec2 resolution);
 
   struct VertexData {
     glm::vec2 pos;
@@ -52,6 +84,13 @@ class DisplayRect {
 
   const Renderer& renderer;
   Shader shader;
+  TextOverlay overlay;
+  PostChain post_chain;
+  GpuTimer timer;
+  UniformBuffer engine_buffer;
+  // Handles into the display shader, looked up again if it's replaced
+  PostUniforms uniforms;
+  GLuint uniforms_program;
   GLuint vbo;
   GLuint ebo;
   GLuint vao;
@@ -0,0 +1,68 @@
+/**
+ * @file fixed_timestep.hpp
+ * @authors quak
+ * @brief Declares the FixedTimestep class, which turns variable frame times
+ * into a whole number of fixed-length simulation ticks.
+ */
+
+#pragma once
+
+#include <cstdint> /* uint64_t */
+
+namespace woop {
+/**
+ * @brief Configuration data for the simulation's fixed timestep.
+ */
+struct TimestepConfig {
+  // Ticks per second (the original game runs at 35)
+  double tick_rate = 35.0;
+  // Most ticks run in one frame. Time beyond that is dropped, so a long
+  // hitch slows the simulation down instead of stalling every later frame.
+  unsigned max_ticks_per_frame = 8;
+};
+
+/**
+ * @brief Accumulates frame time and hands it out in fixed ticks, so the
+ * simulation behaves the same at any frame rate. Whatever is left over sets
+ * how far rendering should interpolate between the last two ticks.
+ */
+class FixedTimestep {
+ public:
+  FixedTimestep(const TimestepConfig& cfg = TimestepConfig{});
+
+  /**
+   * @brief Adds the time since the last frame.
+   * @return Number of ticks to run this frame (possibly 0)
+   */
+  unsigned advance(double frame_time) noexcept;
+
+  /**
+   * @brief Returns how far (0 to 1) the current time is between the last tick
+   * and the next one.
+   */
+  float get_alpha() const noexcept {
+    return static_cast<float>(accumulator / tick_length);
+  }
+  /**
+   * @brief Returns the length of a tick, in seconds.
+   */
+  float get_tick_length() const noexcept {
+    return static_cast<float>(tick_length);
+  }
+  /**
+   * @brief Returns the number of ticks run so far.
+   */
+  uint64_t get_tick() const noexcept { return tick; }
+  /**
+   * @brief Returns the number of ticks skipped because frames took too long.
+   */
+  uint64_t get_dropped_ticks() const noexcept { return dropped_ticks; }
+
+ private:
+  TimestepConfig config;
+  double tick_length;
+  double accumulator;
+  uint64_t tick;
+  uint64_t dropped_ticks;
+};
+}  // namespace woop
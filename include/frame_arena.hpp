@@ -0,0 +1,101 @@
+/**
+ * @file frame_arena.hpp
+ * @authors quak
+ * @brief Declares the FrameArena class, a bump allocator for data that only
+ * lives for a single frame, and an STL allocator that draws from it.
+ */
+
+#pragma once
+
+#include <cstddef> /* std::size_t, std::byte */
+#include <memory>  /* std::unique_ptr */
+#include <vector>  /* std::vector */
+
+namespace woop {
+/**
+ * @brief Hands out memory by bumping an offset into a single block, and frees
+ * everything at once when reset. Allocations that don't fit are served by
+ * overflow blocks, and the main block grows to fit them on the next reset, so
+ * a steady workload stops touching the heap after a frame or two.
+ */
+class FrameArena {
+ public:
+  static constexpr std::size_t default_capacity = 256 * 1024;
+
+  FrameArena(std::size_t capacity = default_capacity);
+  FrameArena(const FrameArena& other) = delete;
+
+  FrameArena& operator=(const FrameArena& other) = delete;
+
+  /**
+   * @brief Returns uninitialized memory that lives until the next reset.
+   */
+  void* allocate(std::size_t size, std::size_t alignment);
+  /**
+   * @brief Frees all allocations. Grows the main block if the last frame
+   * needed overflow blocks.
+   */
+  void reset();
+
+  /**
+   * @brief Returns the number of bytes allocated since the last reset.
+   */
+  std::size_t get_used() const noexcept { return offset + overflow_size; }
+  /**
+   * @brief Returns the size of the main block.
+   */
+  std::size_t get_capacity() const noexcept { return capacity; }
+  /**
+   * @brief Returns the number of overflow blocks allocated since the last
+   * reset.
+   */
+  std::size_t get_overflow_count() const noexcept { return overflow.size(); }
+
+ private:
+  std::unique_ptr<std::byte[]> block;
+  std::size_t capacity;
+  std::size_t offset;
+  std::vector<std::unique_ptr<std::byte[]>> overflow;
+  std::size_t overflow_size;
+};
+
+/**
+ * @brief STL allocator that draws from a FrameArena. Deallocation is a no-op,
+ * so containers using it must not outlive the arena's next reset.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+      : arena(other.get_arena()) {}
+
+  T* allocate(std::size_t count) {
+    return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, std::size_t) noexcept {}
+
+  FrameArena* get_arena() const noexcept { return arena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const noexcept {
+    return arena == other.get_arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+    return arena != other.get_arena();
+  }
+
+ private:
+  FrameArena* arena;
+};
+
+/**
+ * @brief A vector whose storage comes from a FrameArena.
+ */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}  // namespace woop
@@ -0,0 +1,87 @@
+/**
+ * @file frame_limiter.hpp
+ * @authors quak
+ * @brief Declares the FrameLimiter class, which caps the frame rate and
+ * measures how evenly frames are paced.
+ */
+
+#pragma once
+
+#include <chrono>  /* std::chrono::steady_clock */
+#include <cstdint> /* uint64_t */
+#include <string>  /* std::string */
+
+namespace woop {
+/**
+ * @brief Frame pacing measured by a FrameLimiter. Times are in milliseconds.
+ */
+struct FramePacingStats {
+  // Frames measured
+  uint64_t frames = 0;
+  // Average time between frames
+  double mean_frame_time = 0.0;
+  // Standard deviation of the time between frames
+  double jitter = 0.0;
+  // Longest time between frames
+  double max_frame_time = 0.0;
+  // Frames that were already past their deadline when the limiter was reached
+  uint64_t late_frames = 0;
+
+  /**
+   * @brief Returns a human-readable, single-line summary.
+   */
+  std::string to_string() const;
+};
+
+/**
+ * @brief Holds frames back until the next frame boundary at a target rate.
+ *
+ * Sleeping alone wakes up late by up to the OS timer granularity, so the
+ * limiter sleeps until shortly before the deadline and spins for the rest.
+ * Deadlines advance by exactly one period, so an occasional late frame is
+ * made up for; if a frame is more than a period late the schedule restarts
+ * instead of rushing to catch up.
+ */
+class FrameLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::chrono::microseconds default_spin_time{1500};
+
+  /**
+   * @param max_fps Frame rate cap. Values <= 0 disable the cap, but pacing
+   * is still measured.
+   * @param spin_time How long before a deadline to stop sleeping and spin.
+   */
+  FrameLimiter(double max_fps = 0.0,
+               Clock::duration spin_time = default_spin_time);
+
+  /**
+   * @brief Waits until the current frame's deadline, then records its timing.
+   * Call once per frame, right before presenting.
+   */
+  void wait();
+
+  double get_max_fps() const noexcept { return max_fps; }
+  void set_max_fps(double fps) noexcept;
+
+  FramePacingStats get_stats() const noexcept;
+  void reset_stats() noexcept;
+
+ private:
+  void record(Clock::time_point now) noexcept;
+
+  double max_fps;
+  Clock::duration period;
+  Clock::duration spin_time;
+  Clock::time_point deadline;
+  Clock::time_point last_frame;
+  bool started;
+  // Running frame time statistics (Welford's algorithm), in milliseconds
+  uint64_t frames;
+  double mean;
+  double sum_squares;
+  double max_frame_time;
+  uint64_t late_frames;
+};
+}  // namespace woop
@@ -0,0 +1,84 @@
+/**
+ * @file geometry.hpp
+ * @authors quak
+ * @brief Declares geometry helpers shared by the modules that work on a
+ * level's layout, such as the convex BSP regions of its subsectors.
+ */
+
+#pragma once
+
+#include "bsp.hpp"      /* woop::Node */
+#include "glm/vec2.hpp" /* glm::vec2, glm::dvec2 */
+#include <vector>       /* std::vector */
+
+namespace woop {
+class Level;
+struct Linedef;
+
+/**
+ * @brief An axis-aligned box.
+ */
+struct Bounds {
+  glm::vec2 min;
+  glm::vec2 max;
+};
+
+/**
+ * @brief Returns the box around every line's endpoints, or an empty box at
+ * the origin if there are no lines.
+ */
+Bounds get_bounds(const std::vector<Linedef>& linedefs) noexcept;
+
+/**
+ * @brief A corner of a convex region, and the partition that the edge
+ * starting at it lies on (none for edges that aren't partitions).
+ *
+ * Regions are computed in doubles: map coordinates reach 32768, and float
+ * cross products lose most of their precision at that scale.
+ */
+struct RegionVertex {
+  glm::dvec2 point;
+  const Node* node = nullptr;
+  Node::Child child = Node::Child::Right;
+};
+using ConvexRegion = std::vector<RegionVertex>;
+
+/**
+ * @brief Returns which side of the line from start to end a point is on:
+ * positive on the right (like Node::get_nearest_child()), negative on the
+ * left. The magnitude is the distance times the line's length.
+ */
+double get_side(const glm::dvec2& start,
+                const glm::dvec2& end,
+                const glm::dvec2& point) noexcept;
+
+/**
+ * @brief Returns a box as a counter-clockwise region, so that the inside is
+ * on the left of every edge. None of its edges are partitions.
+ */
+ConvexRegion get_box_region(const glm::dvec2& min, const glm::dvec2& max);
+
+/**
+ * @brief Keeps the part of a convex region on one side of a line. Returns an
+ * empty region if less than a triangle is left.
+ * @param node Partition that the line is, which the edge left by the cut is
+ * tagged with (if any)
+ */
+ConvexRegion clip_region(const ConvexRegion& region,
+                         const glm::dvec2& start,
+                         const glm::dvec2& end,
+                         bool keep_right,
+                         const Node* node = nullptr);
+
+/**
+ * @brief Computes the region of every subsector, by cutting the given bounds
+ * along the partition lines of the level's BSP tree. Subsectors whose region
+ * is empty get an empty one.
+ * @param clip_to_segs Whether to also cut each region along its subsector's
+ * segs, leaving the convex hull of the subsector itself. Those edges aren't
+ * tagged.
+ */
+std::vector<ConvexRegion> get_subsector_regions(const Level& level,
+                                                const ConvexRegion& bounds,
+                                                bool clip_to_segs);
+}  // namespace woop
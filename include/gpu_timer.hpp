@@ -0,0 +1,57 @@
+/**
+ * @file gpu_timer.hpp
+ * @authors quak
+ * @brief Declares the GpuTimer class, which measures how long the GPU spends
+ * on a sequence of commands.
+ */
+
+#pragma once
+
+#include "glad/glad.h" /* OpenGL */
+#include <cstddef>     /* std::size_t */
+
+namespace woop {
+/**
+ * @brief Times GPU work with GL_TIME_ELAPSED queries. Results are read a few
+ * frames after they're issued, so measuring never stalls the pipeline; the
+ * reported time lags behind by the same amount.
+ *
+ * @note Timer queries can't nest, so only one GpuTimer can be running at a
+ * time.
+ */
+class GpuTimer {
+ public:
+  // Number of queries in flight before the oldest result is read
+  static constexpr std::size_t latency = 3;
+
+  GpuTimer();
+  GpuTimer(const GpuTimer& other) = delete;
+  GpuTimer(GpuTimer&& other) noexcept;
+  ~GpuTimer();
+
+  GpuTimer& operator=(const GpuTimer& other) = delete;
+  GpuTimer& operator=(GpuTimer&& other) = delete;
+
+  /**
+   * @brief Starts timing the commands that follow.
+   */
+  void begin() noexcept;
+  /**
+   * @brief Stops timing.
+   */
+  void end() noexcept;
+
+  /**
+   * @brief Returns the most recent measured time, in milliseconds.
+   */
+  double get_ms() const noexcept { return ms; }
+
+ private:
+  GLuint queries[latency];
+  // Whether each query has been issued and its result not yet read
+  bool pending[latency];
+  std::size_t current;
+  double ms;
+  bool valid;
+};
+}  // namespace woop
@@ -7,14 +7,23 @@
 
 #pragma once
 
-#include "exception.hpp" /* woop::Exception */
-#include "wad.hpp"       /* woop::Wad, woop::Lump */
-#include "bsp.hpp"       /* woop::Node */
-#include "glm/vec2.hpp"  /* glm::vec2 */
-#include <vector>        /* std::vector */
+#include "exception.hpp"     /* woop::Exception */
+#include "wad.hpp"           /* woop::Wad, woop::Lump */
+#include "blockmap.hpp"      /* woop::Blockmap */
+#include "pvs.hpp"           /* woop::Pvs */
+#include "point_locator.hpp" /* woop::PointLocator */
+#include "node_builder.hpp"  /* woop::NodeBuilderConfig, woop::BspTree */
+#include "udmf.hpp"          /* woop::UdmfMap */
+#include "task_graph.hpp"    /* woop::TaskTiming */
+#include "bsp.hpp"           /* woop::Node */
+#include "span.hpp"          /* woop::Span */
+#include "glm/vec2.hpp"      /* glm::vec2 */
+#include <optional>          /* std::optional */
+#include <vector>            /* std::vector */
 
 namespace woop {
 struct Linedef;
+struct Thing;
 
 /**
  * @brief Exception thrown when a level encounters an error.
@@ -47,6 +56,10 @@ class LevelException : public Exception {
  * great job of explaining the purpose of each type, and I would definitely
  * recommend looking through it if any of this seems confusing.
  * https://doomwiki.org/wiki/Map_format
+ *
+ * Lists of related objects (a sector's lines, a subsector's segs, ...) are
+ * spans into arrays owned by the Level, so that loading a level only makes a
+ * handful of allocations.
  */
 
 /**
@@ -62,7 +75,10 @@ struct Sector {
     std::string texture;
   } ceiling;
   int16_t light_level;
-  std::vector<Linedef*> lines;
+  // Lines with a side facing the sector
+  Span<Linedef*> lines;
+  // Sectors sharing a two-sided line with the sector
+  Span<Sector*> neighbors;
 };
 
 /**
@@ -80,10 +96,18 @@ struct Sidedef {
  * @brief Stores information about a line (wall) in a map
  */
 struct Linedef {
+  // Flags (https://doomwiki.org/wiki/Linedef#Linedef_flags)
+  enum Flags : int16_t {
+    Impassable = 0x0001,
+    BlockMonsters = 0x0002,
+    TwoSided = 0x0004,
+  };
+
   glm::vec2& start;
   glm::vec2& end;
   Sidedef* front;
   Sidedef* back;
+  int16_t flags;
 };
 
 /**
@@ -103,7 +127,9 @@ struct Seg {
  * a convex polygon.
  */
 struct Subsector {
-  std::vector<Seg*> segs;
+  Span<Seg> segs;
+  Sector* sector;
+  Span<const Thing*> things;
 };
 
 /**
@@ -116,6 +142,20 @@ struct Thing {
   int16_t flags;
 };
 
+/**
+ * @brief Options for opening levels.
+ */
+struct LevelConfig {
+  // Whether to build a new BSP tree even when the level has one. Levels
+  // missing their SEGS, SSECTORS, or NODES lumps always get a new tree.
+  bool rebuild_nodes = false;
+  NodeBuilderConfig node_builder;
+  // Whether to load independent parts of the level (e.g. things, the
+  // blockmap, sector connections) on several threads, and build nodes on
+  // several threads when needed
+  bool parallel_load = true;
+};
+
 /**
  * @brief Stores all information about a level
  */
@@ -125,12 +165,16 @@ class Level {
   /**
    * @brief Opens a level with the given name from a wad.
    */
-  Level(const Wad& wad, const std::string& name);
+  Level(const Wad& wad,
+        const std::string& name,
+        const LevelConfig& config = LevelConfig{});
 
   /**
    * @brief Opens a level with the given name from a wad.
    */
-  void open(const Wad& wad, const std::string& name);
+  void open(const Wad& wad,
+            const std::string& name,
+            const LevelConfig& config = LevelConfig{});
   /**
    * @brief Closes the level, releasing all data.
    */
@@ -143,16 +187,145 @@ class Level {
   const Node& get_root_node() const;
   Node& get_root_node();
 
+  /**
+   * @brief Returns the subsector containing a point.
+   */
+  const Subsector& get_subsector(const glm::vec2& point) const;
+  Subsector& get_subsector(const glm::vec2& point);
+  /**
+   * @brief Returns the sector containing a point.
+   */
+  const Sector& get_sector(const glm::vec2& point) const;
+  /**
+   * @brief Returns the locator used to find subsectors from nearby ones,
+   * which is faster than get_subsector() for objects that move a little at a
+   * time.
+   */
+  const PointLocator& get_locator() const noexcept { return locator; }
+  /**
+   * @brief Returns the sector that a subsector belongs to.
+   */
+  const Sector& get_sector(const Subsector& subsector) const noexcept {
+    return *subsector.sector;
+  }
+  /**
+   * @brief Returns the position of a sector in get_sectors().
+   */
+  std::size_t get_sector_index(const Sector& sector) const noexcept {
+    return static_cast<std::size_t>(&sector - sectors.data());
+  }
+
+  /**
+   * @brief Returns false if the REJECT lump marks every point in one sector
+   * as hidden from every point in the other. Returns true if they may see each
+   * other (including when the level has no REJECT data).
+   */
+  bool can_see(std::size_t sector_a, std::size_t sector_b) const noexcept {
+    std::size_t bit = sector_a * sectors.size() + sector_b;
+    return (reject[bit / 8] & (1 << (bit % 8))) == 0;
+  }
+  bool can_see(const Sector& a, const Sector& b) const noexcept {
+    return can_see(get_sector_index(a), get_sector_index(b));
+  }
+
+  const std::vector<Sector>& get_sectors() const noexcept { return sectors; }
+  const std::vector<Subsector>& get_subsectors() const noexcept {
+    return subsectors;
+  }
+  const std::vector<Node>& get_nodes() const noexcept { return nodes; }
+  /**
+   * @brief Returns the position of a subsector in get_subsectors().
+   */
+  std::size_t get_subsector_index(const Subsector& subsector) const noexcept {
+    return static_cast<std::size_t>(&subsector - subsectors.data());
+  }
+  /**
+   * @brief Returns the position of a node in get_nodes().
+   */
+  std::size_t get_node_index(const Node& node) const noexcept {
+    return static_cast<std::size_t>(&node - nodes.data());
+  }
+  const std::vector<Linedef>& get_linedefs() const noexcept {
+    return linedefs;
+  }
+  const std::vector<Sidedef>& get_sidedefs() const noexcept {
+    return sidedefs;
+  }
+  /**
+   * @brief Returns the position of a sidedef in get_sidedefs().
+   */
+  std::size_t get_sidedef_index(const Sidedef& sidedef) const noexcept {
+    return static_cast<std::size_t>(&sidedef - sidedefs.data());
+  }
+  /**
+   * @brief Returns the grid of linedefs used for collision. Read from the
+   * BLOCKMAP lump, or built when the level doesn't have a valid one.
+   */
+  const Blockmap& get_blockmap() const noexcept { return blockmap; }
+  /**
+   * @brief Returns the subsector visibility data used to cull the level, or
+   * nullptr if it has none (see Pvs).
+   */
+  const Pvs* get_pvs() const noexcept {
+    return pvs.is_empty() ? nullptr : &pvs;
+  }
+  void set_pvs(Pvs new_pvs) noexcept { pvs = std::move(new_pvs); }
+
+  /**
+   * @brief Returns a hash of the level's geometry (vertices, lines, sides,
+   * segs, subsectors and nodes, or the TEXTMAP and ZNODES lumps of UDMF
+   * levels). Data derived from the geometry, like the PVS, is cached under
+   * this hash.
+   */
+  uint64_t get_checksum() const noexcept { return checksum; }
+  /**
+   * @brief Returns true if the level's BSP tree was built when it was opened,
+   * rather than read from its lumps.
+   */
+  bool has_built_nodes() const noexcept { return built_nodes; }
+  /**
+   * @brief Returns how long each stage of opening the level took (see
+   * TaskGraph). Stages that ran in parallel overlap.
+   */
+  const std::vector<TaskTiming>& get_load_timings() const noexcept {
+    return load_timings;
+  }
+
   const std::vector<Thing>& get_things() const noexcept { return things; }
   std::vector<Thing>& get_things() noexcept { return things; }
+  /**
+   * @brief Returns the position of a thing in get_things().
+   */
+  std::size_t get_thing_index(const Thing& thing) const noexcept {
+    return static_cast<std::size_t>(&thing - things.data());
+  }
 
- private:
+  /**
+   * @brief Returns a number that changes whenever the level is opened, closed,
+   * or marked as changed. Revisions are unique across all levels.
+   */
+  uint64_t get_revision() const noexcept { return revision; }
+  /**
+   * @brief Gives the level a new revision. Must be called after modifying
+   * level data (e.g. moving things or sectors), so that views of the level
+   * are redrawn.
+   */
+  void mark_changed() noexcept;
+
+ public:
   /**
    * RAW TYPES
    *
    * All types used to extract map information from a lump. These only serve as
-   * an intermediary representation, and aren't used outside of level loading.
+   * an intermediary representation, and are only used to load levels (or to
+   * write them, see map_generator.hpp). Indices are unsigned, like in most
+   * source ports, so that maps can hold up to 65535 of each type.
    */
+  // Sidedef index of linedefs without a back (or front) side
+  static constexpr uint16_t no_sidedef = 0xffff;
+  // Set on node children that refer to subsectors
+  static constexpr uint16_t subsector_bit = 0x8000;
+
   struct RawThing {
     int16_t x_pos;
     int16_t y_pos;
@@ -161,13 +334,13 @@ class Level {
     int16_t flags;
   };
   struct RawLinedef {
-    int16_t start_vertex;
-    int16_t end_vertex;
+    uint16_t start_vertex;
+    uint16_t end_vertex;
     int16_t flags;
     int16_t special;
     int16_t tag;
-    int16_t front_sidedef;
-    int16_t back_sidedef;
+    uint16_t front_sidedef;
+    uint16_t back_sidedef;
   };
   struct RawSidedef {
     int16_t x_offset;
@@ -182,16 +355,16 @@ class Level {
     int16_t y_pos;
   };
   struct RawSeg {
-    int16_t start_vertex;
-    int16_t end_vertex;
+    uint16_t start_vertex;
+    uint16_t end_vertex;
     int16_t angle;
-    int16_t linedef;
+    uint16_t linedef;
     int16_t direction; /* 0: front of linedef, 1: back of linedef */
     int16_t offset;
   };
   struct RawSubsector {
-    int16_t seg_count;
-    int16_t first_seg;
+    uint16_t seg_count;
+    uint16_t first_seg;
   };
   struct RawNode {
     int16_t x_part_start;
@@ -216,9 +389,9 @@ class Level {
         int16_t right;
       } names;
     } left_bounds;
-    /* Sign bit determines child type (0: subnode, 1: subsector) */
-    int16_t right_child;
-    int16_t left_child;
+    /* Top bit determines child type (0: subnode, 1: subsector) */
+    uint16_t right_child;
+    uint16_t left_child;
   };
   struct RawSector {
     int16_t floor_height;
@@ -231,20 +404,67 @@ class Level {
   };
 
  private:
-  void populate_level_data(const Wad& wad);
+  void populate_level_data(const Wad& wad, const LevelConfig& config);
   void populate_sectors(const Wad& wad);
-  void populate_subsectors(const Wad& wad);
-  void populate_segs(const Wad& wad);
+  void populate_subsectors(const BspTree& tree);
+  void populate_segs(const BspTree& tree);
   void populate_linedefs(const Wad& wad);
   void populate_sidedefs(const Wad& wad);
   void populate_vertices(const Wad& wad);
-  void populate_nodes(const Wad& wad);
+  void populate_nodes(const BspTree& tree);
   void populate_things(const Wad& wad);
+  void populate_blockmap(const Wad& wad);
+  void populate_reject(const Wad& wad);
+  /**
+   * @brief Hashes the lumps that the level's geometry was read from (see
+   * get_checksum()).
+   */
+  void populate_checksum(const Wad& wad,
+                         bool udmf,
+                         const NodeBuilderConfig& builder);
+  // UDMF levels, read from a TEXTMAP lump instead of the binary lumps
+  void populate_sectors(const UdmfMap& map);
+  void populate_linedefs(const UdmfMap& map);
+  void populate_sidedefs(const UdmfMap& map);
+  void populate_vertices(const UdmfMap& map);
+  void populate_things(const UdmfMap& map);
+  /**
+   * @brief Reads the level's BSP tree from its SEGS, SSECTORS, and NODES
+   * lumps (or the ZNODES lump of UDMF levels), in any format that
+   * read_node_lumps() supports. Returns nothing if the tree is missing or
+   * can't be used.
+   */
+  std::optional<BspTree> read_nodes(
+      const Wad& wad,
+      const std::vector<NodeBuilder::Line>& lines) const;
+  /**
+   * @brief Returns the level's linedefs as lines to build a tree around.
+   */
+  std::vector<NodeBuilder::Line> read_lines(const Wad& wad) const;
+  std::vector<NodeBuilder::Line> read_lines(const UdmfMap& map) const;
+  /**
+   * @brief Builds a BSP tree from the level's lines.
+   * @param workers Number of worker threads to build it with (0 to build it
+   * on the calling thread)
+   */
+  BspTree build_nodes(const std::vector<NodeBuilder::Line>& lines,
+                      const NodeBuilderConfig& config,
+                      unsigned workers) const;
+  /**
+   * @brief Returns one of the level's lumps, or nullptr if the level doesn't
+   * have it. Unlike Wad::get_lump(), this never finds a lump belonging to the
+   * next level.
+   */
+  const Lump* find_level_lump(const Wad& wad, const std::string& lump) const;
   /**
    * @brief Fills all data that could not be assigned during population (due to
    * dependency circles)
    */
   void finish_connections();
+  /**
+   * @brief Adds each thing to the subsector that contains it.
+   */
+  void sort_things();
 
   std::vector<Sector> sectors;
   std::vector<Subsector> subsectors;
@@ -254,8 +474,23 @@ class Level {
   std::vector<glm::vec2> vertices;
   std::vector<Node> nodes;
   std::vector<Thing> things;
+  // Compressed rows behind the spans in Sector and Subsector. Subsectors view
+  // the segs array directly, since each one's segs are stored contiguously.
+  std::vector<Linedef*> sector_lines;
+  std::vector<Sector*> sector_neighbors;
+  std::vector<const Thing*> subsector_things;
+  Blockmap blockmap;
+  // Sector visibility matrix, one bit per pair of sectors
+  // (https://doomwiki.org/wiki/Reject)
+  std::vector<uint8_t> reject;
+  Pvs pvs;
+  PointLocator locator;
   bool loaded;
   std::string name;
   Node* bsp_root;
+  uint64_t revision;
+  uint64_t checksum;
+  bool built_nodes;
+  std::vector<TaskTiming> load_timings;
 };
 }  // namespace woop
\ No newline at end of file
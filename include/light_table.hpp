@@ -0,0 +1,114 @@
+/**
+ * @file light_table.hpp
+ * @authors quak
+ * @brief Declares the LightTable class, which precomputes how sector light
+ * levels and distance darken colors (like Doom's "zlight" tables).
+ *
+ * See the wiki for details on how Doom handles lighting:
+ * https://doomwiki.org/wiki/Light
+ * https://doomwiki.org/wiki/COLORMAP
+ */
+
+#pragma once
+
+#include "exception.hpp" /* woop::Exception */
+#include "pixel.hpp"     /* woop::Pixel */
+#include "wad.hpp"       /* woop::Wad */
+#include <array>         /* std::array */
+#include <cstdint>       /* uint8_t */
+#include <vector>        /* std::vector */
+
+namespace woop {
+/**
+ * @brief Exception thrown when a light table can't be built.
+ */
+class LightTableException : public Exception {
+ public:
+  /**
+   * @brief Details the cause of the exception.
+   */
+  enum class Type {
+    InvalidLump,
+  };
+
+  LightTableException(Type type, const std::string_view& what)
+      : Exception(what), t(type) {}
+
+  /**
+   * @brief Returns the type of exception that was thrown
+   */
+  Type type() const noexcept { return t; }
+
+ private:
+  Type t;
+};
+
+/**
+ * @brief Number of shades a color can be drawn with (Doom's colormaps).
+ */
+constexpr unsigned shade_count = 32;
+
+/**
+ * @brief All shades of a single color, from full brightness to darkest.
+ */
+using ColorRamp = std::array<Pixel, shade_count>;
+
+/**
+ * @brief Maps light levels and distances to shades. Tables are built once, so
+ * that lighting a column only takes a couple of lookups.
+ */
+class LightTable {
+ public:
+  /**
+   * @brief Number of distinct sector light levels (light levels are 0->255).
+   */
+  static constexpr unsigned light_levels = 16;
+  /**
+   * @brief Number of distinct distances.
+   */
+  static constexpr unsigned scale_levels = 48;
+
+  /**
+   * @brief Builds a table that fades colors toward a fog color.
+   * @param fog_color Color of the darkest shade
+   * @param fog_strength How far (0->1) the darkest shade is faded toward the
+   * fog color. 0 disables lighting.
+   */
+  LightTable(const Pixel& fog_color, float fog_strength);
+  /**
+   * @brief Builds a table from a wad's COLORMAP and PLAYPAL lumps. Colors are
+   * shaded as the closest color of the palette.
+   */
+  LightTable(const Wad& wad);
+
+  /**
+   * @brief Returns the shade (index into a ColorRamp) to draw with.
+   * @param light_level Light level of a sector (0->255)
+   * @param scale Projection scale at 320x200 with a 90 degree FOV (160
+   * divided by distance)
+   */
+  uint8_t get_shade(int light_level, float scale) const noexcept;
+  /**
+   * @brief Returns every shade of a color.
+   */
+  ColorRamp get_ramp(const Pixel& color) const;
+
+  /**
+   * @brief Returns true if the table was built from a COLORMAP lump.
+   */
+  bool uses_colormap() const noexcept { return !colormap.empty(); }
+
+ private:
+  /**
+   * @brief Fills the light level/distance -> shade table.
+   */
+  void gen_shades() noexcept;
+
+  std::array<std::array<uint8_t, scale_levels>, light_levels> shades;
+  Pixel fog_color;
+  float fog_strength;
+  // Palette indices of each shade (shade_count rows of 256 entries)
+  std::vector<uint8_t> colormap;
+  std::vector<Pixel> palette;
+};
+}  // namespace woop
@@ -0,0 +1,155 @@
+/**
+ * @file map_generator.hpp
+ * @authors quak
+ * @brief Declares the MapGenerator class, which procedurally creates valid
+ * Doom-format maps. Generated maps can be used to test and benchmark the engine
+ * at any scale without relying on an external wad.
+ */
+
+#pragma once
+
+#include "level.hpp"       /* woop::Level, woop::LevelException */
+#include "wad_builder.hpp" /* woop::WadBuilder */
+#include <cstdint>         /* int16_t, uint16_t, uint32_t */
+#include <random>          /* std::mt19937 */
+#include <string>          /* std::string */
+#include <unordered_map>   /* std::unordered_map */
+#include <vector>          /* std::vector */
+
+namespace woop {
+/**
+ * @brief Formats that generated maps can be written in.
+ */
+enum class MapFormat {
+  // Binary lumps (THINGS, LINEDEFS, SIDEDEFS, VERTEXES, SEGS, SSECTORS,
+  // NODES, SECTORS)
+  Doom,
+  // A TEXTMAP lump in the "doom" namespace, with the BSP tree in a ZNODES
+  // lump (as XNOD) and an ENDMAP marker (https://zdoom.org/wiki/UDMF)
+  Udmf,
+};
+
+/**
+ * @brief Configuration data for generated maps.
+ */
+struct MapGeneratorConfig {
+  // Number of rooms in the map. Each room is its own sector (and subsector).
+  unsigned sector_count = 64;
+  // Chance (0->1) that the wall between two neighboring rooms is solid. Lower
+  // values create larger open areas, which are more expensive to render.
+  float room_density = 0.5f;
+  // Width of each (square) room, in map units
+  int16_t open_area_size = 256;
+  // Number of linedefs that each wall of a room is split into
+  unsigned wall_detail = 1;
+  // Number of things scattered around the map (besides the player start)
+  unsigned thing_count = 0;
+  // Type of the scattered things (https://doomwiki.org/wiki/Thing_types)
+  int16_t thing_type = 3004;
+  // Seed used for all random decisions. Equal seeds produce equal maps.
+  uint32_t seed = 0;
+  // Format of the map's lumps. Both formats describe the same map.
+  MapFormat format = MapFormat::Doom;
+};
+
+/**
+ * @brief Creates maps made up of a grid of rectangular rooms. Rooms have
+ * random floor and ceiling heights, and are connected through "window"
+ * linedefs. Since every room is convex, the map's BSP tree can be built
+ * directly from the grid.
+ */
+class MapGenerator {
+ public:
+  MapGenerator(const MapGeneratorConfig& cfg = MapGeneratorConfig{});
+
+  /**
+   * @brief Generates a map, then adds a marker lump with the given name and
+   * all of the map's lumps (in the configured format) to the builder.
+   */
+  void generate(WadBuilder& builder, const std::string& name);
+
+ private:
+  /**
+   * @brief A rectangle of grid cells (rooms), including its start and
+   * excluding its end.
+   */
+  struct CellRect {
+    unsigned col_start;
+    unsigned col_end;
+    unsigned row_start;
+    unsigned row_end;
+  };
+
+  void clear();
+  void generate_sectors();
+  void generate_walls();
+  void generate_subsectors();
+  void generate_things();
+
+  /**
+   * @brief Writes the map as the contents of a UDMF TEXTMAP lump.
+   */
+  std::vector<std::byte> write_textmap() const;
+  /**
+   * @brief Writes the map's BSP tree as an XNOD lump.
+   */
+  std::vector<std::byte> write_extended_nodes() const;
+
+  /**
+   * @brief Adds the wall between two cells (or a cell and the void), split
+   * into `wall_detail` linedefs. Coordinates are given in clockwise order
+   * relative to `front`, so that `front` lies on the right side of the wall.
+   */
+  void add_wall(int front, int back, int x0, int y0, int x1, int y1);
+  /**
+   * @brief Adds a linedef between two points, along with its segs.
+   */
+  void add_linedef(int front, int back, int x0, int y0, int x1, int y1);
+  /**
+   * @brief Adds a sidedef facing the given sector.
+   */
+  uint16_t add_sidedef(int sector, bool two_sided);
+  /**
+   * @brief Returns the index of a vertex, adding it if it doesn't exist yet.
+   */
+  uint16_t get_vertex(int x, int y);
+
+  /**
+   * @brief Recursively builds the BSP tree for a rectangle of cells. Returns
+   * the child index (with the subsector bit set for leaves) of its root.
+   */
+  uint16_t build_node(CellRect rect);
+  /**
+   * @brief Shrinks a rectangle to the smallest one containing the same rooms.
+   */
+  CellRect trim_rect(const CellRect& rect) const;
+  /**
+   * @brief Returns the cell at the given grid position, or -1 if there is no
+   * room there.
+   */
+  int get_cell(unsigned col, unsigned row) const noexcept;
+  /**
+   * @brief Returns the map-space coordinate of a grid line.
+   */
+  int get_grid_x(unsigned col) const noexcept;
+  int get_grid_y(unsigned row) const noexcept;
+
+  MapGeneratorConfig config;
+  std::mt19937 rng;
+  unsigned cols;
+  unsigned rows;
+
+  std::vector<Level::RawThing> things;
+  std::vector<Level::RawLinedef> linedefs;
+  std::vector<Level::RawSidedef> sidedefs;
+  std::vector<Level::RawVertex> vertices;
+  std::vector<Level::RawSeg> segs;
+  std::vector<Level::RawSubsector> subsectors;
+  std::vector<Level::RawNode> nodes;
+  std::vector<Level::RawSector> sectors;
+
+  // Segs facing into each cell
+  std::vector<std::vector<Level::RawSeg>> cell_segs;
+  std::unordered_map<int32_t, uint16_t> vertex_indices;
+};
+}  // namespace woop
@@ -0,0 +1,109 @@
+/**
+ * @file node_builder.hpp
+ * @authors quak
+ * @brief Declares the NodeBuilder class, which builds a level's BSP tree (its
+ * segs, subsectors, and nodes) from its lines.
+ */
+
+#pragma once
+
+#include "glm/vec2.hpp" /* glm::vec2 */
+#include <cstdint>      /* int32_t, uint32_t */
+#include <vector>       /* std::vector */
+
+namespace woop {
+class ThreadPool;
+
+/**
+ * @brief Heuristics used to pick partition lines. Each candidate line is
+ * scored by the segs it would split and how unevenly it would divide the
+ * rest, and the lowest score wins.
+ */
+struct NodeBuilderConfig {
+  // Cost of each seg split in two. Splits add segs to draw and clip.
+  unsigned split_cost = 8;
+  // Cost of each seg of difference between the two sides. Balanced trees
+  // are shallower, so locating points and culling nodes take fewer steps.
+  unsigned balance_cost = 1;
+  // Extra cost of partition lines that aren't horizontal or vertical, which
+  // tend to split more lines further down the tree
+  unsigned diagonal_cost = 4;
+  // Most partition lines tried for each node (0 tries every seg). Larger
+  // sets of segs are sampled evenly.
+  unsigned max_candidates = 128;
+};
+
+/**
+ * @brief A BSP tree, stored like the SEGS, SSECTORS, and NODES lumps but with
+ * fractional vertices and 32-bit indices, so that trees aren't limited to what
+ * the vanilla lumps can hold.
+ */
+struct BspTree {
+  // Set on child indices that refer to subsectors
+  static constexpr uint32_t subsector_bit = 0x80000000u;
+
+  struct Seg {
+    uint32_t start_vertex;
+    uint32_t end_vertex;
+    uint32_t linedef;
+    // Whether the seg runs along the back side of its linedef
+    bool back;
+    // Direction of the seg, in degrees counter-clockwise from east
+    float angle;
+    // Distance from the start of the linedef's side to the start of the seg
+    float offset;
+  };
+  struct Subsector {
+    uint32_t first_seg;
+    uint32_t seg_count;
+  };
+  struct Node {
+    glm::vec2 partition_start;
+    glm::vec2 partition_delta;
+    uint32_t right_child;
+    uint32_t left_child;
+  };
+
+  // Vertices added where lines were split, numbered after the level's own
+  std::vector<glm::vec2> vertices;
+  std::vector<Seg> segs;
+  std::vector<Subsector> subsectors;
+  // Nodes, with the root last
+  std::vector<Node> nodes;
+};
+
+/**
+ * @brief Builds BSP trees for levels that don't have one, or that should get
+ * a better one than they shipped with.
+ *
+ * Segs are split recursively along partition lines picked from the segs
+ * themselves, until each set of segs is convex and faces a single sector.
+ * Candidate partitions for each node are scored in parallel.
+ */
+class NodeBuilder {
+ public:
+  /**
+   * @brief A line to build the tree around.
+   */
+  struct Line {
+    uint32_t start_vertex;
+    uint32_t end_vertex;
+    // Sector on each side of the line, or -1 if the side doesn't exist
+    int32_t front_sector;
+    int32_t back_sector;
+  };
+
+  NodeBuilder(const NodeBuilderConfig& config = NodeBuilderConfig{});
+
+  /**
+   * @brief Builds a tree for a level's lines. Throws a LevelException if the
+   * lines refer to vertices that don't exist, or no line has a side.
+   */
+  BspTree build(const std::vector<glm::vec2>& vertices,
+                const std::vector<Line>& lines,
+                ThreadPool& pool) const;
+
+ private:
+  NodeBuilderConfig config;
+};
+}  // namespace woop
@@ -0,0 +1,62 @@
+/**
+ * @file node_format.hpp
+ * @authors quak
+ * @brief Declares functions that read BSP trees from a level's SEGS, SSECTORS,
+ * and NODES lumps, in the vanilla format or one of the extended ones.
+ */
+
+#pragma once
+
+#include "node_builder.hpp" /* woop::BspTree, woop::NodeBuilder::Line */
+#include "glm/vec2.hpp"     /* glm::vec2 */
+#include <cstddef>          /* std::byte */
+#include <optional>         /* std::optional */
+#include <vector>           /* std::vector */
+
+namespace woop {
+/**
+ * @brief Formats that BSP trees are stored in
+ * (https://zdoom.org/wiki/Node#ZDoom_extended_nodes).
+ */
+enum class NodeFormat {
+  // SEGS, SSECTORS, and NODES lumps with 16-bit indices
+  Vanilla,
+  // Everything in the NODES lump, with 32-bit indices and fractional vertices
+  XNOD,
+  // GL nodes (including minisegs) in the SSECTORS lump, with 16-bit linedef
+  // indices, 32-bit ones, or 32-bit ones and fractional partition lines
+  XGLN,
+  XGL2,
+  XGL3,
+  // Any of the above, compressed with zlib (ZNOD, ZGLN, ZGL2, ZGL3)
+  Compressed,
+};
+
+/**
+ * @brief Returns the format of a NODES or SSECTORS lump, going by its
+ * signature.
+ */
+NodeFormat get_node_format(const std::vector<std::byte>& lump) noexcept;
+
+/**
+ * @brief Reads a BSP tree from a level's SEGS, SSECTORS, and NODES lumps.
+ *
+ * Extended nodes are found by their signature, in NODES first and SSECTORS
+ * second, and take the place of all three lumps. The vertices they add come
+ * after the level's own, and their segs get their angles and offsets from the
+ * level's lines, since the formats don't store them. GL nodes' minisegs
+ * aren't kept, since they don't lie along a linedef.
+ *
+ * Returns nothing if the lumps are empty, compressed, or hold GL subsectors
+ * with no segs besides minisegs. Throws a LevelException if the lumps are
+ * malformed.
+ * @param vertices The level's own vertices
+ * @param lines The level's linedefs (only their vertices are used)
+ */
+std::optional<BspTree> read_node_lumps(
+    const std::vector<std::byte>& segs,
+    const std::vector<std::byte>& subsectors,
+    const std::vector<std::byte>& nodes,
+    const std::vector<glm::vec2>& vertices,
+    const std::vector<NodeBuilder::Line>& lines);
+}  // namespace woop
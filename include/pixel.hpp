@@ -0,0 +1,17 @@
+/**
+ * @file pixel.hpp
+ * @authors quak
+ * @brief Declares the Pixel type, used by the renderer's output image.
+ */
+
+#pragma once
+
+#include "glm/vec4.hpp" /* glm::vec */
+#include <cstddef>      /* std::byte */
+
+namespace woop {
+/**
+ * @brief Pixel data in woop (4 bytes, 0->255)
+ */
+using Pixel = glm::vec<4, std::byte>;
+}  // namespace woop
@@ -7,10 +7,11 @@
 
 #pragma once
 
-#include "camera.hpp"   /* woop::Camera */
-#include "level.hpp"    /* woop::Level */
-#include "glm/vec2.hpp" /* glm::vec2 */
-#include "GLFW/glfw3.h" /* GLFWwindow */
+#include "camera.hpp"    /* woop::Camera */
+#include "collision.hpp" /* woop::Body, woop::Collider */
+#include "level.hpp"     /* woop::Level */
+#include "glm/vec2.hpp"  /* glm::vec2 */
+#include "GLFW/glfw3.h"  /* GLFWwindow */
 
 namespace woop {
 /**
@@ -25,21 +26,33 @@ struct PlayerConfig {
   float drag = 0.1f;
   bool enable_mouse = true;
   bool enable_flight = false;
+  // Size used for collisions with walls, floors, and ceilings
+  Body body;
 };
 
 /**
  * @brief Allows for a camera to be moved around a level with first-person
  * controls.
+ *
+ * The player is simulated in fixed ticks (see FixedTimestep). The camera
+ * isn't moved by ticks directly; interpolate() places it between the last two
+ * ticks, so motion stays smooth at any frame rate.
  */
 class Player {
  public:
   Player(Camera& camera, const Level& level, const PlayerConfig& config);
 
   /**
-   * @brief Updates the player's position and rotation.
-   * @param dt Time since last update.
+   * @brief Runs one simulation tick, updating the player's position and
+   * rotation.
+   * @param dt Length of a tick
    */
-  void update(float dt);
+  void tick(float dt);
+  /**
+   * @brief Moves the camera between the poses of the last two ticks.
+   * @param alpha How far (0 to 1) to move from the previous tick's pose
+   */
+  void interpolate(float alpha) noexcept;
 
   /**
    * @brief Returns a reference to the associated camera.
@@ -78,16 +91,23 @@ class Player {
   void do_flight(float dt);
   void do_gravity(float dt);
 
-  float get_floor_height();
-
   inline static glm::vec3 input;
 
   PlayerConfig config;
   const Subsector* current_subsector;
   const Level* level;
+  Collider collider;
   Camera& camera;
+  // Simulated pose, and the pose at the previous tick
+  glm::vec3 position;
+  float rotation;
+  glm::vec3 prev_position;
+  float prev_rotation;
   glm::vec2 horiz_vel;
   float vert_vel;
+  // Floor and ceiling around the player, as of the last check
+  float floor_height;
+  float ceiling_height;
   bool is_subsector_dirty;
 };
 }  // namespace woop
\ No newline at end of file
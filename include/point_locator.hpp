@@ -0,0 +1,114 @@
+/**
+ * @file point_locator.hpp
+ * @authors quak
+ * @brief Declares the PointLocator class, which finds the subsectors
+ * containing points by walking from nearby subsectors.
+ */
+
+#pragma once
+
+#include "bsp.hpp"      /* woop::Node */
+#include "span.hpp"     /* woop::Span */
+#include "glm/vec2.hpp" /* glm::vec2, glm::dvec2 */
+#include <cstdint>      /* uint32_t */
+#include <vector>       /* std::vector */
+
+namespace woop {
+class Level;
+struct Subsector;
+
+/**
+ * @brief Finds the subsector containing a point, starting from a subsector
+ * near it (e.g. the one found for the same object last time).
+ *
+ * Each subsector's BSP region is a convex polygon, bounded by some of the
+ * partition lines above it. A point is still inside the hint if it lies on
+ * the subsector's side of each of those lines. Otherwise, the locator walks
+ * into the neighboring region across the edge between the region's center
+ * and the point, and tries again. Points that are far from the hint (e.g.
+ * after teleporting) fall back to descending the whole tree.
+ *
+ * Results match Level::get_subsector(), since regions are tested with the
+ * same partition tests as the descent.
+ */
+class PointLocator {
+ public:
+  // Subsectors to walk through before giving up and descending the tree
+  static constexpr unsigned max_walk_steps = 16;
+
+  PointLocator();
+  /**
+   * @brief Computes the regions of a level's subsectors, and the neighbors
+   * across each of their edges. The level must outlive the locator.
+   */
+  explicit PointLocator(const Level& level);
+
+  /**
+   * @brief Returns the subsector containing a point, by descending the BSP
+   * tree.
+   */
+  const Subsector& locate(const glm::vec2& point) const;
+  /**
+   * @brief Returns the subsector containing a point, walking to it from a
+   * hint.
+   */
+  const Subsector& locate(const glm::vec2& point, const Subsector& hint) const;
+  /**
+   * @brief Finds the subsectors containing many points at once (e.g. every
+   * thing in a level). Points are visited in spatial order, so that each one
+   * is walked to from a nearby point.
+   * @param out Receives the subsector of each point; must be as long as
+   * points
+   */
+  void locate(Span<const glm::vec2> points,
+              Span<const Subsector*> out) const;
+
+ private:
+  /**
+   * @brief A part of an edge that borders a single neighboring region.
+   */
+  struct Piece {
+    glm::vec2 start;
+    glm::vec2 end;
+    uint32_t neighbor;
+  };
+  /**
+   * @brief An edge of a region, which lies on a node's partition line. The
+   * region is on the given side of the line.
+   */
+  struct Edge {
+    const Node* node;
+    Node::Child child;
+    uint32_t first_piece;
+    uint32_t piece_count;
+  };
+  /**
+   * @brief A subsector's BSP region. Regions with no area (left by
+   * degenerate partitions) are never walked through.
+   */
+  struct Region {
+    glm::vec2 center;
+    uint32_t first_edge;
+    uint32_t edge_count;
+    bool valid;
+  };
+
+  /**
+   * @brief Adds the pieces of an edge that border each region below a node's
+   * child, found by following the edge moved by an offset down the tree.
+   */
+  void add_pieces(const Node& node,
+                  Node::Child child,
+                  const glm::dvec2& start,
+                  const glm::dvec2& end,
+                  const glm::dvec2& offset);
+
+  const Level* level;
+  // Box around the level; points outside it are always found by descent
+  glm::vec2 bounds_min;
+  glm::vec2 bounds_max;
+  std::vector<Region> regions;
+  std::vector<Edge> edges;
+  std::vector<Piece> pieces;
+};
+}  // namespace woop
@@ -0,0 +1,171 @@
+/**
+ * @file post_process.hpp
+ * @authors quak
+ * @brief Declares the PostChain class, which runs a sequence of
+ * post-processing shaders over the output image.
+ */
+
+#pragma once
+
+#include "gpu_timer.hpp" /* woop::GpuTimer */
+#include "shader.hpp"    /* woop::Shader */
+#include "glad/glad.h"   /* OpenGL */
+#include "glm/vec2.hpp"  /* glm::vec2, glm::uvec2 */
+#include "glm/vec3.hpp"  /* glm::vec3 */
+#include <cstddef>       /* offsetof */
+#include <filesystem>    /* std::filesystem::path */
+#include <string>        /* std::string */
+#include <vector>        /* std::vector */
+
+namespace woop {
+/**
+ * @brief Configuration data for a single post-processing pass.
+ */
+struct PostPassConfig {
+  // Shown next to the pass's GPU time in render statistics
+  std::string name = "pass";
+  std::filesystem::path vert_path = "assets/shaders/vert.glsl";
+  std::filesystem::path frag_path = "assets/shaders/frag.glsl";
+  // Size of the pass's output, relative to the output image
+  float scale = 1.0f;
+};
+
+/**
+ * @brief Per-frame engine data shared by every post-processing shader through
+ * a uniform buffer. Shaders can read it by declaring:
+ *
+ *   layout(std140) uniform WoopEngine {
+ *     vec2 resolution;
+ *     vec2 image_size;
+ *     vec3 camera_position;
+ *     float time;
+ *     float camera_rotation;
+ *     float camera_fov;
+ *   } engine;
+ */
+struct EngineUniforms {
+  static constexpr const char* block_name = "WoopEngine";
+  static constexpr GLuint binding = 0;
+
+  // Size of the window's framebuffer, in pixels
+  glm::vec2 resolution;
+  // Size of the output image, in pixels
+  glm::vec2 image_size;
+  glm::vec3 camera_position;
+  // Time in seconds
+  float time;
+  float camera_rotation;
+  float camera_fov;
+  // std140 rounds the block's size up to a multiple of 16 bytes
+  float padding[2];
+};
+static_assert(offsetof(EngineUniforms, camera_position) == 16 &&
+                  offsetof(EngineUniforms, time) == 28 &&
+                  offsetof(EngineUniforms, camera_rotation) == 32 &&
+                  sizeof(EngineUniforms) == 48,
+              "EngineUniforms must match the std140 layout of WoopEngine");
+
+/**
+ * @brief Handles to the uniforms set automatically on post-processing and
+ * display shaders (see PostChain).
+ */
+struct PostUniforms {
+  PostUniforms() = default;
+  /**
+   * @brief Looks up the uniforms, and binds the shader's WoopEngine block.
+   */
+  explicit PostUniforms(const Shader& shader);
+
+  Uniform<int> texture;
+  Uniform<int> source;
+  Uniform<glm::vec2> resolution;
+  Uniform<glm::vec2> texel_size;
+  Uniform<float> time;
+};
+
+/**
+ * @brief Runs post-processing passes in order, each reading the previous
+ * pass's output and writing to an offscreen framebuffer. The display rect
+ * then draws the last output to the screen with its own shader.
+ *
+ * Passes at the same scale ping-pong between two framebuffers, so a chain
+ * needs at most two framebuffers per distinct scale. Each pass is given these
+ * uniforms:
+ * - u_texture: Output of the previous pass (or the output image)
+ * - u_source: The output image, before any post-processing
+ * - u_resolution: Size of the pass's output, in pixels
+ * - u_texel_size: Size of one texel of u_texture, in UV units
+ * - u_time: Time in seconds, as passed to run()
+ * Engine data is also available through the WoopEngine uniform block (see
+ * EngineUniforms).
+ */
+class PostChain {
+ public:
+  /**
+   * @param texture_unit Texture unit u_texture is bound to. u_source uses the
+   * next one.
+   */
+  PostChain(const std::vector<PostPassConfig>& passes,
+            glm::uvec2 image_size,
+            unsigned texture_unit);
+  PostChain(const PostChain& other) = delete;
+  ~PostChain();
+
+  PostChain& operator=(const PostChain& other) = delete;
+
+  /**
+   * @brief Runs every pass over a texture of the output image's size.
+   * Expects the display rect's vertex array to be bound.
+   * @return Texture holding the final pass's output, or source if there are
+   * no passes
+   */
+  GLuint run(GLuint source, float time);
+
+  /**
+   * @brief Returns the size of the texture returned by the last run().
+   */
+  glm::uvec2 get_output_size() const noexcept { return output_size; }
+
+  bool empty() const noexcept { return passes.empty(); }
+  std::size_t get_pass_count() const noexcept { return passes.size(); }
+  const std::string& get_pass_name(std::size_t pass) const noexcept {
+    return passes[pass].name;
+  }
+  /**
+   * @brief Returns the GPU time of a pass, in milliseconds. Lags a few frames
+   * behind (see GpuTimer).
+   */
+  double get_pass_time(std::size_t pass) const noexcept {
+    return passes[pass].timer.get_ms();
+  }
+
+ private:
+  struct Target {
+    GLuint framebuffer;
+    GLuint texture;
+    glm::uvec2 size;
+  };
+  struct Pass {
+    std::string name;
+    Shader shader;
+    glm::uvec2 size;
+    // Target written by the pass
+    std::size_t target;
+    PostUniforms uniforms;
+    GpuTimer timer;
+  };
+
+  /**
+   * @brief Creates the framebuffers needed by every pass. Consecutive passes
+   * of the same size alternate between two targets.
+   */
+  void assign_targets();
+  std::size_t add_target(glm::uvec2 size);
+
+  std::vector<Pass> passes;
+  std::vector<Target> targets;
+  glm::uvec2 image_size;
+  glm::uvec2 output_size;
+  unsigned texture_unit;
+};
+}  // namespace woop
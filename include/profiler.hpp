@@ -0,0 +1,143 @@
+/**
+ * @file profiler.hpp
+ * @authors quak
+ * @brief Declares a lightweight scoped profiler. Zones are recorded into
+ * per-thread ring buffers, and can be exported as a Chrome trace
+ * (chrome://tracing, https://ui.perfetto.dev) for a range of frames.
+ *
+ * Zones are placed with the WOOP_PROFILE_SCOPE macro, which compiles to
+ * nothing unless WOOP_ENABLE_PROFILING is defined.
+ */
+
+#pragma once
+
+#include "exception.hpp" /* woop::Exception */
+#include <cstdint>       /* uint32_t, uint64_t */
+#include <filesystem>    /* std::filesystem::path */
+#include <string>        /* std::string */
+
+#ifdef WOOP_ENABLE_PROFILING
+#define WOOP_PROFILE_CONCAT_IMPL(a, b) a##b
+#define WOOP_PROFILE_CONCAT(a, b) WOOP_PROFILE_CONCAT_IMPL(a, b)
+/**
+ * @brief Profiles the rest of the current scope. Names must be string
+ * literals (or otherwise outlive the profiler).
+ */
+#define WOOP_PROFILE_SCOPE(name) \
+  ::woop::ProfileZone WOOP_PROFILE_CONCAT(woop_profile_zone_, __LINE__)(name)
+#else
+#define WOOP_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
+
+namespace woop {
+/**
+ * @brief Exception thrown when the profiler encounters an error.
+ */
+class ProfilerException : public Exception {
+ public:
+  /**
+   * @brief Describes the type of error encountered.
+   */
+  enum class Type {
+    FileError,
+  };
+
+  ProfilerException(Type type, const std::string_view& what)
+      : Exception(what), t(type) {}
+  Type type() const noexcept { return t; }
+
+ private:
+  Type t;
+};
+
+/**
+ * @brief Configuration data for trace exports.
+ */
+struct ProfilerConfig {
+  // Where to write the trace. No trace is written if this is empty.
+  std::filesystem::path trace_path = "";
+  // First and last frames (inclusive) to include in the trace
+  uint64_t first_frame = 0;
+  uint64_t last_frame = 0;
+};
+
+/**
+ * @brief A single completed zone.
+ */
+struct ProfileEvent {
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+  uint64_t frame;
+  uint32_t depth;
+};
+
+/**
+ * @brief Records the time between its construction and destruction as a zone.
+ * @note Prefer WOOP_PROFILE_SCOPE, which can be compiled out.
+ */
+class ProfileZone {
+ public:
+  ProfileZone(const char* name) noexcept;
+  ProfileZone(const ProfileZone& other) = delete;
+  ~ProfileZone();
+
+  ProfileZone& operator=(const ProfileZone& other) = delete;
+
+ private:
+  const char* name;
+  uint64_t start;
+  uint64_t frame;
+  uint32_t depth;
+};
+
+/**
+ * @brief Global access to recorded zones.
+ */
+class Profiler {
+ public:
+  /**
+   * @brief Number of zones each thread keeps before overwriting the oldest.
+   */
+  static constexpr std::size_t buffer_capacity = 1 << 16;
+
+  /**
+   * @brief Marks the start of a new frame. Zones are tagged with the frame
+   * they started in.
+   */
+  static void next_frame() noexcept;
+  /**
+   * @brief Returns the current frame number.
+   */
+  static uint64_t get_frame() noexcept;
+  /**
+   * @brief Returns the time since the profiler was first used, in nanoseconds.
+   */
+  static uint64_t get_time() noexcept;
+
+  /**
+   * @brief Writes all recorded zones between two frames (inclusive) to a file
+   * in Chrome's trace_event format.
+   */
+  static void write_trace(const std::filesystem::path& path,
+                          uint64_t first_frame,
+                          uint64_t last_frame);
+  /**
+   * @brief Discards all recorded zones.
+   */
+  static void clear() noexcept;
+
+ private:
+  friend ProfileZone;
+
+  /**
+   * @brief Adds a completed zone to the calling thread's buffer. Threads
+   * whose buffer couldn't be allocated drop their zones.
+   */
+  static void record(const ProfileEvent& event) noexcept;
+  /**
+   * @brief Returns the calling thread's current zone depth.
+   */
+  static uint32_t& get_depth() noexcept;
+};
+}  // namespace woop
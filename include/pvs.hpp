@@ -0,0 +1,99 @@
+/**
+ * @file pvs.hpp
+ * @authors quak
+ * @brief Declares the Pvs class, which stores which subsectors of a level can
+ * possibly be seen from each other.
+ */
+
+#pragma once
+
+#include <cstdint>    /* uint32_t, uint64_t */
+#include <filesystem> /* std::filesystem::path */
+#include <optional>   /* std::optional */
+#include <utility>    /* std::pair */
+#include <vector>     /* std::vector */
+
+namespace woop {
+class Level;
+class ThreadPool;
+
+/**
+ * @brief A potentially visible set: for every subsector, the subsectors that
+ * might be seen from somewhere inside it.
+ *
+ * Sets are computed offline by flowing sight through the portals between
+ * subsectors (two-sided lines, and the partition lines that split sectors
+ * into subsectors), ignoring heights. Results are conservative: a subsector
+ * missing from a set can never be seen, but some subsectors in a set might be
+ * hidden in practice.
+ */
+class Pvs {
+ public:
+  /**
+   * @brief Statistics about a computed set.
+   */
+  struct Stats {
+    std::size_t subsectors = 0;
+    std::size_t portals = 0;
+    // Average number of subsectors visible from each subsector
+    double average_visible = 0.0;
+  };
+
+  Pvs();
+
+  /**
+   * @brief Computes the set for a level, spreading the work across a thread
+   * pool.
+   */
+  static Pvs compute(const Level& level, ThreadPool& pool);
+
+  /**
+   * @brief Reads a level's set from a cache directory. Returns nothing if it
+   * isn't cached, or was computed for different geometry.
+   */
+  static std::optional<Pvs> load(const std::filesystem::path& cache,
+                                 const Level& level);
+  /**
+   * @brief Writes the set to a cache directory, where load() can find it for
+   * the same level. Returns false if it couldn't be written.
+   */
+  bool save(const std::filesystem::path& cache, const Level& level) const;
+
+  /**
+   * @brief Returns true if the set holds no data (e.g. it hasn't been
+   * computed).
+   */
+  bool is_empty() const noexcept { return subsector_count == 0; }
+  /**
+   * @brief Returns true if a subsector might be seen from another.
+   */
+  bool is_visible(std::size_t from, std::size_t to) const noexcept {
+    return (bits[from * row_words + to / 64] >> (to % 64)) & 1;
+  }
+  /**
+   * @brief Returns true if any subsector below a BSP node might be seen from a
+   * subsector.
+   */
+  bool is_node_visible(std::size_t from, std::size_t node) const noexcept;
+
+  const Stats& get_stats() const noexcept { return stats; }
+
+ private:
+  /**
+   * @brief Allocates an empty set, and finds the range of subsectors below
+   * each of the level's nodes.
+   */
+  void init(const Level& level);
+  void count_visible() noexcept;
+
+  std::size_t subsector_count;
+  // 64-bit words in each subsector's row of bits
+  std::size_t row_words;
+  std::vector<uint64_t> bits;
+  // First and last subsector below each node. Level loaders number subsectors
+  // in tree order, so these ranges rarely hold subsectors of other subtrees
+  // (which only makes culling less effective).
+  std::vector<std::pair<uint32_t, uint32_t>> node_ranges;
+  Stats stats;
+};
+}  // namespace woop
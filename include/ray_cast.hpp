@@ -0,0 +1,131 @@
+/**
+ * @file ray_cast.hpp
+ * @authors quak
+ * @brief Declares the RayCaster class, which traces rays and lines of sight
+ * through a level.
+ */
+
+#pragma once
+
+#include "level.hpp"    /* woop::Level, woop::Seg, woop::Subsector */
+#include "span.hpp"     /* woop::Span */
+#include "glm/vec2.hpp" /* glm::vec2, glm::dvec2 */
+
+namespace woop {
+class ThreadPool;
+
+/**
+ * @brief A line segment through a level, from a start point and height to an
+ * end point and height.
+ */
+struct Ray {
+  glm::vec2 start;
+  glm::vec2 end;
+  float start_z = 0.0f;
+  float end_z = 0.0f;
+};
+
+/**
+ * @brief The first surface that a ray ran into, if any.
+ */
+struct RayHit {
+  enum class Surface {
+    None,
+    // A one-sided wall
+    Wall,
+    // The parts of a two-sided line above and below its opening
+    Upper,
+    Lower,
+    Floor,
+    Ceiling,
+  };
+
+  bool is_hit() const noexcept { return surface != Surface::None; }
+
+  Surface surface = Surface::None;
+  // How far along the ray the hit is, from 0 (its start) to 1 (its end)
+  float fraction = 1.0f;
+  glm::vec2 position = glm::vec2(0.0f);
+  float z = 0.0f;
+  // The seg that was hit, for walls, uppers, and lowers
+  const Seg* seg = nullptr;
+  // The subsector the ray was in when it hit
+  const Subsector* subsector = nullptr;
+};
+
+/**
+ * @brief Traces rays through a level, stopping at the first wall, floor, or
+ * ceiling in their way.
+ *
+ * Rays walk the BSP tree front to back (splitting at each partition they
+ * cross), so only the segs of subsectors along a ray are tested, and the
+ * search stops at the first subsector with a hit. Two-sided lines let rays
+ * through their opening (between the higher floor and the lower ceiling of
+ * their sectors), and block them above and below it. Like vanilla, impassable
+ * lines don't block sight.
+ */
+class RayCaster {
+ public:
+  explicit RayCaster(const Level& level);
+
+  /**
+   * @brief Returns the first surface that a ray hits.
+   */
+  RayHit cast(const Ray& ray) const;
+  /**
+   * @brief Traces many rays at once. Results are written to hits, which must
+   * be as long as rays.
+   */
+  void cast(Span<const Ray> rays, Span<RayHit> hits) const;
+  /**
+   * @brief Traces many rays at once, spread across a thread pool.
+   */
+  void cast(Span<const Ray> rays, Span<RayHit> hits, ThreadPool& pool) const;
+
+  /**
+   * @brief Returns true if nothing blocks the line between two points. Sectors
+   * that the level's REJECT table or PVS mark as hidden from each other are
+   * rejected without tracing.
+   */
+  bool has_line_of_sight(const glm::vec2& from,
+                         float from_z,
+                         const glm::vec2& to,
+                         float to_z) const;
+
+  void set_level(const Level& lvl) noexcept { level = &lvl; }
+
+ private:
+  /**
+   * @brief State of a single ray being traced.
+   */
+  struct Trace {
+    glm::dvec2 start;
+    glm::dvec2 delta;
+    double start_z;
+    double delta_z;
+    // Fractions of the ray that correspond to one map unit along it
+    double epsilon;
+    RayHit hit;
+  };
+
+  /**
+   * @brief Traces the part of a ray between two fractions through a node's
+   * child. Returns true once something is hit.
+   */
+  bool cross_child(const Node& node,
+                   Node::Child child,
+                   double from,
+                   double to,
+                   Trace& trace) const;
+  bool cross_node(const Node& node,
+                  double from,
+                  double to,
+                  Trace& trace) const;
+  bool cross_subsector(const Subsector& subsector,
+                       double from,
+                       double to,
+                       Trace& trace) const;
+
+  const Level* level;
+};
+}  // namespace woop
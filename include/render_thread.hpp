@@ -0,0 +1,102 @@
+/**
+ * @file render_thread.hpp
+ * @authors quak
+ * @brief Declares the RenderThread class, which draws frames on a worker
+ * thread while the main thread uploads and presents them.
+ */
+
+#pragma once
+
+#include "renderer.hpp"   /* woop::Renderer, woop::RenderStats */
+#include "spsc_queue.hpp" /* woop::SpscQueue */
+#include <atomic>             /* std::atomic */
+#include <condition_variable> /* std::condition_variable */
+#include <exception>          /* std::exception_ptr */
+#include <mutex>              /* std::mutex */
+#include <thread>             /* std::thread */
+#include <vector>             /* std::vector */
+
+namespace woop {
+/**
+ * @brief Pipelines rendering: a worker thread draws frames into CPU buffers
+ * while the thread that owns the OpenGL context only uploads and presents
+ * them. Drawing frame N+1 then overlaps with uploading frame N and waiting
+ * for vsync.
+ *
+ * Buffers cycle through lock-free queues (free -> pending -> ready -> free).
+ * More frames in flight allow more overlap, at the cost of latency.
+ *
+ * @note The renderer's settings and the level must not change while frames
+ * are in flight. Cameras are copied when a frame is submitted.
+ */
+class RenderThread {
+ public:
+  /**
+   * @param frames_in_flight Number of frames that can be queued or drawn at
+   * once (at least 1). Each has its own image buffer.
+   */
+  RenderThread(Renderer& renderer, unsigned frames_in_flight = 2);
+  RenderThread(const RenderThread& other) = delete;
+  ~RenderThread();
+
+  RenderThread& operator=(const RenderThread& other) = delete;
+
+  /**
+   * @brief Queues a frame of the level, as currently seen by the renderer's
+   * cameras. If every buffer is in use, presents finished frames until one is
+   * free.
+   */
+  void submit(const Level& level);
+  /**
+   * @brief Uploads and shows the oldest finished frame. Rethrows exceptions
+   * thrown while drawing.
+   * @param wait Whether to wait for a frame to finish if none are ready
+   * @return True if a frame was presented
+   */
+  bool present(bool wait = false);
+  /**
+   * @brief Presents every frame that's still in flight.
+   */
+  void flush();
+
+  unsigned get_frames_in_flight() const noexcept {
+    return static_cast<unsigned>(slots.size());
+  }
+
+ private:
+  /**
+   * @brief A buffer that frames are drawn to, along with what to draw.
+   */
+  struct Slot {
+    std::vector<Pixel> image;
+    std::vector<Camera> cameras;
+    const Level* level;
+    RenderStats stats;
+  };
+
+  /**
+   * @brief Wakes the thread waiting on a condition variable, after a slot has
+   * been pushed to the queue it waits for.
+   */
+  void notify(std::condition_variable& cv);
+  /**
+   * @brief Loop run by the worker thread.
+   */
+  void work();
+
+  Renderer& renderer;
+  std::vector<Slot> slots;
+  SpscQueue<std::size_t> free_slots;
+  SpscQueue<std::size_t> pending_slots;
+  SpscQueue<std::size_t> ready_slots;
+  std::thread worker;
+  // Only used to sleep while queues are empty
+  std::mutex mutex;
+  std::condition_variable pending_cv;
+  std::condition_variable ready_cv;
+  std::exception_ptr exception;
+  std::atomic<bool> stopping;
+  // Frames submitted but not yet presented
+  unsigned in_flight;
+};
+}  // namespace woop
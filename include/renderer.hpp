@@ -10,19 +10,26 @@
 #include "camera.hpp"       /* woop::Camera */
 #include "window.hpp"       /* woop::Window */
 #include "level.hpp"        /* woop::Level */
+#include "sprite.hpp"       /* woop::SpriteSet */
+#include "light_table.hpp"  /* woop::LightTable */
+#include "pixel.hpp"        /* woop::Pixel */
 #include "display_rect.hpp" /* woop::DisplayRect */
+#include "frame_arena.hpp"  /* woop::FrameArena, woop::ArenaVector */
+#include "thread_pool.hpp"  /* woop::ThreadPool */
 #include "exception.hpp"    /* woop::Exception */
 #include "glad/glad.h"      /* OpenGL functions */
 #include "glm/vec2.hpp"     /* glm::vec2 */
+#include <memory>           /* std::unique_ptr */
+#include <mutex>            /* std::mutex */
 #include <optional>         /* std::optional */
+#include <string>           /* std::string */
+#include <unordered_map>    /* std::unordered_map */
+#include <vector>           /* std::vector */
 
 namespace woop {
+class Frame;
 class Renderer;
-
-/**
- * @brief Pixel data in woop (4 bytes, 0->255)
- */
-using Pixel = glm::vec<4, std::byte>;
+class RenderThread;
 
 /**
  * @brief Describes how an image should be drawn.
@@ -38,52 +45,210 @@ struct UnsignedRange {
 };
 
 /**
- * @brief Manages all draw calls for a single frame. When destroyed, draws the
- * frame to the screen.
+ * @brief The shades of each texture on a sidedef.
  */
-class Frame {
- public:
-  Frame(const Frame& other) = delete;
-  Frame(Frame&& other);
-  ~Frame();
+struct SidedefRamps {
+  const ColorRamp* middle;
+  const ColorRamp* lower;
+  const ColorRamp* upper;
+};
 
-  Frame& operator=(const Frame& other) = delete;
+/**
+ * @brief A sprite that has been projected to the screen, waiting to be drawn
+ * once all walls are done.
+ */
+struct VisSprite {
+  const SpriteFrame* frame;
+  const Patch* patch;
+  const ColorRamp* ramp;
+  bool flipped;
+  DrawMode mode;
+  UnsignedRange columns;
+  // Screen plane position of the patch's left edge
+  float screen_left;
+  float scale;
+  int16_t light_level;
+  // Heights of the patch's top and bottom edges
+  float top;
+  float bottom;
+};
+
+/**
+ * @brief A visible fragment of a drawn wall, which clips the sprites behind
+ * it (like Doom's drawsegs).
+ */
+struct DrawSeg {
+  UnsignedRange columns;
+  // Index of the fragment's first column in the view's wall clips
+  std::size_t clip_offset;
+};
+
+/**
+ * @brief The scale a wall was drawn at in a column, and the rows of the
+ * column still visible once it was drawn.
+ */
+struct WallClip {
+  float scale;
+  UnsignedRange rows;
+};
+
+/**
+ * @brief Counters describing the work done to draw a single frame.
+ */
+struct RenderStats {
+  // BSP nodes traversed
+  unsigned nodes_visited = 0;
+  // BSP nodes skipped because the image was already complete
+  unsigned nodes_culled = 0;
+  // BSP nodes skipped because the PVS hides every subsector below them
+  unsigned nodes_pvs_culled = 0;
+  // Subsectors skipped because REJECT or the PVS hides them from the camera
+  unsigned subsectors_rejected = 0;
+  // Segs submitted for drawing
+  unsigned segs_tested = 0;
+  // Segs rejected because they face away from the camera
+  unsigned segs_backfacing = 0;
+  // Segs that had to be clipped to the view frustum
+  unsigned segs_clipped = 0;
+  // Segs hidden entirely behind previously drawn solid walls
+  unsigned segs_occluded = 0;
+  // Sprites drawn (at least partially visible things)
+  unsigned sprites_drawn = 0;
+  // Columns drawn to, counting a column once per seg
+  unsigned columns_drawn = 0;
+  // Pixels written, counting a pixel once per write
+  std::size_t pixels_written = 0;
+  // Largest size reached by the occlusion list
+  std::size_t occlusion_list_size = 0;
+  // Pixels written per pixel of the output image
+  float overdraw = 0.0f;
+  // Bytes of scratch data allocated from the frame arena
+  std::size_t arena_bytes = 0;
+  // Global heap allocations made while drawing (only counted when built with
+  // WOOP_TRACK_ALLOCATIONS)
+  uint64_t heap_allocations = 0;
 
   /**
-   * @brief Clears the frame, setting all pixels to the same color.
+   * @brief Adds another view's statistics to these. Overdraw isn't added.
    */
-  void clear(const Pixel& color);
+  RenderStats& operator+=(const RenderStats& other) noexcept;
   /**
-   * @brief Draws a node to the frame.
+   * @brief Returns a human-readable summary of the statistics, one per line.
+   */
+  std::string to_string() const;
+};
+
+/**
+ * @brief Everything that determines the image of a view. Views with equal
+ * states look the same, so the previous image can be shown again.
+ */
+struct ViewState {
+  glm::vec3 camera_position;
+  float camera_rotation;
+  float fov;
+  glm::uvec2 resolution;
+  uint64_t level_revision;
+  // Tick of animated state (e.g. sector lights), if any
+  uint64_t tick;
+
+  bool operator==(const ViewState& other) const noexcept;
+  bool operator!=(const ViewState& other) const noexcept {
+    return !(*this == other);
+  }
+};
+
+/**
+ * @brief Region of the output image that a view is drawn to, in pixels. Rows
+ * increase from the bottom of the image.
+ */
+struct Viewport {
+  glm::uvec2 offset;
+  glm::uvec2 size;
+};
+
+/**
+ * @brief Draws what a single camera sees to its viewport of a frame. Views of
+ * a frame only share read-only data, so each can be drawn on its own thread.
+ */
+class View {
+ public:
+  View(const View& other) = delete;
+  View(View&& other) = default;
+
+  View& operator=(const View& other) = delete;
+
+  /**
+   * @brief Draws a node to the view.
    */
   void draw(DrawMode mode, const Node& node);
   /**
-   * @brief Draws a subsector to the frame.
+   * @brief Draws a subsector to the view.
    */
   void draw(DrawMode mode, const Subsector& subsector);
   /**
-   * @brief Draws a segg to the frame
+   * @brief Draws a segg to the view
    */
   void draw(DrawMode mode, const Seg& seg);
 
+  const Camera& get_camera() const noexcept { return camera; }
+  const Viewport& get_viewport() const noexcept { return viewport; }
+  /**
+   * @brief Returns the distance from the screen plane to the camera.
+   * The screen plane is the view-space plane where 1 unit = 1 screen column.
+   */
+  float get_screen_plane_distance() const noexcept {
+    return screen_plane_distance;
+  }
+  /**
+   * @brief Returns statistics about the work done to draw the view so far.
+   */
+  const RenderStats& get_stats() const noexcept { return stats; }
+
  private:
-  friend Renderer;
-  Frame(Renderer& renderer);
+  friend Frame;
+  View(Renderer& renderer,
+       Camera& camera,
+       const Viewport& viewport,
+       FrameArena& arena,
+       Pixel* buffer);
 
   /**
-   * @brief Returns true if all columns of the output image have been drawn to.
+   * @brief Resets the view, so that every column can be drawn to again.
+   */
+  void clear();
+  /**
+   * @brief Sets every pixel of the viewport to the same color.
+   */
+  void fill(const Pixel& color);
+  /**
+   * @brief Makes the view skip the parts of a level that its visibility data
+   * (REJECT, and the PVS if it has one) hides from the camera. Pass nullptr
+   * to draw everything.
+   */
+  void set_cull_level(const Level* level);
+  /**
+   * @brief Returns true if nothing more can be drawn to any column of the
+   * view.
    */
   bool is_image_done() const noexcept;
+  /**
+   * @brief Marks a column as closed, so that nothing more is drawn to it. A
+   * column closes when a solid wall covers it, or when the openings of
+   * two-sided walls narrow its visible rows down to nothing.
+   */
+  void close_column(unsigned column) noexcept;
 
   /**
    * @brief Inserts a range of columns into the occlusion buffer.
    */
   void insert_occluded_range(unsigned start, unsigned end) noexcept;
   /**
-   * @brief Returns the collection of visible fragments of the given seg.
+   * @brief Finds the visible fragments of the given seg. Overwrites the
+   * contents of out.
    */
-  std::vector<UnsignedRange> get_visible_subsegs(unsigned start,
-                                                 unsigned end) noexcept;
+  void get_visible_subsegs(unsigned start,
+                           unsigned end,
+                           ArenaVector<UnsignedRange>& out);
   /**
    * @brief Clips a seg so that both of its endpoints are visible. Modifies both
    * of the given values.
@@ -102,6 +267,30 @@ class Frame {
       const glm::vec2& start_2,
       const glm::vec2& end_2) noexcept;
 
+  /**
+   * @brief Projects the things in a subsector, to be drawn once all walls
+   * are done.
+   */
+  void project_things(DrawMode mode, const Subsector& subsector);
+  /**
+   * @brief Projects a single thing standing in the given sector.
+   */
+  void project_thing(DrawMode mode, const Thing& thing, const Sector& sector);
+  /**
+   * @brief Draws all projected sprites from back to front, then forgets them.
+   */
+  void draw_sprites();
+  /**
+   * @brief Groups the clips of every wall drawn so far by column, so sprites
+   * only visit the walls in their own columns.
+   */
+  void index_wall_clips();
+  /**
+   * @brief Draws a single projected sprite, clipped in each column by the
+   * walls in front of it there.
+   */
+  void draw_sprite(const VisSprite& sprite);
+
   /**
    * @brief Draws the child of a node.
    */
@@ -112,27 +301,20 @@ class Frame {
    */
   void draw_subsegs(DrawMode mode,
                     const Seg& seg,
-                    const std::vector<UnsignedRange>& subsegs,
+                    const ArenaVector<UnsignedRange>& subsegs,
                     const glm::vec2& start,
                     const glm::vec2& end);
 
   /**
-   * @brief Maps the pixel buffer in OpenGL, allowing data to be written.
-   */
-  void map_buffer();
-  /**
-   * @brief Updates the texture that the output image is bound to.
-   */
-  void update_display_texture();
-  /**
-   * @brief Returns the pixel at the given coordinates.
+   * @brief Returns the pixel at the given coordinates of the viewport.
    */
   Pixel& get_buffer_element(unsigned x, unsigned y);
-
   /**
    * @brief Draws a solid column to the screen.
    */
-  void draw_column_solid(unsigned column, const UnsignedRange& rows);
+  void draw_column_solid(unsigned column,
+                         const UnsignedRange& rows,
+                         const Pixel& color);
 
   /**
    * @brief Returns true if a seg can be seen from the player's current
@@ -140,6 +322,12 @@ class Frame {
    */
   bool is_seg_visible(const glm::vec2& start,
                       const glm::vec2& end) const noexcept;
+  /**
+   * @brief Returns true if a seg faces away from the camera (the camera is
+   * behind the seg's sidedef). Points are in world space.
+   */
+  bool is_seg_backfacing(const glm::vec2& start,
+                         const glm::vec2& end) const noexcept;
   /**
    * @brief Returns true if a seg is opaque.
    */
@@ -183,16 +371,142 @@ class Frame {
    */
   UnsignedRange clip_row_range(unsigned column, const UnsignedRange& range);
   /**
-   * @brief Returns the color associated with a texture name.
+   * @brief Returns the shades of a sidedef's textures. Sidedefs of the level
+   * being culled against use the ramps looked up before drawing it.
+   */
+  SidedefRamps get_sidedef_ramps(const Sidedef& sidedef);
+  /**
+   * @brief Returns the shades of a thing's sprite frame, like
+   * get_sidedef_ramps().
    */
-  Pixel get_texture_color(const std::string& name, float fog);
+  const ColorRamp& get_thing_ramp(const Thing& thing, const SpriteFrame& frame);
+  /**
+   * @brief Returns the shade to draw with, given a sector's light level and
+   * the scale that a point is drawn at.
+   */
+  uint8_t get_shade(int light_level, float scale) const noexcept;
 
   Renderer& renderer;
-  std::vector<UnsignedRange> visible_rows;
-  std::list<UnsignedRange> occluded_cols;
-  DisplayRect& display_rect;
   Camera& camera;
+  Viewport viewport;
+  RenderStats stats;
+  // Scratch data, allocated from the view's frame arena
+  ArenaVector<UnsignedRange> visible_rows;
+  // Sorted, non-overlapping ranges of columns hidden by solid walls
+  ArenaVector<UnsignedRange> occluded_cols;
+  // Visible fragments of the seg or sprite currently being drawn
+  ArenaVector<UnsignedRange> visible_ranges;
+  // Number of columns that can still be drawn to
+  unsigned open_columns;
+  ArenaVector<VisSprite> vissprites;
+  // Fragments of every wall drawn, front to back, and their clips in each
+  // column they cover
+  ArenaVector<DrawSeg> drawsegs;
+  ArenaVector<WallClip> wall_clips;
+  // The same clips grouped by column (still front to back), and where each
+  // column's clips start. Rebuilt before sprites are drawn.
+  ArenaVector<WallClip> column_clips;
+  ArenaVector<std::size_t> column_clip_offsets;
+  Pixel* buffer;
+  float screen_plane_distance;
+  // Converts scales to the resolution and FOV that light tables expect
+  float light_scale;
+  // Level being culled (nullptr if disabled), its PVS, and the indices of the
+  // sector and subsector containing the camera
+  const Level* cull_level;
+  const Pvs* pvs;
+  std::size_t camera_sector;
+  std::size_t camera_subsector;
+};
+
+/**
+ * @brief Manages all draw calls for a single frame, which holds a view for
+ * each of the renderer's cameras. When destroyed, draws the frame to the
+ * screen.
+ */
+class Frame {
+ public:
+  Frame(const Frame& other) = delete;
+  Frame(Frame&& other);
+  ~Frame();
+
+  Frame& operator=(const Frame& other) = delete;
+
+  /**
+   * @brief Clears the frame, setting all pixels to the same color.
+   */
+  void clear(const Pixel& color);
+  /**
+   * @brief Draws a node (and the things within it) to every view. Views are
+   * drawn in parallel unless their viewports overlap.
+   */
+  void draw(DrawMode mode, const Node& node);
+  /**
+   * @brief Draws a whole level to every view. Unlike drawing its root node,
+   * this skips subsectors that the level's REJECT data and PVS hide from each
+   * camera (unless disabled with RendererConfig::reject_culling and
+   * RendererConfig::pvs_culling). Texture colors are also looked up once per
+   * level, rather than by every view for each seg and sprite.
+   */
+  void draw(DrawMode mode, const Level& level);
+
+  /**
+   * @brief Returns the number of views in the frame (none if the frame shows
+   * the previous image again).
+   */
+  std::size_t get_view_count() const noexcept { return views.size(); }
+  /**
+   * @brief Returns a view of the frame, which can be drawn to separately.
+   * Things drawn this way appear once the frame ends.
+   */
+  View& get_view(std::size_t index);
+
+ private:
+  friend Renderer;
+  /**
+   * @param reused Whether the frame shows the previous image again instead of
+   * drawing (draw calls are ignored)
+   */
+  Frame(Renderer& renderer, bool reused = false);
+  /**
+   * @brief Creates a frame that draws to a CPU buffer instead of the screen.
+   * No OpenGL calls are made, so it can be drawn on any thread.
+   * @param target Buffer the size of the output image
+   * @param cameras Camera of each of the renderer's views
+   * @param stats_out Receives the frame's statistics once it ends
+   */
+  Frame(Renderer& renderer,
+        Pixel* target,
+        Camera* cameras,
+        RenderStats& stats_out);
+
+  /**
+   * @brief Maps the pixel buffer in OpenGL, allowing data to be written.
+   */
+  void map_buffer();
+  /**
+   * @brief Creates a view for each of the renderer's view slots.
+   * @param cameras Replaces the slots' cameras, if not null
+   */
+  void create_views(Camera* cameras);
+  /**
+   * @brief Records the frame's heap allocations in its statistics. Under
+   * WOOP_TRACK_ALLOCATIONS, asserts that drawing didn't allocate unless the
+   * renderer's caches or arenas had to grow.
+   */
+  void check_allocations() noexcept;
+
+  Renderer& renderer;
+  RenderStats stats;
+  ArenaVector<View> views;
+  // Allocation count and cache size when the frame began
+  uint64_t start_allocations;
+  std::size_t start_ramp_count;
+  DisplayRect& display_rect;
   Pixel* buffer;
+  // Set for frames drawn to CPU buffers
+  RenderStats* stats_out;
+  bool reused;
   bool invalid;
 };
 
@@ -223,12 +537,29 @@ struct RendererConfig {
     std::string vert_src = "";
     std::string frag_src = "";
   } shaders;
+  // Post-processing passes run before the shaders above (see PostChain)
+  std::vector<PostPassConfig> post_passes;
   glm::uvec2 resolution = {320, 200};
   Pixel clear_color = Pixel{0, 0, 0, 255};
-  Pixel fill_color = Pixel{255, 255, 255, 255};
   Pixel fog_color = clear_color;
   float fog_strength = 0.75f;
   unsigned texture_unit = 0;
+  // Whether render statistics are drawn over the output image
+  bool show_stats = false;
+  // Whether frames with an unchanged view show the previous image again
+  bool reuse_frames = true;
+  // Whether views with separate viewports are drawn on worker threads
+  bool parallel_views = true;
+  // Whether levels skip subsectors that their REJECT lump hides from the
+  // camera. Some maps edit REJECT to change how monsters behave, which can
+  // make visible walls disappear.
+  bool reject_culling = true;
+  // Whether levels with a PVS (see Pvs) skip the BSP subtrees it hides from
+  // the camera
+  bool pvs_culling = true;
+  // Frames drawn ahead on a render thread (see RenderThread), or 0 to draw
+  // on the main thread
+  unsigned frames_in_flight = 0;
 };
 
 /**
@@ -237,6 +568,10 @@ struct RendererConfig {
  */
 class Renderer {
  public:
+  /**
+   * @param camera Camera of the first view, which covers the whole output
+   * image
+   */
   Renderer(Window& window,
            Camera& camera,
            const RendererConfig& cfg = RendererConfig{});
@@ -245,6 +580,13 @@ class Renderer {
    * @brief Creates a new frame to be drawn to the screen.
    */
   Frame begin_frame();
+  /**
+   * @brief Creates a new frame showing the given level. If nothing affecting
+   * the image changed since the last frame (see ViewState), the frame shows
+   * the previous image again and ignores draw calls.
+   * @param tick Tick of the level's animated state
+   */
+  Frame begin_frame(const Level& level, uint64_t tick = 0);
 
   /**
    * @brief Returns the size of the output image.
@@ -258,47 +600,57 @@ class Renderer {
    * @brief Returns the OpenGL texture unit that the output image is bound to.
    */
   unsigned get_texture_unit() const noexcept;
+
   /**
-   * @brief Returns the distance from the screen plane to the camera.
-   * The screen plane is the view-space plane where 1 unit = 1 screen column.
+   * @brief Adds a view, drawing what a camera sees to a region of the output
+   * image. Views are drawn in the order they're added, so later views appear
+   * on top (e.g. picture-in-picture).
+   * @return Index of the new view
    */
-  float get_screen_plane_distance() const noexcept {
-    return screen_plane_distance;
-  }
+  std::size_t add_view(Camera& camera, const Viewport& viewport);
   /**
-   * @brief Sets the renderer's fill color.
+   * @brief Moves a view to another region of the output image.
    */
-  void set_fill_color(const Pixel& color) noexcept {
-    config.fill_color = color;
-  }
+  void set_viewport(std::size_t view, const Viewport& viewport);
+  /**
+   * @brief Removes a view. Views after it move down by one index.
+   */
+  void remove_view(std::size_t view);
+  /**
+   * @brief Returns the number of views drawn each frame.
+   */
+  std::size_t get_view_count() const noexcept { return views.size(); }
+  /**
+   * @brief Returns the region of the output image that a view is drawn to.
+   */
+  const Viewport& get_viewport(std::size_t view) const;
   /**
-   * @brief Returns the renderer's fill color.
+   * @brief Returns the camera that a view is drawn from.
    */
-  Pixel get_fill_color() const noexcept { return config.fill_color; }
+  const Camera& get_camera(std::size_t view) const;
   /**
    * @brief Sets the renderer's clear color.
    */
   void set_clear_color(const Pixel& color) noexcept {
     config.clear_color = color;
+    last_views.clear();
   }
   /**
    * @brief Returns the renderer's clear color.
    */
   Pixel get_clear_color() const noexcept { return config.clear_color; }
   /**
-   * @brief Sets the renderer's fog color.
+   * @brief Sets the renderer's fog color. Rebuilds the light table.
    */
-  void set_fog_color(const Pixel& color) noexcept { config.fog_color = color; }
+  void set_fog_color(const Pixel& color);
   /**
    * @brief Returns the renderer's fog color.
    */
   Pixel get_fog_color() const noexcept { return config.fog_color; }
   /**
-   * @brief Sets the renderer's fog strength.
+   * @brief Sets the renderer's fog strength. Rebuilds the light table.
    */
-  void set_fog_strength(float strength) noexcept {
-    config.fog_strength = strength;
-  }
+  void set_fog_strength(float strength);
   /**
    * @brief Returns the renderer's fog color.
    */
@@ -309,8 +661,64 @@ class Renderer {
   }
   Shader& get_shader() noexcept { return display_rect.get_shader(); }
 
+  /**
+   * @brief Sets the table used to light the level (e.g. one built from a
+   * wad's COLORMAP). Fog settings replace it with a fog-based table.
+   */
+  void set_light_table(const LightTable& table);
+  /**
+   * @brief Returns the table used to light the level.
+   */
+  const LightTable& get_light_table() const noexcept { return light_table; }
+
+  /**
+   * @brief Sets the sprites used to draw things. Things aren't drawn until
+   * sprites are set.
+   */
+  void set_sprites(const SpriteSet& new_sprites) noexcept {
+    sprites = &new_sprites;
+    last_views.clear();
+  }
+
+  /**
+   * @brief Returns the arena that frames allocate their views from. Each view
+   * has its own arena for scratch data.
+   */
+  const FrameArena& get_arena() const noexcept { return arena; }
+
+  /**
+   * @brief Returns statistics about the last frame that was drawn, summed
+   * over its views.
+   */
+  const RenderStats& get_stats() const noexcept { return stats; }
+  /**
+   * @brief Sets whether render statistics are drawn over the output image.
+   */
+  void set_show_stats(bool show) noexcept {
+    config.show_stats = show;
+    last_views.clear();
+  }
+  /**
+   * @brief Returns true if render statistics are drawn over the output image.
+   */
+  bool get_show_stats() const noexcept { return config.show_stats; }
+  /**
+   * @brief Returns the number of frames that showed the previous image again
+   * instead of being drawn.
+   */
+  uint64_t get_reused_frame_count() const noexcept { return reused_frames; }
+  /**
+   * @brief Returns the number of frames that should be drawn ahead on a
+   * render thread, or 0 if frames should be drawn on the main thread.
+   */
+  unsigned get_frames_in_flight() const noexcept {
+    return config.frames_in_flight;
+  }
+
  private:
   friend Frame;
+  friend View;
+  friend RenderThread;
 
   /**
    * @brief Generates the front and back PBOs with OpenGL.
@@ -328,13 +736,89 @@ class Renderer {
    * @brief Swaps the front and back PBOs.
    */
   void swap_pbos() noexcept;
+  /**
+   * @brief Creates a frame without touching the saved view states.
+   */
+  Frame start_frame();
+  /**
+   * @brief Creates a frame that draws to a CPU buffer (see Frame).
+   */
+  Frame start_offscreen_frame(Pixel* target,
+                              Camera* cameras,
+                              RenderStats& stats_out);
+  /**
+   * @brief Uploads an image the size of the output image, then presents it.
+   */
+  void present_image(const Pixel* image, const RenderStats& frame_stats);
+  /**
+   * @brief Publishes a frame's statistics, updates the display texture from
+   * the back PBO, then draws it to the window.
+   */
+  void present(const RenderStats& frame_stats);
+  /**
+   * @brief Returns the current state of a view of the given level.
+   */
+  ViewState get_view_state(std::size_t view,
+                           const Level& level,
+                           uint64_t tick) const noexcept;
+  /**
+   * @brief Returns true if any two viewports overlap, in which case views
+   * have to be drawn in order.
+   */
+  bool do_viewports_overlap() const noexcept;
+  /**
+   * @brief Throws if a viewport doesn't fit within the output image.
+   */
+  void check_viewport(const Viewport& viewport) const;
+  /**
+   * @brief Returns every shade of the color associated with a texture name.
+   * Locks the texture caches.
+   */
+  const ColorRamp& get_texture_ramp(const std::string& name);
+  /**
+   * @brief Looks up the ramps of every sidedef and thing in a level, unless
+   * they're up to date. Called before views draw the level, so that they
+   * don't take the texture lock (or hash names) for every seg and sprite.
+   */
+  void resolve_ramps(const Level& level);
+
+  /**
+   * @brief A camera, the region it's drawn to, and the arena its views
+   * allocate scratch data from.
+   */
+  struct ViewSlot {
+    Camera* camera;
+    Viewport viewport;
+    std::unique_ptr<FrameArena> arena;
+  };
 
   RendererConfig config;
   Window& window;
-  Camera& camera;
+  std::vector<ViewSlot> views;
   DisplayRect display_rect;
+  const SpriteSet* sprites;
+  LightTable light_table;
+  // Base color of each texture, and every shade of it
+  std::unordered_map<std::string, Pixel> texture_colors;
+  std::unordered_map<std::string, ColorRamp> texture_ramps;
+  // Guards the texture caches, which views fill while drawing
+  std::mutex texture_mutex;
+  // Ramps of each sidedef and thing (nullptr if it has no sprite) in the
+  // level of the given revision (0 if none), drawn with the given sprites
+  std::vector<SidedefRamps> sidedef_ramps;
+  std::vector<const ColorRamp*> thing_ramps;
+  uint64_t ramp_revision;
+  const SpriteSet* ramp_sprites;
+  // Reset at the start of each frame
+  FrameArena arena;
+  RenderStats stats;
+  // State of each view in the last frame drawn with a level (empty if it
+  // can't be reused)
+  std::vector<ViewState> last_views;
+  uint64_t reused_frames;
+  // Draws views in parallel
+  std::unique_ptr<ThreadPool> thread_pool;
   unsigned pbo_back;
   unsigned pbo_front;
-  float screen_plane_distance;
 };
 }  // namespace woop
\ No newline at end of file
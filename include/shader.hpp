@@ -5,8 +5,11 @@
 #include "glm/vec2.hpp"  /* glm::vec2 */
 #include "glm/vec3.hpp"  /* glm::vec3 */
 #include "glm/vec4.hpp"  /* glm::vec4 */
+#include <cstddef>       /* std::size_t */
+#include <cstdint>       /* uint64_t */
 #include <string>        /* std::string */
 #include <filesystem>    /* std::filesystem::Path */
+#include <unordered_map> /* std::unordered_map */
 
 namespace woop {
 class ShaderException : public Exception {
@@ -26,6 +29,37 @@ class ShaderException : public Exception {
   Type t;
 };
 
+class Shader;
+
+/**
+ * @brief Handle to a uniform of a linked shader, looked up once so that
+ * setting it needs no string lookups. Handles to uniforms the shader doesn't
+ * use are inactive, and setting them does nothing.
+ *
+ * @note Handles are tied to the shader's program. Look them up again if the
+ * shader is replaced.
+ */
+template <typename T>
+class Uniform {
+ public:
+  Uniform() : program(0), location(-1) {}
+
+  bool is_active() const noexcept { return location >= 0; }
+
+  /**
+   * @brief Sets the uniform. The shader doesn't need to be in use.
+   */
+  void set(const T& value) const noexcept;
+
+ private:
+  friend Shader;
+
+  Uniform(GLuint prog, GLint loc) : program(prog), location(loc) {}
+
+  GLuint program;
+  GLint location;
+};
+
 /**
  * @brief Represents an OpenGL shader.
  */
@@ -42,6 +76,17 @@ class Shader {
   static Shader from_file(const std::filesystem::path& vert_path,
                           const std::filesystem::path& frag_path);
 
+  /**
+   * @brief Sets the directory linked programs are cached in. Shaders created
+   * afterwards load a cached binary if one matches their sources and the
+   * current driver, and only compile if none does. An empty path disables
+   * the cache.
+   */
+  static void set_binary_cache(const std::filesystem::path& directory);
+  static const std::filesystem::path& get_binary_cache() noexcept {
+    return binary_cache;
+  }
+
   void set_uniform(const std::string& name, bool v) const;
   void set_uniform(const std::string& name, int v) const;
   void set_uniform(const std::string& name, unsigned v) const;
@@ -50,17 +95,122 @@ class Shader {
   void set_uniform(const std::string& name, const glm::vec3& vec) const;
   void set_uniform(const std::string& name, const glm::vec4& vec) const;
 
+  /**
+   * @brief Returns a handle to a uniform, which is inactive if the shader
+   * doesn't use it. Prefer keeping handles over calling set_uniform() every
+   * frame.
+   */
+  template <typename T>
+  Uniform<T> get_uniform(const std::string& name) const {
+    return Uniform<T>(get_program(), get_uniform_location(name));
+  }
+  /**
+   * @brief Returns the location of a uniform, or -1 if the shader doesn't use
+   * it. Locations are cached when the shader is linked, so this never asks
+   * the driver.
+   */
+  GLint get_uniform_location(const std::string& name) const;
+  /**
+   * @brief Binds a uniform block to a uniform buffer binding point. Does
+   * nothing if the shader doesn't use the block.
+   * @return True if the shader uses the block
+   */
+  bool bind_uniform_block(const std::string& name, GLuint binding) const;
+
   void use() const;
 
   bool is_valid() const noexcept { return !invalid; }
+  /**
+   * @brief Returns the underlying program object. Throws if the shader has
+   * been invalidated.
+   */
+  GLuint get_program() const;
 
  private:
+  /**
+   * @brief Loads a program from the binary cache, or compiles and caches it.
+   */
+  static GLuint load_or_compile(const std::string& vert_src,
+                                const std::string& frag_src);
   static GLuint compile(const std::string& vert_src,
-                        const std::string& frag_src);
+                        const std::string& frag_src,
+                        bool retrievable = false);
+  /**
+   * @brief Returns a hash of a program's sources and the driver that builds
+   * it. Binaries built by other drivers (or versions) can't be loaded.
+   */
+  static uint64_t get_binary_key(const std::string& vert_src,
+                                 const std::string& frag_src);
+  static std::filesystem::path get_binary_path(uint64_t key);
+  /**
+   * @brief Returns a program loaded from the cache, or 0 if there's no
+   * usable cached binary.
+   */
+  static GLuint load_binary(uint64_t key) noexcept;
+  static void save_binary(GLuint program, uint64_t key) noexcept;
   static void check_shader_compile_success(GLuint shader);
   static void check_program_link_success(GLuint program);
 
+  /**
+   * @brief Caches the location of every active uniform. Arrays can be looked
+   * up both as "name" and "name[0]".
+   */
+  void cache_uniforms();
+
+  inline static std::filesystem::path binary_cache;
+
   bool invalid;
   GLuint program;
+  std::unordered_map<std::string, GLint> uniforms;
+};
+
+template <>
+void Uniform<bool>::set(const bool& v) const noexcept;
+template <>
+void Uniform<int>::set(const int& v) const noexcept;
+template <>
+void Uniform<unsigned>::set(const unsigned& v) const noexcept;
+template <>
+void Uniform<float>::set(const float& v) const noexcept;
+template <>
+void Uniform<glm::vec2>::set(const glm::vec2& v) const noexcept;
+template <>
+void Uniform<glm::vec3>::set(const glm::vec3& v) const noexcept;
+template <>
+void Uniform<glm::vec4>::set(const glm::vec4& v) const noexcept;
+
+/**
+ * @brief A uniform buffer object bound to a fixed binding point. Shaders read
+ * it through a uniform block with the std140 layout, so data shared by many
+ * shaders is uploaded once instead of once per uniform per shader.
+ */
+class UniformBuffer {
+ public:
+  UniformBuffer(std::size_t size, GLuint binding);
+  UniformBuffer(const UniformBuffer& other) = delete;
+  ~UniformBuffer();
+
+  UniformBuffer& operator=(const UniformBuffer& other) = delete;
+
+  /**
+   * @brief Uploads part of the buffer's contents.
+   */
+  void update(const void* data, std::size_t size, std::size_t offset = 0);
+  /**
+   * @brief Uploads a whole struct, which must match the block's std140
+   * layout.
+   */
+  template <typename T>
+  void update(const T& data) {
+    update(&data, sizeof(T));
+  }
+
+  std::size_t get_size() const noexcept { return size; }
+  GLuint get_binding() const noexcept { return binding; }
+
+ private:
+  GLuint buffer;
+  std::size_t size;
+  GLuint binding;
 };
 }  // namespace woop
\ No newline at end of file
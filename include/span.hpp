@@ -0,0 +1,40 @@
+/**
+ * @file span.hpp
+ * @authors quak
+ * @brief Declares the Span class, a non-owning view of contiguous elements.
+ */
+
+#pragma once
+
+#include <cstddef> /* std::size_t */
+
+namespace woop {
+/**
+ * @brief A pointer and a length, viewing elements owned by something else
+ * (usually one row of a compressed sparse row array). Spans don't keep their
+ * elements alive, and become invalid when the owner reallocates them.
+ */
+template <typename T>
+class Span {
+ public:
+  constexpr Span() noexcept : first(nullptr), count(0) {}
+  constexpr Span(T* data, std::size_t size) noexcept
+      : first(data), count(size) {}
+
+  constexpr T* begin() const noexcept { return first; }
+  constexpr T* end() const noexcept { return first + count; }
+  constexpr T* data() const noexcept { return first; }
+  constexpr std::size_t size() const noexcept { return count; }
+  constexpr bool empty() const noexcept { return count == 0; }
+
+  constexpr T& operator[](std::size_t index) const noexcept {
+    return first[index];
+  }
+  constexpr T& front() const noexcept { return first[0]; }
+  constexpr T& back() const noexcept { return first[count - 1]; }
+
+ private:
+  T* first;
+  std::size_t count;
+};
+}  // namespace woop
@@ -0,0 +1,171 @@
+/**
+ * @file sprite.hpp
+ * @authors quak
+ * @brief Declares the Patch and SpriteSet classes, which decode the sprites
+ * stored between a wad's S_START and S_END markers.
+ *
+ * See the wiki for details on the picture format and sprite naming:
+ * https://doomwiki.org/wiki/Picture_format
+ * https://doomwiki.org/wiki/Sprite
+ */
+
+#pragma once
+
+#include "exception.hpp" /* woop::Exception */
+#include "wad.hpp"       /* woop::Wad, woop::Lump */
+#include <array>         /* std::array */
+#include <cstdint>       /* int16_t */
+#include <string>        /* std::string */
+#include <unordered_map> /* std::unordered_map */
+#include <vector>        /* std::vector */
+
+namespace woop {
+/**
+ * @brief Exception thrown when a sprite can't be decoded.
+ */
+class SpriteException : public Exception {
+ public:
+  /**
+   * @brief Details the cause of the exception.
+   */
+  enum class Type {
+    InvalidPatch,
+  };
+
+  SpriteException(Type type, const std::string_view& what = "SpriteException")
+      : Exception(what), t(type) {}
+
+  /**
+   * @brief Returns the type of exception that was thrown
+   */
+  Type type() const noexcept { return t; }
+
+ private:
+  Type t;
+};
+
+/**
+ * @brief A decoded picture. Texels are palette indices, stored column by
+ * column from the top of the picture.
+ */
+class Patch {
+ public:
+  /**
+   * @brief Value of transparent texels.
+   */
+  static constexpr int16_t transparent = -1;
+
+  /**
+   * @brief Decodes a patch from a lump in Doom's picture format.
+   */
+  Patch(const Lump& lump);
+
+  const std::string& get_name() const noexcept { return name; }
+  int16_t get_width() const noexcept { return width; }
+  int16_t get_height() const noexcept { return height; }
+  /**
+   * @brief Returns the horizontal offset of the patch's origin from its left
+   * edge.
+   */
+  int16_t get_left_offset() const noexcept { return left_offset; }
+  /**
+   * @brief Returns the vertical offset of the patch's origin from its top edge.
+   */
+  int16_t get_top_offset() const noexcept { return top_offset; }
+
+  /**
+   * @brief Returns the texel at the given column and row (from the top), or
+   * Patch::transparent. Coordinates must be within the patch.
+   */
+  int16_t get_texel(unsigned x, unsigned y) const noexcept {
+    return texels[x * static_cast<unsigned>(height) + y];
+  }
+
+ private:
+  std::string name;
+  int16_t width;
+  int16_t height;
+  int16_t left_offset;
+  int16_t top_offset;
+  std::vector<int16_t> texels;
+};
+
+/**
+ * @brief A single frame of a sprite, seen from eight angles. Rotation 0 (named
+ * "1" in lumps) shows the front of the sprite.
+ */
+struct SpriteFrame {
+  std::string sprite;
+  std::array<const Patch*, 8> patches;
+  // Whether each patch should be mirrored horizontally
+  std::array<bool, 8> flipped;
+};
+
+/**
+ * @brief Describes the sprite that represents a type of thing.
+ */
+struct ThingSprite {
+  int16_t type;
+  const char* sprite;
+  char frame;
+  // Whether the thing hangs from the ceiling, rather than standing on the floor
+  bool hanging;
+};
+
+/**
+ * @brief All sprites found in a wad, indexed by name and frame.
+ */
+class SpriteSet {
+ public:
+  SpriteSet();
+  /**
+   * @brief Loads all sprites from a wad.
+   */
+  SpriteSet(const Wad& wad);
+  SpriteSet(const SpriteSet& other) = delete;
+
+  SpriteSet& operator=(const SpriteSet& other) = delete;
+
+  /**
+   * @brief Loads all sprites from a wad. Wads without sprites produce an empty
+   * set.
+   */
+  void open(const Wad& wad);
+  /**
+   * @brief Removes all loaded sprites.
+   */
+  void close() noexcept;
+
+  /**
+   * @brief Returns the given frame of a sprite (e.g. "TROO", 'A'), or nullptr
+   * if it doesn't exist.
+   */
+  const SpriteFrame* get_frame(const std::string& sprite, char frame) const;
+  /**
+   * @brief Returns the frame used to draw a thing, or nullptr if the thing has
+   * no sprite.
+   */
+  const SpriteFrame* get_frame(const ThingSprite& thing_sprite) const;
+  /**
+   * @brief Returns the number of decoded patches.
+   */
+  std::size_t get_num_patches() const noexcept { return patches.size(); }
+
+  /**
+   * @brief Returns the sprite used by a type of thing, or nullptr if the type
+   * is unknown or never drawn (e.g. player starts).
+   */
+  static const ThingSprite* get_thing_sprite(int16_t type) noexcept;
+
+ private:
+  /**
+   * @brief Registers a patch with every frame and rotation named by its lump.
+   */
+  void add_patch(const Patch& patch);
+
+  // Patches are stored separately from frames so that frames can refer to the
+  // same patch more than once (mirrored rotations).
+  std::vector<Patch> patches;
+  std::unordered_map<std::string, SpriteFrame> frames;
+};
+}  // namespace woop
@@ -0,0 +1,75 @@
+/**
+ * @file spsc_queue.hpp
+ * @authors quak
+ * @brief Declares the SpscQueue class, a bounded lock-free queue with a single
+ * producer and a single consumer.
+ */
+
+#pragma once
+
+#include <atomic>  /* std::atomic */
+#include <cstddef> /* std::size_t */
+#include <vector>  /* std::vector */
+
+namespace woop {
+/**
+ * @brief Fixed-size ring buffer that one thread pushes to while another pops
+ * from, without locking. Neither operation allocates or blocks.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  SpscQueue(std::size_t capacity)
+      : slots(capacity + 1), head(0), tail(0) {}
+  SpscQueue(const SpscQueue& other) = delete;
+
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+
+  /**
+   * @brief Adds a value to the back of the queue. Only call from the producer.
+   * @return False if the queue is full
+   */
+  bool push(const T& value) {
+    std::size_t back = tail.load(std::memory_order_relaxed);
+    std::size_t next = advance(back);
+    if (next == head.load(std::memory_order_acquire))
+      return false;
+    slots[back] = value;
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+  /**
+   * @brief Removes the value at the front of the queue. Only call from the
+   * consumer.
+   * @return False if the queue is empty
+   */
+  bool pop(T& out) {
+    std::size_t front = head.load(std::memory_order_relaxed);
+    if (front == tail.load(std::memory_order_acquire))
+      return false;
+    out = slots[front];
+    head.store(advance(front), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Returns true if the queue was empty when checked.
+   */
+  bool empty() const noexcept {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+  std::size_t capacity() const noexcept { return slots.size() - 1; }
+
+ private:
+  std::size_t advance(std::size_t index) const noexcept {
+    return (index + 1) % slots.size();
+  }
+
+  // One slot is always left empty, to tell a full queue from an empty one
+  std::vector<T> slots;
+  // Kept on separate cache lines, as each is written by a different thread
+  alignas(64) std::atomic<std::size_t> head;
+  alignas(64) std::atomic<std::size_t> tail;
+};
+}  // namespace woop
@@ -0,0 +1,98 @@
+/**
+ * @file task_graph.hpp
+ * @authors quak
+ * @brief Declares the TaskGraph class, which runs jobs that depend on each
+ * other across a ThreadPool, timing each one.
+ */
+
+#pragma once
+
+#include "exception.hpp" /* woop::Exception */
+#include <cstddef>       /* std::size_t */
+#include <functional>    /* std::function */
+#include <vector>        /* std::vector */
+
+namespace woop {
+class ThreadPool;
+
+/**
+ * @brief Exception thrown when a task graph encounters an error.
+ */
+class TaskGraphException : public Exception {
+ public:
+  /**
+   * @brief Details the cause of the exception.
+   */
+  enum class Type {
+    InvalidDependency,
+  };
+
+  TaskGraphException(Type type, const std::string_view& what)
+      : Exception(what), t(type) {}
+  Type type() const noexcept { return t; }
+
+ private:
+  Type t;
+};
+
+/**
+ * @brief When a task of a TaskGraph ran, relative to the start of the graph.
+ */
+struct TaskTiming {
+  const char* name;
+  double start_ms;
+  double duration_ms;
+};
+
+/**
+ * @brief A set of named tasks, each of which starts once every task it
+ * depends on has finished. Tasks that don't depend on each other run in
+ * parallel, so with enough threads a graph takes about as long as its longest
+ * chain of dependent tasks, rather than the sum of all of them.
+ */
+class TaskGraph {
+ public:
+  using TaskId = std::size_t;
+
+  /**
+   * @brief Adds a task, returning its ID. Tasks can only depend on tasks
+   * added before them, so graphs never have cycles. Throws a
+   * TaskGraphException on any other dependency.
+   * @param name Name of the task. Must be a string literal (or otherwise
+   * outlive the graph), like profiler zone names.
+   */
+  TaskId add_task(const char* name,
+                  std::function<void()> fn,
+                  const std::vector<TaskId>& dependencies = {});
+
+  /**
+   * @brief Runs every task on the pool's workers and the calling thread,
+   * blocking until all of them have finished. If a task throws, tasks that
+   * haven't started yet are skipped, and the first exception is rethrown once
+   * the running ones have finished.
+   * @note Loops that tasks start on the same pool run serially.
+   */
+  void run(ThreadPool& pool);
+
+  /**
+   * @brief Returns when each task ran during the last run(), in the order
+   * they were added. Skipped tasks have a duration of 0.
+   */
+  const std::vector<TaskTiming>& get_timings() const noexcept {
+    return timings;
+  }
+  std::size_t get_task_count() const noexcept { return tasks.size(); }
+
+ private:
+  struct Task {
+    const char* name;
+    std::function<void()> fn;
+    // Tasks that depend on this one
+    std::vector<TaskId> dependents;
+    unsigned dependency_count;
+  };
+
+  std::vector<Task> tasks;
+  std::vector<TaskTiming> timings;
+};
+}  // namespace woop
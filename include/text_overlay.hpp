@@ -0,0 +1,66 @@
+/**
+ * @file text_overlay.hpp
+ * @authors quak
+ * @brief Declares the TextOverlay class, which draws a small block of text
+ * over the output image (e.g. render statistics).
+ */
+
+#pragma once
+
+#include "shader.hpp"   /* woop::Shader */
+#include "glad/glad.h"  /* OpenGL */
+#include "glm/vec2.hpp" /* glm::uvec2 */
+#include <cstdint>      /* uint8_t */
+#include <string>       /* std::string */
+#include <vector>       /* std::vector */
+
+namespace woop {
+class Renderer;
+/**
+ * @brief Rasterizes text with a built-in bitmap font, then draws it in the top
+ * left corner of the screen. Text is drawn at the output image's resolution, so
+ * it matches the look of the rest of the frame.
+ */
+class TextOverlay {
+ public:
+  TextOverlay(const Renderer& renderer);
+  TextOverlay(const TextOverlay& other) = delete;
+  ~TextOverlay();
+
+  TextOverlay& operator=(const TextOverlay& other) = delete;
+
+  /**
+   * @brief Sets the text to draw. Lines are separated by '\n'. Only digits,
+   * letters (drawn in uppercase), spaces and ".:/%-" are supported.
+   */
+  void set_text(const std::string& text);
+  const std::string& get_text() const noexcept { return text; }
+
+  /**
+   * @brief Draws the overlay over the current framebuffer. Does nothing if no
+   * text has been set.
+   */
+  void draw() const noexcept;
+
+ private:
+  void gen_texture();
+  void gen_quad();
+  /**
+   * @brief Rasterizes the current text and uploads it to the overlay's texture.
+   */
+  void update_texture();
+  /**
+   * @brief Draws a single glyph to the CPU-side text image.
+   */
+  void draw_glyph(char c, unsigned x, unsigned y);
+
+  const Renderer& renderer;
+  Shader shader;
+  std::string text;
+  std::vector<uint8_t> pixels;
+  glm::uvec2 size;
+  GLuint texture;
+  GLuint vbo;
+  GLuint vao;
+};
+}  // namespace woop
@@ -0,0 +1,94 @@
+/**
+ * @file thread_pool.hpp
+ * @authors quak
+ * @brief Declares the ThreadPool class, which spreads independent jobs across
+ * a fixed set of worker threads.
+ */
+
+#pragma once
+
+#include <atomic>             /* std::atomic */
+#include <condition_variable> /* std::condition_variable */
+#include <cstddef>            /* std::size_t */
+#include <exception>          /* std::exception_ptr */
+#include <mutex>              /* std::mutex */
+#include <thread>             /* std::thread */
+#include <vector>             /* std::vector */
+
+namespace woop {
+/**
+ * @brief A fixed set of worker threads that run parallel loops. Workers are
+ * started once and sleep between loops, so running a loop doesn't allocate or
+ * create threads.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param worker_count Number of threads to start. The calling thread also
+   * runs jobs, so 0 runs every loop serially.
+   */
+  ThreadPool(unsigned worker_count = get_default_worker_count());
+  ThreadPool(const ThreadPool& other) = delete;
+  ~ThreadPool();
+
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  /**
+   * @brief Calls fn(i) for every i in [0, count), spread across the workers
+   * and the calling thread. Blocks until every call has returned, then
+   * rethrows the first exception thrown by fn, if any.
+   * @note Loops started from within fn run serially on the calling thread.
+   */
+  template <typename Fn>
+  void parallel_for(std::size_t count, const Fn& fn) {
+    run(count, &call<Fn>, &fn);
+  }
+
+  unsigned get_worker_count() const noexcept {
+    return static_cast<unsigned>(workers.size());
+  }
+  /**
+   * @brief Returns one less than the number of hardware threads, so that the
+   * calling thread has a core to itself.
+   */
+  static unsigned get_default_worker_count() noexcept;
+
+ private:
+  // Type-erased job, called with a pointer to the callable
+  using Job = void (*)(const void* fn, std::size_t index);
+
+  template <typename Fn>
+  static void call(const void* fn, std::size_t index) {
+    (*static_cast<const Fn*>(fn))(index);
+  }
+
+  /**
+   * @brief Runs a loop (see parallel_for).
+   */
+  void run(std::size_t count, Job new_job, const void* fn);
+  /**
+   * @brief Loop run by each worker thread.
+   */
+  void work();
+  /**
+   * @brief Runs jobs of the current loop until none are left.
+   */
+  void run_jobs() noexcept;
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  // Current loop
+  Job job;
+  const void* job_fn;
+  std::size_t job_count;
+  std::atomic<std::size_t> next_job;
+  std::exception_ptr exception;
+  // Incremented whenever a loop starts, waking the workers
+  unsigned long generation;
+  unsigned active_workers;
+  std::atomic<bool> busy;
+  bool stopping;
+};
+}  // namespace woop
@@ -0,0 +1,113 @@
+/**
+ * @file udmf.hpp
+ * @authors quak
+ * @brief Declares the UdmfTokenizer class and parse_udmf(), which read levels
+ * stored in the Universal Doom Map Format (a TEXTMAP lump).
+ */
+
+#pragma once
+
+#include "glm/vec2.hpp" /* glm::vec2 */
+#include <cstdint>      /* int16_t, int32_t, uint32_t */
+#include <string_view>  /* std::string_view */
+#include <vector>       /* std::vector */
+
+namespace woop {
+/**
+ * @brief A token of UDMF text. Tokens view the text they were read from, so
+ * reading them never allocates.
+ */
+struct UdmfToken {
+  enum class Type {
+    End,
+    Identifier,
+    Integer,
+    Float,
+    // Quoted text. The token's text excludes the quotes, and escape sequences
+    // are left as they are.
+    String,
+    // One of '{', '}', '=', or ';'
+    Symbol,
+  };
+
+  Type type = Type::End;
+  std::string_view text;
+  // Line of the text that the token starts on, counting from 1
+  unsigned line = 1;
+};
+
+/**
+ * @brief Splits UDMF text into tokens in a single pass, skipping whitespace
+ * and comments.
+ */
+class UdmfTokenizer {
+ public:
+  explicit UdmfTokenizer(std::string_view text) noexcept;
+
+  /**
+   * @brief Returns the next token, or an End token once all text was read.
+   * Throws a LevelException on text that isn't a valid token (e.g. an
+   * unterminated string).
+   */
+  UdmfToken next();
+
+ private:
+  void skip_whitespace();
+
+  std::string_view text;
+  std::size_t position;
+  unsigned line;
+};
+
+/**
+ * @brief A level read from a TEXTMAP lump, in the "doom" namespace. Records
+ * refer to each other by index, like binary levels, but without their 16-bit
+ * limits. Names view the text that was parsed, which must outlive the map.
+ */
+struct UdmfMap {
+  struct Thing {
+    glm::vec2 position;
+    int16_t angle;
+    int16_t type;
+    // Flags, converted to the binary format's bits
+    int16_t flags;
+  };
+  struct Linedef {
+    uint32_t start_vertex;
+    uint32_t end_vertex;
+    // Flags, converted to the binary format's bits
+    int16_t flags;
+    // Index of the sidedef on each side, or -1 if the side doesn't exist
+    int32_t front_sidedef;
+    int32_t back_sidedef;
+  };
+  struct Sidedef {
+    glm::vec2 offset;
+    std::string_view upper_name;
+    std::string_view lower_name;
+    std::string_view middle_name;
+    uint32_t sector;
+  };
+  struct Sector {
+    int16_t floor_height;
+    int16_t ceiling_height;
+    std::string_view floor_texture;
+    std::string_view ceiling_texture;
+    int16_t light_level;
+  };
+
+  std::string_view name_space;
+  std::vector<Thing> things;
+  std::vector<glm::vec2> vertices;
+  std::vector<Linedef> linedefs;
+  std::vector<Sidedef> sidedefs;
+  std::vector<Sector> sectors;
+};
+
+/**
+ * @brief Parses the contents of a TEXTMAP lump. Unknown blocks and fields are
+ * skipped. Throws a LevelException naming the line of any syntax error or
+ * block missing a required field.
+ */
+UdmfMap parse_udmf(std::string_view text);
+}  // namespace woop
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <cstdint>                      /* int16_t */
+#include <cstdint>                      /* int16_t, uint64_t */
+#include <filesystem>                   /* std::filesystem::path */
+#include <initializer_list>             /* std::initializer_list */
+#include <string_view>                  /* std::string_view */
 #include "glm/ext/scalar_constants.hpp" /* glm::pi */
 
 /**
@@ -8,6 +11,30 @@
  */
 #define UNUSED_PARAMETER(param) static_cast<void>(param)
 
+/**
+ * @brief Returns the 64-bit FNV-1a hash of some data. Pass a previous hash as
+ * the seed to hash several pieces of data together.
+ */
+constexpr uint64_t fnv1a(std::string_view data,
+                         uint64_t seed = 14695981039346656037ull) {
+  uint64_t hash = seed;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * @brief Writes pieces of data to a file, one after another. They're written
+ * to a temporary file next to it first, which then replaces the file, so a
+ * crash (or another process writing the same file) never leaves a partial
+ * file behind. Returns false if the file couldn't be written.
+ */
+bool write_file_atomically(
+    const std::filesystem::path& path,
+    std::initializer_list<std::string_view> parts) noexcept;
+
 /**
  * @brief Returns true if a value is between a given lower and upper bounds.
  */
@@ -12,6 +12,8 @@
 
 #include "exception.hpp" /* woop::Exception */
 #include <cstdint>       /* int32_t */
+#include <cstring>       /* std::memcpy */
+#include <istream>       /* std::istream */
 #include <string>        /* std::string */
 #include <unordered_map> /* std::unordered_map */
 #include <vector>        /* std::vector */
@@ -116,11 +118,19 @@ class Wad {
    * @brief Opens a wad file at the given path.
    */
   Wad(const std::filesystem::path& path);
+  /**
+   * @brief Reads a wad from a binary stream (e.g. one built in memory).
+   */
+  Wad(std::istream& stream);
 
   /**
    * @brief Opens a wad file at the given path.
    */
   void open(const std::filesystem::path& path);
+  /**
+   * @brief Reads a wad from a binary stream (e.g. one built in memory).
+   */
+  void open(std::istream& stream);
   /**
    * @brief Closes the wad, releasing all data.
    */
@@ -131,6 +141,12 @@ class Wad {
    */
   std::vector<Lump>::iterator begin() noexcept { return lumps.begin(); }
   std::vector<Lump>::iterator end() noexcept { return lumps.end(); }
+  std::vector<Lump>::const_iterator begin() const noexcept {
+    return lumps.begin();
+  }
+  std::vector<Lump>::const_iterator end() const noexcept {
+    return lumps.end();
+  }
 
   /**
    * @brief Returns true if the Wad has been read from a file.
@@ -184,7 +200,7 @@ class Wad {
   /**
    * @brief Parses the header of a wad file.
    */
-  static WadHeader parse_header(std::ifstream& file);
+  static WadHeader parse_header(std::istream& file);
   /**
    * @brief Determines what type of wad was loaded from a header's type.
    */
@@ -192,18 +208,18 @@ class Wad {
   /**
    * @brief Parses the contents of a wad's directory.
    */
-  static std::vector<WadEntry> parse_directory(std::ifstream& file,
+  static std::vector<WadEntry> parse_directory(std::istream& file,
                                                const WadHeader& header);
   /**
    * @brief Runs through directory entries, copying data from the wad into lump
    * objects.
    */
-  void get_lumps_from_directory(std::ifstream& file,
+  void get_lumps_from_directory(std::istream& file,
                                 const std::vector<WadEntry>& directory);
   /**
    * @brief Searches a file for the given lump, returning its data.
    */
-  static Lump get_lump_from_entry(std::ifstream& file, const WadEntry& entry);
+  static Lump get_lump_from_entry(std::istream& file, const WadEntry& entry);
   /**
    * @brief Creates a string from a potentially non-null-terminated buffer.
    */
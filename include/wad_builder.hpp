@@ -0,0 +1,68 @@
+/**
+ * @file wad_builder.hpp
+ * @authors quak
+ * @brief Declares the WadBuilder class, which assembles wads in memory. This
+ * allows tests and benchmarks to create content without shipping a wad file.
+ */
+
+#pragma once
+
+#include "wad.hpp"    /* woop::Wad, woop::WadType */
+#include <cstddef>    /* std::byte */
+#include <cstring>    /* std::memcpy */
+#include <filesystem> /* std::filesystem::path */
+#include <ostream>    /* std::ostream */
+#include <string>     /* std::string */
+#include <vector>     /* std::vector */
+
+namespace woop {
+/**
+ * @brief Assembles a wad's lumps in memory, writing them out in the same
+ * layout that Wad reads from disk.
+ */
+class WadBuilder {
+ public:
+  WadBuilder(WadType type = WadType::Patch);
+
+  /**
+   * @brief Appends a lump containing raw bytes. Lumps without data are
+   * virtual (e.g. map markers like "E1M1").
+   */
+  WadBuilder& add_lump(const std::string& name,
+                       std::vector<std::byte> data = {});
+  /**
+   * @brief Appends a lump whose data is a tightly packed array of the given
+   * type. This is the inverse of `Lump::get_data_as`.
+   */
+  template <typename T>
+  WadBuilder& add_lump(const std::string& name, const std::vector<T>& items) {
+    std::vector<std::byte> data(items.size() * sizeof(T));
+    if (!data.empty())
+      std::memcpy(data.data(), items.data(), data.size());
+    return add_lump(name, std::move(data));
+  }
+
+  /**
+   * @brief Returns the number of lumps that have been added.
+   */
+  std::size_t get_num_lumps() const noexcept { return lumps.size(); }
+
+  /**
+   * @brief Writes the wad's header, lumps, and directory to a binary stream.
+   */
+  void write(std::ostream& stream) const;
+  /**
+   * @brief Writes the wad to a file at the given path.
+   */
+  void write(const std::filesystem::path& path) const;
+  /**
+   * @brief Serializes the wad and opens it, exactly as if it had been read
+   * from a file.
+   */
+  Wad build() const;
+
+ private:
+  WadType type;
+  std::vector<Lump> lumps;
+};
+}  // namespace woop
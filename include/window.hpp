@@ -6,11 +6,12 @@
 
 #pragma once
 
-#include "exception.hpp" /* woop::Exception */
-#include "glad/glad.h"   /* GLAD function loading */
-#include "GLFW/glfw3.h"  /* GLFW windows and events */
-#include "glm/vec2.hpp"  /* glm::ivec2 */
-#include <string>        /* std::string */
+#include "exception.hpp"     /* woop::Exception */
+#include "frame_limiter.hpp" /* woop::FrameLimiter */
+#include "glad/glad.h"       /* GLAD function loading */
+#include "GLFW/glfw3.h"      /* GLFW windows and events */
+#include "glm/vec2.hpp"      /* glm::ivec2 */
+#include <string>            /* std::string */
 
 namespace woop {
 /**
@@ -36,6 +37,19 @@ struct WindowException : public Exception {
   Type t;
 };
 
+/**
+ * @brief How buffer swaps are synchronized with the display's refresh.
+ */
+enum class VSync {
+  // Swap immediately (lowest latency, may tear)
+  Off,
+  // Wait for the next refresh
+  On,
+  // Wait for the refresh, but swap immediately if the frame is late. Falls
+  // back to On if the driver doesn't support it.
+  Adaptive,
+};
+
 /**
  * @brief Configuration data for a single window.
  */
@@ -45,6 +59,9 @@ struct WindowConfig {
   bool fullscreen = false;
   bool resizable = true;
   bool decorated = true;
+  VSync vsync = VSync::On;
+  // Frame rate cap, enforced before each swap (<= 0 for none)
+  double max_fps = 0.0;
 };
 
 /**
@@ -73,6 +90,16 @@ class Window {
 
   float get_aspect_ratio() const;
 
+  VSync get_vsync() const noexcept { return config.vsync; }
+  void set_vsync(VSync vsync) noexcept;
+
+  /**
+   * @brief Returns the limiter that paces buffer swaps, which also measures
+   * frame pacing.
+   */
+  const FrameLimiter& get_frame_limiter() const noexcept { return limiter; }
+  FrameLimiter& get_frame_limiter() noexcept { return limiter; }
+
   /**
    * @brief Returns a reference to the underlying GLFWwindow object.
    */
@@ -98,5 +125,6 @@ class Window {
 
   GLFWwindow* window;
   WindowConfig config;
+  FrameLimiter limiter;
 };
 }  // namespace woop
\ No newline at end of file
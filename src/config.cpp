@@ -44,7 +44,40 @@ woop::Level get_level(const woop::Wad& wad, const toml::table& table) {
     throw ConfigException(
         "No level given. Specify a level with \"general.level\"");
   try {
-    return woop::Level{wad, *level_name};
+    return woop::Level{wad, *level_name, get_level_config(table)};
+  } catch (woop::Exception& exception) {
+    throw ConfigException(exception.what());
+  }
+}
+
+woop::LevelConfig get_level_config(const toml::table& table) {
+  woop::LevelConfig cfg;
+  // Node building
+  if (const auto& entry = table["nodes"]["rebuild"].value<bool>())
+    cfg.rebuild_nodes = entry.value();
+  // Partition heuristics
+  auto get_cost = [&](const char* key, unsigned& cost) {
+    if (const auto& entry = table["nodes"][key].value<int64_t>()) {
+      if (entry.value() < 0)
+        throw ConfigException("nodes." + std::string(key) +
+                              " must not be negative.");
+      cost = static_cast<unsigned>(entry.value());
+    }
+  };
+  get_cost("split_cost", cfg.node_builder.split_cost);
+  get_cost("balance_cost", cfg.node_builder.balance_cost);
+  get_cost("diagonal_cost", cfg.node_builder.diagonal_cost);
+  get_cost("max_candidates", cfg.node_builder.max_candidates);
+  return cfg;
+}
+
+woop::LightTable get_light_table(const woop::Wad& wad,
+                                 const toml::table& table) {
+  woop::RendererConfig cfg = get_renderer_config(table);
+  if (!table["renderer"]["colormap"].value_or(false))
+    return woop::LightTable{cfg.fog_color, cfg.fog_strength};
+  try {
+    return woop::LightTable{wad};
   } catch (woop::Exception& exception) {
     throw ConfigException(exception.what());
   }
@@ -74,6 +107,25 @@ woop::WindowConfig get_window_config(const toml::table& table) {
   // Decorated
   if (const auto& entry = table["window"]["decorated"].value<bool>())
     cfg.decorated = entry.value();
+  // Vsync (on, off, or adaptive)
+  if (const auto& entry = table["window"]["vsync"].value<bool>()) {
+    cfg.vsync = entry.value() ? woop::VSync::On : woop::VSync::Off;
+  } else if (const auto& entry =
+                 table["window"]["vsync"].value<std::string>()) {
+    if (entry.value() == "on")
+      cfg.vsync = woop::VSync::On;
+    else if (entry.value() == "off")
+      cfg.vsync = woop::VSync::Off;
+    else if (entry.value() == "adaptive")
+      cfg.vsync = woop::VSync::Adaptive;
+    else
+      throw ConfigException(
+          "Invalid value given to \"window.vsync\" (expected \"on\", "
+          "\"off\", or \"adaptive\")");
+  }
+  // Frame rate cap
+  if (const auto& entry = table["window"]["max_fps"].value<double>())
+    cfg.max_fps = entry.value();
   return cfg;
 }
 woop::CameraConfig get_camera_config(const toml::table& table) {
@@ -99,6 +151,32 @@ woop::RendererConfig get_renderer_config(const toml::table& table) {
   if (const auto& entry =
           table["renderer"]["fragment_shader"].value<std::string>())
     cfg.shaders.frag_path = entry.value();
+  // Post-processing passes
+  if (const auto* passes = table["post_process"].as_array()) {
+    for (const auto& node : *passes) {
+      const auto* pass = node.as_table();
+      if (!pass)
+        throw ConfigException(
+            "Invalid value given to \"post_process\" (expected an array of "
+            "tables)");
+      woop::PostPassConfig pass_cfg;
+      if (const auto& entry = (*pass)["name"].value<std::string>())
+        pass_cfg.name = entry.value();
+      if (const auto& entry = (*pass)["vertex_shader"].value<std::string>())
+        pass_cfg.vert_path = entry.value();
+      if (const auto& entry = (*pass)["fragment_shader"].value<std::string>())
+        pass_cfg.frag_path = entry.value();
+      else
+        throw ConfigException("Post-processing pass \"" + pass_cfg.name +
+                              "\" has no fragment_shader");
+      if (const auto& entry = (*pass)["scale"].value<double>())
+        pass_cfg.scale = static_cast<float>(entry.value());
+      if (!(pass_cfg.scale > 0.0f))
+        throw ConfigException("Post-processing pass \"" + pass_cfg.name +
+                              "\" must have a positive scale");
+      cfg.post_passes.push_back(pass_cfg);
+    }
+  }
   // Resolution
   if (const auto* entry = table["renderer"]["resolution"].as_array()) {
     glm::ivec2 resolution;
@@ -136,8 +214,42 @@ woop::RendererConfig get_renderer_config(const toml::table& table) {
   // Fog strength
   if (const auto& entry = table["renderer"]["fog_strength"].value<double>())
     cfg.fog_strength = entry.value();
+  // Render statistics
+  if (const auto& entry = table["renderer"]["show_stats"].value<bool>())
+    cfg.show_stats = entry.value();
+  // Idle frame reuse
+  if (const auto& entry = table["renderer"]["reuse_frames"].value<bool>())
+    cfg.reuse_frames = entry.value();
+  // Multi-view rendering
+  if (const auto& entry = table["renderer"]["parallel_views"].value<bool>())
+    cfg.parallel_views = entry.value();
+  // REJECT culling
+  if (const auto& entry = table["renderer"]["reject_culling"].value<bool>())
+    cfg.reject_culling = entry.value();
+  // PVS culling
+  if (const auto& entry = table["renderer"]["pvs_culling"].value<bool>())
+    cfg.pvs_culling = entry.value();
+  // Render thread
+  if (const auto& entry =
+          table["renderer"]["frames_in_flight"].value<int64_t>()) {
+    if (entry.value() < 0)
+      throw ConfigException("renderer.frames_in_flight must not be negative.");
+    cfg.frames_in_flight = static_cast<unsigned>(entry.value());
+  }
   return cfg;
 }
+std::filesystem::path get_shader_cache(const toml::table& table) {
+  if (const auto& entry =
+          table["renderer"]["shader_cache"].value<std::string>())
+    return entry.value();
+  return {};
+}
+std::filesystem::path get_level_cache(const toml::table& table) {
+  if (const auto& entry =
+          table["renderer"]["level_cache"].value<std::string>())
+    return entry.value();
+  return {};
+}
 woop::PlayerConfig get_player_config(const toml::table& table) {
   woop::PlayerConfig cfg;
   // Height
@@ -164,6 +276,56 @@ woop::PlayerConfig get_player_config(const toml::table& table) {
   // Flight
   if (const auto& entry = table["player"]["enable_flight"].value<bool>())
     cfg.enable_flight = entry.value();
+  // Collision size
+  if (const auto& entry = table["player"]["radius"].value<double>())
+    cfg.body.radius = entry.value();
+  if (const auto& entry = table["player"]["body_height"].value<double>())
+    cfg.body.height = entry.value();
+  if (const auto& entry = table["player"]["max_step"].value<double>())
+    cfg.body.max_step = entry.value();
+  if (cfg.body.radius <= 0.0f || cfg.body.height <= 0.0f)
+    throw ConfigException("Player radius and height must be positive");
+  return cfg;
+}
+woop::TimestepConfig get_timestep_config(const toml::table& table) {
+  woop::TimestepConfig cfg;
+  // Tick rate
+  if (const auto& entry = table["simulation"]["tick_rate"].value<double>()) {
+    if (!(entry.value() > 0.0))
+      throw ConfigException("simulation.tick_rate must be positive.");
+    cfg.tick_rate = entry.value();
+  }
+  // Tick limit
+  if (const auto& entry =
+          table["simulation"]["max_ticks_per_frame"].value<int64_t>()) {
+    if (entry.value() < 1)
+      throw ConfigException(
+          "simulation.max_ticks_per_frame must be at least 1.");
+    cfg.max_ticks_per_frame = static_cast<unsigned>(entry.value());
+  }
+  return cfg;
+}
+woop::ProfilerConfig get_profiler_config(const toml::table& table) {
+  woop::ProfilerConfig cfg;
+  // Trace path
+  if (const auto& entry = table["profiler"]["trace"].value<std::string>())
+    cfg.trace_path = entry.value();
+  // Frame range
+  if (const auto* entry = table["profiler"]["frames"].as_array()) {
+    glm::ivec2 frames;
+    try {
+      frames = get_array_as_ivec2(*entry);
+    } catch (std::exception& exception) {
+      throw ConfigException(
+          "Invalid value given to \"profiler.frames\" (expected [first, "
+          "last])");
+    }
+    if (frames.x < 0 || frames.y < frames.x)
+      throw ConfigException(
+          "Profiler frame range must be positive and in increasing order.");
+    cfg.first_frame = static_cast<uint64_t>(frames.x);
+    cfg.last_frame = static_cast<uint64_t>(frames.y);
+  }
   return cfg;
 }
 }  // namespace config
\ No newline at end of file
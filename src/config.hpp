@@ -7,14 +7,16 @@
 
 #pragma once
 
-#include "window.hpp"      /* woop::Window */
-#include "camera.hpp"      /* woop::Camera */
-#include "renderer.hpp"    /* woop::Renderer */
-#include "player.hpp"      /* woop::Player */
-#include "exception.hpp"   /* woop::Exception */
-#include "wad.hpp"         /* woop::Wad */
-#include "level.hpp"       /* woop::Level */
-#include "toml++/toml.hpp" /* Configuration parsing */
+#include "window.hpp"         /* woop::Window */
+#include "camera.hpp"         /* woop::Camera */
+#include "renderer.hpp"       /* woop::Renderer */
+#include "player.hpp"         /* woop::Player */
+#include "fixed_timestep.hpp" /* woop::TimestepConfig */
+#include "exception.hpp"      /* woop::Exception */
+#include "wad.hpp"            /* woop::Wad */
+#include "level.hpp"          /* woop::Level */
+#include "profiler.hpp"       /* woop::ProfilerConfig */
+#include "toml++/toml.hpp"    /* Configuration parsing */
 
 namespace config {
 /**
@@ -34,6 +36,17 @@ woop::Wad get_wad(const toml::table& table);
  * file.
  */
 woop::Level get_level(const woop::Wad& wad, const toml::table& table);
+/**
+ * @brief Fills a level configuration with values present in a configuration
+ * file.
+ */
+woop::LevelConfig get_level_config(const toml::table& table);
+/**
+ * @brief Returns the light table specified in the renderer's configuration
+ * file (built from the wad's COLORMAP, or from fog settings).
+ */
+woop::LightTable get_light_table(const woop::Wad& wad,
+                                 const toml::table& table);
 
 /**
  * @brief Fills a window configuration with values present in a configuration
@@ -50,9 +63,29 @@ woop::CameraConfig get_camera_config(const toml::table& table);
  * file.
  */
 woop::RendererConfig get_renderer_config(const toml::table& table);
+/**
+ * @brief Returns the directory that compiled shaders are cached in, or an
+ * empty path if caching is disabled.
+ */
+std::filesystem::path get_shader_cache(const toml::table& table);
+/**
+ * @brief Returns the directory that data computed from levels (like their
+ * PVS) is cached in, or an empty path if caching is disabled.
+ */
+std::filesystem::path get_level_cache(const toml::table& table);
 /**
  * @brief Fills a player configuration with values present in a configuration
  * file.
  */
 woop::PlayerConfig get_player_config(const toml::table& table);
+/**
+ * @brief Fills a simulation timestep configuration with values present in a
+ * configuration file.
+ */
+woop::TimestepConfig get_timestep_config(const toml::table& table);
+/**
+ * @brief Fills a profiler configuration with values present in a configuration
+ * file.
+ */
+woop::ProfilerConfig get_profiler_config(const toml::table& table);
 }  // namespace config
\ No newline at end of file
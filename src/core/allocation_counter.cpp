@@ -0,0 +1,35 @@
+/**
+ * @file allocation_counter.cpp
+ * @authors quak
+ * @brief Defines members of the AllocationCounter class, and (when tracking
+ * is enabled) replaces the global operator new/delete.
+ */
+
+#include "allocation_counter.hpp"
+#include <atomic>  /* std::atomic */
+#include <cstdlib> /* std::malloc, std::free */
+#include <new>     /* std::bad_alloc */
+
+namespace woop {
+std::atomic<uint64_t> allocation_count{0};
+
+uint64_t AllocationCounter::get_count() noexcept {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+}  // namespace woop
+
+#ifdef WOOP_TRACK_ALLOCATIONS
+// Array and nothrow forms call these by default
+void* operator new(std::size_t size) {
+  woop::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file blockmap.cpp
+ * @authors quak
+ * @brief Defines members of the Blockmap class.
+ */
+
+#include "blockmap.hpp"
+#include "level.hpp"      /* woop::Linedef, woop::LevelException */
+#include "geometry.hpp"   /* woop::get_bounds */
+#include "glm/common.hpp" /* glm::floor, glm::min, glm::max */
+#include <algorithm>      /* std::min, std::max */
+
+namespace woop {
+// Marks the end of a block's line list
+constexpr uint16_t block_list_end = 0xffff;
+// Number of words in the lump's header (origin, columns, rows)
+constexpr std::size_t header_words = 4;
+
+Blockmap::Blockmap() : origin(0.0f), columns(0), rows(0), offsets(1, 0) {}
+
+Blockmap Blockmap::from_lump(const Lump& lump, std::size_t linedef_count) {
+  auto invalid = []() {
+    return LevelException(LevelException::Type::InvalidData,
+                          "Malformed BLOCKMAP lump");
+  };
+  std::vector<uint16_t> words = lump.get_data_as<uint16_t>();
+  if (words.size() < header_words)
+    throw invalid();
+
+  Blockmap blockmap;
+  blockmap.origin = {static_cast<int16_t>(words[0]),
+                     static_cast<int16_t>(words[1])};
+  blockmap.columns = words[2];
+  blockmap.rows = words[3];
+  std::size_t block_count =
+      static_cast<std::size_t>(blockmap.columns) * blockmap.rows;
+  if (words.size() < header_words + block_count)
+    throw invalid();
+
+  blockmap.offsets.reserve(block_count + 1);
+  for (std::size_t block = 0; block < block_count; ++block) {
+    // Lists start with a 0 that isn't a line (vanilla checks linedef 0 for
+    // every block because of it, ports skip it)
+    std::size_t word = words[header_words + block];
+    if (word >= words.size())
+      throw invalid();
+    if (words[word] == 0)
+      ++word;
+    for (; word < words.size() && words[word] != block_list_end; ++word) {
+      if (words[word] >= linedef_count)
+        throw invalid();
+      blockmap.lines.push_back(words[word]);
+    }
+    if (word == words.size())
+      throw invalid();
+    blockmap.offsets.push_back(static_cast<uint32_t>(blockmap.lines.size()));
+  }
+  return blockmap;
+}
+
+/**
+ * @brief Returns true if a line segment passes through a rectangle.
+ */
+static bool does_line_cross_box(const glm::vec2& start,
+                                const glm::vec2& end,
+                                const glm::vec2& min,
+                                const glm::vec2& max) noexcept {
+  if (std::max(start.x, end.x) < min.x || std::min(start.x, end.x) > max.x ||
+      std::max(start.y, end.y) < min.y || std::min(start.y, end.y) > max.y)
+    return false;
+  // The line crosses the box unless every corner is on the same side of it
+  glm::vec2 delta = end - start;
+  auto side = [&](float x, float y) {
+    return delta.x * (y - start.y) - delta.y * (x - start.x);
+  };
+  float corners[4] = {side(min.x, min.y), side(max.x, min.y),
+                      side(min.x, max.y), side(max.x, max.y)};
+  bool any_front = false;
+  bool any_back = false;
+  for (float corner : corners) {
+    any_front = any_front || corner >= 0.0f;
+    any_back = any_back || corner <= 0.0f;
+  }
+  return any_front && any_back;
+}
+
+Blockmap Blockmap::build(const std::vector<Linedef>& linedefs) {
+  Blockmap blockmap;
+  if (linedefs.empty())
+    return blockmap;
+
+  Bounds bounds = get_bounds(linedefs);
+  // Same margin as common node builders, so lines never lie on the edge
+  blockmap.origin = glm::floor(bounds.min) - 8.0f;
+  glm::vec2 extent = (bounds.max - blockmap.origin) / block_size;
+  blockmap.columns = static_cast<unsigned>(extent.x) + 1;
+  blockmap.rows = static_cast<unsigned>(extent.y) + 1;
+
+  std::vector<std::vector<uint32_t>> blocks(
+      static_cast<std::size_t>(blockmap.columns) * blockmap.rows);
+  for (std::size_t i = 0; i < linedefs.size(); ++i) {
+    const Linedef& line = linedefs[i];
+    glm::vec2 line_min = glm::min(line.start, line.end) - blockmap.origin;
+    glm::vec2 line_max = glm::max(line.start, line.end) - blockmap.origin;
+    int col_end = get_block(line_max.x, blockmap.columns);
+    int row_end = get_block(line_max.y, blockmap.rows);
+    for (int row = get_block(line_min.y, blockmap.rows); row <= row_end;
+         ++row) {
+      for (int col = get_block(line_min.x, blockmap.columns); col <= col_end;
+           ++col) {
+        glm::vec2 block_min = blockmap.origin +
+                              glm::vec2(static_cast<float>(col),
+                                        static_cast<float>(row)) *
+                                  block_size;
+        if (!does_line_cross_box(line.start, line.end, block_min,
+                                 block_min + block_size))
+          continue;
+        std::size_t block = static_cast<std::size_t>(row) * blockmap.columns +
+                            static_cast<std::size_t>(col);
+        blocks[block].push_back(static_cast<uint32_t>(i));
+      }
+    }
+  }
+
+  blockmap.offsets.reserve(blocks.size() + 1);
+  for (const auto& block : blocks) {
+    blockmap.lines.insert(blockmap.lines.end(), block.begin(), block.end());
+    blockmap.offsets.push_back(static_cast<uint32_t>(blockmap.lines.size()));
+  }
+  return blockmap;
+}
+
+std::vector<uint16_t> Blockmap::to_lump() const {
+  std::size_t block_count = static_cast<std::size_t>(columns) * rows;
+  std::vector<uint16_t> words = {
+      static_cast<uint16_t>(static_cast<int16_t>(origin.x)),
+      static_cast<uint16_t>(static_cast<int16_t>(origin.y)),
+      static_cast<uint16_t>(columns),
+      static_cast<uint16_t>(rows),
+  };
+  words.resize(header_words + block_count);
+  for (std::size_t block = 0; block < block_count; ++block) {
+    // Offsets are 16-bit word indices, which limits the size of the lump
+    if (words.size() > block_list_end || lines.size() >= block_list_end)
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Blockmap is too large for the BLOCKMAP format");
+    words[header_words + block] = static_cast<uint16_t>(words.size());
+    words.push_back(0);
+    for (uint32_t i = offsets[block]; i < offsets[block + 1]; ++i)
+      words.push_back(static_cast<uint16_t>(lines[i]));
+    words.push_back(block_list_end);
+  }
+  return words;
+}
+}  // namespace woop
@@ -0,0 +1,114 @@
+/**
+ * @file collision.cpp
+ * @authors quak
+ * @brief Defines members of the Collider class.
+ */
+
+#include "collision.hpp"
+#include "glm/common.hpp"    /* glm::clamp */
+#include "glm/geometric.hpp" /* glm::dot, glm::length, glm::normalize */
+#include <algorithm>         /* std::min, std::max */
+#include <cmath>             /* std::ceil */
+
+namespace woop {
+/**
+ * @brief Returns the squared distance between a point and a line segment.
+ */
+static float get_distance_squared(const glm::vec2& point,
+                                  const glm::vec2& start,
+                                  const glm::vec2& end) noexcept {
+  glm::vec2 line = end - start;
+  float length_squared = glm::dot(line, line);
+  float t = 0.0f;
+  if (length_squared > 0.0f)
+    t = glm::clamp(glm::dot(point - start, line) / length_squared, 0.0f, 1.0f);
+  glm::vec2 offset = point - (start + line * t);
+  return glm::dot(offset, offset);
+}
+
+Collider::Collider(const Level& lvl, const Body& b) : level(&lvl), body(b) {}
+
+PositionCheck Collider::check_position(const glm::vec2& position,
+                                       float z) const {
+  const Sector& sector = level->get_sector(position);
+  PositionCheck check;
+  check.floor = static_cast<float>(sector.floor.height);
+  check.ceiling = static_cast<float>(sector.ceiling.height);
+
+  const std::vector<Linedef>& linedefs = level->get_linedefs();
+  const float radius_squared = body.radius * body.radius;
+  level->get_blockmap().for_each_line(
+      position - body.radius, position + body.radius, [&](uint32_t index) {
+        const Linedef& line = linedefs[index];
+        if (check.blocked ||
+            get_distance_squared(position, line.start, line.end) >=
+                radius_squared)
+          return;
+        if (!line.front || !line.back || (line.flags & Linedef::Impassable)) {
+          check.blocked = true;
+          check.blocking_line = &line;
+          return;
+        }
+        // The opening between the line's two sectors
+        const Sector& front = line.front->sector_facing;
+        const Sector& back = line.back->sector_facing;
+        float top = std::min(front.ceiling.height, back.ceiling.height);
+        float bottom = std::max(front.floor.height, back.floor.height);
+        float low_floor = std::min(front.floor.height, back.floor.height);
+        if (top - bottom < body.height ||
+            top - std::max(z, bottom) < body.height ||
+            bottom - z > body.max_step ||
+            bottom - low_floor > body.max_drop_off) {
+          check.blocked = true;
+          check.blocking_line = &line;
+          return;
+        }
+        check.floor = std::max(check.floor, bottom);
+        check.ceiling = std::min(check.ceiling, top);
+      });
+  return check;
+}
+
+glm::vec2 Collider::slide_move(const glm::vec2& from,
+                               const glm::vec2& delta,
+                               float z) const {
+  float distance = glm::length(delta);
+  if (distance == 0.0f)
+    return from;
+  // Short steps, so that thin walls can't be skipped over
+  float max_step = body.radius / 2.0f;
+  int step_count = static_cast<int>(std::ceil(distance / max_step));
+  glm::vec2 step = delta / static_cast<float>(step_count);
+
+  glm::vec2 position = from;
+  for (int i = 0; i < step_count; ++i) {
+    PositionCheck check = try_move(position, step, z);
+    if (!check.blocked)
+      continue;
+    // Slide along the blocking wall, or along either axis if that fails too
+    if (check.blocking_line) {
+      glm::vec2 wall = check.blocking_line->end - check.blocking_line->start;
+      if (wall.x != 0.0f || wall.y != 0.0f) {
+        wall = glm::normalize(wall);
+        if (!try_move(position, wall * glm::dot(step, wall), z).blocked)
+          continue;
+      }
+    }
+    if (!try_move(position, {step.x, 0.0f}, z).blocked)
+      continue;
+    if (!try_move(position, {0.0f, step.y}, z).blocked)
+      continue;
+    break;
+  }
+  return position;
+}
+
+PositionCheck Collider::try_move(glm::vec2& position,
+                                 const glm::vec2& step,
+                                 float z) const {
+  PositionCheck check = check_position(position + step, z);
+  if (!check.blocked)
+    position += step;
+  return check;
+}
+}  // namespace woop
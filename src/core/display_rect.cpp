@@ -1,12 +1,21 @@
 #include "display_rect.hpp"
 #include "glm/ext/vector_float3.hpp"
 #include "log.hpp"
+#include "profiler.hpp"
 #include "shader.hpp"
 #include "renderer.hpp"
+#include <cstdio>
 
 namespace woop {
-DisplayRect::DisplayRect(const Renderer& rndr, Shader&& shdr)
-    : renderer(rndr), shader(std::forward<Shader>(shdr)) {
+DisplayRect::DisplayRect(const Renderer& rndr,
+                         Shader&& shdr,
+                         const std::vector<PostPassConfig>& post_passes)
+    : renderer(rndr),
+      shader(std::forward<Shader>(shdr)),
+      overlay(rndr),
+      post_chain(post_passes, rndr.get_img_size(), rndr.get_texture_unit()),
+      engine_buffer(sizeof(EngineUniforms), EngineUniforms::binding),
+      uniforms_program(0) {
   texture_unit = renderer.get_texture_unit();
   gen_texture();
   gen_quad();
@@ -18,12 +27,58 @@ DisplayRect::~DisplayRect() {
   glDeleteTextures(1, &texture);
 }
 
-void DisplayRect::draw() const noexcept {
-  shader.use();
-  shader.set_uniform("u_texture", texture_unit);
-  bind_texture();
+void DisplayRect::draw() noexcept {
+  WOOP_PROFILE_SCOPE("DisplayRect::draw");
+  float time = static_cast<float>(glfwGetTime());
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  update_engine_uniforms(time, glm::vec2(viewport[2], viewport[3]));
+
   bind_vertices();
+  GLuint image = post_chain.run(texture, time);
+  glActiveTexture(GL_TEXTURE0 + texture_unit + 1);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  timer.begin();
+  shader.use();
+  if (uniforms_program != shader.get_program()) {
+    uniforms = PostUniforms(shader);
+    uniforms_program = shader.get_program();
+  }
+  uniforms.texture.set(static_cast<int>(texture_unit));
+  uniforms.source.set(static_cast<int>(texture_unit + 1));
+  uniforms.resolution.set(glm::vec2(viewport[2], viewport[3]));
+  uniforms.texel_size.set(1.0f / glm::vec2(post_chain.get_output_size()));
+  uniforms.time.set(time);
+  glActiveTexture(GL_TEXTURE0 + texture_unit);
+  glBindTexture(GL_TEXTURE_2D, image);
   glDrawElements(GL_TRIANGLES, sizeof(elements), GL_UNSIGNED_INT, &elements);
+  timer.end();
+  overlay.draw();
+}
+std::string DisplayRect::get_timing_summary() const {
+  std::string out;
+  char line[64];
+  for (std::size_t i = 0; i < post_chain.get_pass_count(); ++i) {
+    std::snprintf(line, sizeof(line), "%.2f MS", post_chain.get_pass_time(i));
+    out += "\nPASS " + post_chain.get_pass_name(i) + ": " + line;
+  }
+  std::snprintf(line, sizeof(line), "\nDISPLAY: %.2f MS", timer.get_ms());
+  out += line;
+  return out;
+}
+void DisplayRect::update_engine_uniforms(float time, glm::vec2 resolution) {
+  EngineUniforms data{};
+  data.resolution = resolution;
+  data.image_size = glm::vec2(renderer.get_img_size());
+  data.time = time;
+  if (renderer.get_view_count() > 0) {
+    const Camera& camera = renderer.get_camera(0);
+    data.camera_position = camera.get_position();
+    data.camera_rotation = camera.get_rotation();
+    data.camera_fov = camera.get_fov();
+  }
+  engine_buffer.update(data);
 }
 void DisplayRect::bind_texture() const noexcept {
   glActiveTexture(GL_TEXTURE0 + texture_unit);
@@ -0,0 +1,32 @@
+/**
+ * @file fixed_timestep.cpp
+ * @authors quak
+ * @brief Defines members of the FixedTimestep class.
+ */
+
+#include "fixed_timestep.hpp"
+#include "exception.hpp" /* woop::Exception */
+#include <algorithm>     /* std::max */
+#include <cmath>         /* std::floor */
+
+namespace woop {
+FixedTimestep::FixedTimestep(const TimestepConfig& cfg)
+    : config(cfg), accumulator(0.0), tick(0), dropped_ticks(0) {
+  if (!(config.tick_rate > 0.0))
+    throw Exception("Simulation tick rate must be positive");
+  config.max_ticks_per_frame = std::max(config.max_ticks_per_frame, 1u);
+  tick_length = 1.0 / config.tick_rate;
+}
+
+unsigned FixedTimestep::advance(double frame_time) noexcept {
+  accumulator += std::max(frame_time, 0.0);
+  double ticks = std::floor(accumulator / tick_length);
+  accumulator -= ticks * tick_length;
+  if (ticks > config.max_ticks_per_frame) {
+    dropped_ticks += static_cast<uint64_t>(ticks) - config.max_ticks_per_frame;
+    ticks = config.max_ticks_per_frame;
+  }
+  tick += static_cast<uint64_t>(ticks);
+  return static_cast<unsigned>(ticks);
+}
+}  // namespace woop
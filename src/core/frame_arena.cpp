@@ -0,0 +1,45 @@
+/**
+ * @file frame_arena.cpp
+ * @authors quak
+ * @brief Defines members of the FrameArena class.
+ */
+
+#include "frame_arena.hpp"
+
+namespace woop {
+/**
+ * @brief Rounds an offset up to the given alignment (a power of two).
+ */
+constexpr std::size_t align_up(std::size_t offset, std::size_t alignment) {
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(std::size_t size)
+    : block(new std::byte[size]),
+      capacity(size),
+      offset(0),
+      overflow_size(0) {}
+
+void* FrameArena::allocate(std::size_t size, std::size_t alignment) {
+  // new[] only guarantees fundamental alignment, which is also all that the
+  // renderer needs
+  std::size_t start = align_up(offset, alignment);
+  if (start + size <= capacity) {
+    offset = start + size;
+    return block.get() + start;
+  }
+  overflow.emplace_back(new std::byte[size]);
+  overflow_size += size;
+  return overflow.back().get();
+}
+void FrameArena::reset() {
+  if (!overflow.empty()) {
+    // Grow to fit everything the last frame needed, with room to spare
+    capacity = 2 * (capacity + overflow_size);
+    block.reset(new std::byte[capacity]);
+    overflow.clear();
+    overflow_size = 0;
+  }
+  offset = 0;
+}
+}  // namespace woop
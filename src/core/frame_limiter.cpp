@@ -0,0 +1,98 @@
+/**
+ * @file frame_limiter.cpp
+ * @authors quak
+ * @brief Defines members of the FrameLimiter class.
+ */
+
+#include "frame_limiter.hpp"
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include <algorithm>    /* std::max */
+#include <cmath>        /* std::sqrt */
+#include <cstdio>       /* std::snprintf */
+#include <thread>       /* std::this_thread */
+
+namespace woop {
+std::string FramePacingStats::to_string() const {
+  char out[128];
+  std::snprintf(out, sizeof(out),
+                "%llu frames, %.2f ms avg, %.2f ms jitter, %.2f ms max, "
+                "%llu late",
+                static_cast<unsigned long long>(frames), mean_frame_time,
+                jitter, max_frame_time,
+                static_cast<unsigned long long>(late_frames));
+  return out;
+}
+
+FrameLimiter::FrameLimiter(double fps, Clock::duration spin)
+    : max_fps(0.0),
+      period(Clock::duration::zero()),
+      spin_time(spin),
+      started(false) {
+  set_max_fps(fps);
+  reset_stats();
+}
+
+void FrameLimiter::set_max_fps(double fps) noexcept {
+  max_fps = fps;
+  if (fps > 0.0)
+    period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / fps));
+  else
+    period = Clock::duration::zero();
+  // Start a new schedule from the next frame
+  started = false;
+}
+
+void FrameLimiter::wait() {
+  Clock::time_point now = Clock::now();
+  if (period > Clock::duration::zero()) {
+    if (!started) {
+      deadline = now;
+    } else if (now < deadline) {
+      WOOP_PROFILE_SCOPE("FrameLimiter::wait");
+      if (deadline - now > spin_time)
+        std::this_thread::sleep_until(deadline - spin_time);
+      while ((now = Clock::now()) < deadline) {
+      }
+    } else {
+      ++late_frames;
+      if (now - deadline > period)
+        deadline = now;
+    }
+    deadline += period;
+  }
+  record(now);
+}
+
+FramePacingStats FrameLimiter::get_stats() const noexcept {
+  FramePacingStats stats;
+  stats.frames = frames;
+  stats.mean_frame_time = mean;
+  if (frames > 1)
+    stats.jitter = std::sqrt(sum_squares / static_cast<double>(frames - 1));
+  stats.max_frame_time = max_frame_time;
+  stats.late_frames = late_frames;
+  return stats;
+}
+void FrameLimiter::reset_stats() noexcept {
+  frames = 0;
+  mean = 0.0;
+  sum_squares = 0.0;
+  max_frame_time = 0.0;
+  late_frames = 0;
+}
+
+void FrameLimiter::record(Clock::time_point now) noexcept {
+  if (started) {
+    double frame_time =
+        std::chrono::duration<double, std::milli>(now - last_frame).count();
+    ++frames;
+    double delta = frame_time - mean;
+    mean += delta / static_cast<double>(frames);
+    sum_squares += delta * (frame_time - mean);
+    max_frame_time = std::max(max_frame_time, frame_time);
+  }
+  last_frame = now;
+  started = true;
+}
+}  // namespace woop
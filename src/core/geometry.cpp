@@ -0,0 +1,140 @@
+/**
+ * @file geometry.cpp
+ * @authors quak
+ * @brief Defines the geometry helpers shared by the level's modules.
+ */
+
+#include "geometry.hpp"
+#include "level.hpp"         /* woop::Level, woop::Linedef, woop::Subsector */
+#include "glm/common.hpp"    /* glm::min, glm::max */
+#include "glm/geometric.hpp" /* glm::length */
+#include <limits>            /* std::numeric_limits */
+#include <utility>           /* std::move */
+
+namespace woop {
+namespace {
+// Points closer than this are merged when clipping regions
+constexpr double merge_epsilon = 1e-6;
+
+glm::dvec2 to_point(const glm::vec2& point) noexcept {
+  return {point.x, point.y};
+}
+
+/**
+ * @brief Cuts a region along the partition lines of the BSP tree below it,
+ * down to its subsectors.
+ */
+class RegionBuilder {
+ public:
+  RegionBuilder(const Level& lvl,
+                bool clip_segs,
+                std::vector<ConvexRegion>& out)
+      : level(lvl), clip_to_segs(clip_segs), regions(out) {}
+
+  void build(const Node& node, const ConvexRegion& region) {
+    glm::dvec2 start = to_point(node.get_partition_start());
+    glm::dvec2 end = to_point(node.get_partition_end());
+    for (Node::Child child : {Node::Child::Left, Node::Child::Right}) {
+      ConvexRegion part =
+          clip_region(region, start, end, child == Node::Child::Right, &node);
+      if (part.empty())
+        continue;
+      if (node.is_node(child)) {
+        build(node.get_node(child), part);
+        continue;
+      }
+      // Subsectors lie on the right of their segs
+      const Subsector& subsector = node.get_subsector(child);
+      for (const Seg& seg : subsector.segs) {
+        if (!clip_to_segs || part.empty())
+          break;
+        if (seg.start != seg.end)
+          part = clip_region(part, to_point(seg.start), to_point(seg.end),
+                             true);
+      }
+      regions[level.get_subsector_index(subsector)] = std::move(part);
+    }
+  }
+
+ private:
+  const Level& level;
+  bool clip_to_segs;
+  std::vector<ConvexRegion>& regions;
+};
+}  // namespace
+
+Bounds get_bounds(const std::vector<Linedef>& linedefs) noexcept {
+  if (linedefs.empty())
+    return {glm::vec2(0.0f), glm::vec2(0.0f)};
+  Bounds bounds = {glm::vec2(std::numeric_limits<float>::max()),
+                   glm::vec2(std::numeric_limits<float>::lowest())};
+  for (const Linedef& line : linedefs) {
+    bounds.min = glm::min(bounds.min, glm::min(line.start, line.end));
+    bounds.max = glm::max(bounds.max, glm::max(line.start, line.end));
+  }
+  return bounds;
+}
+
+double get_side(const glm::dvec2& start,
+                const glm::dvec2& end,
+                const glm::dvec2& point) noexcept {
+  return (point.x - start.x) * (end.y - start.y) -
+         (point.y - start.y) * (end.x - start.x);
+}
+
+ConvexRegion get_box_region(const glm::dvec2& min, const glm::dvec2& max) {
+  return {{min}, {{max.x, min.y}}, {max}, {{min.x, max.y}}};
+}
+
+ConvexRegion clip_region(const ConvexRegion& region,
+                         const glm::dvec2& start,
+                         const glm::dvec2& end,
+                         bool keep_right,
+                         const Node* node) {
+  const double sign = keep_right ? 1.0 : -1.0;
+  const Node::Child child = keep_right ? Node::Child::Right : Node::Child::Left;
+  ConvexRegion out;
+  auto push = [&](const RegionVertex& vertex) {
+    // The edge starting at a repeated point has no length, so the point takes
+    // on the next edge's tag
+    if (!out.empty() &&
+        glm::length(vertex.point - out.back().point) < merge_epsilon)
+      out.back() = vertex;
+    else
+      out.push_back(vertex);
+  };
+  for (std::size_t i = 0; i < region.size(); ++i) {
+    const RegionVertex& current = region[i];
+    const RegionVertex& next = region[(i + 1) % region.size()];
+    double current_side = sign * get_side(start, end, current.point);
+    double next_side = sign * get_side(start, end, next.point);
+    if (current_side >= 0.0)
+      push(current);
+    if ((current_side >= 0.0) == (next_side >= 0.0))
+      continue;
+    glm::dvec2 cut =
+        current.point + (next.point - current.point) *
+                            (current_side / (current_side - next_side));
+    // Leaving the kept side starts an edge along the line
+    if (current_side >= 0.0)
+      push({cut, node, child});
+    else
+      push({cut, current.node, current.child});
+  }
+  while (out.size() > 1 &&
+         glm::length(out.front().point - out.back().point) < merge_epsilon)
+    out.pop_back();
+  if (out.size() < 3)
+    out.clear();
+  return out;
+}
+
+std::vector<ConvexRegion> get_subsector_regions(const Level& level,
+                                                const ConvexRegion& bounds,
+                                                bool clip_to_segs) {
+  std::vector<ConvexRegion> regions(level.get_subsectors().size());
+  RegionBuilder(level, clip_to_segs, regions)
+      .build(level.get_root_node(), bounds);
+  return regions;
+}
+}  // namespace woop
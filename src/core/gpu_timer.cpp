@@ -0,0 +1,46 @@
+/**
+ * @file gpu_timer.cpp
+ * @authors quak
+ * @brief Defines members of the GpuTimer class.
+ */
+
+#include "gpu_timer.hpp"
+
+namespace woop {
+GpuTimer::GpuTimer() : pending{}, current(0), ms(0.0), valid(true) {
+  glGenQueries(static_cast<GLsizei>(latency), queries);
+}
+GpuTimer::GpuTimer(GpuTimer&& other) noexcept
+    : current(other.current), ms(other.ms), valid(other.valid) {
+  for (std::size_t i = 0; i < latency; ++i) {
+    queries[i] = other.queries[i];
+    pending[i] = other.pending[i];
+  }
+  other.valid = false;
+}
+GpuTimer::~GpuTimer() {
+  if (valid)
+    glDeleteQueries(static_cast<GLsizei>(latency), queries);
+}
+
+void GpuTimer::begin() noexcept {
+  // Collect the result of the query about to be reused, if it's ready
+  if (pending[current]) {
+    GLint available = 0;
+    glGetQueryObjectiv(queries[current], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+    if (available) {
+      GLuint64 elapsed = 0;
+      glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &elapsed);
+      ms = static_cast<double>(elapsed) / 1e6;
+    }
+    pending[current] = false;
+  }
+  glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+void GpuTimer::end() noexcept {
+  glEndQuery(GL_TIME_ELAPSED);
+  pending[current] = true;
+  current = (current + 1) % latency;
+}
+}  // namespace woop
@@ -7,20 +7,62 @@
 #include "level.hpp"
 #include "bsp.hpp"
 #include "log.hpp"
+#include "node_format.hpp"
+#include "profiler.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
+#include <algorithm> /* std::find, std::find_if, std::min, std::sort */
+#include <iterator>  /* std::begin, std::end */
+#include <atomic>    /* std::atomic */
+#include <cstddef>   /* std::to_integer */
+#include <string>    /* std::to_string */
+#include <utility>   /* std::pair */
 
 namespace woop {
-Level::Level() : loaded(false) {}
+/**
+ * @brief Creates a string from a name buffer, which is only null-terminated if
+ * the name is shorter than the buffer.
+ */
+template <std::size_t Size>
+std::string get_name_from_buff(const char (&buffer)[Size]) {
+  return std::string(buffer, std::find(buffer, buffer + Size, '\0'));
+}
+
+/**
+ * @brief Views a lump's data as text.
+ */
+std::string_view get_text(const std::vector<std::byte>& data) {
+  return std::string_view(reinterpret_cast<const char*>(data.data()),
+                          data.size());
+}
+
+// Last revision given to a level
+std::atomic<uint64_t> last_revision{0};
+
+Level::Level() : loaded(false), revision(0), checksum(0), built_nodes(false) {
+  mark_changed();
+}
 
-Level::Level(const Wad& wad, const std::string& level_name) {
-  open(wad, level_name);
+Level::Level(const Wad& wad,
+             const std::string& level_name,
+             const LevelConfig& config)
+    : loaded(false), revision(0), checksum(0), built_nodes(false) {
+  open(wad, level_name, config);
 }
 
-void Level::open(const Wad& wad, const std::string& level_name) {
+void Level::open(const Wad& wad,
+                 const std::string& level_name,
+                 const LevelConfig& config) {
+  WOOP_PROFILE_SCOPE("Level::open");
   close();
   name = level_name;
-  populate_level_data(wad);
+  populate_level_data(wad, config);
   loaded = true;
+  // Things are located with the BSP tree, so the level must be loaded first
+  locator = PointLocator(*this);
+  sort_things();
+  mark_changed();
 }
 
 void Level::close() {
@@ -31,8 +73,25 @@ void Level::close() {
   segs.clear();
   linedefs.clear();
   sidedefs.clear();
+  vertices.clear();
   nodes.clear();
+  things.clear();
+  sector_lines.clear();
+  sector_neighbors.clear();
+  subsector_things.clear();
+  blockmap = Blockmap();
+  reject.clear();
+  pvs = Pvs();
+  locator = PointLocator();
+  checksum = 0;
+  built_nodes = false;
+  load_timings.clear();
   loaded = false;
+  mark_changed();
+}
+
+void Level::mark_changed() noexcept {
+  revision = ++last_revision;
 }
 
 const Node& Level::get_root_node() const {
@@ -48,16 +107,141 @@ Node& Level::get_root_node() {
   return *bsp_root;
 }
 
-void Level::populate_level_data(const Wad& wad) {
-  populate_vertices(wad);
-  populate_sectors(wad);
-  populate_sidedefs(wad);
-  populate_linedefs(wad);
-  populate_segs(wad);
-  populate_subsectors(wad);
-  populate_nodes(wad);
-  populate_things(wad);
-  finish_connections();
+const Subsector& Level::get_subsector(const glm::vec2& point) const {
+  const Node* node = &get_root_node();
+  Node::Child nearest_child = node->get_nearest_child(point);
+  while (node->is_node(nearest_child)) {
+    node = &node->get_node(nearest_child);
+    nearest_child = node->get_nearest_child(point);
+  }
+  return node->get_subsector(nearest_child);
+}
+Subsector& Level::get_subsector(const glm::vec2& point) {
+  Node* node = &get_root_node();
+  Node::Child nearest_child = node->get_nearest_child(point);
+  while (node->is_node(nearest_child)) {
+    node = &node->get_node(nearest_child);
+    nearest_child = node->get_nearest_child(point);
+  }
+  return node->get_subsector(nearest_child);
+}
+
+const Sector& Level::get_sector(const glm::vec2& point) const {
+  return get_sector(get_subsector(point));
+}
+
+void Level::populate_level_data(const Wad& wad, const LevelConfig& config) {
+  // Loading is split into tasks, which run as soon as the data they read is
+  // ready. Lists of references (lines to vertices, segs to lines, ...) are
+  // built once the list they refer to is complete, since it can't move
+  // afterwards.
+  TaskGraph graph;
+  using TaskId = TaskGraph::TaskId;
+  const unsigned workers =
+      config.parallel_load ? ThreadPool::get_default_worker_count() : 0u;
+
+  // UDMF levels are parsed once, and their fields viewed in place until
+  // they're copied into the level
+  const Lump* textmap = find_level_lump(wad, "TEXTMAP");
+  std::optional<UdmfMap> udmf;
+  std::vector<TaskId> parsed;
+  if (textmap) {
+    parsed.push_back(graph.add_task("parse_udmf", [&]() {
+      udmf = parse_udmf(get_text(textmap->data));
+    }));
+  }
+  TaskId vertices_task = graph.add_task("vertices", [&]() {
+    if (textmap)
+      populate_vertices(*udmf);
+    else
+      populate_vertices(wad);
+  }, parsed);
+  TaskId sectors_task = graph.add_task("sectors", [&]() {
+    if (textmap)
+      populate_sectors(*udmf);
+    else
+      populate_sectors(wad);
+  }, parsed);
+  graph.add_task("things", [&]() {
+    if (textmap)
+      populate_things(*udmf);
+    else
+      populate_things(wad);
+  }, parsed);
+  TaskId sidedefs_task = graph.add_task("sidedefs", [&]() {
+    if (textmap)
+      populate_sidedefs(*udmf);
+    else
+      populate_sidedefs(wad);
+  }, {sectors_task});
+  std::vector<NodeBuilder::Line> lines;
+  TaskId lines_task = graph.add_task("lines", [&]() {
+    lines = textmap ? read_lines(*udmf) : read_lines(wad);
+  }, {sidedefs_task});
+
+  std::optional<BspTree> tree;
+  TaskId tree_task = graph.add_task("bsp_tree", [&]() {
+    if (!config.rebuild_nodes)
+      tree = read_nodes(wad, lines);
+    built_nodes = !tree;
+    if (built_nodes) {
+      if (!config.rebuild_nodes)
+        log_warning(name, ": no usable nodes, building them");
+      tree = build_nodes(lines, config.node_builder, workers);
+    }
+    // Lines refer to vertices, so the tree's vertices must be added first
+    vertices.insert(vertices.end(), tree->vertices.begin(),
+                    tree->vertices.end());
+  }, {vertices_task, lines_task});
+  TaskId linedefs_task = graph.add_task("linedefs", [&]() {
+    if (textmap)
+      populate_linedefs(*udmf);
+    else
+      populate_linedefs(wad);
+  }, {tree_task});
+  TaskId segs_task = graph.add_task("segs", [&]() {
+    populate_segs(*tree);
+  }, {linedefs_task});
+  TaskId subsectors_task = graph.add_task("subsectors", [&]() {
+    populate_subsectors(*tree);
+  }, {segs_task});
+  graph.add_task("nodes", [&]() { populate_nodes(*tree); }, {subsectors_task});
+  graph.add_task("blockmap", [&]() { populate_blockmap(wad); },
+                 {linedefs_task});
+  graph.add_task("reject", [&]() { populate_reject(wad); }, {sectors_task});
+  graph.add_task("connections", [&]() { finish_connections(); },
+                 {linedefs_task});
+  graph.add_task("checksum", [&]() {
+    populate_checksum(wad, textmap != nullptr, config.node_builder);
+  }, {tree_task});
+
+  ThreadPool pool(workers);
+  graph.run(pool);
+  load_timings = graph.get_timings();
+}
+void Level::populate_checksum(const Wad& wad,
+                              bool udmf,
+                              const NodeBuilderConfig& builder) {
+  // Lumps that the geometry is read from. Built trees are described by the
+  // settings they were built with instead of the last three (or ZNODES).
+  constexpr const char* geometry_lumps[] = {
+      "VERTEXES", "LINEDEFS", "SIDEDEFS", "SEGS", "SSECTORS", "NODES",
+  };
+  constexpr const char* udmf_lumps[] = {"TEXTMAP", "ZNODES"};
+  checksum = fnv1a("");
+  const std::size_t lump_count = udmf ? (built_nodes ? 1 : 2)
+                                      : (built_nodes ? 3 : 6);
+  for (std::size_t i = 0; i < lump_count; ++i) {
+    const char* lump = udmf ? udmf_lumps[i] : geometry_lumps[i];
+    checksum = fnv1a(get_text(wad.get_lump(name, lump).data), checksum);
+  }
+  if (built_nodes) {
+    checksum = fnv1a("nodes " + std::to_string(builder.split_cost) + " " +
+                         std::to_string(builder.balance_cost) + " " +
+                         std::to_string(builder.diagonal_cost) + " " +
+                         std::to_string(builder.max_candidates),
+                     checksum);
+  }
 }
 void Level::populate_sectors(const Wad& wad) {
   const Lump& lump = wad.get_lump(name, "SECTORS");
@@ -66,44 +250,53 @@ void Level::populate_sectors(const Wad& wad) {
   for (const auto& raw_sector : raw_data) {
     Sector sector;
     sector.ceiling.height = raw_sector.ceiling_height;
-    sector.ceiling.texture = raw_sector.ceiling_texture;
+    sector.ceiling.texture = get_name_from_buff(raw_sector.ceiling_texture);
     sector.floor.height = raw_sector.floor_height;
-    sector.floor.texture = raw_sector.floor_texture;
+    sector.floor.texture = get_name_from_buff(raw_sector.floor_texture);
     sector.light_level = raw_sector.light_level;
     sectors.emplace_back(sector);
   }
 }
-void Level::populate_subsectors(const Wad& wad) {
-  const Lump& lump = wad.get_lump(name, "SSECTORS");
-  std::vector<RawSubsector> raw_data = lump.get_data_as<RawSubsector>();
-  subsectors.reserve(raw_data.size());
-  for (const auto& raw_subsector : raw_data) {
-    Subsector subsector;
-    std::size_t offset = static_cast<std::size_t>(raw_subsector.first_seg);
-    std::size_t count = static_cast<std::size_t>(raw_subsector.seg_count);
-
-    subsector.segs.reserve(count);
-    for (std::size_t i = offset; i < offset + count; ++i)
-      subsector.segs.emplace_back(segs.data() + i);
+void Level::populate_subsectors(const BspTree& tree) {
+  subsectors.reserve(tree.subsectors.size());
+  for (const auto& tree_subsector : tree.subsectors) {
+    std::size_t offset = tree_subsector.first_seg;
+    std::size_t count = tree_subsector.seg_count;
+    if (offset > segs.size() || count > segs.size() - offset)
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Subsector refers to segs that don't exist");
 
+    Subsector subsector;
+    subsector.segs = Span<Seg>(segs.data() + offset, count);
+    // Every seg of a subsector borders the same sector
+    subsector.sector = nullptr;
+    for (const Seg& seg : subsector.segs) {
+      if (seg.sidedef) {
+        subsector.sector = &seg.sidedef->sector_facing;
+        break;
+      }
+    }
+    if (!subsector.sector)
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Subsector has no sided segs");
     subsectors.emplace_back(subsector);
   }
 }
-void Level::populate_segs(const Wad& wad) {
-  const Lump& lump = wad.get_lump(name, "SEGS");
-  std::vector<RawSeg> raw_data = lump.get_data_as<RawSeg>();
-  segs.reserve(raw_data.size());
-  for (const auto& raw_seg : raw_data) {
-    std::size_t start_index = static_cast<std::size_t>(raw_seg.start_vertex);
-    std::size_t end_index = static_cast<std::size_t>(raw_seg.end_vertex);
-    std::size_t linedef_index = static_cast<std::size_t>(raw_seg.linedef);
+void Level::populate_segs(const BspTree& tree) {
+  segs.reserve(tree.segs.size());
+  for (const auto& tree_seg : tree.segs) {
+    if (tree_seg.start_vertex >= vertices.size() ||
+        tree_seg.end_vertex >= vertices.size() ||
+        tree_seg.linedef >= linedefs.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Seg refers to data that doesn't exist");
 
-    glm::vec2& start = vertices[start_index];
-    glm::vec2& end = vertices[end_index];
-    Linedef& linedef = linedefs[linedef_index];
-    Sidedef* sidedef = (raw_seg.direction == 0) ? linedef.front : linedef.back;
-    float angle = doom_angle_to_deg(raw_seg.angle);
-    int16_t offset = raw_seg.offset;
+    glm::vec2& start = vertices[tree_seg.start_vertex];
+    glm::vec2& end = vertices[tree_seg.end_vertex];
+    Linedef& linedef = linedefs[tree_seg.linedef];
+    Sidedef* sidedef = tree_seg.back ? linedef.back : linedef.front;
+    float angle = tree_seg.angle;
+    int16_t offset = static_cast<int16_t>(tree_seg.offset);
 
     Seg seg{start, end, linedef, sidedef, angle, offset};
     segs.emplace_back(seg);
@@ -114,31 +307,33 @@ void Level::populate_linedefs(const Wad& wad) {
   std::vector<RawLinedef> raw_data = lump.get_data_as<RawLinedef>();
   linedefs.reserve(raw_data.size());
   for (const auto& raw_linedef : raw_data) {
-    std::size_t start_index =
-        static_cast<std::size_t>(raw_linedef.start_vertex);
-    std::size_t end_index = static_cast<std::size_t>(raw_linedef.end_vertex);
+    if (raw_linedef.start_vertex >= vertices.size() ||
+        raw_linedef.end_vertex >= vertices.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Linedef refers to vertices that don't exist");
 
-    glm::vec2& start = vertices[start_index];
-    glm::vec2& end = vertices[end_index];
-    Sidedef* front = nullptr;
-    Sidedef* back = nullptr;
+    glm::vec2& start = vertices[raw_linedef.start_vertex];
+    glm::vec2& end = vertices[raw_linedef.end_vertex];
 
     // From the doom wiki: " The special value -1 (hexadecimal 0xFFFF) is used
     // to indicate no sidedef, in one-sided lines"
-    if (raw_linedef.front_sidedef > 0) {
-      std::size_t index = static_cast<std::size_t>(raw_linedef.front_sidedef);
-      front = sidedefs.data() + index;
-    }
-    if (raw_linedef.back_sidedef > 0) {
-      std::size_t index = static_cast<std::size_t>(raw_linedef.back_sidedef);
-      back = sidedefs.data() + index;
-    }
+    auto get_sidedef = [&](uint16_t index) -> Sidedef* {
+      if (index == no_sidedef)
+        return nullptr;
+      if (index >= sidedefs.size())
+        throw LevelException(LevelException::Type::InvalidData,
+                             "Linedef refers to a sidedef that doesn't exist");
+      return sidedefs.data() + index;
+    };
+    Sidedef* front = get_sidedef(raw_linedef.front_sidedef);
+    Sidedef* back = get_sidedef(raw_linedef.back_sidedef);
 
     Linedef linedef{
         start,
         end,
         front,
         back,
+        raw_linedef.flags,
     };
     linedefs.emplace_back(linedef);
   }
@@ -148,9 +343,9 @@ void Level::populate_sidedefs(const Wad& wad) {
   std::vector<RawSidedef> raw_data = lump.get_data_as<RawSidedef>();
   sidedefs.reserve(raw_data.size());
   for (const auto& raw_sidedef : raw_data) {
-    std::string upper_name = raw_sidedef.upper_name;
-    std::string lower_name = raw_sidedef.lower_name;
-    std::string middle_name = raw_sidedef.middle_name;
+    std::string upper_name = get_name_from_buff(raw_sidedef.upper_name);
+    std::string lower_name = get_name_from_buff(raw_sidedef.lower_name);
+    std::string middle_name = get_name_from_buff(raw_sidedef.middle_name);
 
     std::size_t sector_index =
         static_cast<std::size_t>(raw_sidedef.sector_facing);
@@ -173,41 +368,37 @@ void Level::populate_vertices(const Wad& wad) {
   }
 }
 
-void Level::populate_nodes(const Wad& wad) {
-  const Lump& lump = wad.get_lump(name, "NODES");
-  std::vector<RawNode> raw_data = lump.get_data_as<RawNode>();
-  nodes.reserve(raw_data.size());
+void Level::populate_nodes(const BspTree& tree) {
+  if (tree.nodes.empty())
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Level has no nodes");
+  nodes.reserve(tree.nodes.size());
 
   // Initialize nodes
-  for (const auto& raw_node : raw_data) {
-    glm::vec2 part_start{
-        raw_node.x_part_start,
-        raw_node.y_part_start,
-    };
-    glm::vec2 part_end{
-        raw_node.x_part_start + raw_node.x_part_delta,
-        raw_node.y_part_start + raw_node.y_part_delta,
-    };
+  for (const auto& tree_node : tree.nodes) {
+    glm::vec2 part_start = tree_node.partition_start;
+    glm::vec2 part_end = tree_node.partition_start + tree_node.partition_delta;
     Node node{part_start, part_end};
     nodes.emplace_back(node);
   }
   // Link nodes
+  auto link = [&](Node& node, uint32_t target, Node::Child child) {
+    std::size_t index = target & ~BspTree::subsector_bit;
+    if (target & BspTree::subsector_bit) {
+      if (index >= subsectors.size())
+        throw LevelException(LevelException::Type::InvalidData,
+                             "Node refers to a subsector that doesn't exist");
+      node.set_subsector(subsectors[index], child);
+    } else {
+      if (index >= nodes.size())
+        throw LevelException(LevelException::Type::InvalidData,
+                             "Node refers to a node that doesn't exist");
+      node.set_node(nodes[index], child);
+    }
+  };
   for (std::size_t i = 0; i < nodes.size(); ++i) {
-    const RawNode& raw_node = raw_data[i];
-    Node& node = nodes[i];
-    // Mask out sign bit of both targets
-    std::size_t left_target = raw_node.left_child & 0x7fff;
-    std::size_t right_target = raw_node.right_child & 0x7fff;
-    // If child's sign is negative, it points to a subsector
-    // Otherwise, it points to a node
-    if (raw_node.left_child < 0)
-      node.set_subsector_left(subsectors[left_target]);
-    else
-      node.set_node_left(nodes[left_target]);
-    if (raw_node.right_child < 0)
-      node.set_subsector_right(subsectors[right_target]);
-    else
-      node.set_node_right(nodes[right_target]);
+    link(nodes[i], tree.nodes[i].left_child, Node::Child::Left);
+    link(nodes[i], tree.nodes[i].right_child, Node::Child::Right);
   }
   // "The root node is the highest-numbered entry in the lump"
   // (https://doomwiki.org/wiki/Node)
@@ -220,7 +411,8 @@ void Level::populate_things(const Wad& wad) {
 
   for (const auto& raw_thing : raw_things) {
     glm::vec2 position = {raw_thing.x_pos, raw_thing.y_pos};
-    float angle = doom_angle_to_deg(raw_thing.angle);
+    // Unlike other angles, thing angles are stored in degrees
+    float angle = static_cast<float>(raw_thing.angle);
     int16_t type = raw_thing.type;
     int16_t flags = raw_thing.flags;
     Thing thing{position, angle, type, flags};
@@ -228,17 +420,259 @@ void Level::populate_things(const Wad& wad) {
   };
 }
 
+void Level::populate_sectors(const UdmfMap& map) {
+  sectors.reserve(map.sectors.size());
+  for (const auto& udmf_sector : map.sectors) {
+    Sector sector;
+    sector.ceiling.height = udmf_sector.ceiling_height;
+    sector.ceiling.texture = std::string(udmf_sector.ceiling_texture);
+    sector.floor.height = udmf_sector.floor_height;
+    sector.floor.texture = std::string(udmf_sector.floor_texture);
+    sector.light_level = udmf_sector.light_level;
+    sectors.emplace_back(sector);
+  }
+}
+void Level::populate_linedefs(const UdmfMap& map) {
+  linedefs.reserve(map.linedefs.size());
+  for (const auto& udmf_linedef : map.linedefs) {
+    if (udmf_linedef.start_vertex >= vertices.size() ||
+        udmf_linedef.end_vertex >= vertices.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Linedef refers to vertices that don't exist");
+
+    // Sidedefs were checked by read_lines()
+    auto get_sidedef = [&](int32_t index) -> Sidedef* {
+      return (index < 0) ? nullptr
+                         : sidedefs.data() + static_cast<std::size_t>(index);
+    };
+    Linedef linedef{
+        vertices[udmf_linedef.start_vertex],
+        vertices[udmf_linedef.end_vertex],
+        get_sidedef(udmf_linedef.front_sidedef),
+        get_sidedef(udmf_linedef.back_sidedef),
+        udmf_linedef.flags,
+    };
+    linedefs.emplace_back(linedef);
+  }
+}
+void Level::populate_sidedefs(const UdmfMap& map) {
+  sidedefs.reserve(map.sidedefs.size());
+  for (const auto& udmf_sidedef : map.sidedefs) {
+    if (udmf_sidedef.sector >= sectors.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Sidedef refers to a sector that doesn't exist");
+    Sidedef sidedef{
+        std::string(udmf_sidedef.upper_name),
+        std::string(udmf_sidedef.lower_name),
+        std::string(udmf_sidedef.middle_name),
+        sectors[udmf_sidedef.sector],
+        udmf_sidedef.offset,
+    };
+    sidedefs.emplace_back(sidedef);
+  }
+}
+void Level::populate_vertices(const UdmfMap& map) {
+  vertices = map.vertices;
+}
+void Level::populate_things(const UdmfMap& map) {
+  things.reserve(map.things.size());
+  for (const auto& udmf_thing : map.things) {
+    float angle = static_cast<float>(udmf_thing.angle);
+    Thing thing{udmf_thing.position, angle, udmf_thing.type, udmf_thing.flags};
+    things.emplace_back(thing);
+  }
+}
+
+void Level::populate_blockmap(const Wad& wad) {
+  if (const Lump* lump = find_level_lump(wad, "BLOCKMAP")) {
+    try {
+      blockmap = Blockmap::from_lump(*lump, linedefs.size());
+      return;
+    } catch (const Exception& exception) {
+      log_error(name, ": ", exception.what(), ", rebuilding it");
+    }
+  }
+  blockmap = Blockmap::build(linedefs);
+}
+void Level::populate_reject(const Wad& wad) {
+  // Missing or short lumps are padded with zeroes (visible), like vanilla
+  std::size_t size = (sectors.size() * sectors.size() + 7) / 8;
+  reject.assign(size, 0);
+  const Lump* lump = find_level_lump(wad, "REJECT");
+  if (!lump)
+    return;
+  if (lump->data.size() < size)
+    log_warning(name, ": REJECT lump is too short, padding it");
+  for (std::size_t i = 0; i < std::min(size, lump->data.size()); ++i)
+    reject[i] = std::to_integer<uint8_t>(lump->data[i]);
+}
+std::optional<BspTree> Level::read_nodes(
+    const Wad& wad,
+    const std::vector<NodeBuilder::Line>& lines) const {
+  static const std::vector<std::byte> missing;
+  auto get_data =
+      [&](const std::string& lump) -> const std::vector<std::byte>& {
+    const Lump* found = find_level_lump(wad, lump);
+    return found ? found->data : missing;
+  };
+  // UDMF levels keep their (extended) nodes in ZNODES, which reads just like
+  // an extended NODES lump
+  if (find_level_lump(wad, "TEXTMAP"))
+    return read_node_lumps(missing, missing, get_data("ZNODES"), vertices,
+                           lines);
+  return read_node_lumps(get_data("SEGS"), get_data("SSECTORS"),
+                         get_data("NODES"), vertices, lines);
+}
+std::vector<NodeBuilder::Line> Level::read_lines(const Wad& wad) const {
+  auto get_sector = [&](uint16_t sidedef) -> int32_t {
+    if (sidedef == no_sidedef)
+      return -1;
+    if (sidedef >= sidedefs.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Linedef refers to a sidedef that doesn't exist");
+    return static_cast<int32_t>(
+        get_sector_index(sidedefs[sidedef].sector_facing));
+  };
+  const Lump& lump = wad.get_lump(name, "LINEDEFS");
+  std::vector<NodeBuilder::Line> lines;
+  for (const auto& raw_linedef : lump.get_data_as<RawLinedef>()) {
+    lines.push_back({
+        raw_linedef.start_vertex,
+        raw_linedef.end_vertex,
+        get_sector(raw_linedef.front_sidedef),
+        get_sector(raw_linedef.back_sidedef),
+    });
+  }
+  return lines;
+}
+std::vector<NodeBuilder::Line> Level::read_lines(const UdmfMap& map) const {
+  auto get_sector = [&](int32_t sidedef) -> int32_t {
+    if (sidedef < 0)
+      return -1;
+    if (static_cast<std::size_t>(sidedef) >= sidedefs.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Linedef refers to a sidedef that doesn't exist");
+    return static_cast<int32_t>(get_sector_index(
+        sidedefs[static_cast<std::size_t>(sidedef)].sector_facing));
+  };
+  std::vector<NodeBuilder::Line> lines;
+  lines.reserve(map.linedefs.size());
+  for (const auto& linedef : map.linedefs) {
+    lines.push_back({
+        linedef.start_vertex,
+        linedef.end_vertex,
+        get_sector(linedef.front_sidedef),
+        get_sector(linedef.back_sidedef),
+    });
+  }
+  return lines;
+}
+BspTree Level::build_nodes(const std::vector<NodeBuilder::Line>& lines,
+                           const NodeBuilderConfig& config,
+                           unsigned workers) const {
+  WOOP_PROFILE_SCOPE("Level::build_nodes");
+  // A pool of its own, since loops on the loading pool would run serially
+  // while the graph is running
+  ThreadPool pool(workers);
+  return NodeBuilder(config).build(vertices, lines, pool);
+}
+const Lump* Level::find_level_lump(const Wad& wad,
+                                   const std::string& lump) const {
+  // Lumps that can follow a level's marker (https://doomwiki.org/wiki/WAD)
+  static const std::string level_lumps[] = {
+      "THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS",
+      "SSECTORS", "NODES", "SECTORS", "REJECT", "BLOCKMAP",
+      // UDMF levels (https://zdoom.org/wiki/UDMF)
+      "TEXTMAP", "ZNODES", "BEHAVIOR", "DIALOGUE", "ENDMAP",
+  };
+  auto it = std::find_if(wad.begin(), wad.end(),
+                         [&](const Lump& l) { return l.name == name; });
+  if (it == wad.end())
+    return nullptr;
+  for (++it; it != wad.end(); ++it) {
+    if (std::find(std::begin(level_lumps), std::end(level_lumps),
+                  it->name) == std::end(level_lumps))
+      return nullptr;
+    if (it->name == lump)
+      return &*it;
+  }
+  return nullptr;
+}
+
 void Level::finish_connections() {
-  // Connect lines to sectors
+  // Connect lines to sectors, counting each sector's lines first so that
+  // they can be stored in one array
+  std::vector<std::size_t> offsets(sectors.size() + 1, 0);
+  for (const auto& line : linedefs) {
+    if (line.front)
+      ++offsets[get_sector_index(line.front->sector_facing) + 1];
+    if (line.back)
+      ++offsets[get_sector_index(line.back->sector_facing) + 1];
+  }
+  for (std::size_t i = 1; i < offsets.size(); ++i)
+    offsets[i] += offsets[i - 1];
+  sector_lines.resize(offsets.back());
+  std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
   for (auto& line : linedefs) {
-    if (line.front) {
-      Sector& sector = line.front->sector_facing;
-      sector.lines.emplace_back(&line);
-    }
-    if (line.back) {
-      Sector& sector = line.back->sector_facing;
-      sector.lines.emplace_back(&line);
-    }
+    if (line.front)
+      sector_lines[next[get_sector_index(line.front->sector_facing)]++] = &line;
+    if (line.back)
+      sector_lines[next[get_sector_index(line.back->sector_facing)]++] = &line;
   }
+  for (std::size_t i = 0; i < sectors.size(); ++i)
+    sectors[i].lines =
+        Span<Linedef*>(sector_lines.data() + offsets[i],
+                       offsets[i + 1] - offsets[i]);
+
+  // Connect sectors to their neighbors, through lines with different sectors
+  // on each side
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  for (const auto& line : linedefs) {
+    if (!line.front || !line.back)
+      continue;
+    std::size_t front = get_sector_index(line.front->sector_facing);
+    std::size_t back = get_sector_index(line.back->sector_facing);
+    if (front == back)
+      continue;
+    pairs.emplace_back(front, back);
+    pairs.emplace_back(back, front);
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  sector_neighbors.reserve(pairs.size());
+  for (const auto& pair : pairs)
+    sector_neighbors.push_back(&sectors[pair.second]);
+  std::size_t first = 0;
+  for (std::size_t i = 0; i < sectors.size(); ++i) {
+    std::size_t last = first;
+    while (last < pairs.size() && pairs[last].first == i)
+      ++last;
+    sectors[i].neighbors =
+        Span<Sector*>(sector_neighbors.data() + first, last - first);
+    first = last;
+  }
+}
+void Level::sort_things() {
+  std::vector<glm::vec2> positions;
+  positions.reserve(things.size());
+  for (const auto& thing : things)
+    positions.push_back(thing.position);
+  std::vector<const Subsector*> owners(things.size());
+  locator.locate(Span<const glm::vec2>(positions.data(), positions.size()),
+                 Span<const Subsector*>(owners.data(), owners.size()));
+
+  // Subsectors list their things in one array, grouped by subsector
+  std::vector<std::size_t> offsets(subsectors.size() + 1, 0);
+  for (const Subsector* owner : owners)
+    ++offsets[get_subsector_index(*owner) + 1];
+  for (std::size_t i = 1; i < offsets.size(); ++i)
+    offsets[i] += offsets[i - 1];
+  subsector_things.resize(things.size());
+  std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+  for (std::size_t i = 0; i < things.size(); ++i)
+    subsector_things[next[get_subsector_index(*owners[i])]++] = &things[i];
+  for (std::size_t i = 0; i < subsectors.size(); ++i)
+    subsectors[i].things = Span<const Thing*>(
+        subsector_things.data() + offsets[i], offsets[i + 1] - offsets[i]);
 }
 }  // namespace woop
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file light_table.cpp
+ * @authors quak
+ * @brief Defines members of the LightTable class.
+ */
+
+#include "light_table.hpp"
+#include "glm/vec4.hpp" /* glm::vec4 */
+#include <algorithm>    /* std::clamp */
+#include <limits>       /* std::numeric_limits */
+
+namespace woop {
+// Size of a single palette in PLAYPAL, and of a single colormap in COLORMAP
+constexpr std::size_t palette_size = 256;
+
+Pixel interpolate_color(float v, const Pixel& c1, const Pixel& c2) {
+  glm::vec4 c1_f = c1;
+  glm::vec4 c2_f = c2;
+  return c1_f + v * (c2_f - c1_f);
+}
+
+LightTable::LightTable(const Pixel& fog, float strength)
+    : fog_color(fog), fog_strength(std::clamp(strength, 0.0f, 1.0f)) {
+  gen_shades();
+}
+LightTable::LightTable(const Wad& wad)
+    : fog_color(Pixel{0, 0, 0, 255}), fog_strength(1.0f) {
+  const Lump& colormap_lump = wad.get_lump("COLORMAP");
+  const Lump& playpal_lump = wad.get_lump("PLAYPAL");
+  if (colormap_lump.data.size() < shade_count * palette_size)
+    throw LightTableException(LightTableException::Type::InvalidLump,
+                              "COLORMAP is too small to hold every shade");
+  if (playpal_lump.data.size() < palette_size * 3)
+    throw LightTableException(LightTableException::Type::InvalidLump,
+                              "PLAYPAL is too small to hold a palette");
+
+  colormap.reserve(shade_count * palette_size);
+  for (std::size_t i = 0; i < shade_count * palette_size; ++i)
+    colormap.emplace_back(std::to_integer<uint8_t>(colormap_lump.data[i]));
+  // Only the first palette is used (the others tint the screen)
+  palette.reserve(palette_size);
+  for (std::size_t i = 0; i < palette_size; ++i) {
+    const std::byte* rgb = playpal_lump.data.data() + i * 3;
+    palette.emplace_back(Pixel{rgb[0], rgb[1], rgb[2], std::byte{255}});
+  }
+  gen_shades();
+}
+
+uint8_t LightTable::get_shade(int light_level, float scale) const noexcept {
+  int light =
+      std::clamp(light_level / 16, 0, static_cast<int>(light_levels - 1));
+  int distance = std::clamp(static_cast<int>(scale * 16.0f), 0,
+                            static_cast<int>(scale_levels - 1));
+  return shades[static_cast<std::size_t>(light)]
+               [static_cast<std::size_t>(distance)];
+}
+ColorRamp LightTable::get_ramp(const Pixel& color) const {
+  ColorRamp ramp;
+  if (!uses_colormap()) {
+    for (unsigned shade = 0; shade < shade_count; ++shade) {
+      float fog = fog_strength * static_cast<float>(shade) /
+                  static_cast<float>(shade_count - 1);
+      ramp[shade] = interpolate_color(fog, color, fog_color);
+    }
+    return ramp;
+  }
+
+  // Find the closest color in the palette
+  auto square = [](int v) { return v * v; };
+  std::size_t closest = 0;
+  int closest_distance = std::numeric_limits<int>::max();
+  for (std::size_t i = 0; i < palette.size(); ++i) {
+    int distance = 0;
+    for (int channel = 0; channel < 3; ++channel)
+      distance += square(std::to_integer<int>(palette[i][channel]) -
+                         std::to_integer<int>(color[channel]));
+    if (distance < closest_distance) {
+      closest = i;
+      closest_distance = distance;
+    }
+  }
+  for (std::size_t shade = 0; shade < shade_count; ++shade)
+    ramp[shade] = palette[colormap[shade * palette_size + closest]];
+  return ramp;
+}
+
+void LightTable::gen_shades() noexcept {
+  // From R_InitLightTables: brighter sectors start at brighter shades, and
+  // every sector gets brighter as things get closer.
+  for (unsigned light = 0; light < light_levels; ++light) {
+    int start =
+        static_cast<int>((light_levels - 1 - light) * 2 * shade_count /
+                         light_levels);
+    for (unsigned distance = 0; distance < scale_levels; ++distance) {
+      int shade = start - static_cast<int>(distance) / 2;
+      shades[light][distance] = static_cast<uint8_t>(
+          std::clamp(shade, 0, static_cast<int>(shade_count - 1)));
+    }
+  }
+}
+}  // namespace woop
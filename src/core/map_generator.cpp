@@ -0,0 +1,512 @@
+/**
+ * @file map_generator.cpp
+ * @authors quak
+ * @brief Defines members of the MapGenerator class.
+ */
+
+#include "map_generator.hpp"
+#include "utils.hpp"             /* deg_to_doom_angle */
+#include "glm/trigonometric.hpp" /* glm::degrees */
+#include <algorithm>             /* std::find, std::min, std::max, std::swap */
+#include <cmath>                 /* std::atan2, std::ceil, std::sqrt */
+#include <cstring>               /* std::memcpy, std::strncpy */
+#include <iterator>              /* std::size */
+#include <limits>                /* std::numeric_limits */
+#include <string>                /* std::string, std::to_string */
+
+namespace woop {
+// Linedef flags (https://doomwiki.org/wiki/Linedef#Linedef_flags)
+constexpr int16_t linedef_impassable = 0x0001;
+constexpr int16_t linedef_two_sided = 0x0004;
+// "Type" of the Player 1 start Thing
+constexpr int16_t player_start_thing = 1;
+// Things appear on all skill levels
+constexpr int16_t thing_all_skills = 0x0007;
+
+const char* const wall_textures[] = {
+    "STARTAN3", "STARG3", "BROWN1", "COMPTALL", "TEKWALL1", "BIGDOOR2",
+};
+const char* const flat_textures[] = {
+    "FLOOR4_8", "FLOOR5_1", "CEIL3_5", "NUKAGE1", "FLAT14",
+};
+
+/**
+ * @brief Converts an index into the uint16 used by the vanilla map format.
+ * @param limit Largest index that fits. 0xffff marks missing sidedefs, and
+ * node children use the top bit.
+ */
+uint16_t to_raw_index(std::size_t index,
+                      std::size_t limit = Level::no_sidedef - 1u) {
+  if (index > limit)
+    throw LevelException(
+        LevelException::Type::InvalidData,
+        "Generated map exceeds the limits of the vanilla map format");
+  return static_cast<uint16_t>(index);
+}
+/**
+ * @brief Converts a subsector or node index into a vanilla node child.
+ */
+uint16_t to_raw_child(std::size_t index, bool subsector) {
+  uint16_t child = to_raw_index(index, Level::subsector_bit - 1u);
+  return subsector ? (child | Level::subsector_bit) : child;
+}
+
+/**
+ * @brief Copies a texture name into a (not necessarily null-terminated) name
+ * buffer.
+ */
+void copy_name(char (&dest)[8], const char* src) {
+  std::strncpy(dest, src, sizeof(dest));
+}
+/**
+ * @brief Copies a name buffer into a quoted UDMF string.
+ */
+std::string quote_name(const char (&name)[8]) {
+  return '"' + std::string(name, std::find(name, name + sizeof(name), '\0')) +
+         '"';
+}
+
+/**
+ * @brief Appends a value's bytes to a lump.
+ */
+template <typename T>
+void append(std::vector<std::byte>& data, T value) {
+  std::size_t size = data.size();
+  data.resize(size + sizeof(T));
+  std::memcpy(data.data() + size, &value, sizeof(T));
+}
+
+MapGenerator::MapGenerator(const MapGeneratorConfig& cfg)
+    : config(cfg), rng(cfg.seed), cols(0), rows(0) {}
+
+void MapGenerator::generate(WadBuilder& builder, const std::string& name) {
+  if (config.sector_count < 2)
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Generated maps need at least two sectors");
+  if (config.open_area_size <= 0)
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Generated rooms must have a positive size");
+  if (config.wall_detail == 0 ||
+      config.wall_detail > static_cast<unsigned>(config.open_area_size))
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Wall detail must be between 1 and the room size");
+
+  clear();
+  rng.seed(config.seed);
+  cols = static_cast<unsigned>(
+      std::ceil(std::sqrt(static_cast<double>(config.sector_count))));
+  rows = (config.sector_count + cols - 1) / cols;
+
+  // All coordinates (and partition deltas) need to fit in an int16
+  const unsigned max_extent =
+      static_cast<unsigned>(std::numeric_limits<int16_t>::max());
+  const unsigned size = static_cast<unsigned>(config.open_area_size);
+  if (cols * size > max_extent || rows * size > max_extent)
+    throw LevelException(
+        LevelException::Type::InvalidData,
+        "Generated map is too large (reduce the room size or sector count)");
+
+  generate_sectors();
+  generate_walls();
+  generate_subsectors();
+  build_node(CellRect{0, cols, 0, rows});
+  generate_things();
+
+  if (config.format == MapFormat::Udmf) {
+    builder.add_lump(name)
+        .add_lump("TEXTMAP", write_textmap())
+        .add_lump("ZNODES", write_extended_nodes())
+        .add_lump("ENDMAP");
+    return;
+  }
+  builder.add_lump(name)
+      .add_lump("THINGS", things)
+      .add_lump("LINEDEFS", linedefs)
+      .add_lump("SIDEDEFS", sidedefs)
+      .add_lump("VERTEXES", vertices)
+      .add_lump("SEGS", segs)
+      .add_lump("SSECTORS", subsectors)
+      .add_lump("NODES", nodes)
+      .add_lump("SECTORS", sectors);
+}
+
+void MapGenerator::clear() {
+  things.clear();
+  linedefs.clear();
+  sidedefs.clear();
+  vertices.clear();
+  segs.clear();
+  subsectors.clear();
+  nodes.clear();
+  sectors.clear();
+  cell_segs.clear();
+  vertex_indices.clear();
+}
+
+void MapGenerator::generate_sectors() {
+  std::uniform_int_distribution<int> floor_step(0, 4);
+  std::uniform_int_distribution<int> ceil_step(0, 3);
+  std::uniform_int_distribution<int> light(128, 255);
+  std::uniform_int_distribution<std::size_t> flat(
+      0, std::size(flat_textures) - 1);
+
+  sectors.reserve(config.sector_count);
+  for (unsigned i = 0; i < config.sector_count; ++i) {
+    Level::RawSector sector{};
+    int floor = floor_step(rng) * 8;
+    sector.floor_height = static_cast<int16_t>(floor);
+    sector.ceiling_height =
+        static_cast<int16_t>(floor + 96 + ceil_step(rng) * 32);
+    copy_name(sector.floor_texture, flat_textures[flat(rng)]);
+    copy_name(sector.ceiling_texture, flat_textures[flat(rng)]);
+    sector.light_level = static_cast<int16_t>(light(rng));
+    sectors.emplace_back(sector);
+  }
+  cell_segs.resize(config.sector_count);
+}
+
+void MapGenerator::generate_walls() {
+  std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+  auto add_edge = [&](int a, int b, int x0, int y0, int x1, int y1) {
+    // Points are clockwise relative to a, and counter-clockwise relative to b
+    if (a >= 0 && b >= 0 && chance(rng) >= config.room_density) {
+      add_wall(a, b, x0, y0, x1, y1);
+      return;
+    }
+    if (a >= 0)
+      add_wall(a, -1, x0, y0, x1, y1);
+    if (b >= 0)
+      add_wall(b, -1, x1, y1, x0, y0);
+  };
+
+  // Vertical grid lines (a: cell to the left, b: cell to the right)
+  for (unsigned col = 0; col <= cols; ++col) {
+    for (unsigned row = 0; row < rows; ++row) {
+      int a = (col > 0) ? get_cell(col - 1, row) : -1;
+      int b = get_cell(col, row);
+      int x = get_grid_x(col);
+      add_edge(a, b, x, get_grid_y(row + 1), x, get_grid_y(row));
+    }
+  }
+  // Horizontal grid lines (a: cell below, b: cell above)
+  for (unsigned row = 0; row <= rows; ++row) {
+    for (unsigned col = 0; col < cols; ++col) {
+      int a = (row > 0) ? get_cell(col, row - 1) : -1;
+      int b = get_cell(col, row);
+      int y = get_grid_y(row);
+      add_edge(a, b, get_grid_x(col), y, get_grid_x(col + 1), y);
+    }
+  }
+}
+
+void MapGenerator::generate_subsectors() {
+  // Segs of a subsector must be stored contiguously
+  subsectors.reserve(cell_segs.size());
+  for (const auto& cell : cell_segs) {
+    Level::RawSubsector subsector{};
+    subsector.first_seg = to_raw_index(segs.size());
+    subsector.seg_count = to_raw_index(cell.size());
+    segs.insert(segs.end(), cell.begin(), cell.end());
+    subsectors.emplace_back(subsector);
+  }
+  to_raw_index(segs.size());
+}
+
+void MapGenerator::generate_things() {
+  const int size = config.open_area_size;
+  const int margin = size / 8;
+  std::uniform_int_distribution<unsigned> cell(0, config.sector_count - 1);
+  std::uniform_int_distribution<int> offset(margin, size - margin);
+  std::uniform_int_distribution<int> angle(0, 7);
+
+  things.reserve(config.thing_count + 1);
+  auto add_thing = [&](unsigned index, int x, int y, int degrees,
+                       int16_t type) {
+    Level::RawThing thing{};
+    thing.x_pos = static_cast<int16_t>(get_grid_x(index % cols) + x);
+    thing.y_pos = static_cast<int16_t>(get_grid_y(index / cols) + y);
+    thing.angle = static_cast<int16_t>(degrees);
+    thing.type = type;
+    thing.flags = thing_all_skills;
+    things.emplace_back(thing);
+  };
+
+  // Player starts in the middle of the first room, facing north
+  add_thing(0, size / 2, size / 2, 90, player_start_thing);
+  for (unsigned i = 0; i < config.thing_count; ++i) {
+    add_thing(cell(rng), offset(rng), offset(rng), angle(rng) * 45,
+              config.thing_type);
+  }
+}
+
+std::vector<std::byte> MapGenerator::write_textmap() const {
+  std::string text = "namespace = \"doom\";\n";
+  auto add_field = [&](const char* key, const std::string& value) {
+    text.append(key).append(" = ").append(value).append(";\n");
+  };
+  auto add_flag = [&](const char* key, bool set) {
+    if (set)
+      add_field(key, "true");
+  };
+
+  for (const auto& thing : things) {
+    text += "thing\n{\n";
+    add_field("x", std::to_string(thing.x_pos));
+    add_field("y", std::to_string(thing.y_pos));
+    add_field("angle", std::to_string(thing.angle));
+    add_field("type", std::to_string(thing.type));
+    add_flag("skill1", thing.flags & 0x0001);
+    add_flag("skill2", thing.flags & 0x0001);
+    add_flag("skill3", thing.flags & 0x0002);
+    add_flag("skill4", thing.flags & 0x0004);
+    add_flag("skill5", thing.flags & 0x0004);
+    add_flag("ambush", thing.flags & 0x0008);
+    add_flag("single", !(thing.flags & 0x0010));
+    text += "}\n";
+  }
+  for (const auto& vertex : vertices) {
+    text += "vertex\n{\n";
+    add_field("x", std::to_string(vertex.x_pos));
+    add_field("y", std::to_string(vertex.y_pos));
+    text += "}\n";
+  }
+  for (const auto& linedef : linedefs) {
+    text += "linedef\n{\n";
+    add_field("v1", std::to_string(linedef.start_vertex));
+    add_field("v2", std::to_string(linedef.end_vertex));
+    add_field("sidefront", std::to_string(linedef.front_sidedef));
+    if (linedef.back_sidedef != Level::no_sidedef)
+      add_field("sideback", std::to_string(linedef.back_sidedef));
+    add_flag("blocking", linedef.flags & linedef_impassable);
+    add_flag("twosided", linedef.flags & linedef_two_sided);
+    text += "}\n";
+  }
+  for (const auto& sidedef : sidedefs) {
+    text += "sidedef\n{\n";
+    add_field("sector", std::to_string(sidedef.sector_facing));
+    add_field("texturetop", quote_name(sidedef.upper_name));
+    add_field("texturebottom", quote_name(sidedef.lower_name));
+    add_field("texturemiddle", quote_name(sidedef.middle_name));
+    text += "}\n";
+  }
+  for (const auto& sector : sectors) {
+    text += "sector\n{\n";
+    add_field("heightfloor", std::to_string(sector.floor_height));
+    add_field("heightceiling", std::to_string(sector.ceiling_height));
+    add_field("texturefloor", quote_name(sector.floor_texture));
+    add_field("textureceiling", quote_name(sector.ceiling_texture));
+    add_field("lightlevel", std::to_string(sector.light_level));
+    text += "}\n";
+  }
+
+  std::vector<std::byte> data(text.size());
+  std::memcpy(data.data(), text.data(), text.size());
+  return data;
+}
+
+std::vector<std::byte> MapGenerator::write_extended_nodes() const {
+  // https://zdoom.org/wiki/Node#ZDoom_extended_nodes
+  std::vector<std::byte> data;
+  for (char c : {'X', 'N', 'O', 'D'})
+    append(data, c);
+  append(data, static_cast<uint32_t>(vertices.size()));
+  append(data, uint32_t{0});  // Generated maps don't split any segs
+  append(data, static_cast<uint32_t>(subsectors.size()));
+  for (const auto& subsector : subsectors)
+    append(data, static_cast<uint32_t>(subsector.seg_count));
+  append(data, static_cast<uint32_t>(segs.size()));
+  for (const auto& seg : segs) {
+    append(data, static_cast<uint32_t>(seg.start_vertex));
+    append(data, static_cast<uint32_t>(seg.end_vertex));
+    append(data, seg.linedef);
+    append(data, static_cast<uint8_t>(seg.direction));
+  }
+  // Extended children use the top bit of 32-bit indices for subsectors
+  auto get_child = [](uint16_t child) -> uint32_t {
+    if (child & Level::subsector_bit)
+      return static_cast<uint32_t>(child ^ Level::subsector_bit) | 0x80000000u;
+    return child;
+  };
+  append(data, static_cast<uint32_t>(nodes.size()));
+  for (const auto& node : nodes) {
+    append(data, node.x_part_start);
+    append(data, node.y_part_start);
+    append(data, node.x_part_delta);
+    append(data, node.y_part_delta);
+    for (int16_t bound : node.right_bounds.data)
+      append(data, bound);
+    for (int16_t bound : node.left_bounds.data)
+      append(data, bound);
+    append(data, get_child(node.right_child));
+    append(data, get_child(node.left_child));
+  }
+  return data;
+}
+
+void MapGenerator::add_wall(int front,
+                            int back,
+                            int x0,
+                            int y0,
+                            int x1,
+                            int y1) {
+  const int detail = static_cast<int>(config.wall_detail);
+  for (int i = 0; i < detail; ++i) {
+    int start_x = x0 + (x1 - x0) * i / detail;
+    int start_y = y0 + (y1 - y0) * i / detail;
+    int end_x = x0 + (x1 - x0) * (i + 1) / detail;
+    int end_y = y0 + (y1 - y0) * (i + 1) / detail;
+    add_linedef(front, back, start_x, start_y, end_x, end_y);
+  }
+}
+
+void MapGenerator::add_linedef(int front,
+                               int back,
+                               int x0,
+                               int y0,
+                               int x1,
+                               int y1) {
+  const bool two_sided = back >= 0;
+  Level::RawLinedef linedef{};
+  linedef.start_vertex = get_vertex(x0, y0);
+  linedef.end_vertex = get_vertex(x1, y1);
+  linedef.flags = two_sided ? linedef_two_sided : linedef_impassable;
+  linedef.front_sidedef = add_sidedef(front, two_sided);
+  linedef.back_sidedef =
+      two_sided ? add_sidedef(back, two_sided) : Level::no_sidedef;
+
+  float angle = glm::degrees(std::atan2(static_cast<float>(y1 - y0),
+                                        static_cast<float>(x1 - x0)));
+  Level::RawSeg seg{};
+  seg.start_vertex = linedef.start_vertex;
+  seg.end_vertex = linedef.end_vertex;
+  seg.angle = deg_to_doom_angle(angle);
+  seg.linedef = to_raw_index(linedefs.size());
+  seg.direction = 0;
+  seg.offset = 0;
+  cell_segs[static_cast<std::size_t>(front)].emplace_back(seg);
+  if (two_sided) {
+    std::swap(seg.start_vertex, seg.end_vertex);
+    seg.angle = deg_to_doom_angle((angle > 0.0f) ? angle - 180.0f
+                                                 : angle + 180.0f);
+    seg.direction = 1;
+    cell_segs[static_cast<std::size_t>(back)].emplace_back(seg);
+  }
+  linedefs.emplace_back(linedef);
+}
+
+uint16_t MapGenerator::add_sidedef(int sector, bool two_sided) {
+  std::uniform_int_distribution<std::size_t> texture(
+      0, std::size(wall_textures) - 1);
+  Level::RawSidedef sidedef{};
+  if (two_sided) {
+    copy_name(sidedef.upper_name, wall_textures[texture(rng)]);
+    copy_name(sidedef.lower_name, wall_textures[texture(rng)]);
+    copy_name(sidedef.middle_name, "-");
+  } else {
+    copy_name(sidedef.upper_name, "-");
+    copy_name(sidedef.lower_name, "-");
+    copy_name(sidedef.middle_name, wall_textures[texture(rng)]);
+  }
+  sidedef.sector_facing = static_cast<int16_t>(sector);
+  sidedefs.emplace_back(sidedef);
+  return to_raw_index(sidedefs.size() - 1);
+}
+
+uint16_t MapGenerator::get_vertex(int x, int y) {
+  int32_t key = static_cast<int32_t>(static_cast<uint32_t>(x) << 16 |
+                                     static_cast<uint16_t>(y));
+  auto found = vertex_indices.find(key);
+  if (found != vertex_indices.end())
+    return found->second;
+
+  uint16_t index = to_raw_index(vertices.size());
+  vertices.emplace_back(
+      Level::RawVertex{static_cast<int16_t>(x), static_cast<int16_t>(y)});
+  vertex_indices.emplace(key, index);
+  return index;
+}
+
+uint16_t MapGenerator::build_node(CellRect rect) {
+  rect = trim_rect(rect);
+  const unsigned width = rect.col_end - rect.col_start;
+  const unsigned height = rect.row_end - rect.row_start;
+  // Every room is convex, so single rooms become subsectors
+  if (width == 1 && height == 1) {
+    int cell = get_cell(rect.col_start, rect.row_start);
+    return to_raw_child(static_cast<std::size_t>(cell), true);
+  }
+
+  // Split the longest side in half. The right child is always the front of the
+  // partition line.
+  Level::RawNode node{};
+  CellRect right = rect;
+  CellRect left = rect;
+  if (width >= height) {
+    unsigned mid = rect.col_start + width / 2;
+    node.x_part_start = static_cast<int16_t>(get_grid_x(mid));
+    node.y_part_start = static_cast<int16_t>(get_grid_y(rect.row_start));
+    node.x_part_delta = 0;
+    node.y_part_delta = static_cast<int16_t>(get_grid_y(rect.row_end) -
+                                             get_grid_y(rect.row_start));
+    right.col_start = mid;
+    left.col_end = mid;
+  } else {
+    unsigned mid = rect.row_start + height / 2;
+    node.x_part_start = static_cast<int16_t>(get_grid_x(rect.col_start));
+    node.y_part_start = static_cast<int16_t>(get_grid_y(mid));
+    node.x_part_delta = static_cast<int16_t>(get_grid_x(rect.col_end) -
+                                             get_grid_x(rect.col_start));
+    node.y_part_delta = 0;
+    right.row_end = mid;
+    left.row_start = mid;
+  }
+  right = trim_rect(right);
+  left = trim_rect(left);
+
+  auto set_bounds = [&](auto& bounds, const CellRect& child) {
+    bounds.names.top = static_cast<int16_t>(get_grid_y(child.row_end));
+    bounds.names.bottom = static_cast<int16_t>(get_grid_y(child.row_start));
+    bounds.names.left = static_cast<int16_t>(get_grid_x(child.col_start));
+    bounds.names.right = static_cast<int16_t>(get_grid_x(child.col_end));
+  };
+  set_bounds(node.right_bounds, right);
+  set_bounds(node.left_bounds, left);
+  node.right_child = build_node(right);
+  node.left_child = build_node(left);
+
+  // Children are added first, so the root is the highest-numbered node
+  nodes.emplace_back(node);
+  return to_raw_child(nodes.size() - 1, false);
+}
+
+MapGenerator::CellRect MapGenerator::trim_rect(const CellRect& rect) const {
+  CellRect out{rect.col_end, rect.col_start, rect.row_end, rect.row_start};
+  for (unsigned row = rect.row_start; row < rect.row_end; ++row) {
+    for (unsigned col = rect.col_start; col < rect.col_end; ++col) {
+      if (get_cell(col, row) < 0)
+        continue;
+      out.col_start = std::min(out.col_start, col);
+      out.col_end = std::max(out.col_end, col + 1);
+      out.row_start = std::min(out.row_start, row);
+      out.row_end = std::max(out.row_end, row + 1);
+    }
+  }
+  return out;
+}
+
+int MapGenerator::get_cell(unsigned col, unsigned row) const noexcept {
+  if (col >= cols || row >= rows)
+    return -1;
+  unsigned cell = row * cols + col;
+  return (cell < config.sector_count) ? static_cast<int>(cell) : -1;
+}
+
+int MapGenerator::get_grid_x(unsigned col) const noexcept {
+  const int size = config.open_area_size;
+  return static_cast<int>(col) * size - static_cast<int>(cols) * size / 2;
+}
+int MapGenerator::get_grid_y(unsigned row) const noexcept {
+  const int size = config.open_area_size;
+  return static_cast<int>(row) * size - static_cast<int>(rows) * size / 2;
+}
+}  // namespace woop
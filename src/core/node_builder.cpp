@@ -0,0 +1,339 @@
+/**
+ * @file node_builder.cpp
+ * @authors quak
+ * @brief Defines members of the NodeBuilder class.
+ */
+
+#include "node_builder.hpp"
+#include "level.hpp"             /* woop::LevelException */
+#include "profiler.hpp"          /* WOOP_PROFILE_SCOPE */
+#include "thread_pool.hpp"       /* woop::ThreadPool */
+#include "glm/vec2.hpp"          /* glm::dvec2 */
+#include "glm/geometric.hpp"     /* glm::dot, glm::length */
+#include "glm/trigonometric.hpp" /* glm::degrees */
+#include <cmath>                 /* std::abs, std::atan2 */
+#include <cstdlib>               /* std::llabs */
+#include <limits>                /* std::numeric_limits */
+#include <unordered_map>         /* std::unordered_map */
+
+namespace woop {
+namespace {
+// Split points are computed in doubles, like BSP regions (see geometry.hpp)
+using Point = glm::dvec2;
+
+// Distance within which a point counts as lying on a partition line
+constexpr double on_epsilon = 1e-3;
+// Candidates times segs below which partitions are scored on the calling
+// thread, since spreading small loops across the pool costs more than it saves
+constexpr std::size_t parallel_threshold = 1 << 14;
+
+/**
+ * @brief A seg while the tree is being built.
+ */
+struct BuildSeg {
+  Point start;
+  Point end;
+  uint32_t start_vertex;
+  uint32_t end_vertex;
+  uint32_t linedef;
+  bool back;
+  int32_t sector;
+  double offset;
+};
+
+/**
+ * @brief Which side of a partition a seg lies on.
+ */
+enum class Side { Right, Left, Split };
+
+/**
+ * @brief Counts of the segs on each side of a candidate partition.
+ */
+struct Score {
+  std::size_t right = 0;
+  std::size_t left = 0;
+  std::size_t splits = 0;
+  uint64_t cost = std::numeric_limits<uint64_t>::max();
+
+  bool is_valid() const noexcept {
+    return cost != std::numeric_limits<uint64_t>::max();
+  }
+};
+
+/**
+ * @brief Returns the signed distance from a partition to a point, positive on
+ * its right (like Node::get_nearest_child()).
+ */
+double get_distance(const BuildSeg& partition, const Point& point) noexcept {
+  Point delta = partition.end - partition.start;
+  return ((point.x - partition.start.x) * delta.y -
+          (point.y - partition.start.y) * delta.x) /
+         glm::length(delta);
+}
+
+Side classify(const BuildSeg& partition, const BuildSeg& seg) noexcept {
+  double start = get_distance(partition, seg.start);
+  double end = get_distance(partition, seg.end);
+  if (std::abs(start) < on_epsilon && std::abs(end) < on_epsilon) {
+    // Segs along the partition go on the side they face
+    return glm::dot(seg.end - seg.start, partition.end - partition.start) > 0.0
+               ? Side::Right
+               : Side::Left;
+  }
+  if (start > -on_epsilon && end > -on_epsilon)
+    return Side::Right;
+  if (start < on_epsilon && end < on_epsilon)
+    return Side::Left;
+  return Side::Split;
+}
+
+/**
+ * @brief Returns true if no seg lies behind another, so that the segs bound a
+ * convex region.
+ */
+bool is_convex(const std::vector<BuildSeg>& segs) noexcept {
+  for (const BuildSeg& partition : segs) {
+    for (const BuildSeg& seg : segs) {
+      if (&seg != &partition && classify(partition, seg) != Side::Right)
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Recursively splits segs into a tree.
+ */
+class TreeBuilder {
+ public:
+  TreeBuilder(const NodeBuilderConfig& cfg,
+              std::size_t vertex_count,
+              ThreadPool& thread_pool,
+              BspTree& out)
+      : config(cfg),
+        first_new_vertex(vertex_count),
+        pool(thread_pool),
+        tree(out) {}
+
+  /**
+   * @brief Builds the subtree holding a set of segs, returning its index as a
+   * child of its parent node.
+   */
+  uint32_t build(std::vector<BuildSeg> segs) {
+    if (is_leaf(segs))
+      return add_subsector(segs);
+    const BuildSeg* partition = choose_partition(segs, config.max_candidates);
+    if (!partition)
+      partition = choose_partition(segs, 0);
+    // Nothing divides the segs (e.g. sectors that overlap), so keep them
+    // together
+    if (!partition)
+      return add_subsector(segs);
+
+    BspTree::Node node;
+    node.partition_start = to_vec2(partition->start);
+    node.partition_delta = to_vec2(partition->end - partition->start);
+    std::vector<BuildSeg> right;
+    std::vector<BuildSeg> left;
+    split(segs, *partition, right, left);
+    segs = std::vector<BuildSeg>();
+    node.right_child = build(std::move(right));
+    node.left_child = build(std::move(left));
+    tree.nodes.push_back(node);
+    return static_cast<uint32_t>(tree.nodes.size() - 1);
+  }
+
+ private:
+  static glm::vec2 to_vec2(const Point& point) noexcept {
+    return {static_cast<float>(point.x), static_cast<float>(point.y)};
+  }
+
+  /**
+   * @brief Returns true if segs are convex and face a single sector, so they
+   * can form a subsector.
+   */
+  static bool is_leaf(const std::vector<BuildSeg>& segs) noexcept {
+    for (const BuildSeg& seg : segs) {
+      if (seg.sector != segs.front().sector)
+        return false;
+    }
+    return is_convex(segs);
+  }
+
+  uint32_t add_subsector(const std::vector<BuildSeg>& segs) {
+    BspTree::Subsector subsector;
+    subsector.first_seg = static_cast<uint32_t>(tree.segs.size());
+    subsector.seg_count = static_cast<uint32_t>(segs.size());
+    for (const BuildSeg& seg : segs) {
+      Point delta = seg.end - seg.start;
+      float angle =
+          static_cast<float>(glm::degrees(std::atan2(delta.y, delta.x)));
+      tree.segs.push_back({seg.start_vertex, seg.end_vertex, seg.linedef,
+                           seg.back, angle, static_cast<float>(seg.offset)});
+    }
+    tree.subsectors.push_back(subsector);
+    return static_cast<uint32_t>(tree.subsectors.size() - 1) |
+           BspTree::subsector_bit;
+  }
+
+  /**
+   * @brief Returns the seg along the best partition line, or nullptr if no
+   * candidate divides the segs.
+   * @param max_candidates Most segs to try (0 tries all of them)
+   */
+  const BuildSeg* choose_partition(const std::vector<BuildSeg>& segs,
+                                   unsigned max_candidates) {
+    std::size_t count = segs.size();
+    if (max_candidates > 0 && count > max_candidates)
+      count = max_candidates;
+    std::vector<Score> scores(count);
+    auto score_candidate = [&](std::size_t i) {
+      // Candidates are spread evenly over the segs
+      scores[i] = score(segs, segs[i * segs.size() / count]);
+    };
+    if (count * segs.size() < parallel_threshold) {
+      for (std::size_t i = 0; i < count; ++i)
+        score_candidate(i);
+    } else
+      pool.parallel_for(count, score_candidate);
+
+    // Ties go to the first candidate, so trees don't depend on thread timing
+    std::size_t best = count;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (scores[i].is_valid() &&
+          (best == count || scores[i].cost < scores[best].cost))
+        best = i;
+    }
+    return (best == count) ? nullptr : &segs[best * segs.size() / count];
+  }
+
+  Score score(const std::vector<BuildSeg>& segs,
+              const BuildSeg& partition) const noexcept {
+    Score result;
+    Point delta = partition.end - partition.start;
+    if (glm::length(delta) < on_epsilon)
+      return result;
+    for (const BuildSeg& seg : segs) {
+      switch (classify(partition, seg)) {
+        case Side::Right:
+          ++result.right;
+          break;
+        case Side::Left:
+          ++result.left;
+          break;
+        case Side::Split:
+          ++result.splits;
+          break;
+      }
+    }
+    // Partitions must leave segs on both sides
+    if (result.right + result.splits == 0 || result.left + result.splits == 0)
+      return result;
+    auto difference = static_cast<int64_t>(result.right) -
+                      static_cast<int64_t>(result.left);
+    result.cost = config.split_cost * result.splits +
+                  config.balance_cost * static_cast<uint64_t>(
+                                            std::llabs(difference));
+    if (delta.x != 0.0 && delta.y != 0.0)
+      result.cost += config.diagonal_cost;
+    return result;
+  }
+
+  void split(const std::vector<BuildSeg>& segs,
+             const BuildSeg& partition,
+             std::vector<BuildSeg>& right,
+             std::vector<BuildSeg>& left) {
+    // Both sides of a linedef are split at the same new vertex
+    std::unordered_map<uint32_t, uint32_t> split_vertices;
+    for (const BuildSeg& seg : segs) {
+      Side side = classify(partition, seg);
+      if (side == Side::Right) {
+        right.push_back(seg);
+        continue;
+      }
+      if (side == Side::Left) {
+        left.push_back(seg);
+        continue;
+      }
+      double start_distance = get_distance(partition, seg.start);
+      double end_distance = get_distance(partition, seg.end);
+      double t = start_distance / (start_distance - end_distance);
+      Point cut = seg.start + (seg.end - seg.start) * t;
+      auto [it, added] = split_vertices.emplace(
+          seg.linedef, static_cast<uint32_t>(first_new_vertex +
+                                             tree.vertices.size()));
+      if (added)
+        tree.vertices.push_back(to_vec2(cut));
+      // Use the vertex as stored, so that segs meet exactly
+      const glm::vec2& vertex = tree.vertices[it->second - first_new_vertex];
+      cut = {vertex.x, vertex.y};
+
+      BuildSeg first = seg;
+      first.end = cut;
+      first.end_vertex = it->second;
+      BuildSeg second = seg;
+      second.start = cut;
+      second.start_vertex = it->second;
+      second.offset = seg.offset + glm::length(cut - seg.start);
+      (start_distance > 0.0 ? right : left).push_back(first);
+      (start_distance > 0.0 ? left : right).push_back(second);
+    }
+  }
+
+  const NodeBuilderConfig& config;
+  std::size_t first_new_vertex;
+  ThreadPool& pool;
+  BspTree& tree;
+};
+}  // namespace
+
+NodeBuilder::NodeBuilder(const NodeBuilderConfig& cfg) : config(cfg) {}
+
+BspTree NodeBuilder::build(const std::vector<glm::vec2>& vertices,
+                           const std::vector<Line>& lines,
+                           ThreadPool& pool) const {
+  WOOP_PROFILE_SCOPE("NodeBuilder::build");
+  // One seg for each side of each line
+  std::vector<BuildSeg> segs;
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    const Line& line = lines[i];
+    if (line.start_vertex >= vertices.size() ||
+        line.end_vertex >= vertices.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Linedef refers to vertices that don't exist");
+    Point start = {vertices[line.start_vertex].x,
+                   vertices[line.start_vertex].y};
+    Point end = {vertices[line.end_vertex].x, vertices[line.end_vertex].y};
+    if (glm::length(end - start) < on_epsilon)
+      continue;
+    auto index = static_cast<uint32_t>(i);
+    if (line.front_sector >= 0)
+      segs.push_back({start, end, line.start_vertex, line.end_vertex, index,
+                      false, line.front_sector, 0.0});
+    if (line.back_sector >= 0)
+      segs.push_back({end, start, line.end_vertex, line.start_vertex, index,
+                      true, line.back_sector, 0.0});
+  }
+  if (segs.empty())
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Level has no sided linedefs to build nodes from");
+
+  BspTree tree;
+  TreeBuilder builder(config, vertices.size(), pool, tree);
+  uint32_t root = builder.build(std::move(segs));
+  // Levels made of a single convex sector still need a root node. Its
+  // partition runs along a seg, so the subsector lies on its right, and
+  // nothing lies on its left.
+  if (tree.nodes.empty()) {
+    const BspTree::Seg& seg = tree.segs.front();
+    glm::vec2 start = seg.start_vertex < vertices.size()
+                          ? vertices[seg.start_vertex]
+                          : tree.vertices[seg.start_vertex - vertices.size()];
+    glm::vec2 end = seg.end_vertex < vertices.size()
+                        ? vertices[seg.end_vertex]
+                        : tree.vertices[seg.end_vertex - vertices.size()];
+    tree.nodes.push_back({start, end - start, root, root});
+  }
+  return tree;
+}
+}  // namespace woop
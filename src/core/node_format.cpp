@@ -0,0 +1,272 @@
+/**
+ * @file node_format.cpp
+ * @authors quak
+ * @brief Defines functions declared in node_format.hpp.
+ */
+
+#include "node_format.hpp"
+#include "level.hpp"             /* woop::Level, woop::LevelException */
+#include "utils.hpp"             /* woop::doom_angle_to_deg */
+#include "glm/geometric.hpp"     /* glm::length */
+#include "glm/trigonometric.hpp" /* glm::degrees */
+#include <cmath>                 /* std::atan2 */
+#include <cstring>               /* std::memcpy */
+#include <string_view>           /* std::string_view */
+
+namespace woop {
+namespace {
+// Extended formats store fractional coordinates as 16.16 fixed point numbers
+constexpr double fixed_scale = 65536.0;
+// Linedef index of minisegs, which don't lie along a linedef
+constexpr uint32_t no_linedef = 0xffffffffu;
+
+/**
+ * @brief Reads values from a lump in order, throwing if it ends early.
+ */
+class LumpReader {
+ public:
+  LumpReader(const std::vector<std::byte>& lump) : data(lump), position(0) {}
+
+  template <typename T>
+  T read() {
+    require(sizeof(T));
+    T value;
+    std::memcpy(&value, data.data() + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+  float read_fixed() {
+    return static_cast<float>(read<int32_t>() / fixed_scale);
+  }
+  /**
+   * @brief Reads the length of a list, making sure the lump is long enough to
+   * hold it.
+   */
+  std::size_t read_count(std::size_t element_size) {
+    std::size_t count = read<uint32_t>();
+    if (count > (data.size() - position) / element_size)
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Extended nodes end early");
+    return count;
+  }
+  void skip(std::size_t size) {
+    require(size);
+    position += size;
+  }
+
+ private:
+  void require(std::size_t size) const {
+    if (data.size() - position < size)
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Extended nodes end early");
+  }
+
+  const std::vector<std::byte>& data;
+  std::size_t position;
+};
+
+/**
+ * @brief A seg as extended formats store it.
+ */
+struct ExtendedSeg {
+  uint32_t start_vertex;
+  uint32_t end_vertex;
+  uint32_t linedef;
+  bool back;
+};
+
+template <typename T>
+std::vector<T> get_data_as(const std::vector<std::byte>& data) {
+  if (data.size() % sizeof(T) != 0)
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Node lump ends partway through an entry");
+  std::vector<T> out(data.size() / sizeof(T));
+  if (!out.empty())
+    std::memcpy(out.data(), data.data(), out.size() * sizeof(T));
+  return out;
+}
+
+BspTree read_vanilla_nodes(const std::vector<std::byte>& segs,
+                           const std::vector<std::byte>& subsectors,
+                           const std::vector<std::byte>& nodes) {
+  BspTree tree;
+  for (const auto& raw_seg : get_data_as<Level::RawSeg>(segs)) {
+    tree.segs.push_back({
+        raw_seg.start_vertex,
+        raw_seg.end_vertex,
+        raw_seg.linedef,
+        raw_seg.direction != 0,
+        doom_angle_to_deg(raw_seg.angle),
+        static_cast<float>(raw_seg.offset),
+    });
+  }
+  for (const auto& raw_subsector :
+       get_data_as<Level::RawSubsector>(subsectors)) {
+    tree.subsectors.push_back({raw_subsector.first_seg,
+                               raw_subsector.seg_count});
+  }
+  auto get_child = [](uint16_t child) -> uint32_t {
+    if (child & Level::subsector_bit)
+      return static_cast<uint32_t>(child ^ Level::subsector_bit) |
+             BspTree::subsector_bit;
+    return child;
+  };
+  for (const auto& raw_node : get_data_as<Level::RawNode>(nodes)) {
+    tree.nodes.push_back({
+        {raw_node.x_part_start, raw_node.y_part_start},
+        {raw_node.x_part_delta, raw_node.y_part_delta},
+        get_child(raw_node.right_child),
+        get_child(raw_node.left_child),
+    });
+  }
+  return tree;
+}
+
+std::optional<BspTree> read_extended_nodes(
+    const std::vector<std::byte>& lump,
+    NodeFormat format,
+    const std::vector<glm::vec2>& vertices,
+    const std::vector<NodeBuilder::Line>& lines) {
+  const bool gl = format != NodeFormat::XNOD;
+  const bool wide_linedefs =
+      format == NodeFormat::XGL2 || format == NodeFormat::XGL3;
+  LumpReader reader(lump);
+  reader.skip(4);  // Signature
+  BspTree tree;
+
+  // Vertices
+  if (reader.read<uint32_t>() != vertices.size())
+    throw LevelException(LevelException::Type::InvalidData,
+                         "Extended nodes were built for different vertices");
+  std::size_t vertex_count = reader.read_count(2 * sizeof(int32_t));
+  tree.vertices.reserve(vertex_count);
+  for (std::size_t i = 0; i < vertex_count; ++i)
+    tree.vertices.push_back({reader.read_fixed(), reader.read_fixed()});
+
+  // Subsectors, which only store their seg counts
+  std::vector<uint32_t> seg_counts(reader.read_count(sizeof(uint32_t)));
+  for (uint32_t& seg_count : seg_counts)
+    seg_count = reader.read<uint32_t>();
+
+  // Segs
+  std::vector<ExtendedSeg> segs(reader.read_count(wide_linedefs ? 13 : 11));
+  for (ExtendedSeg& seg : segs) {
+    seg.start_vertex = reader.read<uint32_t>();
+    // GL segs store their partner seg (on the other side of the line) here,
+    // which is replaced by their end vertex below
+    seg.end_vertex = reader.read<uint32_t>();
+    if (wide_linedefs) {
+      seg.linedef = reader.read<uint32_t>();
+    } else {
+      uint16_t linedef = reader.read<uint16_t>();
+      seg.linedef = (gl && linedef == 0xffff) ? no_linedef : linedef;
+    }
+    seg.back = reader.read<uint8_t>() != 0;
+  }
+
+  // Nodes. Their children use the same subsector bit as BspTree.
+  const std::size_t partition_size =
+      (format == NodeFormat::XGL3) ? sizeof(int32_t) : sizeof(int16_t);
+  std::size_t node_count = reader.read_count(
+      4 * partition_size + 8 * sizeof(int16_t) + 2 * sizeof(uint32_t));
+  tree.nodes.reserve(node_count);
+  for (std::size_t i = 0; i < node_count; ++i) {
+    BspTree::Node node;
+    if (format == NodeFormat::XGL3) {
+      node.partition_start = {reader.read_fixed(), reader.read_fixed()};
+      node.partition_delta = {reader.read_fixed(), reader.read_fixed()};
+    } else {
+      node.partition_start = {reader.read<int16_t>(), reader.read<int16_t>()};
+      node.partition_delta = {reader.read<int16_t>(), reader.read<int16_t>()};
+    }
+    reader.skip(8 * sizeof(int16_t));  // Bounding boxes
+    node.right_child = reader.read<uint32_t>();
+    node.left_child = reader.read<uint32_t>();
+    tree.nodes.push_back(node);
+  }
+
+  auto get_vertex = [&](uint32_t index) {
+    if (index >= vertices.size() + tree.vertices.size())
+      throw LevelException(LevelException::Type::InvalidData,
+                           "Extended segs refer to vertices that don't exist");
+    return (index < vertices.size()) ? vertices[index]
+                                     : tree.vertices[index - vertices.size()];
+  };
+  std::size_t first_seg = 0;
+  for (uint32_t seg_count : seg_counts) {
+    if (seg_count > segs.size() - first_seg)
+      throw LevelException(
+          LevelException::Type::InvalidData,
+          "Extended subsectors refer to segs that don't exist");
+    ExtendedSeg* subsector_segs = segs.data() + first_seg;
+    first_seg += seg_count;
+    BspTree::Subsector subsector{static_cast<uint32_t>(tree.segs.size()), 0};
+    for (uint32_t i = 0; i < seg_count; ++i) {
+      ExtendedSeg& seg = subsector_segs[i];
+      // GL segs run to the start of the next seg around the subsector
+      if (gl)
+        seg.end_vertex = subsector_segs[(i + 1) % seg_count].start_vertex;
+      if (seg.linedef == no_linedef)
+        continue;
+      if (seg.linedef >= lines.size())
+        throw LevelException(
+            LevelException::Type::InvalidData,
+            "Extended segs refer to linedefs that don't exist");
+
+      // Offsets are measured from the start of the linedef's side
+      const NodeBuilder::Line& line = lines[seg.linedef];
+      glm::vec2 start = get_vertex(seg.start_vertex);
+      glm::vec2 delta = get_vertex(seg.end_vertex) - start;
+      glm::vec2 side_start =
+          get_vertex(seg.back ? line.end_vertex : line.start_vertex);
+      tree.segs.push_back({seg.start_vertex, seg.end_vertex, seg.linedef,
+                           seg.back,
+                           glm::degrees(std::atan2(delta.y, delta.x)),
+                           glm::length(start - side_start)});
+      ++subsector.seg_count;
+    }
+    // Without a seg along a linedef, a subsector has no sector
+    if (subsector.seg_count == 0)
+      return std::nullopt;
+    tree.subsectors.push_back(subsector);
+  }
+  return tree;
+}
+}  // namespace
+
+NodeFormat get_node_format(const std::vector<std::byte>& lump) noexcept {
+  if (lump.size() < 4)
+    return NodeFormat::Vanilla;
+  std::string_view signature(reinterpret_cast<const char*>(lump.data()), 4);
+  if (signature == "XNOD")
+    return NodeFormat::XNOD;
+  if (signature == "XGLN")
+    return NodeFormat::XGLN;
+  if (signature == "XGL2")
+    return NodeFormat::XGL2;
+  if (signature == "XGL3")
+    return NodeFormat::XGL3;
+  if (signature == "ZNOD" || signature == "ZGLN" || signature == "ZGL2" ||
+      signature == "ZGL3")
+    return NodeFormat::Compressed;
+  return NodeFormat::Vanilla;
+}
+
+std::optional<BspTree> read_node_lumps(
+    const std::vector<std::byte>& segs,
+    const std::vector<std::byte>& subsectors,
+    const std::vector<std::byte>& nodes,
+    const std::vector<glm::vec2>& vertices,
+    const std::vector<NodeBuilder::Line>& lines) {
+  for (const std::vector<std::byte>* lump : {&nodes, &subsectors}) {
+    NodeFormat format = get_node_format(*lump);
+    if (format == NodeFormat::Compressed)
+      return std::nullopt;
+    if (format != NodeFormat::Vanilla)
+      return read_extended_nodes(*lump, format, vertices, lines);
+  }
+  if (segs.empty() || subsectors.empty() || nodes.empty())
+    return std::nullopt;
+  return read_vanilla_nodes(segs, subsectors, nodes);
+}
+}  // namespace woop
@@ -5,10 +5,11 @@
  */
 
 #include "player.hpp"
-#include <stdexcept>
 #include "GLFW/glfw3.h"
+#include "glm/common.hpp"
 #include "glm/geometric.hpp"
 #include "level.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
 
 namespace woop {
@@ -16,7 +17,11 @@ namespace woop {
 constexpr int16_t player_start_thing = 1;
 
 Player::Player(Camera& cam, const Level& lvl, const PlayerConfig& conf)
-    : config(conf), camera(cam), horiz_vel(0.0f), vert_vel(0.0f) {
+    : config(conf),
+      collider(lvl, conf.body),
+      camera(cam),
+      horiz_vel(0.0f),
+      vert_vel(0.0f) {
   GLFWwindow* window = camera.get_window().get_wrapped();
   // Set window callbacks
   glfwSetKeyCallback(window, key_callback);
@@ -28,13 +33,28 @@ Player::Player(Camera& cam, const Level& lvl, const PlayerConfig& conf)
   set_level(lvl);
 }
 
-void Player::update(float dt) {
+void Player::tick(float dt) {
+  WOOP_PROFILE_SCOPE("Player::tick");
+  prev_position = position;
+  prev_rotation = rotation;
   update_position(dt);
   update_rotation();
 }
+void Player::interpolate(float alpha) noexcept {
+  // Turn the short way around when the rotation wraps
+  float turn = rotation - prev_rotation;
+  if (turn > 180.0f)
+    turn -= 360.0f;
+  else if (turn < -180.0f)
+    turn += 360.0f;
+  camera.set_position(glm::mix(prev_position, position, alpha));
+  camera.set_rotation(prev_rotation + turn * alpha);
+}
 
 void Player::set_level(const Level& lvl) noexcept {
   level = &lvl;
+  collider.set_level(lvl);
+  current_subsector = nullptr;
   is_subsector_dirty = true;
 
   // Search for player start position
@@ -46,9 +66,17 @@ void Player::set_level(const Level& lvl) noexcept {
           config.camera_height,
           thing.position.y,
       });
-      camera.set_rotation(thing.angle - 90.0f);
+      // Camera rotations are clockwise, thing angles are counter-clockwise
+      camera.set_rotation(-thing.angle);
     }
   }
+  // Start without interpolating from the old level's pose
+  position = prev_position = camera.get_position();
+  rotation = prev_rotation = camera.get_rotation();
+  PositionCheck check = collider.check_position(
+      {position.x, position.z}, position.y - config.camera_height);
+  floor_height = check.floor;
+  ceiling_height = check.ceiling;
 }
 
 const Subsector& Player::get_current_subsector() noexcept {
@@ -58,13 +86,13 @@ const Subsector& Player::get_current_subsector() noexcept {
 }
 
 void Player::update_current_subsector() {
-  const Node* node = &level->get_root_node();
-  Node::Child nearest_child = node->get_nearest_child(camera.get_position_2d());
-  while (node->is_node(nearest_child)) {
-    node = &node->get_node(nearest_child);
-    nearest_child = node->get_nearest_child(camera.get_position_2d());
-  }
-  current_subsector = &node->get_subsector(nearest_child);
+  // Walk from the last subsector, since the player rarely moves far
+  const PointLocator& locator = level->get_locator();
+  glm::vec2 position_2d = {position.x, position.z};
+  if (current_subsector)
+    current_subsector = &locator.locate(position_2d, *current_subsector);
+  else
+    current_subsector = &locator.locate(position_2d);
   is_subsector_dirty = false;
 }
 
@@ -74,15 +102,26 @@ void Player::update_position(float dt) {
   do_horizontal_accel(direction, dt);
   if (config.enable_flight)
     do_flight(dt);
-  do_gravity(dt);
 
-  if (horiz_vel.x != 0.0f || horiz_vel.y != 0.0f || vert_vel != 0.0f) {
-    glm::vec3 velocity = {
-        horiz_vel.x,
-        vert_vel,
-        horiz_vel.y,
-    };
-    camera.set_position(camera.get_position() + velocity * dt);
+  // Move against the walls, then find the floor and ceiling where we ended up
+  glm::vec2 position_2d = {position.x, position.z};
+  float feet = position.y - config.camera_height;
+  if (dt > 0.0f && (horiz_vel.x != 0.0f || horiz_vel.y != 0.0f)) {
+    glm::vec2 moved = collider.slide_move(position_2d, horiz_vel * dt, feet);
+    // Walls absorb the part of the velocity that went into them
+    horiz_vel = (moved - position_2d) / dt;
+    position_2d = moved;
+    position.x = moved.x;
+    position.z = moved.y;
+    is_subsector_dirty = true;
+  }
+  PositionCheck check = collider.check_position(position_2d, feet);
+  floor_height = check.floor;
+  ceiling_height = check.ceiling;
+
+  do_gravity(dt);
+  if (vert_vel != 0.0f) {
+    position.y += vert_vel * dt;
     is_subsector_dirty = true;
   }
 }
@@ -91,16 +130,16 @@ glm::vec2 Player::get_direction() const noexcept {
   if (config.enable_mouse) {
     // X input used for movement
     return {
-        -input.x * sin(glm::radians(camera.get_rotation())) +
-            input.z * cos(glm::radians(camera.get_rotation())),
-        -input.x * cos(glm::radians(camera.get_rotation())) -
-            input.z * sin(glm::radians(camera.get_rotation())),
+        -input.x * sin(glm::radians(rotation)) +
+            input.z * cos(glm::radians(rotation)),
+        -input.x * cos(glm::radians(rotation)) -
+            input.z * sin(glm::radians(rotation)),
     };
   }
   // X input used for rotation
   return {
-      input.z * cos(glm::radians(camera.get_rotation())),
-      -input.z * sin(glm::radians(camera.get_rotation())),
+      input.z * cos(glm::radians(rotation)),
+      -input.z * sin(glm::radians(rotation)),
   };
 }
 
@@ -132,23 +171,24 @@ void Player::do_flight(float dt) {
 }
 
 void Player::do_gravity(float dt) {
-  if (camera.get_position().y > get_floor_height() + config.camera_height) {
+  // Stop at the ceiling
+  float top = position.y - config.camera_height + config.body.height;
+  if (top > ceiling_height) {
+    position.y -= top - ceiling_height;
+    vert_vel = std::min(vert_vel, 0.0f);
+  }
+
+  if (position.y > floor_height + config.camera_height) {
     if (!config.enable_flight)
       vert_vel -= config.gravity * dt;
   } else {
     if (!config.enable_flight || input.y <= 0)
       vert_vel = 0.0f;
-    camera.set_position(glm::vec3{
-        camera.get_position().x,
-        get_floor_height() + config.camera_height,
-        camera.get_position().z,
-    });
+    position.y = floor_height + config.camera_height;
   }
 }
 
 void Player::update_rotation() {
-  float rotation = camera.get_rotation();
-
   if (config.enable_mouse) {
     // Calculate mouse movement
     static double mouse_prev_x = 0.0f;
@@ -166,8 +206,6 @@ void Player::update_rotation() {
   // Loop rotation when it goes beyond 360 deg
   while (rotation > 360.0f)
     rotation -= 360.0f;
-
-  camera.set_rotation(rotation);
 }
 
 void Player::key_callback(GLFWwindow* window,
@@ -223,17 +261,4 @@ void Player::window_focus_callback(GLFWwindow* window, int focused) {
   else
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 }
-
-float Player::get_floor_height() {
-  const Subsector& subsector = get_current_subsector();
-  if (subsector.segs.empty())
-    throw std::runtime_error("No segs in sector.");
-
-  for (const Seg* seg : subsector.segs) {
-    const Sidedef* sidedef = seg->sidedef;
-    if (sidedef)
-      return sidedef->sector_facing.floor.height;
-  }
-  return 0.0f;
-}
 }  // namespace woop
\ No newline at end of file
@@ -0,0 +1,219 @@
+/**
+ * @file point_locator.cpp
+ * @authors quak
+ * @brief Defines members of the PointLocator class.
+ */
+
+#include "point_locator.hpp"
+#include "level.hpp"         /* woop::Level, woop::Subsector */
+#include "geometry.hpp"      /* woop::ConvexRegion, woop::get_bounds */
+#include "profiler.hpp"      /* WOOP_PROFILE_SCOPE */
+#include "glm/vec2.hpp"      /* glm::dvec2 */
+#include "glm/geometric.hpp" /* glm::length */
+#include <algorithm>         /* std::clamp, std::min, std::sort */
+#include <utility>           /* std::pair */
+
+namespace woop {
+namespace {
+using Point = glm::dvec2;
+
+// Space left around the level's vertices, in map units
+constexpr float bounds_margin = 64.0f;
+// How far edges are moved across their line to find the regions bordering
+// them
+constexpr double neighbor_offset = 1e-3;
+// Size of the grid cells that batched points are ordered by
+constexpr float batch_cell_size = 64.0f;
+
+struct Segment {
+  Point start;
+  Point end;
+};
+
+Point to_point(const glm::vec2& point) noexcept {
+  return {point.x, point.y};
+}
+glm::vec2 to_vec2(const Point& point) noexcept {
+  return {static_cast<float>(point.x), static_cast<float>(point.y)};
+}
+
+Segment get_partition(const Node& node) noexcept {
+  return {to_point(node.get_partition_start()),
+          to_point(node.get_partition_end())};
+}
+
+/**
+ * @brief Returns true if the line through two points separates (or touches)
+ * the ends of a segment.
+ */
+bool crosses(const glm::vec2& from,
+             const glm::vec2& to,
+             const glm::vec2& start,
+             const glm::vec2& end) noexcept {
+  double start_side = get_side(to_point(from), to_point(to), to_point(start));
+  double end_side = get_side(to_point(from), to_point(to), to_point(end));
+  return (start_side <= 0.0 && end_side >= 0.0) ||
+         (start_side >= 0.0 && end_side <= 0.0);
+}
+
+/**
+ * @brief Spreads the low 16 bits of a number out to the even bits.
+ */
+uint64_t spread_bits(uint32_t value) noexcept {
+  uint64_t bits = value & 0xffff;
+  bits = (bits | (bits << 8)) & 0x00ff00ff;
+  bits = (bits | (bits << 4)) & 0x0f0f0f0f;
+  bits = (bits | (bits << 2)) & 0x33333333;
+  bits = (bits | (bits << 1)) & 0x55555555;
+  return bits;
+}
+}  // namespace
+
+PointLocator::PointLocator()
+    : level(nullptr), bounds_min(0.0f), bounds_max(0.0f) {}
+
+PointLocator::PointLocator(const Level& lvl) : level(&lvl) {
+  WOOP_PROFILE_SCOPE("PointLocator::PointLocator");
+  Bounds bounds = get_bounds(level->get_linedefs());
+  bounds_min = bounds.min - bounds_margin;
+  bounds_max = bounds.max + bounds_margin;
+  std::vector<ConvexRegion> polygons = get_subsector_regions(
+      *level, get_box_region(to_point(bounds_min), to_point(bounds_max)),
+      false);
+
+  regions.reserve(polygons.size());
+  for (const ConvexRegion& polygon : polygons) {
+    Region region;
+    region.first_edge = static_cast<uint32_t>(edges.size());
+    region.valid = !polygon.empty();
+    Point center(0.0);
+    for (const RegionVertex& vertex : polygon)
+      center += vertex.point;
+    if (region.valid)
+      center /= static_cast<double>(polygon.size());
+    region.center = to_vec2(center);
+
+    for (std::size_t i = 0; i < polygon.size(); ++i) {
+      const RegionVertex& vertex = polygon[i];
+      if (!vertex.node)
+        continue;
+      Edge edge;
+      edge.node = vertex.node;
+      edge.child = vertex.child;
+      edge.first_piece = static_cast<uint32_t>(pieces.size());
+      // Find the regions across the edge, by following it down the other
+      // side of its partition (nudged onto that side)
+      Segment partition = get_partition(*vertex.node);
+      Point direction = partition.end - partition.start;
+      Point offset = Point(direction.y, -direction.x) *
+                     (neighbor_offset / glm::length(direction));
+      if (vertex.child == Node::Child::Right)
+        offset = -offset;
+      add_pieces(*vertex.node, !vertex.child, vertex.point,
+                 polygon[(i + 1) % polygon.size()].point, offset);
+      edge.piece_count =
+          static_cast<uint32_t>(pieces.size()) - edge.first_piece;
+      edges.push_back(edge);
+    }
+    region.edge_count = static_cast<uint32_t>(edges.size()) - region.first_edge;
+    regions.push_back(region);
+  }
+}
+
+const Subsector& PointLocator::locate(const glm::vec2& point) const {
+  if (!level)
+    throw BSPException(BSPException::Type::InvalidNodeAccess,
+                       "Locating a point without a level");
+  return level->get_subsector(point);
+}
+const Subsector& PointLocator::locate(const glm::vec2& point,
+                                      const Subsector& hint) const {
+  if (!level)
+    throw BSPException(BSPException::Type::InvalidNodeAccess,
+                       "Locating a point without a level");
+  if (point.x < bounds_min.x || point.y < bounds_min.y ||
+      point.x > bounds_max.x || point.y > bounds_max.y)
+    return locate(point);
+
+  std::size_t current = level->get_subsector_index(hint);
+  for (unsigned step = 0; step < max_walk_steps; ++step) {
+    const Region& region = regions[current];
+    if (!region.valid)
+      break;
+    bool inside = true;
+    const Piece* exit = nullptr;
+    for (uint32_t i = 0; i < region.edge_count && !exit; ++i) {
+      const Edge& edge = edges[region.first_edge + i];
+      if (edge.node->get_nearest_child(point) == edge.child)
+        continue;
+      // Leave through the piece of the edge between the center and the point
+      inside = false;
+      for (uint32_t j = 0; j < edge.piece_count; ++j) {
+        const Piece& piece = pieces[edge.first_piece + j];
+        if (crosses(region.center, point, piece.start, piece.end)) {
+          exit = &piece;
+          break;
+        }
+      }
+    }
+    if (inside)
+      return level->get_subsectors()[current];
+    if (!exit)
+      break;
+    current = exit->neighbor;
+  }
+  return locate(point);
+}
+void PointLocator::locate(Span<const glm::vec2> points,
+                          Span<const Subsector*> out) const {
+  WOOP_PROFILE_SCOPE("PointLocator::locate");
+  // Visit points along a Z-order curve over a grid, so that consecutive
+  // points are usually in the same or neighboring subsectors
+  std::size_t count = std::min(points.size(), out.size());
+  std::vector<std::pair<uint64_t, std::size_t>> order;
+  order.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    glm::vec2 cell = (points[i] - bounds_min) / batch_cell_size;
+    auto x = static_cast<uint32_t>(std::clamp(cell.x, 0.0f, 65535.0f));
+    auto y = static_cast<uint32_t>(std::clamp(cell.y, 0.0f, 65535.0f));
+    order.emplace_back(spread_bits(x) | (spread_bits(y) << 1), i);
+  }
+  std::sort(order.begin(), order.end());
+
+  const Subsector* previous = nullptr;
+  for (const auto& [key, index] : order) {
+    previous = previous ? &locate(points[index], *previous)
+                        : &locate(points[index]);
+    out[index] = previous;
+  }
+}
+
+void PointLocator::add_pieces(const Node& node,
+                              Node::Child child,
+                              const glm::dvec2& start,
+                              const glm::dvec2& end,
+                              const glm::dvec2& offset) {
+  if (node.is_subsector(child)) {
+    pieces.push_back({to_vec2(start), to_vec2(end),
+                      static_cast<uint32_t>(level->get_subsector_index(
+                          node.get_subsector(child)))});
+    return;
+  }
+  const Node& next = node.get_node(child);
+  Segment partition = get_partition(next);
+  double start_side = get_side(partition.start, partition.end, start + offset);
+  double end_side = get_side(partition.start, partition.end, end + offset);
+  Node::Child start_child =
+      (start_side < 0.0) ? Node::Child::Left : Node::Child::Right;
+  Node::Child end_child =
+      (end_side < 0.0) ? Node::Child::Left : Node::Child::Right;
+  if (start_child == end_child) {
+    add_pieces(next, start_child, start, end, offset);
+    return;
+  }
+  // Split the edge where it crosses the partition
+  Point cut = start + (end - start) * (start_side / (start_side - end_side));
+  add_pieces(next, start_child, start, cut, offset);
+  add_pieces(next, end_child, cut, end, offset);
+}
+}  // namespace woop
@@ -0,0 +1,138 @@
+/**
+ * @file post_process.cpp
+ * @authors quak
+ * @brief Defines members of the PostChain class.
+ */
+
+#include "post_process.hpp"
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include "renderer.hpp" /* woop::RenderException */
+#include <algorithm>    /* std::max */
+#include <cmath>        /* std::round */
+#include <utility>      /* std::move */
+
+namespace woop {
+PostUniforms::PostUniforms(const Shader& shader)
+    : texture(shader.get_uniform<int>("u_texture")),
+      source(shader.get_uniform<int>("u_source")),
+      resolution(shader.get_uniform<glm::vec2>("u_resolution")),
+      texel_size(shader.get_uniform<glm::vec2>("u_texel_size")),
+      time(shader.get_uniform<float>("u_time")) {
+  shader.bind_uniform_block(EngineUniforms::block_name,
+                            EngineUniforms::binding);
+}
+
+PostChain::PostChain(const std::vector<PostPassConfig>& configs,
+                     glm::uvec2 img_size,
+                     unsigned unit)
+    : image_size(img_size), output_size(img_size), texture_unit(unit) {
+  passes.reserve(configs.size());
+  for (const auto& cfg : configs) {
+    if (!(cfg.scale > 0.0f))
+      throw RenderException(
+          RenderException::Type::InvalidConfig,
+          "Post-processing pass \"" + cfg.name + "\" has a non-positive scale");
+    glm::uvec2 size = {
+        std::max(1u, static_cast<unsigned>(std::round(
+                         static_cast<float>(image_size.x) * cfg.scale))),
+        std::max(1u, static_cast<unsigned>(std::round(
+                         static_cast<float>(image_size.y) * cfg.scale))),
+    };
+    Shader shader = Shader::from_file(cfg.vert_path, cfg.frag_path);
+    PostUniforms uniforms(shader);
+    passes.push_back(
+        Pass{cfg.name, std::move(shader), size, 0, uniforms, GpuTimer{}});
+  }
+  assign_targets();
+}
+PostChain::~PostChain() {
+  for (const auto& target : targets) {
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.texture);
+  }
+}
+
+GLuint PostChain::run(GLuint source, float time) {
+  output_size = image_size;
+  if (passes.empty())
+    return source;
+  WOOP_PROFILE_SCOPE("PostChain::run");
+
+  // The display rect draws to the whole window afterwards
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glActiveTexture(GL_TEXTURE0 + texture_unit + 1);
+  glBindTexture(GL_TEXTURE_2D, source);
+
+  GLuint input = source;
+  glm::uvec2 input_size = image_size;
+  for (auto& pass : passes) {
+    const Target& target = targets[pass.target];
+    pass.timer.begin();
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glViewport(0, 0, static_cast<GLsizei>(pass.size.x),
+               static_cast<GLsizei>(pass.size.y));
+    pass.shader.use();
+    pass.uniforms.texture.set(static_cast<int>(texture_unit));
+    pass.uniforms.source.set(static_cast<int>(texture_unit + 1));
+    pass.uniforms.resolution.set(glm::vec2(pass.size));
+    pass.uniforms.texel_size.set(1.0f / glm::vec2(input_size));
+    pass.uniforms.time.set(time);
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    pass.timer.end();
+    input = target.texture;
+    input_size = pass.size;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  output_size = input_size;
+  return input;
+}
+
+void PostChain::assign_targets() {
+  // No target yet holds the previous pass's output
+  std::size_t previous = targets.size() + passes.size();
+  for (auto& pass : passes) {
+    std::size_t found = targets.size();
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+      if (targets[i].size == pass.size && i != previous) {
+        found = i;
+        break;
+      }
+    }
+    if (found == targets.size())
+      found = add_target(pass.size);
+    pass.target = found;
+    previous = found;
+  }
+}
+std::size_t PostChain::add_target(glm::uvec2 size) {
+  Target target;
+  target.size = size;
+  glGenTextures(1, &target.texture);
+  glBindTexture(GL_TEXTURE_2D, target.texture);
+  // Linear filtering lets reduced-resolution passes be sampled smoothly
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(size.x),
+               static_cast<GLsizei>(size.y), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               nullptr);
+
+  glGenFramebuffers(1, &target.framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         target.texture, 0);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  targets.push_back(target);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+    throw RenderException(RenderException::Type::InvalidConfig,
+                          "Could not create post-processing framebuffer");
+  return targets.size() - 1;
+}
+}  // namespace woop
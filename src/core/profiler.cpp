@@ -0,0 +1,194 @@
+/**
+ * @file profiler.cpp
+ * @authors quak
+ * @brief Defines members of the ProfileZone and Profiler classes.
+ */
+
+#include "profiler.hpp"
+#include <algorithm> /* std::sort */
+#include <atomic>    /* std::atomic */
+#include <chrono>    /* std::chrono::steady_clock */
+#include <cstdio>    /* std::snprintf */
+#include <fstream>   /* std::ofstream */
+#include <memory>    /* std::shared_ptr */
+#include <mutex>     /* std::mutex, std::lock_guard */
+#include <vector>    /* std::vector */
+
+namespace woop {
+/**
+ * @brief Ring buffer of zones recorded by a single thread.
+ */
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<ProfileEvent> events;
+  std::size_t next = 0;
+  uint32_t thread_id = 0;
+  uint32_t depth = 0;
+};
+
+/**
+ * @brief Buffers of every thread that has recorded a zone. Buffers are kept
+ * alive after their thread exits, so that their zones can still be exported.
+ */
+struct ThreadRegistry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+ThreadRegistry& get_registry() {
+  static ThreadRegistry registry;
+  return registry;
+}
+
+/**
+ * @brief Returns the calling thread's buffer, registering it on first use. If
+ * it can't be allocated, returns nullptr and the thread records nothing,
+ * since zones are placed in code that can't throw.
+ */
+ThreadBuffer* get_thread_buffer() noexcept {
+  thread_local std::shared_ptr<ThreadBuffer> buffer =
+      []() noexcept -> std::shared_ptr<ThreadBuffer> {
+    try {
+      auto out = std::make_shared<ThreadBuffer>();
+      out->events.reserve(Profiler::buffer_capacity);
+      ThreadRegistry& registry = get_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      out->thread_id = static_cast<uint32_t>(registry.buffers.size());
+      registry.buffers.emplace_back(out);
+      return out;
+    } catch (...) {
+      return nullptr;
+    }
+  }();
+  return buffer.get();
+}
+
+std::atomic<uint64_t> current_frame{0};
+
+/**
+ * @brief Writes a string to a JSON stream, escaping special characters.
+ */
+void write_json_string(std::ostream& stream, const char* str) {
+  stream << '"';
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\')
+      stream << '\\' << *str;
+    else if (static_cast<unsigned char>(*str) >= 0x20)
+      stream << *str;
+  }
+  stream << '"';
+}
+
+/**
+ * @brief Formats a time in nanoseconds as (fractional) microseconds, the unit
+ * used by Chrome traces.
+ */
+std::string get_trace_time(uint64_t ns) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+                static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  return buffer;
+}
+
+ProfileZone::ProfileZone(const char* zone_name) noexcept
+    : name(zone_name),
+      start(Profiler::get_time()),
+      frame(Profiler::get_frame()),
+      depth(Profiler::get_depth()++) {}
+ProfileZone::~ProfileZone() {
+  --Profiler::get_depth();
+  uint64_t end = Profiler::get_time();
+  Profiler::record(ProfileEvent{name, start, end, frame, depth});
+}
+
+void Profiler::next_frame() noexcept {
+  ++current_frame;
+}
+uint64_t Profiler::get_frame() noexcept {
+  return current_frame;
+}
+uint64_t Profiler::get_time() noexcept {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point epoch = Clock::now();
+  auto elapsed = Clock::now() - epoch;
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Profiler::write_trace(const std::filesystem::path& path,
+                           uint64_t first_frame,
+                           uint64_t last_frame) {
+  std::ofstream file(path);
+  if (!file.is_open())
+    throw ProfilerException(ProfilerException::Type::FileError,
+                            "Could not create trace at path " + path.string());
+
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  {
+    ThreadRegistry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    buffers = registry.buffers;
+  }
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first_event = true;
+  for (const auto& buffer : buffers) {
+    std::vector<ProfileEvent> events;
+    {
+      std::lock_guard<std::mutex> lock(buffer->mutex);
+      events = buffer->events;
+    }
+    // Parents complete after their children, so sort by start time (and
+    // depth, for zones starting at the same time) for a readable trace.
+    std::sort(events.begin(), events.end(),
+              [](const ProfileEvent& a, const ProfileEvent& b) {
+                return (a.start == b.start) ? a.depth < b.depth
+                                            : a.start < b.start;
+              });
+    for (const auto& event : events) {
+      if (event.frame < first_frame || event.frame > last_frame)
+        continue;
+      if (!first_event)
+        file << ',';
+      first_event = false;
+      file << "{\"name\":";
+      write_json_string(file, event.name);
+      file << ",\"cat\":\"woop\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+           << buffer->thread_id << ",\"ts\":" << get_trace_time(event.start)
+           << ",\"dur\":" << get_trace_time(event.end - event.start)
+           << ",\"args\":{\"frame\":" << event.frame << "}}";
+    }
+  }
+  file << "]}\n";
+}
+void Profiler::clear() noexcept {
+  ThreadRegistry& registry = get_registry();
+  std::lock_guard<std::mutex> registry_lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+  }
+}
+
+void Profiler::record(const ProfileEvent& event) noexcept {
+  ThreadBuffer* buffer = get_thread_buffer();
+  if (!buffer)
+    return;
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  // Overwrite the oldest zone once the buffer is full. Events were reserved
+  // up front, so this never allocates.
+  if (buffer->events.size() < buffer_capacity)
+    buffer->events.emplace_back(event);
+  else
+    buffer->events[buffer->next] = event;
+  buffer->next = (buffer->next + 1) % buffer_capacity;
+}
+uint32_t& Profiler::get_depth() noexcept {
+  // Threads without a buffer still track depth, so zones stay balanced
+  thread_local uint32_t unrecorded_depth = 0;
+  ThreadBuffer* buffer = get_thread_buffer();
+  return buffer ? buffer->depth : unrecorded_depth;
+}
+}  // namespace woop
@@ -0,0 +1,593 @@
+/**
+ * @file pvs.cpp
+ * @authors quak
+ * @brief Defines members of the Pvs class, and the portal flow used to
+ * compute it.
+ */
+
+#include "pvs.hpp"
+#include "level.hpp"         /* woop::Level, woop::Subsector, woop::Seg */
+#include "geometry.hpp"      /* woop::ConvexRegion, woop::get_bounds */
+#include "thread_pool.hpp"   /* woop::ThreadPool */
+#include "profiler.hpp"      /* WOOP_PROFILE_SCOPE */
+#include "log.hpp"           /* woop::log_error */
+#include "utils.hpp"         /* write_file_atomically */
+#include "glm/vec2.hpp"      /* glm::dvec2 */
+#include "glm/common.hpp"    /* glm::min, glm::max */
+#include "glm/geometric.hpp" /* glm::dot, glm::length */
+#include <algorithm>         /* std::min, std::max, std::sort */
+#include <cmath>             /* std::abs, std::floor */
+#include <cstdio>            /* std::snprintf */
+#include <cstring>           /* std::memcmp, std::memcpy */
+#include <deque>             /* std::deque */
+#include <fstream>           /* std::ifstream */
+#include <limits>            /* std::numeric_limits */
+
+namespace woop {
+namespace {
+// Computed in doubles, like the regions of the BSP tree (see geometry.hpp)
+using Point = glm::dvec2;
+
+// Distance within which a point counts as lying on a line
+constexpr double on_epsilon = 0.1;
+// Distance within which polygon edges count as lying on the same line. Seg
+// vertices are rounded to whole units, so edges of neighboring subsectors can
+// be a little apart.
+constexpr double edge_epsilon = 1.0;
+// Size of the grid cells used to find neighboring edges
+constexpr double edge_cell_size = 128.0;
+
+struct Segment {
+  Point start;
+  Point end;
+};
+
+/**
+ * @brief A portal out of a subsector. The subsector it leads to lies on the
+ * right of the segment, going from start to end.
+ */
+struct Portal {
+  Segment segment;
+  uint32_t from;
+  uint32_t to;
+  // Subsectors that might be seen through the portal (a rough first pass),
+  // then the ones that are after flowing through it
+  std::vector<uint64_t> might_see;
+  std::vector<uint64_t> sees;
+};
+
+/**
+ * @brief An edge of a subsector's polygon, with the subsector on its left.
+ */
+struct Edge {
+  Segment segment;
+  uint32_t subsector;
+};
+
+bool test_bit(const uint64_t* bits, std::size_t bit) noexcept {
+  return (bits[bit / 64] >> (bit % 64)) & 1;
+}
+void set_bit(uint64_t* bits, std::size_t bit) noexcept {
+  bits[bit / 64] |= uint64_t{1} << (bit % 64);
+}
+
+Point to_point(const glm::vec2& point) noexcept {
+  return {point.x, point.y};
+}
+
+/**
+ * @brief Returns the signed distance from a line to a point, positive on the
+ * line's right.
+ */
+double get_distance(const Segment& line, const Point& point) noexcept {
+  Point delta = line.end - line.start;
+  double length = glm::length(delta);
+  if (length == 0.0)
+    return 0.0;
+  return ((point.x - line.start.x) * delta.y -
+          (point.y - line.start.y) * delta.x) /
+         length;
+}
+
+/**
+ * @brief Keeps the part of a segment on one side of a line (or within
+ * on_epsilon of it). Returns false if nothing is left.
+ */
+bool clip_segment(Segment& segment, const Segment& line, bool keep_right) {
+  double start_side = get_distance(line, segment.start);
+  double end_side = get_distance(line, segment.end);
+  if (!keep_right) {
+    start_side = -start_side;
+    end_side = -end_side;
+  }
+  if (start_side < -on_epsilon && end_side < -on_epsilon)
+    return false;
+  if (start_side >= -on_epsilon && end_side >= -on_epsilon)
+    return true;
+  double t = (start_side + on_epsilon) / (start_side - end_side);
+  Point cut = segment.start + (segment.end - segment.start) * t;
+  if (start_side < -on_epsilon)
+    segment.start = cut;
+  else
+    segment.end = cut;
+  return true;
+}
+
+/**
+ * @brief Clips a target segment to the region that can be seen from a source
+ * segment through a pass segment. That region is bounded by the separating
+ * lines: lines through an endpoint of each segment, with the source on one
+ * side and the pass on the other.
+ */
+bool clip_to_separators(const Segment& source,
+                        const Segment& pass,
+                        Segment& target) {
+  const Point source_points[] = {source.start, source.end};
+  const Point pass_points[] = {pass.start, pass.end};
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      Segment line = {source_points[i], pass_points[j]};
+      if (glm::length(line.end - line.start) < on_epsilon)
+        continue;
+      double source_side = get_distance(line, source_points[1 - i]);
+      double pass_side = get_distance(line, pass_points[1 - j]);
+      bool separates = (source_side < -on_epsilon && pass_side > on_epsilon) ||
+                       (source_side > on_epsilon && pass_side < -on_epsilon);
+      if (separates && !clip_segment(target, line, pass_side > 0.0))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Removes the parts of the interval [start, end] along a line that are
+ * covered by one-sided segs of a subsector.
+ */
+void subtract_solid_segs(const Subsector& subsector,
+                         const Segment& line,
+                         std::vector<std::pair<double, double>>& intervals) {
+  Point direction = line.end - line.start;
+  double length = glm::length(direction);
+  direction /= length;
+  for (const Seg& seg : subsector.segs) {
+    if (seg.linedef.back && seg.linedef.front)
+      continue;
+    Point start = to_point(seg.start);
+    Point end = to_point(seg.end);
+    if (std::abs(get_distance(line, start)) > edge_epsilon ||
+        std::abs(get_distance(line, end)) > edge_epsilon)
+      continue;
+    double a = glm::dot(start - line.start, direction);
+    double b = glm::dot(end - line.start, direction);
+    double solid_start = std::min(a, b);
+    double solid_end = std::max(a, b);
+    std::vector<std::pair<double, double>> remaining;
+    for (const auto& [open_start, open_end] : intervals) {
+      if (solid_end <= open_start || solid_start >= open_end) {
+        remaining.emplace_back(open_start, open_end);
+        continue;
+      }
+      if (solid_start > open_start)
+        remaining.emplace_back(open_start, solid_start);
+      if (solid_end < open_end)
+        remaining.emplace_back(solid_end, open_end);
+    }
+    intervals = std::move(remaining);
+  }
+}
+
+/**
+ * @brief Computes the PVS of a level, one portal at a time.
+ */
+class PortalFlow {
+ public:
+  PortalFlow(const Level& lvl) : level(lvl) {
+    subsector_count = level.get_subsectors().size();
+    words = (subsector_count + 63) / 64;
+    build_polygons();
+    build_portals();
+  }
+
+  std::size_t get_portal_count() const noexcept { return portals.size(); }
+  bool is_degenerate(std::size_t subsector) const noexcept {
+    return polygons[subsector].empty();
+  }
+
+  /**
+   * @brief Finds the subsectors that might be seen through a portal, by
+   * flooding through every portal in front of it that it is (partially)
+   * behind.
+   */
+  void find_might_see(std::size_t index) {
+    Portal& portal = portals[index];
+    portal.might_see.assign(words, 0);
+    std::vector<uint32_t> stack = {portal.to};
+    set_bit(portal.might_see.data(), portal.to);
+    while (!stack.empty()) {
+      uint32_t subsector = stack.back();
+      stack.pop_back();
+      for (uint32_t next_index : subsector_portals[subsector]) {
+        const Portal& next = portals[next_index];
+        if (test_bit(portal.might_see.data(), next.to) ||
+            !is_in_front(portal.segment, next.segment) ||
+            !is_behind(next.segment, portal.segment))
+          continue;
+        set_bit(portal.might_see.data(), next.to);
+        stack.push_back(next.to);
+      }
+    }
+  }
+
+  /**
+   * @brief Finds the subsectors that can be seen through a portal. Requires
+   * find_might_see() to have been called for every portal.
+   */
+  void flow(std::size_t index) {
+    Portal& portal = portals[index];
+    portal.sees.assign(words, 0);
+    State state{portal, std::vector<bool>(subsector_count), {}};
+    state.on_stack[portal.from] = true;
+    flow(state, portal.to, portal.segment, nullptr,
+         portal.might_see.data(), 0);
+  }
+
+  /**
+   * @brief Writes the subsectors visible from a subsector to a row of bits.
+   * Requires flow() to have been called for every portal.
+   */
+  void fill_row(std::size_t subsector, uint64_t* row) const {
+    set_bit(row, subsector);
+    for (uint32_t index : subsector_portals[subsector]) {
+      const std::vector<uint64_t>& sees = portals[index].sees;
+      for (std::size_t i = 0; i < words; ++i)
+        row[i] |= sees[i];
+    }
+  }
+
+ private:
+  /**
+   * @brief Scratch data for flowing through one portal.
+   */
+  struct State {
+    Portal& portal;
+    std::vector<bool> on_stack;
+    // Might-see sets at each depth of the flow
+    std::deque<std::vector<uint64_t>> might_see;
+  };
+
+  static bool is_in_front(const Segment& line, const Segment& segment) {
+    return get_distance(line, segment.start) > on_epsilon ||
+           get_distance(line, segment.end) > on_epsilon;
+  }
+  static bool is_behind(const Segment& line, const Segment& segment) {
+    return get_distance(line, segment.start) < -on_epsilon ||
+           get_distance(line, segment.end) < -on_epsilon;
+  }
+
+  void flow(State& state,
+            uint32_t subsector,
+            const Segment& source,
+            const Segment* pass,
+            const uint64_t* might_see,
+            std::size_t depth) {
+    uint64_t* sees = state.portal.sees.data();
+    set_bit(sees, subsector);
+    state.on_stack[subsector] = true;
+    if (state.might_see.size() <= depth)
+      state.might_see.emplace_back(words);
+    uint64_t* next_might_see = state.might_see[depth].data();
+
+    for (uint32_t next_index : subsector_portals[subsector]) {
+      const Portal& next = portals[next_index];
+      if (state.on_stack[next.to] || !test_bit(might_see, next.to))
+        continue;
+      // Stop once nothing new could be seen
+      bool more = false;
+      for (std::size_t i = 0; i < words; ++i) {
+        next_might_see[i] = might_see[i] & next.might_see[i];
+        more = more || (next_might_see[i] & ~sees[i]);
+      }
+      if (!more && test_bit(sees, next.to))
+        continue;
+
+      // Portals of the first subsector can all be seen from the source
+      Segment target = next.segment;
+      if (!clip_segment(target, source, true))
+        continue;
+      if (!pass) {
+        flow(state, next.to, source, &target, next_might_see, depth + 1);
+        continue;
+      }
+      if (!clip_segment(target, *pass, true) ||
+          !clip_to_separators(source, *pass, target))
+        continue;
+      // Only the part of the source that sees the target matters further on
+      Segment next_source = source;
+      if (!clip_to_separators(target, *pass, next_source))
+        continue;
+      flow(state, next.to, next_source, &target, next_might_see, depth + 1);
+    }
+    state.on_stack[subsector] = false;
+  }
+
+  void build_polygons() {
+    Bounds bounds = get_bounds(level.get_linedefs());
+    bounds_min = to_point(bounds.min) - 64.0;
+    bounds_max = to_point(bounds.max) + 64.0;
+    // Counter-clockwise, so that the inside is on the left of every edge
+    polygons = get_subsector_regions(
+        level, get_box_region(bounds_min, bounds_max), true);
+  }
+
+  void build_portals() {
+    std::vector<Edge> edges;
+    for (std::size_t i = 0; i < subsector_count; ++i) {
+      const ConvexRegion& polygon = polygons[i];
+      for (std::size_t j = 0; j < polygon.size(); ++j) {
+        Segment segment = {polygon[j].point,
+                           polygon[(j + 1) % polygon.size()].point};
+        if (glm::length(segment.end - segment.start) > on_epsilon)
+          edges.push_back({segment, static_cast<uint32_t>(i)});
+      }
+    }
+
+    // Edges are bucketed into a grid, so only nearby edges are compared
+    auto get_cell = [&](double value, double origin) {
+      return static_cast<std::size_t>(
+          std::max(0.0, std::floor((value - origin) / edge_cell_size)));
+    };
+    std::size_t columns = get_cell(bounds_max.x, bounds_min.x) + 1;
+    std::size_t rows = get_cell(bounds_max.y, bounds_min.y) + 1;
+    std::vector<std::vector<uint32_t>> cells(columns * rows);
+    auto for_each_cell = [&](const Segment& segment, auto&& fn) {
+      Point min = glm::min(segment.start, segment.end) - edge_epsilon;
+      Point max = glm::max(segment.start, segment.end) + edge_epsilon;
+      std::size_t col_end =
+          std::min(get_cell(max.x, bounds_min.x), columns - 1);
+      std::size_t row_end = std::min(get_cell(max.y, bounds_min.y), rows - 1);
+      for (std::size_t row = get_cell(min.y, bounds_min.y); row <= row_end;
+           ++row) {
+        for (std::size_t col = get_cell(min.x, bounds_min.x); col <= col_end;
+             ++col)
+          fn(row * columns + col);
+      }
+    };
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+      for_each_cell(edges[i].segment, [&](std::size_t cell) {
+        cells[cell].push_back(static_cast<uint32_t>(i));
+      });
+    }
+
+    subsector_portals.resize(subsector_count);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (const auto& cell : cells) {
+      for (std::size_t a = 0; a < cell.size(); ++a) {
+        for (std::size_t b = a + 1; b < cell.size(); ++b) {
+          if (edges[cell[a]].subsector != edges[cell[b]].subsector)
+            pairs.emplace_back(std::min(cell[a], cell[b]),
+                               std::max(cell[a], cell[b]));
+        }
+      }
+    }
+    // Edges crossing several cells are paired once per shared cell
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    for (const auto& [a, b] : pairs)
+      add_portals(edges[a], edges[b]);
+  }
+
+  /**
+   * @brief Adds portals both ways through the part that two edges share,
+   * unless it is covered by a one-sided seg.
+   */
+  void add_portals(const Edge& first, const Edge& second) {
+    const Segment& line = first.segment;
+    Point direction = line.end - line.start;
+    double length = glm::length(direction);
+    direction /= length;
+    // Neighbors' edges run the opposite way along the same line
+    if (glm::dot(second.segment.end - second.segment.start, direction) >= 0.0 ||
+        std::abs(get_distance(line, second.segment.start)) > edge_epsilon ||
+        std::abs(get_distance(line, second.segment.end)) > edge_epsilon)
+      return;
+    double a = glm::dot(second.segment.start - line.start, direction);
+    double b = glm::dot(second.segment.end - line.start, direction);
+    double start = std::max(0.0, std::min(a, b));
+    double end = std::min(length, std::max(a, b));
+    if (end - start <= on_epsilon)
+      return;
+
+    std::vector<std::pair<double, double>> intervals = {{start, end}};
+    const auto& subsectors = level.get_subsectors();
+    subtract_solid_segs(subsectors[first.subsector], line, intervals);
+    subtract_solid_segs(subsectors[second.subsector], line, intervals);
+    for (const auto& [open_start, open_end] : intervals) {
+      if (open_end - open_start <= on_epsilon)
+        continue;
+      // The first edge's subsector is on its left, so the second is on the
+      // right of the portal going the same way
+      Segment segment = {line.start + direction * open_start,
+                         line.start + direction * open_end};
+      add_portal(segment, first.subsector, second.subsector);
+      add_portal({segment.end, segment.start}, second.subsector,
+                 first.subsector);
+    }
+  }
+  void add_portal(const Segment& segment, uint32_t from, uint32_t to) {
+    subsector_portals[from].push_back(static_cast<uint32_t>(portals.size()));
+    portals.push_back(Portal{segment, from, to, {}, {}});
+  }
+
+  const Level& level;
+  std::size_t subsector_count;
+  std::size_t words;
+  Point bounds_min;
+  Point bounds_max;
+  std::vector<ConvexRegion> polygons;
+  std::vector<Portal> portals;
+  // Portals leading out of each subsector
+  std::vector<std::vector<uint32_t>> subsector_portals;
+};
+
+/**
+ * @brief Header of a cached PVS file.
+ */
+struct CacheHeader {
+  static constexpr char expected_magic[8] = "WOOPPVS";
+  static constexpr uint32_t expected_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t padding;
+  uint64_t checksum;
+  uint64_t subsector_count;
+  uint64_t portal_count;
+};
+
+std::filesystem::path get_cache_path(const std::filesystem::path& cache,
+                                     const Level& level) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.pvs",
+                static_cast<unsigned long long>(level.get_checksum()));
+  return cache / name;
+}
+}  // namespace
+
+Pvs::Pvs() : subsector_count(0), row_words(0) {}
+
+Pvs Pvs::compute(const Level& level, ThreadPool& pool) {
+  WOOP_PROFILE_SCOPE("Pvs::compute");
+  Pvs pvs;
+  pvs.init(level);
+  PortalFlow flow(level);
+  pool.parallel_for(flow.get_portal_count(),
+                    [&](std::size_t i) { flow.find_might_see(i); });
+  pool.parallel_for(flow.get_portal_count(),
+                    [&](std::size_t i) { flow.flow(i); });
+  pool.parallel_for(pvs.subsector_count, [&](std::size_t i) {
+    flow.fill_row(i, &pvs.bits[i * pvs.row_words]);
+  });
+
+  // Subsectors without an area (from broken nodes) can't be flowed through,
+  // so they see, and are seen by, everything
+  for (std::size_t i = 0; i < pvs.subsector_count; ++i) {
+    if (!flow.is_degenerate(i))
+      continue;
+    for (std::size_t j = 0; j < pvs.subsector_count; ++j) {
+      set_bit(&pvs.bits[i * pvs.row_words], j);
+      set_bit(&pvs.bits[j * pvs.row_words], i);
+    }
+  }
+
+  // Portals are stored once each way
+  pvs.stats.portals = flow.get_portal_count() / 2;
+  pvs.count_visible();
+  return pvs;
+}
+
+std::optional<Pvs> Pvs::load(const std::filesystem::path& cache,
+                             const Level& level) {
+  std::ifstream file(get_cache_path(cache, level), std::ios::binary);
+  if (!file.is_open())
+    return std::nullopt;
+  CacheHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, CacheHeader::expected_magic,
+                  sizeof(header.magic)) != 0 ||
+      header.version != CacheHeader::expected_version ||
+      header.checksum != level.get_checksum() ||
+      header.subsector_count != level.get_subsectors().size())
+    return std::nullopt;
+
+  Pvs pvs;
+  pvs.init(level);
+  if (!file.read(reinterpret_cast<char*>(pvs.bits.data()),
+                 static_cast<std::streamsize>(pvs.bits.size() *
+                                              sizeof(uint64_t))))
+    return std::nullopt;
+  pvs.stats.portals = static_cast<std::size_t>(header.portal_count);
+  pvs.count_visible();
+  return pvs;
+}
+
+bool Pvs::save(const std::filesystem::path& cache, const Level& level) const {
+  CacheHeader header{};
+  std::memcpy(header.magic, CacheHeader::expected_magic, sizeof(header.magic));
+  header.version = CacheHeader::expected_version;
+  header.checksum = level.get_checksum();
+  header.subsector_count = subsector_count;
+  header.portal_count = stats.portals;
+
+  std::error_code error;
+  std::filesystem::create_directories(cache, error);
+  // Written atomically, so that a partial set is never loaded
+  std::filesystem::path path = get_cache_path(cache, level);
+  if (!write_file_atomically(
+          path, {{reinterpret_cast<const char*>(&header), sizeof(header)},
+                 {reinterpret_cast<const char*>(bits.data()),
+                  bits.size() * sizeof(uint64_t)}})) {
+    log_error("Could not write PVS to ", path.string());
+    return false;
+  }
+  return true;
+}
+
+bool Pvs::is_node_visible(std::size_t from, std::size_t node) const noexcept {
+  const auto& [first, last] = node_ranges[node];
+  const uint64_t* row = &bits[from * row_words];
+  for (std::size_t word = first / 64; word <= last / 64; ++word) {
+    uint64_t mask = ~uint64_t{0};
+    if (word == first / 64)
+      mask &= ~uint64_t{0} << (first % 64);
+    if (word == last / 64)
+      mask &= ~uint64_t{0} >> (63 - last % 64);
+    if (row[word] & mask)
+      return true;
+  }
+  return false;
+}
+
+void Pvs::count_visible() noexcept {
+  std::size_t visible = 0;
+  for (uint64_t word : bits) {
+    for (; word; word &= word - 1)
+      ++visible;
+  }
+  if (subsector_count > 0)
+    stats.average_visible = static_cast<double>(visible) /
+                            static_cast<double>(subsector_count);
+}
+void Pvs::init(const Level& level) {
+  subsector_count = level.get_subsectors().size();
+  row_words = (subsector_count + 63) / 64;
+  bits.assign(subsector_count * row_words, 0);
+  stats = Stats{};
+  stats.subsectors = subsector_count;
+
+  const std::vector<Node>& nodes = level.get_nodes();
+  node_ranges.assign(nodes.size(), {0, 0});
+  if (nodes.empty())
+    return;
+  auto get_range = [&](const auto& self, const Node& node)
+      -> std::pair<uint32_t, uint32_t> {
+    std::pair<uint32_t, uint32_t> range = {
+        std::numeric_limits<uint32_t>::max(), 0};
+    for (Node::Child child : {Node::Child::Left, Node::Child::Right}) {
+      std::pair<uint32_t, uint32_t> child_range;
+      if (node.is_node(child)) {
+        child_range = self(self, node.get_node(child));
+      } else {
+        uint32_t index = static_cast<uint32_t>(
+            level.get_subsector_index(node.get_subsector(child)));
+        child_range = {index, index};
+      }
+      range.first = std::min(range.first, child_range.first);
+      range.second = std::max(range.second, child_range.second);
+    }
+    node_ranges[level.get_node_index(node)] = range;
+    return range;
+  };
+  get_range(get_range, level.get_root_node());
+}
+}  // namespace woop
@@ -0,0 +1,191 @@
+/**
+ * @file ray_cast.cpp
+ * @authors quak
+ * @brief Defines members of the RayCaster class.
+ */
+
+#include "ray_cast.hpp"
+#include "thread_pool.hpp"   /* woop::ThreadPool */
+#include "glm/geometric.hpp" /* glm::length */
+#include <algorithm>         /* std::clamp, std::min, std::max */
+
+namespace woop {
+// Rays traced by each job of a batch spread across a thread pool
+constexpr std::size_t rays_per_job = 64;
+
+/**
+ * @brief Returns the z component of the cross product of two vectors.
+ */
+static double cross(const glm::dvec2& a, const glm::dvec2& b) noexcept {
+  return a.x * b.y - a.y * b.x;
+}
+static glm::dvec2 to_dvec2(const glm::vec2& point) noexcept {
+  return {point.x, point.y};
+}
+
+RayCaster::RayCaster(const Level& lvl) : level(&lvl) {}
+
+RayHit RayCaster::cast(const Ray& ray) const {
+  Trace trace;
+  trace.start = to_dvec2(ray.start);
+  trace.delta = to_dvec2(ray.end) - trace.start;
+  trace.start_z = ray.start_z;
+  trace.delta_z = static_cast<double>(ray.end_z) - ray.start_z;
+  double length = glm::length(trace.delta);
+  trace.epsilon = (length > 0.0) ? 1.0 / length : 0.0;
+  // Rays missing everything end at their end point
+  trace.hit.position = ray.end;
+  trace.hit.z = ray.end_z;
+  cross_node(level->get_root_node(), 0.0, 1.0, trace);
+  return trace.hit;
+}
+void RayCaster::cast(Span<const Ray> rays, Span<RayHit> hits) const {
+  std::size_t count = std::min(rays.size(), hits.size());
+  for (std::size_t i = 0; i < count; ++i)
+    hits[i] = cast(rays[i]);
+}
+void RayCaster::cast(Span<const Ray> rays,
+                     Span<RayHit> hits,
+                     ThreadPool& pool) const {
+  std::size_t count = std::min(rays.size(), hits.size());
+  std::size_t job_count = (count + rays_per_job - 1) / rays_per_job;
+  pool.parallel_for(job_count, [&](std::size_t job) {
+    std::size_t end = std::min(count, (job + 1) * rays_per_job);
+    for (std::size_t i = job * rays_per_job; i < end; ++i)
+      hits[i] = cast(rays[i]);
+  });
+}
+
+bool RayCaster::has_line_of_sight(const glm::vec2& from,
+                                  float from_z,
+                                  const glm::vec2& to,
+                                  float to_z) const {
+  const Subsector& from_subsector = level->get_subsector(from);
+  const Subsector& to_subsector = level->get_subsector(to);
+  if (!level->can_see(*from_subsector.sector, *to_subsector.sector))
+    return false;
+  if (const Pvs* pvs = level->get_pvs()) {
+    if (!pvs->is_visible(level->get_subsector_index(from_subsector),
+                         level->get_subsector_index(to_subsector)))
+      return false;
+  }
+  return !cast({from, to, from_z, to_z}).is_hit();
+}
+
+bool RayCaster::cross_child(const Node& node,
+                            Node::Child child,
+                            double from,
+                            double to,
+                            Trace& trace) const {
+  if (node.is_subsector(child))
+    return cross_subsector(node.get_subsector(child), from, to, trace);
+  return cross_node(node.get_node(child), from, to, trace);
+}
+bool RayCaster::cross_node(const Node& node,
+                           double from,
+                           double to,
+                           Trace& trace) const {
+  glm::dvec2 partition_start = to_dvec2(node.get_partition_start());
+  glm::dvec2 partition = to_dvec2(node.get_partition_end()) - partition_start;
+  // Distances to the partition are positive on its right, like
+  // Node::get_nearest_child()
+  auto get_side = [&](double fraction) {
+    glm::dvec2 point = trace.start + trace.delta * fraction;
+    return cross(point - partition_start, partition);
+  };
+  double from_side = get_side(from);
+  double to_side = get_side(to);
+  Node::Child to_child = (to_side < 0.0) ? Node::Child::Left
+                                         : Node::Child::Right;
+  Node::Child from_child = to_child;
+  if (from_side != 0.0)
+    from_child = (from_side < 0.0) ? Node::Child::Left : Node::Child::Right;
+  if (from_child == to_child)
+    return cross_child(node, from_child, from, to, trace);
+
+  // Cross the near side first, and only go on to the far side if the ray
+  // made it through
+  double split = from + (to - from) * (from_side / (from_side - to_side));
+  return cross_child(node, from_child, from, split, trace) ||
+         cross_child(node, to_child, split, to, trace);
+}
+bool RayCaster::cross_subsector(const Subsector& subsector,
+                                double from,
+                                double to,
+                                Trace& trace) const {
+  auto get_z = [&](double fraction) {
+    return trace.start_z + trace.delta_z * fraction;
+  };
+  double nearest = to;
+  RayHit::Surface surface = RayHit::Surface::None;
+  const Seg* nearest_seg = nullptr;
+
+  // Floors and ceilings
+  const Sector& sector = *subsector.sector;
+  double floor = sector.floor.height;
+  double ceiling = sector.ceiling.height;
+  double from_z = get_z(from);
+  double to_z = get_z(to);
+  if (from_z < floor) {
+    nearest = from;
+    surface = RayHit::Surface::Floor;
+  } else if (from_z > ceiling) {
+    nearest = from;
+    surface = RayHit::Surface::Ceiling;
+  } else if (to_z < floor) {
+    nearest = from + (to - from) * (from_z - floor) / (from_z - to_z);
+    surface = RayHit::Surface::Floor;
+  } else if (to_z > ceiling) {
+    nearest = from + (to - from) * (ceiling - from_z) / (to_z - from_z);
+    surface = RayHit::Surface::Ceiling;
+  }
+
+  // Walls. Seg vertices are rounded to whole units, so segs can stick out of
+  // their subsector's region a little.
+  for (const Seg& seg : subsector.segs) {
+    glm::dvec2 seg_start = to_dvec2(seg.start);
+    glm::dvec2 seg_delta = to_dvec2(seg.end) - seg_start;
+    double denominator = cross(trace.delta, seg_delta);
+    if (denominator == 0.0)
+      continue;
+    double fraction = cross(seg_start - trace.start, seg_delta) / denominator;
+    double along = cross(seg_start - trace.start, trace.delta) / denominator;
+    if (along < 0.0 || along > 1.0 || fraction < from - trace.epsilon ||
+        fraction > std::min(nearest, to + trace.epsilon) || fraction < 0.0)
+      continue;
+
+    RayHit::Surface seg_surface = RayHit::Surface::Wall;
+    const Linedef& line = seg.linedef;
+    if (line.front && line.back) {
+      // The opening between the line's two sectors
+      const Sector& front = line.front->sector_facing;
+      const Sector& back = line.back->sector_facing;
+      double top = std::min(front.ceiling.height, back.ceiling.height);
+      double bottom = std::max(front.floor.height, back.floor.height);
+      double z = get_z(fraction);
+      if (z > top)
+        seg_surface = RayHit::Surface::Upper;
+      else if (z < bottom)
+        seg_surface = RayHit::Surface::Lower;
+      else
+        continue;
+    }
+    nearest = fraction;
+    surface = seg_surface;
+    nearest_seg = &seg;
+  }
+
+  if (surface == RayHit::Surface::None)
+    return false;
+  double fraction = std::clamp(nearest, 0.0, 1.0);
+  glm::dvec2 position = trace.start + trace.delta * fraction;
+  trace.hit.surface = surface;
+  trace.hit.fraction = static_cast<float>(fraction);
+  trace.hit.position = {static_cast<float>(position.x),
+                        static_cast<float>(position.y)};
+  trace.hit.z = static_cast<float>(get_z(fraction));
+  trace.hit.seg = nearest_seg;
+  trace.hit.subsector = &subsector;
+  return true;
+}
+}  // namespace woop
@@ -0,0 +1,118 @@
+/**
+ * @file render_thread.cpp
+ * @authors quak
+ * @brief Defines members of the RenderThread class.
+ */
+
+#include "render_thread.hpp"
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include <algorithm>    /* std::max */
+
+namespace woop {
+RenderThread::RenderThread(Renderer& rndr, unsigned frames_in_flight)
+    : renderer(rndr),
+      slots(std::max(frames_in_flight, 1u)),
+      free_slots(slots.size()),
+      pending_slots(slots.size()),
+      ready_slots(slots.size()),
+      stopping(false),
+      in_flight(0) {
+  for (std::size_t i = 0; i < slots.size(); ++i) {
+    slots[i].image.resize(renderer.get_pixel_count());
+    slots[i].cameras.reserve(renderer.views.size());
+    slots[i].level = nullptr;
+    free_slots.push(i);
+  }
+  worker = std::thread(&RenderThread::work, this);
+}
+RenderThread::~RenderThread() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  pending_cv.notify_one();
+  worker.join();
+}
+
+void RenderThread::submit(const Level& level) {
+  std::size_t index = 0;
+  while (!free_slots.pop(index))
+    present(true);
+
+  // Cameras keep moving while the frame is drawn, so they're copied
+  Slot& slot = slots[index];
+  slot.cameras.clear();
+  for (const auto& view : renderer.views)
+    slot.cameras.push_back(*view.camera);
+  slot.level = &level;
+  pending_slots.push(index);
+  ++in_flight;
+  notify(pending_cv);
+}
+bool RenderThread::present(bool wait) {
+  std::size_t index = 0;
+  if (!ready_slots.pop(index)) {
+    if (!wait || in_flight == 0)
+      return false;
+    WOOP_PROFILE_SCOPE("RenderThread::wait");
+    std::unique_lock lock(mutex);
+    ready_cv.wait(lock, [this]() { return !ready_slots.empty(); });
+    lock.unlock();
+    ready_slots.pop(index);
+  }
+  --in_flight;
+
+  std::exception_ptr thrown;
+  {
+    std::lock_guard lock(mutex);
+    std::swap(thrown, exception);
+  }
+  if (!thrown)
+    renderer.present_image(slots[index].image.data(), slots[index].stats);
+  free_slots.push(index);
+  if (thrown)
+    std::rethrow_exception(thrown);
+  return true;
+}
+void RenderThread::flush() {
+  while (in_flight > 0)
+    present(true);
+}
+
+void RenderThread::notify(std::condition_variable& cv) {
+  // Taking the lock makes sure that a waiting thread either sees the new
+  // slot when it checks its queue, or is already asleep and gets woken
+  {
+    std::lock_guard lock(mutex);
+  }
+  cv.notify_one();
+}
+void RenderThread::work() {
+  while (true) {
+    std::size_t index = 0;
+    {
+      std::unique_lock lock(mutex);
+      pending_cv.wait(lock,
+                      [this]() { return stopping || !pending_slots.empty(); });
+      if (stopping)
+        return;
+    }
+    pending_slots.pop(index);
+
+    try {
+      WOOP_PROFILE_SCOPE("RenderThread::draw");
+      Slot& slot = slots[index];
+      Frame frame = renderer.start_offscreen_frame(
+          slot.image.data(), slot.cameras.data(), slot.stats);
+      frame.draw(DrawMode::Solid, *slot.level);
+    } catch (...) {
+      std::lock_guard lock(mutex);
+      if (!exception)
+        exception = std::current_exception();
+    }
+
+    ready_slots.push(index);
+    notify(ready_cv);
+  }
+}
+}  // namespace woop
@@ -4,20 +4,19 @@
  * @brief Defines members of the Frame and Renderer classes.
  */
 
-#include "renderer.hpp"          /* woop::Frame, woop::Renderer */
-#include "log.hpp"               /* log_error */
-#include "glm/trigonometric.hpp" /* glm::radians */
-#include <algorithm>             /* std::swap, std::clamp, std::max, std::min */
-#include <string>                /* std::string */
-#include <unordered_map>         /* std::unordered_map */
+#include "renderer.hpp"           /* woop::Frame, woop::Renderer */
+#include "allocation_counter.hpp" /* woop::AllocationCounter */
+#include "log.hpp"                /* log_error */
+#include "profiler.hpp"           /* WOOP_PROFILE_SCOPE */
+#include "glm/trigonometric.hpp"  /* glm::radians, glm::degrees */
+#include <algorithm>              /* std::clamp, std::lower_bound, std::sort */
+#include <cassert>                /* assert */
+#include <cmath>                  /* std::atan2, std::fmod */
+#include <cstdio>                 /* std::snprintf */
+#include <string>                 /* std::string */
+#include <unordered_map>          /* std::unordered_map */
 
 namespace woop {
-Pixel interpolate_color(float v, const Pixel& c1, const Pixel& c2) {
-  glm::vec4 c1_f = c1;
-  glm::vec4 c2_f = c2;
-  return c1_f + v * (c2_f - c1_f);
-}
-
 /**
  * @brief Returns a random color.
  */
@@ -25,6 +24,51 @@ Pixel get_random_color() {
   return Pixel{rand(), rand(), rand(), 255};
 }
 
+RenderStats& RenderStats::operator+=(const RenderStats& other) noexcept {
+  nodes_visited += other.nodes_visited;
+  nodes_culled += other.nodes_culled;
+  nodes_pvs_culled += other.nodes_pvs_culled;
+  subsectors_rejected += other.subsectors_rejected;
+  segs_tested += other.segs_tested;
+  segs_backfacing += other.segs_backfacing;
+  segs_clipped += other.segs_clipped;
+  segs_occluded += other.segs_occluded;
+  sprites_drawn += other.sprites_drawn;
+  columns_drawn += other.columns_drawn;
+  pixels_written += other.pixels_written;
+  occlusion_list_size =
+      std::max(occlusion_list_size, other.occlusion_list_size);
+  arena_bytes += other.arena_bytes;
+  heap_allocations += other.heap_allocations;
+  return *this;
+}
+std::string RenderStats::to_string() const {
+  char overdraw_str[16];
+  std::snprintf(overdraw_str, sizeof(overdraw_str), "%.2f", overdraw);
+  return "NODES VISITED: " + std::to_string(nodes_visited) +
+         "\nNODES CULLED: " + std::to_string(nodes_culled) +
+         "\nNODES PVS CULLED: " + std::to_string(nodes_pvs_culled) +
+         "\nSUBSECTORS REJECTED: " + std::to_string(subsectors_rejected) +
+         "\nSEGS TESTED: " + std::to_string(segs_tested) +
+         "\nSEGS BACKFACING: " + std::to_string(segs_backfacing) +
+         "\nSEGS CLIPPED: " + std::to_string(segs_clipped) +
+         "\nSEGS OCCLUDED: " + std::to_string(segs_occluded) +
+         "\nSPRITES DRAWN: " + std::to_string(sprites_drawn) +
+         "\nCOLUMNS DRAWN: " + std::to_string(columns_drawn) +
+         "\nPIXELS WRITTEN: " + std::to_string(pixels_written) +
+         "\nOVERDRAW: " + overdraw_str +
+         "\nOCCLUSION LIST: " + std::to_string(occlusion_list_size) +
+         "\nARENA BYTES: " + std::to_string(arena_bytes) +
+         "\nHEAP ALLOCATIONS: " + std::to_string(heap_allocations);
+}
+
+bool ViewState::operator==(const ViewState& other) const noexcept {
+  return camera_position == other.camera_position &&
+         camera_rotation == other.camera_rotation && fov == other.fov &&
+         resolution == other.resolution &&
+         level_revision == other.level_revision && tick == other.tick;
+}
+
 Shader get_shader_from_cfg(const RendererConfig cfg) {
   if (!cfg.shaders.vert_path.empty() && !cfg.shaders.frag_path.empty())
     return Shader::from_file(cfg.shaders.vert_path, cfg.shaders.frag_path);
@@ -34,64 +78,122 @@ Shader get_shader_from_cfg(const RendererConfig cfg) {
                         "Unable to create shader (incomplete source/paths)");
 }
 
-Frame::Frame(Renderer& rndr)
+Frame::Frame(Renderer& rndr, bool reuse)
     : renderer(rndr),
-      visible_rows(renderer.get_img_size().x, {0, renderer.get_img_size().y}),
+      views(rndr.arena),
+      start_allocations(AllocationCounter::get_count()),
+      start_ramp_count(rndr.texture_ramps.size()),
       display_rect(rndr.display_rect),
-      camera(rndr.camera),
+      buffer(nullptr),
+      stats_out(nullptr),
+      reused(reuse),
       invalid(false) {
+  // Reused frames keep showing the display texture, so nothing is written
+  if (reused)
+    return;
   map_buffer();
+  create_views(nullptr);
+}
+Frame::Frame(Renderer& rndr,
+             Pixel* target,
+             Camera* cameras,
+             RenderStats& out)
+    : renderer(rndr),
+      views(rndr.arena),
+      start_allocations(AllocationCounter::get_count()),
+      start_ramp_count(rndr.texture_ramps.size()),
+      display_rect(rndr.display_rect),
+      buffer(target),
+      stats_out(&out),
+      reused(false),
+      invalid(false) {
+  create_views(cameras);
 }
 Frame::Frame(Frame&& other)
     : renderer(other.renderer),
-      visible_rows(renderer.get_img_size().x, {0, renderer.get_img_size().y}),
+      stats(other.stats),
+      views(std::move(other.views)),
+      start_allocations(other.start_allocations),
+      start_ramp_count(other.start_ramp_count),
       display_rect(other.renderer.display_rect),
-      camera(other.renderer.camera),
       buffer(other.buffer),
+      stats_out(other.stats_out),
+      reused(other.reused),
       invalid(false) {
   other.invalid = true;
 }
 Frame::~Frame() {
   if (invalid)
     return;
-  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-  // Draw frame to the window
-  update_display_texture();
-  display_rect.draw();
-  renderer.window.swap_buffers();
+  if (reused) {
+    // The display texture still holds the previous image, so only the display
+    // shader has to run
+    ++renderer.reused_frames;
+    display_rect.draw();
+    renderer.window.swap_buffers();
+    return;
+  }
+  // Things in views that were drawn to separately
+  for (auto& view : views)
+    view.draw_sprites();
+  for (const auto& view : views)
+    stats += view.get_stats();
+  stats.arena_bytes = renderer.arena.get_used();
+  for (const auto& slot : renderer.views)
+    stats.arena_bytes += slot.arena->get_used();
+  // Frames drawn to CPU buffers are presented later, by their owner. Other
+  // threads allocate meanwhile, so allocations aren't counted.
+  if (stats_out) {
+    *stats_out = stats;
+    return;
+  }
+  {
+    WOOP_PROFILE_SCOPE("glUnmapBuffer");
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  }
+  // Presenting allocates (to format statistics), so count allocations first
+  check_allocations();
+  renderer.present(stats);
 }
 
-bool Frame::is_image_done() const noexcept {
-  // All columns have been drawn to:
-  // ocluded range = {0, renderer.get_img_size().x};
-  if (occluded_cols.size() != 1)
-    return false;
-  return occluded_cols.front().start == 0 &&
-         occluded_cols.front().end == renderer.get_img_size().x;
+bool View::is_image_done() const noexcept {
+  return open_columns == 0;
+}
+void View::close_column(unsigned column) noexcept {
+  UnsignedRange& rows = visible_rows[column];
+  if (rows.start >= rows.end)
+    return;
+  // Empty row ranges clip everything drawn to the column afterwards
+  rows.start = rows.end;
+  --open_columns;
 }
-void Frame::insert_occluded_range(unsigned start, unsigned end) noexcept {
+void View::insert_occluded_range(unsigned start, unsigned end) noexcept {
   // Invalid range
   if (start > end)
     return;
 
-  // Insert new range while keeping list sorted
-  std::list<UnsignedRange>::iterator found = occluded_cols.begin();
-  while (found != occluded_cols.end() && found->start < start)
-    ++found;
-  occluded_cols.emplace(found, UnsignedRange{start, end});
+  // Find the ranges that touch the new one. The list is sorted and never
+  // overlaps, so they're contiguous.
+  auto first = std::lower_bound(
+      occluded_cols.begin(), occluded_cols.end(), start,
+      [](const UnsignedRange& range, unsigned col) { return range.end < col; });
+  auto last = first;
+  while (last != occluded_cols.end() && last->start <= end)
+    ++last;
 
-  // Re-sort and merge occlusion list
-  std::list<UnsignedRange> new_occluded_cols{occluded_cols.front()};
-  for (const auto& range : occluded_cols) {
-    UnsignedRange& prev = new_occluded_cols.back();
-    if (prev.end >= range.start)
-      prev.end = std::max(prev.end, range.end);
-    else
-      new_occluded_cols.emplace_back(range);
+  // Merge them in place (at most one range is added to the list)
+  if (first == last) {
+    occluded_cols.insert(first, UnsignedRange{start, end});
+  } else {
+    first->start = std::min(first->start, start);
+    first->end = std::max((last - 1)->end, end);
+    occluded_cols.erase(first + 1, last);
   }
-  occluded_cols = new_occluded_cols;
+  stats.occlusion_list_size =
+      std::max(stats.occlusion_list_size, occluded_cols.size());
 }
-bool Frame::clip_seg(glm::vec2& start, glm::vec2& end) noexcept {
+bool View::clip_seg(glm::vec2& start, glm::vec2& end) noexcept {
+  WOOP_PROFILE_SCOPE("View::clip_seg");
   float fov_slope = tan(glm::radians(camera.get_fov() / 2.0f));
   float fov_y_at_start_x = fov_slope * std::abs(start.x);
   float fov_y_at_end_x = fov_slope * std::abs(end.x);
@@ -123,7 +225,7 @@ bool Frame::clip_seg(glm::vec2& start, glm::vec2& end) noexcept {
     return false;
   return true;
 }
-std::optional<glm::vec2> Frame::get_segment_intersection(
+std::optional<glm::vec2> View::get_segment_intersection(
     const glm::vec2& start_1,
     const glm::vec2& end_1,
     const glm::vec2& start_2,
@@ -148,9 +250,11 @@ std::optional<glm::vec2> Frame::get_segment_intersection(
   return std::nullopt;
 }
 
-std::vector<UnsignedRange> Frame::get_visible_subsegs(unsigned start,
-                                                      unsigned end) noexcept {
-  std::vector<UnsignedRange> out{UnsignedRange{start, end}};
+void View::get_visible_subsegs(unsigned start,
+                                unsigned end,
+                                ArenaVector<UnsignedRange>& out) {
+  WOOP_PROFILE_SCOPE("View::get_visible_subsegs");
+  out.assign(1, UnsignedRange{start, end});
   for (const auto& range : occluded_cols) {
     UnsignedRange& prev = out.back();
 
@@ -170,13 +274,11 @@ std::vector<UnsignedRange> Frame::get_visible_subsegs(unsigned start,
     }
 
     if (prev.start > prev.end) {
-      if (out.size() > 1)
-        out.erase(out.end() - 1);
-      else
-        return std::vector<UnsignedRange>{};
+      out.pop_back();
+      if (out.empty())
+        return;
     }
   }
-  return out;
 }
 
 void Frame::map_buffer() {
@@ -184,48 +286,168 @@ void Frame::map_buffer() {
   void* raw_buffer = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
   buffer = static_cast<Pixel*>(raw_buffer);
 }
-void Frame::update_display_texture() {
-  renderer.swap_pbos();
-  renderer.bind_pbo_front();
-  display_rect.bind_texture();
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, renderer.get_img_size().x,
-                  renderer.get_img_size().y, GL_RGBA, GL_UNSIGNED_BYTE,
-                  nullptr);
+void Frame::create_views(Camera* cameras) {
+  views.reserve(renderer.views.size());
+  for (std::size_t i = 0; i < renderer.views.size(); ++i) {
+    auto& slot = renderer.views[i];
+    Camera& camera = cameras ? cameras[i] : *slot.camera;
+    views.push_back(
+        View(renderer, camera, slot.viewport, *slot.arena, buffer));
+  }
 }
-Pixel& Frame::get_buffer_element(unsigned x, unsigned y) {
-  if (x > renderer.get_img_size().x || y > renderer.get_img_size().y)
+Pixel& View::get_buffer_element(unsigned x, unsigned y) {
+  if (x >= viewport.size.x || y >= viewport.size.y)
     throw RenderException(RenderException::Type::FrameError,
                           "Can't access pixel at given index (out of bounds)");
-  return buffer[y * renderer.get_img_size().x + x];
+  return buffer[(viewport.offset.y + y) * renderer.get_img_size().x +
+                viewport.offset.x + x];
 }
 
 void Frame::clear(const Pixel& color) {
-  if (invalid)
+  if (invalid || reused)
     return;
   std::fill(buffer, buffer + renderer.get_pixel_count(), color);
+  for (auto& view : views)
+    view.clear();
+}
+void Frame::draw(DrawMode mode, const Node& node) {
+  if (invalid || reused)
+    return;
+  auto draw_view = [&](std::size_t i) {
+    views[i].draw(mode, node);
+    views[i].draw_sprites();
+  };
+  bool overlap = renderer.do_viewports_overlap();
+  if (!overlap && renderer.config.parallel_views) {
+    renderer.thread_pool->parallel_for(views.size(), draw_view);
+    return;
+  }
+  // Later views are drawn on top of earlier ones, hiding what's behind them
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    if (overlap && i > 0)
+      views[i].fill(renderer.config.clear_color);
+    draw_view(i);
+  }
+}
+void Frame::draw(DrawMode mode, const Level& level) {
+  if (invalid || reused)
+    return;
+  renderer.resolve_ramps(level);
+  for (auto& view : views)
+    view.set_cull_level(&level);
+  draw(mode, level.get_root_node());
+  for (auto& view : views)
+    view.set_cull_level(nullptr);
+}
+View& Frame::get_view(std::size_t index) {
+  if (index >= views.size())
+    throw RenderException(RenderException::Type::FrameError,
+                          "Attempting to access a view that doesn't exist");
+  return views[index];
+}
+
+View::View(Renderer& rndr,
+           Camera& cam,
+           const Viewport& port,
+           FrameArena& arena,
+           Pixel* pixels)
+    : renderer(rndr),
+      camera(cam),
+      viewport(port),
+      visible_rows(port.size.x, {0, port.size.y}, arena),
+      occluded_cols(arena),
+      visible_ranges(arena),
+      open_columns(port.size.x),
+      vissprites(arena),
+      drawsegs(arena),
+      wall_clips(arena),
+      column_clips(arena),
+      column_clip_offsets(arena),
+      buffer(pixels),
+      cull_level(nullptr),
+      pvs(nullptr),
+      camera_sector(0),
+      camera_subsector(0) {
+  screen_plane_distance =
+      static_cast<float>(viewport.size.x) / 2.0f /
+      static_cast<float>(std::tan(glm::radians(camera.get_fov() / 2.0f)));
+  // Light tables follow Doom's projection (160 units to the screen plane)
+  light_scale = 160.0f / screen_plane_distance;
+}
+void View::set_cull_level(const Level* level) {
+  cull_level = level;
+  pvs = nullptr;
+  if (!level)
+    return;
+  if (renderer.config.pvs_culling)
+    pvs = level->get_pvs();
+  const Subsector& subsector = level->get_subsector(camera.get_position_2d());
+  camera_subsector = level->get_subsector_index(subsector);
+  camera_sector = level->get_sector_index(level->get_sector(subsector));
+}
+void View::fill(const Pixel& color) {
+  for (unsigned row = 0; row < viewport.size.y; ++row) {
+    Pixel* start = &get_buffer_element(0, row);
+    std::fill(start, start + viewport.size.x, color);
+  }
+}
+void View::clear() {
   occluded_cols.clear();
-  visible_rows = std::vector<UnsignedRange>(renderer.get_img_size().x,
-                                            {0, renderer.get_img_size().y});
+  visible_rows.assign(viewport.size.x, {0, viewport.size.y});
+  open_columns = viewport.size.x;
+  vissprites.clear();
+  drawsegs.clear();
+  wall_clips.clear();
+  stats = RenderStats{};
 }
 
-void Frame::draw(DrawMode mode, const Node& node) {
-  if (invalid || is_image_done())
+void View::draw(DrawMode mode, const Node& node) {
+  if (is_image_done()) {
+    ++stats.nodes_culled;
+    return;
+  }
+  if (pvs && !pvs->is_node_visible(camera_subsector,
+                                   cull_level->get_node_index(node))) {
+    ++stats.nodes_pvs_culled;
     return;
+  }
+  ++stats.nodes_visited;
   Node::Child nearest_child = node.get_nearest_child(camera.get_position_2d());
   Node::Child farthest_child = !nearest_child;
 
   draw_node_child(mode, node, nearest_child);
   draw_node_child(mode, node, farthest_child);
 }
-void Frame::draw(DrawMode mode, const Subsector& subsector) {
-  if (invalid || is_image_done())
+void View::draw(DrawMode mode, const Subsector& subsector) {
+  if (is_image_done())
+    return;
+  if (cull_level && pvs &&
+      !pvs->is_visible(camera_subsector,
+                       cull_level->get_subsector_index(subsector))) {
+    ++stats.subsectors_rejected;
     return;
-  for (const Seg* seg : subsector.segs)
-    draw(mode, *seg);
+  }
+  if (cull_level && renderer.config.reject_culling) {
+    const Sector& sector = cull_level->get_sector(subsector);
+    if (!cull_level->can_see(camera_sector,
+                             cull_level->get_sector_index(sector))) {
+      ++stats.subsectors_rejected;
+      return;
+    }
+  }
+  project_things(mode, subsector);
+  for (const Seg& seg : subsector.segs)
+    draw(mode, seg);
 }
-void Frame::draw(DrawMode mode, const Seg& seg) {
-  if (invalid || is_image_done() || !seg.sidedef)
+void View::draw(DrawMode mode, const Seg& seg) {
+  if (is_image_done() || !seg.sidedef)
     return;
+  ++stats.segs_tested;
+
+  if (is_seg_backfacing(seg.start, seg.end)) {
+    ++stats.segs_backfacing;
+    return;
+  }
 
   glm::vec2 start =
       rotate_point(seg.start - camera.get_position_2d(), camera.get_rotation());
@@ -234,8 +456,12 @@ void Frame::draw(DrawMode mode, const Seg& seg) {
 
   if (!is_seg_visible(start, end))
     return;
+  glm::vec2 unclipped_start = start;
+  glm::vec2 unclipped_end = end;
   if (!clip_seg(start, end))
     return;
+  if (start != unclipped_start || end != unclipped_end)
+    ++stats.segs_clipped;
 
   float start_screen = get_screen_plane_y(start);
   float end_screen = get_screen_plane_y(end);
@@ -243,18 +469,21 @@ void Frame::draw(DrawMode mode, const Seg& seg) {
   unsigned end_column = get_column(end_screen);
 
   // All "subsegments", or visible fragments of the current seg
-  std::vector subsegs = get_visible_subsegs(start_column, end_column);
-  if (subsegs.size() == 0)
+  get_visible_subsegs(start_column, end_column, visible_ranges);
+  if (visible_ranges.empty()) {
+    ++stats.segs_occluded;
     return;
-  draw_subsegs(mode, seg, subsegs, start, end);
+  }
+  draw_subsegs(mode, seg, visible_ranges, start, end);
   if (is_seg_solid(seg))
     insert_occluded_range(start_column, end_column);
 }
-void Frame::draw_subsegs(DrawMode mode,
+void View::draw_subsegs(DrawMode mode,
                          const Seg& seg,
-                         const std::vector<UnsignedRange>& subsegs,
+                         const ArenaVector<UnsignedRange>& subsegs,
                          const glm::vec2& start,
                          const glm::vec2& end) {
+  WOOP_PROFILE_SCOPE("View::draw_subsegs");
   float screen_start = get_screen_plane_y(start);
   float screen_end = get_screen_plane_y(end);
   float start_scale = get_scale(start.x);
@@ -264,15 +493,37 @@ void Frame::draw_subsegs(DrawMode mode,
   int16_t floor = sector.floor.height;
   int16_t ceil = sector.ceiling.height;
 
+  // Colors only depend on the seg, so they're looked up once
+  const SidedefRamps ramps = get_sidedef_ramps(*seg.sidedef);
+  const ColorRamp& middle_ramp = *ramps.middle;
+  const ColorRamp& lower_ramp = *ramps.lower;
+  const ColorRamp& upper_ramp = *ramps.upper;
+  // Fake contrast (from Doom): walls along the x axis are darker, and walls
+  // along the y axis are brighter
+  int light_level = sector.light_level;
+  if (seg.start.y == seg.end.y)
+    light_level -= 16;
+  else if (seg.start.x == seg.end.x)
+    light_level += 16;
+
+  // Interpolate scale screen plane position
+  auto get_column_scale = [&](unsigned col) {
+    float screen = get_screen_plane_y(col);
+    float v = (screen - screen_start) / (screen_end - screen_start);
+    v = std::clamp(v, 0.0f, 1.0f);
+    return start_scale + v * (end_scale - start_scale);
+  };
+
   for (const auto& subseg : subsegs) {
+    if (subseg.end > subseg.start)
+      stats.columns_drawn += subseg.end - subseg.start;
     for (unsigned col = subseg.start; col < subseg.end; ++col) {
-      // Interpolate scale screen plane position
-      float screen = get_screen_plane_y(col);
-      float v = (screen - screen_start) / (screen_end - screen_start);
-      v = std::clamp(v, 0.0f, 1.0f);
-      float scale = start_scale + v * (end_scale - start_scale);
+      // Nothing more can be drawn to closed columns
+      if (visible_rows[col].start >= visible_rows[col].end)
+        continue;
+      float scale = get_column_scale(col);
 
-      float fog = renderer.get_fog_strength() - scale;
+      uint8_t shade = get_shade(light_level, scale);
 
       // Drawing solid segs
       if (is_seg_solid(seg)) {
@@ -280,16 +531,15 @@ void Frame::draw_subsegs(DrawMode mode,
         // Clip occluded rows
         range = clip_row_range(col, range);
 
-        renderer.set_fill_color(
-            get_texture_color(seg.sidedef->middle_name, fog));
         switch (mode) {
           case DrawMode::Solid:
-            draw_column_solid(col, range);
+            draw_column_solid(col, range, middle_ramp[shade]);
             break;
           default:
             log_error("Unknown draw mode provided!");
             break;
         }
+        close_column(col);
       }
       // Drawing "window" segs
       else {
@@ -316,13 +566,8 @@ void Frame::draw_subsegs(DrawMode mode,
 
           switch (mode) {
             case DrawMode::Solid:
-              renderer.set_fill_color(
-                  get_texture_color(seg.sidedef->lower_name, fog));
-              draw_column_solid(col, bottom_range);
-
-              renderer.set_fill_color(
-                  get_texture_color(seg.sidedef->upper_name, fog));
-              draw_column_solid(col, top_range);
+              draw_column_solid(col, bottom_range, lower_ramp[shade]);
+              draw_column_solid(col, top_range, upper_ramp[shade]);
               break;
             default:
               log_error("Unknown draw mode provided!");
@@ -330,23 +575,36 @@ void Frame::draw_subsegs(DrawMode mode,
           }
         }
         window_range = clip_row_range(col, window_range);
-        visible_rows[col].start =
-            std::max(window_range.start, visible_rows[col].start);
-        visible_rows[col].end =
-            std::min(window_range.end, visible_rows[col].end);
-        if (visible_rows[col].start > visible_rows[col].end)
-          visible_rows[col].start = visible_rows[col].end;
+        if (window_range.start >= window_range.end) {
+          // The opening's ceiling meets its floor
+          close_column(col);
+        } else {
+          visible_rows[col].start =
+              std::max(window_range.start, visible_rows[col].start);
+          visible_rows[col].end =
+              std::min(window_range.end, visible_rows[col].end);
+        }
       }
     }
+    // Sprites behind the wall only show through the rows it left open
+    if (!renderer.sprites || subseg.start >= subseg.end)
+      continue;
+    drawsegs.push_back({subseg, wall_clips.size()});
+    for (unsigned col = subseg.start; col < subseg.end; ++col)
+      wall_clips.push_back({get_column_scale(col), visible_rows[col]});
   }
 }
 
-void Frame::draw_column_solid(unsigned column, const UnsignedRange& range) {
+void View::draw_column_solid(unsigned column,
+                             const UnsignedRange& range,
+                             const Pixel& color) {
+  if (range.end > range.start)
+    stats.pixels_written += range.end - range.start;
   for (unsigned row = range.start; row < range.end; ++row) {
-    get_buffer_element(column, row) = renderer.get_fill_color();
+    get_buffer_element(column, row) = color;
   }
 }
-bool Frame::is_seg_visible(const glm::vec2& start,
+bool View::is_seg_visible(const glm::vec2& start,
                            const glm::vec2& end) const noexcept {
   // Far planes
   if (start.x < camera.get_near_plane() && end.x < camera.get_near_plane())
@@ -366,10 +624,18 @@ bool Frame::is_seg_visible(const glm::vec2& start,
 
   return true;
 }
-bool Frame::is_seg_solid(const Seg& seg) const noexcept {
+bool View::is_seg_backfacing(const glm::vec2& start,
+                              const glm::vec2& end) const noexcept {
+  // Sidedefs face the right side of their seg, so the camera must lie to the
+  // right of start->end for the seg to be seen.
+  glm::vec2 seg = end - start;
+  glm::vec2 to_camera = camera.get_position_2d() - start;
+  return seg.x * to_camera.y - seg.y * to_camera.x >= 0.0f;
+}
+bool View::is_seg_solid(const Seg& seg) const noexcept {
   return !seg.linedef.front ^ !seg.linedef.back;
 }
-glm::vec2 Frame::rotate_point(const glm::vec2& point,
+glm::vec2 View::rotate_point(const glm::vec2& point,
                               float degrees) const noexcept {
   float rad = glm::radians(degrees);
   return {
@@ -377,43 +643,43 @@ glm::vec2 Frame::rotate_point(const glm::vec2& point,
       point.x * sin(rad) + point.y * cos(rad),
   };
 }
-float Frame::get_screen_plane_y(const glm::vec2& view) noexcept {
+float View::get_screen_plane_y(const glm::vec2& view) noexcept {
   float slope = view.y / std::clamp(std::abs(view.x), camera.get_near_plane(),
                                     camera.get_far_plane());
-  return slope * renderer.get_screen_plane_distance();
+  return slope * screen_plane_distance;
 }
-float Frame::get_screen_plane_y(unsigned column) noexcept {
-  const float screen_size = static_cast<float>(renderer.get_img_size().x);
-  unsigned reflected = renderer.get_img_size().x - column;
+float View::get_screen_plane_y(unsigned column) noexcept {
+  const float screen_size = static_cast<float>(viewport.size.x);
+  unsigned reflected = viewport.size.x - column;
   return static_cast<float>(reflected) - screen_size / 2.0f;
 }
-unsigned Frame::get_column(float screen_y) {
-  const float screen_size = static_cast<float>(renderer.get_img_size().x);
+unsigned View::get_column(float screen_y) {
+  const float screen_size = static_cast<float>(viewport.size.x);
   screen_y = std::clamp(screen_y + screen_size / 2.0f, 0.0f, screen_size);
   // Coordinates need to be reflected (world space increses bottom->top, but
   // columns increase left->right)
-  return renderer.get_img_size().x - static_cast<unsigned>(screen_y);
+  return viewport.size.x - static_cast<unsigned>(screen_y);
 }
-float Frame::get_scale(float distance) {
+float View::get_scale(float distance) {
   constexpr float min_scale = 0.0025f;
   constexpr float max_scale = 5'000.0f;
   if (distance <= camera.get_near_plane())
     return max_scale;
-  float scale = renderer.get_screen_plane_distance() / distance;
+  float scale = screen_plane_distance / distance;
   return std::clamp(scale, min_scale, max_scale);
 }
-UnsignedRange Frame::get_row_range(int16_t floor, int16_t ceil, float scale) {
-  float screen_half = static_cast<float>(renderer.get_img_size().y) / 2.0f;
+UnsignedRange View::get_row_range(int16_t floor, int16_t ceil, float scale) {
+  float screen_half = static_cast<float>(viewport.size.y) / 2.0f;
   float floor_adjusted = (floor - camera.get_position().y) * scale;
   float ceil_adjusted = (ceil - camera.get_position().y) * scale;
   int floor_int = static_cast<int>(screen_half + floor_adjusted);
   int ceil_int = static_cast<int>(screen_half + ceil_adjusted);
-  int max_row = static_cast<int>(renderer.get_img_size().y);
+  int max_row = static_cast<int>(viewport.size.y);
   floor_int = std::clamp(floor_int, 0, max_row);
   ceil_int = std::clamp(ceil_int, 0, max_row);
   return {static_cast<unsigned>(floor_int), static_cast<unsigned>(ceil_int)};
 }
-UnsignedRange Frame::clip_row_range(unsigned column,
+UnsignedRange View::clip_row_range(unsigned column,
                                     const UnsignedRange& range) {
   unsigned start = visible_rows[column].start;
   unsigned end = visible_rows[column].end;
@@ -423,7 +689,169 @@ UnsignedRange Frame::clip_row_range(unsigned column,
   };
 }
 
-void Frame::draw_node_child(DrawMode mode,
+void View::project_things(DrawMode mode, const Subsector& subsector) {
+  if (!renderer.sprites || subsector.things.empty())
+    return;
+  for (const Thing* thing : subsector.things)
+    project_thing(mode, *thing, *subsector.sector);
+}
+void View::project_thing(DrawMode mode,
+                          const Thing& thing,
+                          const Sector& sector) {
+  const ThingSprite* thing_sprite = SpriteSet::get_thing_sprite(thing.type);
+  if (!thing_sprite)
+    return;
+  const SpriteFrame* frame = renderer.sprites->get_frame(*thing_sprite);
+  if (!frame)
+    return;
+
+  glm::vec2 to_thing = thing.position - camera.get_position_2d();
+  glm::vec2 view = rotate_point(to_thing, camera.get_rotation());
+  if (view.x < camera.get_near_plane() || view.x > camera.get_far_plane())
+    return;
+
+  // Pick the rotation that faces the camera (rotation 0 when the thing looks
+  // straight at it)
+  float angle = glm::degrees(std::atan2(to_thing.y, to_thing.x)) - thing.angle;
+  angle = std::fmod(angle + 180.0f + 22.5f, 360.0f);
+  if (angle < 0.0f)
+    angle += 360.0f;
+  std::size_t rotation = static_cast<std::size_t>(angle / 45.0f) % 8;
+  const Patch* patch = frame->patches[rotation];
+  if (!patch)
+    return;
+  bool flipped = frame->flipped[rotation];
+
+  // Patch offsets place the thing's origin within the patch
+  float scale = get_scale(view.x);
+  float width = static_cast<float>(patch->get_width());
+  float left_offset = static_cast<float>(patch->get_left_offset());
+  if (flipped)
+    left_offset = width - left_offset;
+  float screen_left = get_screen_plane_y(view) + left_offset * scale;
+  UnsignedRange columns = {
+      get_column(screen_left),
+      get_column(screen_left - width * scale),
+  };
+  if (columns.start >= columns.end)
+    return;
+
+  float height = static_cast<float>(patch->get_height());
+  float top = (thing_sprite->hanging)
+                  ? static_cast<float>(sector.ceiling.height) - height
+                  : static_cast<float>(sector.floor.height);
+  top += static_cast<float>(patch->get_top_offset());
+
+  vissprites.emplace_back(VisSprite{
+      frame,
+      patch,
+      &get_thing_ramp(thing, *frame),
+      flipped,
+      mode,
+      columns,
+      screen_left,
+      scale,
+      sector.light_level,
+      top,
+      top - height,
+  });
+}
+void View::draw_sprites() {
+  WOOP_PROFILE_SCOPE("View::draw_sprites");
+  if (vissprites.empty())
+    return;
+  index_wall_clips();
+  // Farther sprites have smaller scales, and are drawn first
+  std::sort(vissprites.begin(), vissprites.end(),
+            [](const VisSprite& a, const VisSprite& b) {
+              return a.scale < b.scale;
+            });
+  for (const auto& sprite : vissprites)
+    draw_sprite(sprite);
+  stats.sprites_drawn += static_cast<unsigned>(vissprites.size());
+  vissprites.clear();
+}
+void View::index_wall_clips() {
+  // Counting sort by column, which keeps each column's walls in order
+  column_clip_offsets.assign(viewport.size.x + 1, 0);
+  for (const DrawSeg& drawseg : drawsegs) {
+    for (unsigned col = drawseg.columns.start; col < drawseg.columns.end; ++col)
+      ++column_clip_offsets[col + 1];
+  }
+  for (unsigned col = 0; col < viewport.size.x; ++col)
+    column_clip_offsets[col + 1] += column_clip_offsets[col];
+  // Offsets are advanced past each column's clips as they're placed, then
+  // shifted back to where the columns start
+  column_clips.resize(wall_clips.size(), WallClip{});
+  for (const DrawSeg& drawseg : drawsegs) {
+    for (unsigned col = drawseg.columns.start; col < drawseg.columns.end; ++col)
+      column_clips[column_clip_offsets[col]++] =
+          wall_clips[drawseg.clip_offset + col - drawseg.columns.start];
+  }
+  for (unsigned col = viewport.size.x; col > 0; --col)
+    column_clip_offsets[col] = column_clip_offsets[col - 1];
+  column_clip_offsets[0] = 0;
+}
+void View::draw_sprite(const VisSprite& sprite) {
+  if (sprite.mode != DrawMode::Solid) {
+    log_error("Unknown draw mode provided!");
+    return;
+  }
+  const Patch& patch = *sprite.patch;
+  int width = patch.get_width();
+  int height = patch.get_height();
+  float screen_half = static_cast<float>(viewport.size.y) / 2.0f;
+  float camera_height = camera.get_position().y;
+  Pixel color = (*sprite.ramp)[get_shade(sprite.light_level, sprite.scale)];
+
+  int max_row = static_cast<int>(viewport.size.y);
+  int bottom_row = static_cast<int>(
+      screen_half + (sprite.bottom - camera_height) * sprite.scale);
+  int top_row = static_cast<int>(screen_half +
+                                 (sprite.top - camera_height) * sprite.scale);
+  UnsignedRange rows = {
+      static_cast<unsigned>(std::clamp(bottom_row, 0, max_row)),
+      static_cast<unsigned>(std::clamp(top_row, 0, max_row)),
+  };
+
+  for (unsigned col = sprite.columns.start; col < sprite.columns.end; ++col) {
+    // Walls in a column were drawn front to back, so their scales decrease,
+    // and each one's clip includes the walls drawn before it. The sprite is
+    // clipped by the farthest wall in front of it (walls it stands in front
+    // of don't hide it).
+    const WallClip* first = column_clips.data() + column_clip_offsets[col];
+    const WallClip* last = column_clips.data() + column_clip_offsets[col + 1];
+    const WallClip* behind =
+        std::partition_point(first, last, [&](const WallClip& wall) {
+          return wall.scale > sprite.scale;
+        });
+    UnsignedRange clip = (behind == first) ? UnsignedRange{0, viewport.size.y}
+                                           : (behind - 1)->rows;
+    unsigned start = std::clamp(rows.start, clip.start, clip.end);
+    unsigned end = std::clamp(rows.end, clip.start, clip.end);
+    if (start >= end)
+      continue;
+
+    float screen_x = sprite.screen_left - get_screen_plane_y(col);
+    int tex_x = std::clamp(static_cast<int>(screen_x / sprite.scale), 0,
+                           width - 1);
+    if (sprite.flipped)
+      tex_x = width - 1 - tex_x;
+
+    for (unsigned row = start; row < end; ++row) {
+      float z = camera_height +
+                (static_cast<float>(row) + 0.5f - screen_half) / sprite.scale;
+      int tex_y = std::clamp(static_cast<int>(sprite.top - z), 0, height - 1);
+      if (patch.get_texel(static_cast<unsigned>(tex_x),
+                          static_cast<unsigned>(tex_y)) == Patch::transparent)
+        continue;
+      get_buffer_element(col, row) = color;
+      ++stats.pixels_written;
+    }
+  }
+}
+
+void View::draw_node_child(DrawMode mode,
                             const Node& node,
                             Node::Child child) {
   if (node.is_node(child))
@@ -432,36 +860,79 @@ void Frame::draw_node_child(DrawMode mode,
     draw(mode, node.get_subsector(child));
 }
 
-Pixel Frame::get_texture_color(const std::string& name, float fog) {
-  static std::unordered_map<std::string, Pixel> colormap;
-  if (colormap.find(name) == colormap.end())
-    colormap.insert({name, get_random_color()});
-
-  // Fade color based on fog value
-  fog = std::clamp(fog, 0.0f, 1.0f);
-  return interpolate_color(fog, colormap[name], renderer.get_fog_color());
+SidedefRamps View::get_sidedef_ramps(const Sidedef& sidedef) {
+  if (cull_level && cull_level->get_revision() == renderer.ramp_revision)
+    return renderer.sidedef_ramps[cull_level->get_sidedef_index(sidedef)];
+  return {&renderer.get_texture_ramp(sidedef.middle_name),
+          &renderer.get_texture_ramp(sidedef.lower_name),
+          &renderer.get_texture_ramp(sidedef.upper_name)};
+}
+const ColorRamp& View::get_thing_ramp(const Thing& thing,
+                                      const SpriteFrame& frame) {
+  if (cull_level && cull_level->get_revision() == renderer.ramp_revision &&
+      renderer.ramp_sprites == renderer.sprites) {
+    const ColorRamp* ramp =
+        renderer.thing_ramps[cull_level->get_thing_index(thing)];
+    if (ramp)
+      return *ramp;
+  }
+  return renderer.get_texture_ramp(frame.sprite);
+}
+void Frame::check_allocations() noexcept {
+  stats.heap_allocations = AllocationCounter::get_count() - start_allocations;
+#if defined(WOOP_TRACK_ALLOCATIONS) && !defined(WOOP_ENABLE_PROFILING)
+  // New textures and arena growth allocate, but only until the renderer warms
+  // up (the profiler allocates as it records, so it's excluded)
+  bool warming_up = renderer.texture_ramps.size() != start_ramp_count ||
+                    renderer.arena.get_overflow_count() > 0;
+  for (const auto& slot : renderer.views)
+    warming_up = warming_up || slot.arena->get_overflow_count() > 0;
+  assert(stats.heap_allocations == 0 || warming_up);
+#endif
+}
+uint8_t View::get_shade(int light_level, float scale) const noexcept {
+  return renderer.light_table.get_shade(light_level, scale * light_scale);
 }
 
 Renderer::Renderer(Window& wdw, Camera& cam, const RendererConfig& cfg)
     : config(cfg),
       window(wdw),
-      camera(cam),
-      display_rect(*this, get_shader_from_cfg(cfg)) {
-  // Shaders are only guaranteed to support 16 texture units.
-  if (cfg.texture_unit > 16)
+      display_rect(*this, get_shader_from_cfg(cfg), cfg.post_passes),
+      sprites(nullptr),
+      light_table(cfg.fog_color, cfg.fog_strength),
+      ramp_revision(0),
+      ramp_sprites(nullptr),
+      reused_frames(0) {
+  // Shaders are only guaranteed to support 16 texture units. Post-processing
+  // also binds the source image to the unit after the configured one.
+  if (cfg.texture_unit + 1 >= 16)
     throw RenderException(
         RenderException::Type::InvalidConfig,
         "Attempting to bind renderer to an invalid texture index.");
-  screen_plane_distance =
-      static_cast<float>(config.resolution.x) / 2.0f /
-      static_cast<float>(std::tan(glm::radians(camera.get_fov() / 2.0f)));
+  add_view(cam, Viewport{{0, 0}, config.resolution});
+  if (config.parallel_views)
+    thread_pool = std::make_unique<ThreadPool>();
   gen_pbos();
 }
 
 Frame Renderer::begin_frame() {
-  Frame frame = Frame(*this);
-  frame.clear(config.clear_color);
-  return frame;
+  // Frames drawn without a level can't be compared to later ones
+  last_views.clear();
+  return start_frame();
+}
+Frame Renderer::begin_frame(const Level& level, uint64_t tick) {
+  bool unchanged = config.reuse_frames && !views.empty() &&
+                   last_views.size() == views.size();
+  for (std::size_t i = 0; unchanged && i < views.size(); ++i)
+    unchanged = last_views[i] == get_view_state(i, level, tick);
+  if (unchanged) {
+    arena.reset();
+    return Frame(*this, true);
+  }
+  last_views.clear();
+  for (std::size_t i = 0; i < views.size(); ++i)
+    last_views.emplace_back(get_view_state(i, level, tick));
+  return start_frame();
 }
 glm::uvec2 Renderer::get_img_size() const noexcept {
   return config.resolution;
@@ -472,6 +943,92 @@ std::size_t Renderer::get_pixel_count() const noexcept {
 unsigned Renderer::get_texture_unit() const noexcept {
   return config.texture_unit;
 }
+std::size_t Renderer::add_view(Camera& camera, const Viewport& viewport) {
+  check_viewport(viewport);
+  views.emplace_back(
+      ViewSlot{&camera, viewport, std::make_unique<FrameArena>()});
+  last_views.clear();
+  return views.size() - 1;
+}
+void Renderer::set_viewport(std::size_t view, const Viewport& viewport) {
+  check_viewport(viewport);
+  if (view >= views.size())
+    throw RenderException(RenderException::Type::InvalidConfig,
+                          "Attempting to move a view that doesn't exist");
+  views[view].viewport = viewport;
+  last_views.clear();
+}
+void Renderer::remove_view(std::size_t view) {
+  if (view >= views.size())
+    throw RenderException(RenderException::Type::InvalidConfig,
+                          "Attempting to remove a view that doesn't exist");
+  views.erase(views.begin() + static_cast<std::ptrdiff_t>(view));
+  last_views.clear();
+}
+const Viewport& Renderer::get_viewport(std::size_t view) const {
+  if (view >= views.size())
+    throw RenderException(RenderException::Type::InvalidConfig,
+                          "Attempting to access a view that doesn't exist");
+  return views[view].viewport;
+}
+const Camera& Renderer::get_camera(std::size_t view) const {
+  if (view >= views.size())
+    throw RenderException(RenderException::Type::InvalidConfig,
+                          "Attempting to access a view that doesn't exist");
+  return *views[view].camera;
+}
+void Renderer::set_fog_color(const Pixel& color) {
+  config.fog_color = color;
+  set_light_table(LightTable(config.fog_color, config.fog_strength));
+}
+void Renderer::set_fog_strength(float strength) {
+  config.fog_strength = strength;
+  set_light_table(LightTable(config.fog_color, config.fog_strength));
+}
+void Renderer::set_light_table(const LightTable& table) {
+  light_table = table;
+  // Shades need to be rebuilt with the new table
+  texture_ramps.clear();
+  ramp_revision = 0;
+  last_views.clear();
+}
+
+const ColorRamp& Renderer::get_texture_ramp(const std::string& name) {
+  // Ramps are node-based, so references stay valid as others are added
+  std::lock_guard lock(texture_mutex);
+  auto found = texture_ramps.find(name);
+  if (found != texture_ramps.end())
+    return found->second;
+
+  // Base colors are kept when the light table changes
+  auto color = texture_colors.find(name);
+  if (color == texture_colors.end())
+    color = texture_colors.emplace(name, get_random_color()).first;
+  ColorRamp ramp = light_table.get_ramp(color->second);
+  return texture_ramps.emplace(name, ramp).first->second;
+}
+void Renderer::resolve_ramps(const Level& level) {
+  if (ramp_revision == level.get_revision() && ramp_sprites == sprites)
+    return;
+  WOOP_PROFILE_SCOPE("Renderer::resolve_ramps");
+  sidedef_ramps.clear();
+  for (const Sidedef& sidedef : level.get_sidedefs()) {
+    sidedef_ramps.push_back({&get_texture_ramp(sidedef.middle_name),
+                             &get_texture_ramp(sidedef.lower_name),
+                             &get_texture_ramp(sidedef.upper_name)});
+  }
+  thing_ramps.assign(level.get_things().size(), nullptr);
+  for (std::size_t i = 0; sprites && i < thing_ramps.size(); ++i) {
+    const ThingSprite* thing_sprite =
+        SpriteSet::get_thing_sprite(level.get_things()[i].type);
+    const SpriteFrame* frame =
+        thing_sprite ? sprites->get_frame(*thing_sprite) : nullptr;
+    if (frame)
+      thing_ramps[i] = &get_texture_ramp(frame->sprite);
+  }
+  ramp_revision = level.get_revision();
+  ramp_sprites = sprites;
+}
 
 void Renderer::gen_pbos() {
   glGenBuffers(1, &pbo_back);
@@ -492,4 +1049,85 @@ void Renderer::bind_pbo_front() const noexcept {
 void Renderer::swap_pbos() noexcept {
   std::swap(pbo_back, pbo_front);
 }
+Frame Renderer::start_frame() {
+  // The previous frame has been drawn, so its scratch data can be reused
+  arena.reset();
+  for (auto& slot : views)
+    slot.arena->reset();
+  Frame frame = Frame(*this);
+  frame.clear(config.clear_color);
+  return frame;
+}
+Frame Renderer::start_offscreen_frame(Pixel* target,
+                                      Camera* cameras,
+                                      RenderStats& stats_out) {
+  arena.reset();
+  for (auto& slot : views)
+    slot.arena->reset();
+  Frame frame = Frame(*this, target, cameras, stats_out);
+  frame.clear(config.clear_color);
+  return frame;
+}
+void Renderer::present_image(const Pixel* image,
+                             const RenderStats& frame_stats) {
+  {
+    WOOP_PROFILE_SCOPE("glBufferSubData");
+    bind_pbo_back();
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0,
+                    static_cast<GLsizeiptr>(get_pixel_count() * sizeof(Pixel)),
+                    image);
+  }
+  present(frame_stats);
+}
+void Renderer::present(const RenderStats& frame_stats) {
+  stats = frame_stats;
+  stats.overdraw = static_cast<float>(stats.pixels_written) /
+                   static_cast<float>(get_pixel_count());
+  display_rect.get_overlay().set_text(
+      config.show_stats
+          ? stats.to_string() + display_rect.get_timing_summary()
+          : "");
+  {
+    WOOP_PROFILE_SCOPE("glTexSubImage2D");
+    swap_pbos();
+    bind_pbo_front();
+    display_rect.bind_texture();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, config.resolution.x,
+                    config.resolution.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+  display_rect.draw();
+  window.swap_buffers();
+}
+ViewState Renderer::get_view_state(std::size_t view,
+                                   const Level& level,
+                                   uint64_t tick) const noexcept {
+  const Camera& camera = *views[view].camera;
+  return ViewState{
+      camera.get_position(), camera.get_rotation(), camera.get_fov(),
+      config.resolution,     level.get_revision(),  tick,
+  };
+}
+bool Renderer::do_viewports_overlap() const noexcept {
+  auto overlaps = [](const Viewport& a, const Viewport& b) {
+    return a.offset.x < b.offset.x + b.size.x &&
+           b.offset.x < a.offset.x + a.size.x &&
+           a.offset.y < b.offset.y + b.size.y &&
+           b.offset.y < a.offset.y + a.size.y;
+  };
+  for (std::size_t i = 0; i < views.size(); ++i) {
+    for (std::size_t j = i + 1; j < views.size(); ++j) {
+      if (overlaps(views[i].viewport, views[j].viewport))
+        return true;
+    }
+  }
+  return false;
+}
+void Renderer::check_viewport(const Viewport& viewport) const {
+  glm::uvec2 end = viewport.offset + viewport.size;
+  if (viewport.size.x == 0 || viewport.size.y == 0 ||
+      end.x > config.resolution.x || end.y > config.resolution.y)
+    throw RenderException(
+        RenderException::Type::InvalidConfig,
+        "Viewport must be non-empty and fit within the output image");
+}
 }  // namespace woop
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "shader.hpp"
 #include "log.hpp"
+#include "utils.hpp"
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <new>
 #include <sstream>
+#include <vector>
 
 namespace woop {
 Shader::Shader(const std::string& vert_src, const std::string& frag_src) {
@@ -9,23 +14,28 @@ Shader::Shader(const std::string& vert_src, const std::string& frag_src) {
     throw ShaderException(
         ShaderException::Type::InvalidSource,
         "Attempting to create shader with empty source file.");
-  program = compile(vert_src, frag_src);
+  program = load_or_compile(vert_src, frag_src);
+  invalid = false;
+  cache_uniforms();
 }
-Shader::Shader(Shader&& other) {
+Shader::Shader(Shader&& other) : uniforms(std::move(other.uniforms)) {
   program = other.program;
-  invalid = false;
+  invalid = other.invalid;
   other.invalid = true;
 }
 Shader::~Shader() {
   if (is_valid())
-    glDeleteShader(program);
+    glDeleteProgram(program);
 }
 
 Shader& Shader::operator=(Shader&& other) {
+  if (this == &other)
+    return *this;
   if (is_valid())
-    glDeleteShader(program);
+    glDeleteProgram(program);
   program = other.program;
   invalid = other.invalid;
+  uniforms = std::move(other.uniforms);
   other.invalid = true;
   return *this;
 }
@@ -49,40 +59,54 @@ Shader Shader::from_file(const std::filesystem::path& vert_path,
   return Shader(vert_src, frag_src);
 }
 
+void Shader::set_binary_cache(const std::filesystem::path& directory) {
+  binary_cache = directory;
+  if (binary_cache.empty())
+    return;
+  std::error_code error;
+  std::filesystem::create_directories(binary_cache, error);
+  if (error) {
+    log_error("Could not create shader cache at ", binary_cache.string(),
+              ", disabling it");
+    binary_cache.clear();
+  }
+}
+
 void Shader::set_uniform(const std::string& name, bool v) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform1i(location, v);
+  get_uniform<bool>(name).set(v);
 }
 void Shader::set_uniform(const std::string& name, int v) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform1i(location, v);
+  get_uniform<int>(name).set(v);
 }
 void Shader::set_uniform(const std::string& name, unsigned v) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform1ui(location, v);
+  get_uniform<unsigned>(name).set(v);
 }
 void Shader::set_uniform(const std::string& name, float v) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform1f(location, v);
+  get_uniform<float>(name).set(v);
 }
 void Shader::set_uniform(const std::string& name, const glm::vec2& vec) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform2f(location, vec.x, vec.y);
+  get_uniform<glm::vec2>(name).set(vec);
 }
 void Shader::set_uniform(const std::string& name, const glm::vec3& vec) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform3f(location, vec.x, vec.y, vec.z);
+  get_uniform<glm::vec3>(name).set(vec);
 }
 void Shader::set_uniform(const std::string& name, const glm::vec4& vec) const {
-  use();
-  GLint location = glGetUniformLocation(program, name.c_str());
-  glUniform4f(location, vec.x, vec.y, vec.z, vec.w);
+  get_uniform<glm::vec4>(name).set(vec);
+}
+
+GLint Shader::get_uniform_location(const std::string& name) const {
+  if (!is_valid())
+    throw ShaderException(ShaderException::Type::InvalidUse,
+                          "Attempting to use invalidated shader.");
+  auto it = uniforms.find(name);
+  return it != uniforms.end() ? it->second : -1;
+}
+bool Shader::bind_uniform_block(const std::string& name, GLuint binding) const {
+  GLuint index = glGetUniformBlockIndex(get_program(), name.c_str());
+  if (index == GL_INVALID_INDEX)
+    return false;
+  glUniformBlockBinding(program, index, binding);
+  return true;
 }
 
 void Shader::use() const {
@@ -92,9 +116,138 @@ void Shader::use() const {
     throw ShaderException(ShaderException::Type::InvalidUse,
                           "Attempting to use invalidated shader.");
 }
+GLuint Shader::get_program() const {
+  if (!is_valid())
+    throw ShaderException(ShaderException::Type::InvalidUse,
+                          "Attempting to use invalidated shader.");
+  return program;
+}
+
+/**
+ * @brief Header at the start of a cached program binary.
+ */
+struct BinaryHeader {
+  static constexpr char expected_magic[8] = "WOOPPRG";
+  static constexpr uint32_t expected_version = 1;
+
+  char magic[8];
+  uint32_t version;
+  GLenum format;
+  uint64_t key;
+  uint64_t size;
+};
+
+GLuint Shader::load_or_compile(const std::string& vert_src,
+                               const std::string& frag_src) {
+  GLint formats = 0;
+  if (!binary_cache.empty())
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats <= 0)
+    return compile(vert_src, frag_src);
+
+  uint64_t key = get_binary_key(vert_src, frag_src);
+  if (GLuint cached = load_binary(key))
+    return cached;
+  GLuint program = compile(vert_src, frag_src, true);
+  save_binary(program, key);
+  return program;
+}
+uint64_t Shader::get_binary_key(const std::string& vert_src,
+                                const std::string& frag_src) {
+  auto gl_string = [](GLenum name) {
+    const GLubyte* str = glGetString(name);
+    return str ? std::string_view(reinterpret_cast<const char*>(str))
+               : std::string_view();
+  };
+  // Separators keep e.g. ("ab", "c") and ("a", "bc") from colliding
+  uint64_t key = fnv1a(vert_src);
+  key = fnv1a(std::string_view("\0", 1), key);
+  key = fnv1a(frag_src, key);
+  constexpr GLenum driver_strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+  for (GLenum name : driver_strings) {
+    key = fnv1a(std::string_view("\0", 1), key);
+    key = fnv1a(gl_string(name), key);
+  }
+  return key;
+}
+std::filesystem::path Shader::get_binary_path(uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin",
+                static_cast<unsigned long long>(key));
+  return binary_cache / name;
+}
+GLuint Shader::load_binary(uint64_t key) noexcept {
+  std::ifstream file(get_binary_path(key), std::ios::binary);
+  if (!file.is_open())
+    return 0;
+  BinaryHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, BinaryHeader::expected_magic,
+                  sizeof(header.magic)) != 0 ||
+      header.version != BinaryHeader::expected_version || header.key != key)
+    return 0;
+  // A corrupt size would otherwise allocate (or throw) before the read fails
+  std::streampos data_start = file.tellg();
+  if (!file.seekg(0, std::ios::end))
+    return 0;
+  std::streamoff remaining = file.tellg() - data_start;
+  if (remaining < 0 || header.size > static_cast<uint64_t>(remaining) ||
+      !file.seekg(data_start))
+    return 0;
+  std::vector<char> data;
+  try {
+    data.resize(static_cast<std::size_t>(header.size));
+  } catch (const std::bad_alloc&) {
+    return 0;
+  }
+  if (!file.read(data.data(), static_cast<std::streamsize>(data.size())))
+    return 0;
+
+  // Drivers reject binaries they can't use (e.g. after an update), in which
+  // case the program is compiled again
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, header.format, data.data(),
+                  static_cast<GLsizei>(data.size()));
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+void Shader::save_binary(GLuint program, uint64_t key) noexcept {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  BinaryHeader header;
+  std::memcpy(header.magic, BinaryHeader::expected_magic,
+              sizeof(header.magic));
+  header.version = BinaryHeader::expected_version;
+  header.key = key;
+  std::vector<char> data;
+  try {
+    data.resize(static_cast<std::size_t>(length));
+  } catch (const std::bad_alloc&) {
+    return;
+  }
+  GLsizei written = 0;
+  glGetProgramBinary(program, length, &written, &header.format, data.data());
+  header.size = static_cast<uint64_t>(written);
+
+  // Another instance may be writing the same binary, so it's never left
+  // partially written
+  std::filesystem::path path = get_binary_path(key);
+  if (!write_file_atomically(
+          path, {{reinterpret_cast<const char*>(&header), sizeof(header)},
+                 {data.data(), static_cast<std::size_t>(written)}}))
+    log_error("Could not write shader binary to ", path.string());
+}
 
 GLuint Shader::compile(const std::string& vert_src,
-                       const std::string& frag_src) {
+                       const std::string& frag_src,
+                       bool retrievable) {
   const char* vert_src_raw = vert_src.c_str();
   const char* frag_src_raw = frag_src.c_str();
 
@@ -124,6 +277,8 @@ GLuint Shader::compile(const std::string& vert_src,
   }
 
   GLuint program = glCreateProgram();
+  if (retrievable)
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glAttachShader(program, vert);
   glAttachShader(program, frag);
   glLinkProgram(program);
@@ -159,5 +314,81 @@ void Shader::check_program_link_success(GLuint program) {
     throw ShaderException(ShaderException::Type::LinkError, buffer);
   }
 }
+void Shader::cache_uniforms() {
+  GLint count = 0;
+  GLint max_length = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+  std::vector<char> buffer(static_cast<std::size_t>(max_length) + 1);
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, static_cast<GLuint>(i),
+                       static_cast<GLsizei>(buffer.size()), &length, &size,
+                       &type, buffer.data());
+    std::string name(buffer.data(), static_cast<std::size_t>(length));
+    // Members of uniform blocks have no location
+    GLint location = glGetUniformLocation(program, name.c_str());
+    if (location < 0)
+      continue;
+    uniforms[name] = location;
+    constexpr std::string_view array_suffix = "[0]";
+    if (name.size() > array_suffix.size() &&
+        name.compare(name.size() - array_suffix.size(), array_suffix.size(),
+                     array_suffix) == 0)
+      uniforms[name.substr(0, name.size() - array_suffix.size())] = location;
+  }
+}
 
+template <>
+void Uniform<bool>::set(const bool& v) const noexcept {
+  glProgramUniform1i(program, location, v);
+}
+template <>
+void Uniform<int>::set(const int& v) const noexcept {
+  glProgramUniform1i(program, location, v);
+}
+template <>
+void Uniform<unsigned>::set(const unsigned& v) const noexcept {
+  glProgramUniform1ui(program, location, v);
+}
+template <>
+void Uniform<float>::set(const float& v) const noexcept {
+  glProgramUniform1f(program, location, v);
+}
+template <>
+void Uniform<glm::vec2>::set(const glm::vec2& v) const noexcept {
+  glProgramUniform2f(program, location, v.x, v.y);
+}
+template <>
+void Uniform<glm::vec3>::set(const glm::vec3& v) const noexcept {
+  glProgramUniform3f(program, location, v.x, v.y, v.z);
+}
+template <>
+void Uniform<glm::vec4>::set(const glm::vec4& v) const noexcept {
+  glProgramUniform4f(program, location, v.x, v.y, v.z, v.w);
+}
+
+UniformBuffer::UniformBuffer(std::size_t buffer_size, GLuint buffer_binding)
+    : size(buffer_size), binding(buffer_binding) {
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+UniformBuffer::~UniformBuffer() {
+  glDeleteBuffers(1, &buffer);
+}
+void UniformBuffer::update(const void* data,
+                           std::size_t data_size,
+                           std::size_t offset) {
+  if (offset + data_size > size)
+    throw ShaderException(ShaderException::Type::InvalidUse,
+                          "Uniform buffer update is out of bounds.");
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset),
+                  static_cast<GLsizeiptr>(data_size), data);
+}
 }  // namespace woop
\ No newline at end of file
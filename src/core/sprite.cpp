@@ -0,0 +1,316 @@
+/**
+ * @file sprite.cpp
+ * @authors quak
+ * @brief Defines members of the Patch and SpriteSet classes.
+ */
+
+#include "sprite.hpp"
+#include "log.hpp"      /* woop::log_warning */
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include <cstring>      /* std::memcpy */
+
+namespace woop {
+/**
+ * @brief Header of a lump in Doom's picture format, followed by one 32-bit
+ * offset per column.
+ */
+struct RawPatchHeader {
+  int16_t width;
+  int16_t height;
+  int16_t left_offset;
+  int16_t top_offset;
+};
+
+/**
+ * @brief Sprites of the things found in Doom and Doom II
+ * (https://doomwiki.org/wiki/Thing_types). Player starts, teleport
+ * destinations and other invisible things are left out.
+ */
+constexpr ThingSprite thing_sprites[] = {
+    // Monsters
+    {7, "SPID", 'A', false},
+    {9, "SPOS", 'A', false},
+    {16, "CYBR", 'A', false},
+    {58, "SARG", 'A', false},
+    {64, "VILE", 'A', false},
+    {65, "CPOS", 'A', false},
+    {66, "SKEL", 'A', false},
+    {67, "FATT", 'A', false},
+    {68, "BSPI", 'A', false},
+    {69, "BOS2", 'A', false},
+    {71, "PAIN", 'A', false},
+    {84, "SSWV", 'A', false},
+    {3001, "TROO", 'A', false},
+    {3002, "SARG", 'A', false},
+    {3003, "BOSS", 'A', false},
+    {3004, "POSS", 'A', false},
+    {3005, "HEAD", 'A', false},
+    {3006, "SKUL", 'A', false},
+    // Weapons
+    {82, "SGN2", 'A', false},
+    {2001, "SHOT", 'A', false},
+    {2002, "MGUN", 'A', false},
+    {2003, "LAUN", 'A', false},
+    {2004, "PLAS", 'A', false},
+    {2005, "CSAW", 'A', false},
+    {2006, "BFUG", 'A', false},
+    // Ammunition
+    {8, "BPAK", 'A', false},
+    {17, "CELP", 'A', false},
+    {2007, "CLIP", 'A', false},
+    {2008, "SHEL", 'A', false},
+    {2010, "ROCK", 'A', false},
+    {2046, "BROK", 'A', false},
+    {2047, "CELL", 'A', false},
+    {2048, "AMMO", 'A', false},
+    {2049, "SBOX", 'A', false},
+    // Health, armor and powerups
+    {83, "MEGA", 'A', false},
+    {2011, "STIM", 'A', false},
+    {2012, "MEDI", 'A', false},
+    {2013, "SOUL", 'A', false},
+    {2014, "BON1", 'A', false},
+    {2015, "BON2", 'A', false},
+    {2018, "ARM1", 'A', false},
+    {2019, "ARM2", 'A', false},
+    {2022, "PINV", 'A', false},
+    {2023, "PSTR", 'A', false},
+    {2024, "PINS", 'A', false},
+    {2025, "SUIT", 'A', false},
+    {2026, "PMAP", 'A', false},
+    {2045, "PVIS", 'A', false},
+    // Keys
+    {5, "BKEY", 'A', false},
+    {6, "YKEY", 'A', false},
+    {13, "RKEY", 'A', false},
+    {38, "RSKU", 'A', false},
+    {39, "YSKU", 'A', false},
+    {40, "BSKU", 'A', false},
+    // Obstacles and decorations
+    {10, "PLAY", 'W', false},
+    {12, "PLAY", 'W', false},
+    {15, "PLAY", 'N', false},
+    {18, "POSS", 'L', false},
+    {19, "SPOS", 'L', false},
+    {20, "TROO", 'M', false},
+    {21, "SARG", 'N', false},
+    {22, "HEAD", 'L', false},
+    {23, "SKUL", 'K', false},
+    {24, "POL5", 'A', false},
+    {25, "POL1", 'A', false},
+    {26, "POL6", 'A', false},
+    {27, "POL4", 'A', false},
+    {28, "POL2", 'A', false},
+    {29, "POL3", 'A', false},
+    {30, "COL1", 'A', false},
+    {31, "COL2", 'A', false},
+    {32, "COL3", 'A', false},
+    {33, "COL4", 'A', false},
+    {34, "CAND", 'A', false},
+    {35, "CBRA", 'A', false},
+    {36, "COL5", 'A', false},
+    {37, "COL6", 'A', false},
+    {41, "CEYE", 'A', false},
+    {42, "FSKU", 'A', false},
+    {43, "TRE1", 'A', false},
+    {44, "TBLU", 'A', false},
+    {45, "TGRN", 'A', false},
+    {46, "TRED", 'A', false},
+    {47, "SMIT", 'A', false},
+    {48, "ELEC", 'A', false},
+    {49, "GOR1", 'A', true},
+    {50, "GOR2", 'A', true},
+    {51, "GOR3", 'A', true},
+    {52, "GOR4", 'A', true},
+    {53, "GOR5", 'A', true},
+    {54, "TRE2", 'A', false},
+    {55, "SMBT", 'A', false},
+    {56, "SMGT", 'A', false},
+    {57, "SMRT", 'A', false},
+    {59, "GOR2", 'A', true},
+    {60, "GOR4", 'A', true},
+    {61, "GOR3", 'A', true},
+    {62, "GOR5", 'A', true},
+    {63, "GOR1", 'A', true},
+    {70, "FCAN", 'A', false},
+    {85, "TLMP", 'A', false},
+    {86, "TLP2", 'A', false},
+    {2028, "COLU", 'A', false},
+    {2035, "BAR1", 'A', false},
+};
+
+/**
+ * @brief Returns true if a lump marks the start of the sprite namespace.
+ */
+bool is_sprite_start(const std::string& name) {
+  return name == "S_START" || name == "SS_START";
+}
+/**
+ * @brief Returns true if a lump marks the end of the sprite namespace.
+ */
+bool is_sprite_end(const std::string& name) {
+  return name == "S_END" || name == "SS_END";
+}
+
+/**
+ * @brief Returns true if a lump name follows the sprite naming convention
+ * (NAMEFR or NAMEFRFR, where F is a frame and R a rotation).
+ */
+bool is_sprite_name(const std::string& name) {
+  auto is_rotation = [](char c) { return c >= '0' && c <= '8'; };
+  if (name.size() != 6 && name.size() != 8)
+    return false;
+  if (!is_rotation(name[5]))
+    return false;
+  return name.size() == 6 || is_rotation(name[7]);
+}
+
+Patch::Patch(const Lump& lump) : name(lump.name) {
+  const std::vector<std::byte>& data = lump.data;
+  if (data.size() < sizeof(RawPatchHeader))
+    throw SpriteException(SpriteException::Type::InvalidPatch,
+                          "Patch " + name + " is too small to hold a header");
+  RawPatchHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  width = header.width;
+  height = header.height;
+  left_offset = header.left_offset;
+  top_offset = header.top_offset;
+  if (width <= 0 || height <= 0)
+    throw SpriteException(SpriteException::Type::InvalidPatch,
+                          "Patch " + name + " has an invalid size");
+
+  std::size_t columns = static_cast<std::size_t>(width);
+  std::size_t rows = static_cast<std::size_t>(height);
+  if (data.size() < sizeof(RawPatchHeader) + columns * sizeof(int32_t))
+    throw SpriteException(SpriteException::Type::InvalidPatch,
+                          "Patch " + name + " is missing column offsets");
+  texels.assign(columns * rows, transparent);
+
+  for (std::size_t x = 0; x < columns; ++x) {
+    int32_t column_offset;
+    std::memcpy(&column_offset,
+                data.data() + sizeof(RawPatchHeader) + x * sizeof(int32_t),
+                sizeof(column_offset));
+    if (column_offset < 0)
+      throw SpriteException(SpriteException::Type::InvalidPatch,
+                            "Patch " + name + " has an invalid column offset");
+
+    // Columns are made up of "posts" (runs of opaque texels):
+    // top (1 byte), length (1 byte), padding, texels, padding
+    std::size_t offset = static_cast<std::size_t>(column_offset);
+    int top = -1;
+    while (true) {
+      if (offset >= data.size())
+        throw SpriteException(SpriteException::Type::InvalidPatch,
+                              "Patch " + name + " has an unterminated column");
+      int top_delta = std::to_integer<int>(data[offset]);
+      if (top_delta == 0xff)
+        break;
+      // Tall patches store the offset from the previous post when a post
+      // starts at or above it (https://doomwiki.org/wiki/Picture_format)
+      top = (top_delta <= top) ? top + top_delta : top_delta;
+
+      if (offset + 2 >= data.size())
+        throw SpriteException(SpriteException::Type::InvalidPatch,
+                              "Patch " + name + " has a truncated post");
+      std::size_t length = std::to_integer<std::size_t>(data[offset + 1]);
+      if (offset + 4 + length > data.size())
+        throw SpriteException(SpriteException::Type::InvalidPatch,
+                              "Patch " + name + " has a truncated post");
+      for (std::size_t i = 0; i < length; ++i) {
+        std::size_t row = static_cast<std::size_t>(top) + i;
+        if (row < rows)
+          texels[x * rows + row] =
+              std::to_integer<int16_t>(data[offset + 3 + i]);
+      }
+      offset += length + 4;
+    }
+  }
+}
+
+SpriteSet::SpriteSet() {}
+SpriteSet::SpriteSet(const Wad& wad) {
+  open(wad);
+}
+
+void SpriteSet::open(const Wad& wad) {
+  WOOP_PROFILE_SCOPE("SpriteSet::open");
+  close();
+
+  // Find all lumps in the sprite namespace
+  std::vector<const Lump*> lumps;
+  bool in_namespace = false;
+  for (const auto& lump : wad) {
+    if (is_sprite_start(lump.name))
+      in_namespace = true;
+    else if (is_sprite_end(lump.name))
+      in_namespace = false;
+    else if (in_namespace && !lump.data.empty()) {
+      if (is_sprite_name(lump.name))
+        lumps.emplace_back(&lump);
+      else
+        log_warning("Skipping sprite with invalid name ", lump.name);
+    }
+  }
+
+  // Frames point to patches, so they can only be added once all patches exist
+  patches.reserve(lumps.size());
+  for (const Lump* lump : lumps)
+    patches.emplace_back(*lump);
+  for (const auto& patch : patches)
+    add_patch(patch);
+}
+void SpriteSet::close() noexcept {
+  frames.clear();
+  patches.clear();
+}
+
+const SpriteFrame* SpriteSet::get_frame(const std::string& sprite,
+                                        char frame) const {
+  auto found = frames.find(sprite + frame);
+  if (found == frames.end())
+    return nullptr;
+  return &found->second;
+}
+const SpriteFrame* SpriteSet::get_frame(const ThingSprite& thing_sprite) const {
+  return get_frame(thing_sprite.sprite, thing_sprite.frame);
+}
+
+const ThingSprite* SpriteSet::get_thing_sprite(int16_t type) noexcept {
+  static const std::unordered_map<int16_t, const ThingSprite*> types = []() {
+    std::unordered_map<int16_t, const ThingSprite*> out;
+    for (const auto& thing_sprite : thing_sprites)
+      out.emplace(thing_sprite.type, &thing_sprite);
+    return out;
+  }();
+  auto found = types.find(type);
+  return (found == types.end()) ? nullptr : found->second;
+}
+
+void SpriteSet::add_patch(const Patch& patch) {
+  const std::string& name = patch.get_name();
+  std::string sprite = name.substr(0, 4);
+
+  // Each lump can hold two frames/rotations, the second one mirrored
+  for (std::size_t i = 4; i + 1 < name.size(); i += 2) {
+    bool flipped = i > 4;
+    SpriteFrame& frame = frames[sprite + name[i]];
+    if (frame.sprite.empty()) {
+      frame.sprite = sprite;
+      frame.patches.fill(nullptr);
+      frame.flipped.fill(false);
+    }
+
+    unsigned rotation = static_cast<unsigned>(name[i + 1] - '0');
+    // Rotation 0 is used for every angle
+    if (rotation == 0) {
+      frame.patches.fill(&patch);
+      frame.flipped.fill(flipped);
+    } else {
+      frame.patches[rotation - 1] = &patch;
+      frame.flipped[rotation - 1] = flipped;
+    }
+  }
+}
+}  // namespace woop
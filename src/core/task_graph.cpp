@@ -0,0 +1,95 @@
+/**
+ * @file task_graph.cpp
+ * @authors quak
+ * @brief Defines members of the TaskGraph class.
+ */
+
+#include "task_graph.hpp"
+#include "thread_pool.hpp"    /* woop::ThreadPool */
+#include <chrono>             /* std::chrono::steady_clock */
+#include <condition_variable> /* std::condition_variable */
+#include <mutex>              /* std::mutex, std::unique_lock */
+#include <utility>            /* std::move */
+
+namespace woop {
+TaskGraph::TaskId TaskGraph::add_task(
+    const char* name,
+    std::function<void()> fn,
+    const std::vector<TaskId>& dependencies) {
+  const TaskId id = tasks.size();
+  for (TaskId dependency : dependencies) {
+    if (dependency >= id)
+      throw TaskGraphException(
+          TaskGraphException::Type::InvalidDependency,
+          "Tasks can only depend on tasks that were added before them");
+  }
+  for (TaskId dependency : dependencies)
+    tasks[dependency].dependents.push_back(id);
+  tasks.push_back(
+      {name, std::move(fn), {}, static_cast<unsigned>(dependencies.size())});
+  return id;
+}
+
+void TaskGraph::run(ThreadPool& pool) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  auto get_ms = [&](Clock::time_point time) {
+    return std::chrono::duration<double, std::milli>(time - start).count();
+  };
+
+  timings.clear();
+  std::vector<unsigned> waiting_on(tasks.size());
+  std::vector<TaskId> ready;
+  for (TaskId id = 0; id < tasks.size(); ++id) {
+    timings.push_back({tasks[id].name, 0.0, 0.0});
+    waiting_on[id] = tasks[id].dependency_count;
+    if (waiting_on[id] == 0)
+      ready.push_back(id);
+  }
+
+  // Each thread takes ready tasks until every task has finished. A thread
+  // only waits while another one is running a task, whose dependents may
+  // become ready.
+  std::mutex mutex;
+  std::condition_variable ready_cv;
+  std::size_t finished = 0;
+  bool failed = false;
+  auto run_tasks = [&](std::size_t) {
+    std::unique_lock lock(mutex);
+    while (true) {
+      ready_cv.wait(lock, [&]() {
+        return !ready.empty() || finished == tasks.size() || failed;
+      });
+      if (ready.empty())
+        return;
+      TaskId id = ready.back();
+      ready.pop_back();
+      lock.unlock();
+
+      Clock::time_point task_start = Clock::now();
+      try {
+        tasks[id].fn();
+      } catch (...) {
+        lock.lock();
+        failed = true;
+        ready.clear();
+        ready_cv.notify_all();
+        throw;
+      }
+      Clock::time_point task_end = Clock::now();
+
+      lock.lock();
+      timings[id].start_ms = get_ms(task_start);
+      timings[id].duration_ms = get_ms(task_end) - timings[id].start_ms;
+      ++finished;
+      // Once a task has failed, nothing new is started
+      for (TaskId dependent : tasks[id].dependents) {
+        if (--waiting_on[dependent] == 0 && !failed)
+          ready.push_back(dependent);
+      }
+      ready_cv.notify_all();
+    }
+  };
+  pool.parallel_for(pool.get_worker_count() + 1u, run_tasks);
+}
+}  // namespace woop
@@ -0,0 +1,230 @@
+/**
+ * @file text_overlay.cpp
+ * @authors quak
+ * @brief Defines members of the TextOverlay class.
+ */
+
+#include "text_overlay.hpp"
+#include "renderer.hpp" /* woop::Renderer */
+#include <algorithm>    /* std::max, std::fill */
+#include <cctype>       /* std::toupper */
+
+namespace woop {
+/**
+ * @brief A 3x5 glyph. Each row is stored in the lowest three bits of a byte,
+ * with the leftmost pixel in the highest bit.
+ */
+struct Glyph {
+  char character;
+  uint8_t rows[5];
+};
+
+// Size of a glyph, including one pixel of spacing on its right and bottom
+constexpr unsigned glyph_width = 4;
+constexpr unsigned glyph_height = 6;
+
+// clang-format off
+constexpr Glyph font[] = {
+    {'0', {0b111, 0b101, 0b101, 0b101, 0b111}},
+    {'1', {0b010, 0b110, 0b010, 0b010, 0b111}},
+    {'2', {0b111, 0b001, 0b111, 0b100, 0b111}},
+    {'3', {0b111, 0b001, 0b111, 0b001, 0b111}},
+    {'4', {0b101, 0b101, 0b111, 0b001, 0b001}},
+    {'5', {0b111, 0b100, 0b111, 0b001, 0b111}},
+    {'6', {0b111, 0b100, 0b111, 0b101, 0b111}},
+    {'7', {0b111, 0b001, 0b001, 0b001, 0b001}},
+    {'8', {0b111, 0b101, 0b111, 0b101, 0b111}},
+    {'9', {0b111, 0b101, 0b111, 0b001, 0b111}},
+    {'A', {0b010, 0b101, 0b111, 0b101, 0b101}},
+    {'B', {0b110, 0b101, 0b110, 0b101, 0b110}},
+    {'C', {0b011, 0b100, 0b100, 0b100, 0b011}},
+    {'D', {0b110, 0b101, 0b101, 0b101, 0b110}},
+    {'E', {0b111, 0b100, 0b110, 0b100, 0b111}},
+    {'F', {0b111, 0b100, 0b110, 0b100, 0b100}},
+    {'G', {0b011, 0b100, 0b101, 0b101, 0b011}},
+    {'H', {0b101, 0b101, 0b111, 0b101, 0b101}},
+    {'I', {0b111, 0b010, 0b010, 0b010, 0b111}},
+    {'J', {0b001, 0b001, 0b001, 0b101, 0b010}},
+    {'K', {0b101, 0b101, 0b110, 0b101, 0b101}},
+    {'L', {0b100, 0b100, 0b100, 0b100, 0b111}},
+    {'M', {0b101, 0b111, 0b111, 0b101, 0b101}},
+    {'N', {0b110, 0b101, 0b101, 0b101, 0b101}},
+    {'O', {0b010, 0b101, 0b101, 0b101, 0b010}},
+    {'P', {0b110, 0b101, 0b110, 0b100, 0b100}},
+    {'Q', {0b010, 0b101, 0b101, 0b110, 0b011}},
+    {'R', {0b110, 0b101, 0b110, 0b101, 0b101}},
+    {'S', {0b011, 0b100, 0b010, 0b001, 0b110}},
+    {'T', {0b111, 0b010, 0b010, 0b010, 0b010}},
+    {'U', {0b101, 0b101, 0b101, 0b101, 0b111}},
+    {'V', {0b101, 0b101, 0b101, 0b101, 0b010}},
+    {'W', {0b101, 0b101, 0b111, 0b111, 0b101}},
+    {'X', {0b101, 0b101, 0b010, 0b101, 0b101}},
+    {'Y', {0b101, 0b101, 0b010, 0b010, 0b010}},
+    {'Z', {0b111, 0b001, 0b010, 0b100, 0b111}},
+    {'.', {0b000, 0b000, 0b000, 0b000, 0b010}},
+    {':', {0b000, 0b010, 0b000, 0b010, 0b000}},
+    {'/', {0b001, 0b001, 0b010, 0b100, 0b100}},
+    {'%', {0b101, 0b001, 0b010, 0b100, 0b101}},
+    {'-', {0b000, 0b000, 0b111, 0b000, 0b000}},
+};
+// clang-format on
+
+constexpr const char* overlay_vert_src = R"(
+#version 430 core
+layout(location = 0) in vec2 a_pos;
+
+out vec2 uv;
+
+// Bottom left corner (xy) and size (zw) of the overlay in clip space
+uniform vec4 u_rect;
+
+void main() {
+  gl_Position = vec4(u_rect.xy + a_pos * u_rect.zw, 0.0f, 1.0f);
+  // The first row of text is stored at the start of the texture
+  uv = vec2(a_pos.x, 1.0f - a_pos.y);
+}
+)";
+
+constexpr const char* overlay_frag_src = R"(
+#version 430 core
+out vec4 f_color;
+
+in vec2 uv;
+
+uniform sampler2D u_texture;
+
+const vec4 background = vec4(0.0f, 0.0f, 0.0f, 0.6f);
+const vec4 foreground = vec4(1.0f, 1.0f, 0.6f, 1.0f);
+
+void main() {
+  f_color = mix(background, foreground, texture(u_texture, uv).r);
+}
+)";
+
+TextOverlay::TextOverlay(const Renderer& rndr)
+    : renderer(rndr),
+      shader(overlay_vert_src, overlay_frag_src),
+      size(0, 0) {
+  gen_texture();
+  gen_quad();
+}
+TextOverlay::~TextOverlay() {
+  glDeleteBuffers(1, &vbo);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteTextures(1, &texture);
+}
+
+void TextOverlay::set_text(const std::string& new_text) {
+  if (new_text == text)
+    return;
+  text = new_text;
+  update_texture();
+}
+
+void TextOverlay::draw() const noexcept {
+  if (text.empty())
+    return;
+  // Text is drawn in image pixels (scaled up for large resolutions), with a
+  // one pixel margin from the corner of the screen.
+  glm::vec2 img_size = renderer.get_img_size();
+  float scale = std::max(1.0f, img_size.y / 200.0f);
+  glm::vec2 rect_size = 2.0f * scale * glm::vec2(size) / img_size;
+  glm::vec2 margin = 2.0f * scale / img_size;
+  glm::vec4 rect = {
+      -1.0f + margin.x,
+      1.0f - margin.y - rect_size.y,
+      rect_size.x,
+      rect_size.y,
+  };
+
+  shader.use();
+  shader.set_uniform("u_texture",
+                     static_cast<int>(renderer.get_texture_unit()));
+  shader.set_uniform("u_rect", rect);
+  glActiveTexture(GL_TEXTURE0 + renderer.get_texture_unit());
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glBindVertexArray(vao);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  glDisable(GL_BLEND);
+}
+
+void TextOverlay::gen_texture() {
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+void TextOverlay::gen_quad() {
+  constexpr glm::vec2 vertices[] = {
+      {0.0f, 0.0f},
+      {1.0f, 0.0f},
+      {1.0f, 1.0f},
+      {0.0f, 1.0f},
+  };
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
+}
+
+void TextOverlay::update_texture() {
+  // Measure text
+  unsigned columns = 0;
+  unsigned lines = 1;
+  unsigned line_length = 0;
+  for (char c : text) {
+    if (c == '\n') {
+      ++lines;
+      line_length = 0;
+    } else
+      columns = std::max(columns, ++line_length);
+  }
+  size = {columns * glyph_width + 1, lines * glyph_height + 1};
+
+  // Rasterize text
+  pixels.assign(size.x * size.y, 0);
+  unsigned x = 1;
+  unsigned y = 1;
+  for (char c : text) {
+    if (c == '\n') {
+      x = 1;
+      y += glyph_height;
+      continue;
+    }
+    draw_glyph(c, x, y);
+    x += glyph_width;
+  }
+
+  // The renderer leaves its PBO bound, which would be used as the source of
+  // the upload instead of our pixels.
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, static_cast<GLsizei>(size.x),
+               static_cast<GLsizei>(size.y), 0, GL_RED, GL_UNSIGNED_BYTE,
+               pixels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextOverlay::draw_glyph(char c, unsigned x, unsigned y) {
+  char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  for (const auto& glyph : font) {
+    if (glyph.character != upper)
+      continue;
+    for (unsigned row = 0; row < 5; ++row) {
+      for (unsigned col = 0; col < 3; ++col) {
+        if (glyph.rows[row] & (0b100 >> col))
+          pixels[(y + row) * size.x + x + col] = 255;
+      }
+    }
+    return;
+  }
+}
+}  // namespace woop
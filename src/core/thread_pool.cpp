@@ -0,0 +1,102 @@
+/**
+ * @file thread_pool.cpp
+ * @authors quak
+ * @brief Defines members of the ThreadPool class.
+ */
+
+#include "thread_pool.hpp"
+
+namespace woop {
+ThreadPool::ThreadPool(unsigned worker_count)
+    : job(nullptr),
+      job_fn(nullptr),
+      job_count(0),
+      next_job(0),
+      generation(0),
+      active_workers(0),
+      busy(false),
+      stopping(false) {
+  workers.reserve(worker_count);
+  for (unsigned i = 0; i < worker_count; ++i)
+    workers.emplace_back(&ThreadPool::work, this);
+}
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  start_cv.notify_all();
+  for (auto& worker : workers)
+    worker.join();
+}
+
+unsigned ThreadPool::get_default_worker_count() noexcept {
+  unsigned threads = std::thread::hardware_concurrency();
+  return threads > 1 ? threads - 1 : 0;
+}
+
+void ThreadPool::run(std::size_t count, Job new_job, const void* fn) {
+  if (count == 0)
+    return;
+  // Serial fallback: no workers, a single job, or a loop inside a loop
+  bool serial = workers.empty() || count == 1;
+  if (serial || busy.exchange(true)) {
+    for (std::size_t i = 0; i < count; ++i)
+      new_job(fn, i);
+    return;
+  }
+
+  {
+    std::lock_guard lock(mutex);
+    job = new_job;
+    job_fn = fn;
+    job_count = count;
+    next_job = 0;
+    exception = nullptr;
+    active_workers = static_cast<unsigned>(workers.size());
+    ++generation;
+  }
+  start_cv.notify_all();
+  run_jobs();
+
+  std::unique_lock lock(mutex);
+  done_cv.wait(lock, [this]() { return active_workers == 0; });
+  std::exception_ptr thrown = exception;
+  exception = nullptr;
+  busy = false;
+  lock.unlock();
+  if (thrown)
+    std::rethrow_exception(thrown);
+}
+void ThreadPool::work() {
+  unsigned long last_generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      start_cv.wait(lock, [&]() {
+        return stopping || generation != last_generation;
+      });
+      if (stopping)
+        return;
+      last_generation = generation;
+    }
+    run_jobs();
+    {
+      std::lock_guard lock(mutex);
+      --active_workers;
+    }
+    done_cv.notify_one();
+  }
+}
+void ThreadPool::run_jobs() noexcept {
+  for (std::size_t i = next_job++; i < job_count; i = next_job++) {
+    try {
+      job(job_fn, i);
+    } catch (...) {
+      std::lock_guard lock(mutex);
+      if (!exception)
+        exception = std::current_exception();
+    }
+  }
+}
+}  // namespace woop
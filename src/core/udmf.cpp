@@ -0,0 +1,496 @@
+/**
+ * @file udmf.cpp
+ * @authors quak
+ * @brief Defines the UdmfTokenizer class and parse_udmf().
+ */
+
+#include "udmf.hpp"
+#include "level.hpp"    /* woop::LevelException */
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include <cmath>        /* std::pow */
+#include <string>       /* std::string, std::to_string */
+
+namespace woop {
+namespace {
+// Vanilla thing flags (https://doomwiki.org/wiki/Thing#Flags)
+constexpr int16_t thing_easy = 0x0001;
+constexpr int16_t thing_medium = 0x0002;
+constexpr int16_t thing_hard = 0x0004;
+constexpr int16_t thing_ambush = 0x0008;
+constexpr int16_t thing_multiplayer = 0x0010;
+
+/**
+ * @brief A UDMF boolean field, and the binary flag it sets.
+ */
+struct FlagField {
+  std::string_view key;
+  int16_t flag;
+};
+const FlagField thing_flags[] = {
+    {"skill1", thing_easy},   {"skill2", thing_easy},
+    {"skill3", thing_medium}, {"skill4", thing_hard},
+    {"skill5", thing_hard},   {"ambush", thing_ambush},
+};
+// https://doomwiki.org/wiki/Linedef#Linedef_flags
+const FlagField linedef_flags[] = {
+    {"blocking", 0x0001},      {"blockmonsters", 0x0002},
+    {"twosided", 0x0004},      {"dontpegtop", 0x0008},
+    {"dontpegbottom", 0x0010}, {"secret", 0x0020},
+    {"blocksound", 0x0040},    {"dontdraw", 0x0080},
+    {"mapped", 0x0100},
+};
+
+bool is_digit(char c) noexcept {
+  return c >= '0' && c <= '9';
+}
+bool is_identifier_start(char c) noexcept {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+char to_lower(char c) noexcept {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+/**
+ * @brief Compares an identifier to a lowercase key, ignoring case.
+ */
+bool is_key(std::string_view identifier, std::string_view key) noexcept {
+  if (identifier.size() != key.size())
+    return false;
+  for (std::size_t i = 0; i < key.size(); ++i) {
+    if (to_lower(identifier[i]) != key[i])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads UDMF blocks into a map.
+ */
+class Parser {
+ public:
+  explicit Parser(std::string_view text) : tokenizer(text) { advance(); }
+
+  UdmfMap parse() {
+    UdmfMap map;
+    while (token.type != UdmfToken::Type::End) {
+      std::string_view name = expect_identifier();
+      if (is_symbol('=')) {
+        // Global fields
+        advance();
+        UdmfToken value = read_value();
+        if (is_key(name, "namespace"))
+          map.name_space = get_string(value);
+        continue;
+      }
+      if (is_key(name, "thing"))
+        map.things.push_back(read_thing());
+      else if (is_key(name, "vertex"))
+        map.vertices.push_back(read_vertex());
+      else if (is_key(name, "linedef"))
+        map.linedefs.push_back(read_linedef());
+      else if (is_key(name, "sidedef"))
+        map.sidedefs.push_back(read_sidedef());
+      else if (is_key(name, "sector"))
+        map.sectors.push_back(read_sector());
+      else
+        read_block([](std::string_view, const UdmfToken&) {});
+    }
+    return map;
+  }
+
+ private:
+  void advance() { token = tokenizer.next(); }
+  [[noreturn]] void fail(const std::string& message, unsigned line) const {
+    throw LevelException(
+        LevelException::Type::InvalidData,
+        "TEXTMAP line " + std::to_string(line) + ": " + message);
+  }
+
+  bool is_symbol(char symbol) const noexcept {
+    return token.type == UdmfToken::Type::Symbol && token.text[0] == symbol;
+  }
+  void expect_symbol(char symbol) {
+    if (!is_symbol(symbol))
+      fail(std::string("Expected '") + symbol + "'", token.line);
+    advance();
+  }
+  std::string_view expect_identifier() {
+    if (token.type != UdmfToken::Type::Identifier)
+      fail("Expected an identifier", token.line);
+    std::string_view text = token.text;
+    advance();
+    return text;
+  }
+  /**
+   * @brief Reads the value of a field and the semicolon after it.
+   */
+  UdmfToken read_value() {
+    UdmfToken value = token;
+    if (value.type == UdmfToken::Type::End ||
+        value.type == UdmfToken::Type::Symbol)
+      fail("Expected a value", value.line);
+    advance();
+    expect_symbol(';');
+    return value;
+  }
+  /**
+   * @brief Reads a block's fields, passing each one's key and value to a
+   * function.
+   */
+  template <typename Fn>
+  void read_block(Fn&& read_field) {
+    expect_symbol('{');
+    while (!is_symbol('}')) {
+      std::string_view key = expect_identifier();
+      expect_symbol('=');
+      read_field(key, read_value());
+    }
+    advance();
+  }
+
+  int64_t get_integer(const UdmfToken& value) const {
+    if (value.type != UdmfToken::Type::Integer)
+      fail("Expected an integer", value.line);
+    std::string_view text = value.text;
+    bool negative = text[0] == '-';
+    if (text[0] == '-' || text[0] == '+')
+      text.remove_prefix(1);
+    // Integers are decimal, octal (with a leading 0), or hexadecimal
+    int64_t base = 10;
+    if (text.size() > 2 && text[0] == '0' &&
+        (text[1] == 'x' || text[1] == 'X')) {
+      base = 16;
+      text.remove_prefix(2);
+    } else if (text.size() > 1 && text[0] == '0') {
+      base = 8;
+    }
+    if (text.empty())
+      fail("Invalid integer", value.line);
+    int64_t result = 0;
+    for (char c : text) {
+      int64_t digit = is_digit(c) ? c - '0' : to_lower(c) - 'a' + 10;
+      if (digit < 0 || digit >= base)
+        fail("Invalid integer", value.line);
+      result = result * base + digit;
+      if (result > 0xffffffffll)
+        fail("Integer is out of range", value.line);
+    }
+    return negative ? -result : result;
+  }
+  double get_number(const UdmfToken& value) const {
+    if (value.type == UdmfToken::Type::Integer)
+      return static_cast<double>(get_integer(value));
+    if (value.type != UdmfToken::Type::Float)
+      fail("Expected a number", value.line);
+    std::string_view text = value.text;
+    std::size_t i = 0;
+    double sign = 1.0;
+    if (text[i] == '-' || text[i] == '+')
+      sign = (text[i++] == '-') ? -1.0 : 1.0;
+    auto is_digit_at = [&](std::size_t j) {
+      return j < text.size() && is_digit(text[j]);
+    };
+    double mantissa = 0.0;
+    int exponent = 0;
+    bool has_digits = is_digit_at(i) || is_digit_at(i + 1);
+    for (; is_digit_at(i); ++i)
+      mantissa = mantissa * 10.0 + (text[i] - '0');
+    if (i < text.size() && text[i] == '.') {
+      for (++i; is_digit_at(i); ++i) {
+        mantissa = mantissa * 10.0 + (text[i] - '0');
+        --exponent;
+      }
+    }
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+      ++i;
+      int exponent_sign = 1;
+      if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+        exponent_sign = (text[i++] == '-') ? -1 : 1;
+      has_digits = has_digits && is_digit_at(i);
+      int written = 0;
+      for (; is_digit_at(i) && written < 1000; ++i)
+        written = written * 10 + (text[i] - '0');
+      exponent += exponent_sign * written;
+    }
+    if (!has_digits || i != text.size())
+      fail("Invalid number", value.line);
+    return sign * mantissa * std::pow(10.0, exponent);
+  }
+  bool get_bool(const UdmfToken& value) const {
+    if (value.type == UdmfToken::Type::Identifier) {
+      if (is_key(value.text, "true"))
+        return true;
+      if (is_key(value.text, "false"))
+        return false;
+    }
+    fail("Expected true or false", value.line);
+  }
+  std::string_view get_string(const UdmfToken& value) const {
+    if (value.type != UdmfToken::Type::String)
+      fail("Expected a string", value.line);
+    return value.text;
+  }
+  int16_t get_int16(const UdmfToken& value) const {
+    int64_t integer = get_integer(value);
+    if (integer < INT16_MIN || integer > INT16_MAX)
+      fail("Integer is out of range", value.line);
+    return static_cast<int16_t>(integer);
+  }
+  uint32_t get_index(const UdmfToken& value) const {
+    int64_t integer = get_integer(value);
+    if (integer < 0)
+      fail("Index must not be negative", value.line);
+    return static_cast<uint32_t>(integer);
+  }
+  /**
+   * @brief Sets or clears a flag if a key names a flag field. Returns false if
+   * it doesn't.
+   */
+  template <std::size_t Size>
+  bool read_flag(const FlagField (&fields)[Size],
+                 std::string_view key,
+                 const UdmfToken& value,
+                 int16_t& flags) const {
+    for (const FlagField& field : fields) {
+      if (is_key(key, field.key)) {
+        if (get_bool(value))
+          flags = static_cast<int16_t>(flags | field.flag);
+        return true;
+      }
+    }
+    return false;
+  }
+  void require(bool found, const char* block, unsigned line) const {
+    if (!found)
+      fail(std::string(block) + " is missing a required field", line);
+  }
+
+  UdmfMap::Thing read_thing() {
+    unsigned line = token.line;
+    UdmfMap::Thing thing{{0.0f, 0.0f}, 0, 0, 0};
+    bool single = false;
+    bool has_x = false, has_y = false, has_type = false;
+    read_block([&](std::string_view key, const UdmfToken& value) {
+      if (is_key(key, "x")) {
+        thing.position.x = static_cast<float>(get_number(value));
+        has_x = true;
+      } else if (is_key(key, "y")) {
+        thing.position.y = static_cast<float>(get_number(value));
+        has_y = true;
+      } else if (is_key(key, "angle")) {
+        thing.angle = get_int16(value);
+      } else if (is_key(key, "type")) {
+        thing.type = get_int16(value);
+        has_type = true;
+      } else if (is_key(key, "single")) {
+        single = get_bool(value);
+      } else {
+        read_flag(thing_flags, key, value, thing.flags);
+      }
+    });
+    require(has_x && has_y && has_type, "Thing", line);
+    if (!single)
+      thing.flags = static_cast<int16_t>(thing.flags | thing_multiplayer);
+    return thing;
+  }
+  glm::vec2 read_vertex() {
+    unsigned line = token.line;
+    glm::vec2 vertex(0.0f);
+    bool has_x = false, has_y = false;
+    read_block([&](std::string_view key, const UdmfToken& value) {
+      if (is_key(key, "x")) {
+        vertex.x = static_cast<float>(get_number(value));
+        has_x = true;
+      } else if (is_key(key, "y")) {
+        vertex.y = static_cast<float>(get_number(value));
+        has_y = true;
+      }
+    });
+    require(has_x && has_y, "Vertex", line);
+    return vertex;
+  }
+  UdmfMap::Linedef read_linedef() {
+    unsigned line = token.line;
+    UdmfMap::Linedef linedef{0, 0, 0, -1, -1};
+    bool has_start = false, has_end = false;
+    read_block([&](std::string_view key, const UdmfToken& value) {
+      if (is_key(key, "v1")) {
+        linedef.start_vertex = get_index(value);
+        has_start = true;
+      } else if (is_key(key, "v2")) {
+        linedef.end_vertex = get_index(value);
+        has_end = true;
+      } else if (is_key(key, "sidefront")) {
+        linedef.front_sidedef = static_cast<int32_t>(get_index(value));
+      } else if (is_key(key, "sideback")) {
+        // -1 is the default, meaning no back side
+        int64_t index = get_integer(value);
+        linedef.back_sidedef = (index < 0) ? -1 : static_cast<int32_t>(index);
+      } else {
+        read_flag(linedef_flags, key, value, linedef.flags);
+      }
+    });
+    require(has_start && has_end && linedef.front_sidedef >= 0, "Linedef",
+            line);
+    return linedef;
+  }
+  UdmfMap::Sidedef read_sidedef() {
+    unsigned line = token.line;
+    UdmfMap::Sidedef sidedef{{0.0f, 0.0f}, "-", "-", "-", 0};
+    bool has_sector = false;
+    read_block([&](std::string_view key, const UdmfToken& value) {
+      if (is_key(key, "offsetx")) {
+        sidedef.offset.x = static_cast<float>(get_number(value));
+      } else if (is_key(key, "offsety")) {
+        sidedef.offset.y = static_cast<float>(get_number(value));
+      } else if (is_key(key, "texturetop")) {
+        sidedef.upper_name = get_string(value);
+      } else if (is_key(key, "texturebottom")) {
+        sidedef.lower_name = get_string(value);
+      } else if (is_key(key, "texturemiddle")) {
+        sidedef.middle_name = get_string(value);
+      } else if (is_key(key, "sector")) {
+        sidedef.sector = get_index(value);
+        has_sector = true;
+      }
+    });
+    require(has_sector, "Sidedef", line);
+    return sidedef;
+  }
+  UdmfMap::Sector read_sector() {
+    unsigned line = token.line;
+    UdmfMap::Sector sector{0, 0, {}, {}, 160};
+    bool has_floor = false, has_ceiling = false;
+    read_block([&](std::string_view key, const UdmfToken& value) {
+      if (is_key(key, "heightfloor")) {
+        sector.floor_height = get_int16(value);
+      } else if (is_key(key, "heightceiling")) {
+        sector.ceiling_height = get_int16(value);
+      } else if (is_key(key, "texturefloor")) {
+        sector.floor_texture = get_string(value);
+        has_floor = true;
+      } else if (is_key(key, "textureceiling")) {
+        sector.ceiling_texture = get_string(value);
+        has_ceiling = true;
+      } else if (is_key(key, "lightlevel")) {
+        sector.light_level = get_int16(value);
+      }
+    });
+    require(has_floor && has_ceiling, "Sector", line);
+    return sector;
+  }
+
+  UdmfTokenizer tokenizer;
+  UdmfToken token;
+};
+}  // namespace
+
+UdmfTokenizer::UdmfTokenizer(std::string_view txt) noexcept
+    : text(txt), position(0), line(1) {}
+
+UdmfToken UdmfTokenizer::next() {
+  skip_whitespace();
+  UdmfToken token;
+  token.line = line;
+  if (position >= text.size())
+    return token;
+
+  auto fail = [&](const char* message) {
+    throw LevelException(
+        LevelException::Type::InvalidData,
+        "TEXTMAP line " + std::to_string(line) + ": " + message);
+  };
+  auto is_at = [&](auto predicate) {
+    return position < text.size() && predicate(text[position]);
+  };
+  const std::size_t start = position;
+  const char c = text[position];
+  if (is_identifier_start(c)) {
+    token.type = UdmfToken::Type::Identifier;
+    ++position;
+    while (is_at([](char c) { return is_identifier_start(c) || is_digit(c); }))
+      ++position;
+  } else if (is_digit(c) || c == '-' || c == '+' || c == '.') {
+    // Numbers are scanned loosely (e.g. "0x1F" or "-1.5e3"), and their digits
+    // are checked when their value is read
+    token.type = UdmfToken::Type::Integer;
+    if (c == '-' || c == '+')
+      ++position;
+    const bool hex = text.compare(position, 2, "0x") == 0 ||
+                     text.compare(position, 2, "0X") == 0;
+    if (hex)
+      position += 2;
+    while (is_at([](char c) {
+      return is_digit(c) || is_identifier_start(c) || c == '.';
+    })) {
+      char digit = text[position++];
+      if (hex)
+        continue;
+      if (digit == '.')
+        token.type = UdmfToken::Type::Float;
+      if (digit == 'e' || digit == 'E') {
+        token.type = UdmfToken::Type::Float;
+        if (is_at([](char c) { return c == '-' || c == '+'; }))
+          ++position;
+      }
+    }
+    if (position - start == 1 && !is_digit(c))
+      fail("Unexpected character");
+  } else if (c == '"') {
+    token.type = UdmfToken::Type::String;
+    ++position;
+    while (is_at([](char c) { return c != '"'; })) {
+      if (text[position] == '\\')
+        ++position;
+      else if (text[position] == '\n')
+        ++line;
+      ++position;
+    }
+    if (position >= text.size())
+      fail("Unterminated string");
+    token.text = text.substr(start + 1, position - start - 1);
+    ++position;
+    return token;
+  } else if (c == '{' || c == '}' || c == '=' || c == ';') {
+    token.type = UdmfToken::Type::Symbol;
+    ++position;
+  } else {
+    fail("Unexpected character");
+  }
+  token.text = text.substr(start, position - start);
+  return token;
+}
+
+void UdmfTokenizer::skip_whitespace() {
+  while (position < text.size()) {
+    char c = text[position];
+    if (c == '\n') {
+      ++line;
+      ++position;
+    } else if (c == ' ' || c == '\t' || c == '\r') {
+      ++position;
+    } else if (text.compare(position, 2, "//") == 0) {
+      position = text.find('\n', position);
+      if (position == std::string_view::npos)
+        position = text.size();
+    } else if (text.compare(position, 2, "/*") == 0) {
+      std::size_t end = text.find("*/", position + 2);
+      if (end == std::string_view::npos)
+        throw LevelException(
+            LevelException::Type::InvalidData,
+            "TEXTMAP line " + std::to_string(line) + ": Unterminated comment");
+      for (; position < end; ++position) {
+        if (text[position] == '\n')
+          ++line;
+      }
+      position = end + 2;
+    } else {
+      return;
+    }
+  }
+}
+
+UdmfMap parse_udmf(std::string_view text) {
+  WOOP_PROFILE_SCOPE("parse_udmf");
+  return Parser(text).parse();
+}
+}  // namespace woop
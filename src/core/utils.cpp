@@ -0,0 +1,33 @@
+/**
+ * @file utils.cpp
+ * @authors quak
+ * @brief Defines the utilities in utils.hpp that aren't constexpr.
+ */
+
+#include "utils.hpp"
+#include <fstream>      /* std::ofstream */
+#include <system_error> /* std::error_code */
+
+bool write_file_atomically(
+    const std::filesystem::path& path,
+    std::initializer_list<std::string_view> parts) noexcept {
+  try {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      if (!file.is_open())
+        return false;
+      for (std::string_view part : parts)
+        file.write(part.data(), static_cast<std::streamsize>(part.size()));
+      if (!file)
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    return !error;
+  } catch (...) {
+    // Paths allocate, which is the only thing that can throw
+    return false;
+  }
+}
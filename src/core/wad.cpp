@@ -5,28 +5,37 @@
  */
 
 #include "wad.hpp"
-#include <fstream> /* std::ifstream */
+#include "profiler.hpp" /* WOOP_PROFILE_SCOPE */
+#include <fstream>      /* std::ifstream */
 
 namespace woop {
-Wad::Wad() : type(WadType::Unloaded) {}
+Wad::Wad() : file_loaded(false), type(WadType::Unloaded) {}
 Wad::Wad(const std::filesystem::path& path) {
   open(path);
 }
+Wad::Wad(std::istream& stream) {
+  open(stream);
+}
 
 void Wad::open(const std::filesystem::path& path) {
-  // Release all data from previous openings
-  close();
   // Open file
   std::ifstream file(path, std::ifstream::binary);
   if (!file.is_open()) {
+    close();
     throw WadException(WadException::Type::FileNotFound,
                        "Could not find wad at path " + path.string());
   }
+  open(file);
+}
+void Wad::open(std::istream& stream) {
+  WOOP_PROFILE_SCOPE("Wad::open");
+  // Release all data from previous openings
+  close();
   // Load data
-  WadHeader header = parse_header(file);
+  WadHeader header = parse_header(stream);
   get_wad_type(header);
-  std::vector<WadEntry> directory = parse_directory(file, header);
-  get_lumps_from_directory(file, directory);
+  std::vector<WadEntry> directory = parse_directory(stream, header);
+  get_lumps_from_directory(stream, directory);
   file_loaded = true;
 }
 
@@ -36,7 +45,7 @@ void Wad::close() noexcept {
   lumps.clear();
 }
 
-WadHeader Wad::parse_header(std::ifstream& file) {
+WadHeader Wad::parse_header(std::istream& file) {
   WadHeader out;
   file.seekg(offsetof(WadHeader, type));
   file.read(out.type, sizeof(out.type));
@@ -58,7 +67,7 @@ void Wad::get_wad_type(const WadHeader& header) {
                        "Unknown wad type " + type_str);
 }
 
-std::vector<WadEntry> Wad::parse_directory(std::ifstream& file,
+std::vector<WadEntry> Wad::parse_directory(std::istream& file,
                                            const WadHeader& header) {
   if (header.num_lumps < 0)
     throw WadException(WadException::Type::InvalidHeader,
@@ -93,7 +102,7 @@ std::vector<WadEntry> Wad::parse_directory(std::ifstream& file,
   return directory;
 }
 
-void Wad::get_lumps_from_directory(std::ifstream& file,
+void Wad::get_lumps_from_directory(std::istream& file,
                                    const std::vector<WadEntry>& directory) {
   for (const auto& entry : directory) {
     Lump lump = get_lump_from_entry(file, entry);
@@ -102,7 +111,7 @@ void Wad::get_lumps_from_directory(std::ifstream& file,
   }
 }
 
-Lump Wad::get_lump_from_entry(std::ifstream& file, const WadEntry& entry) {
+Lump Wad::get_lump_from_entry(std::istream& file, const WadEntry& entry) {
   if (entry.offset < 0)
     throw WadException(WadException::Type::InvalidDirectory,
                        "Lump offset is negative");
@@ -0,0 +1,77 @@
+/**
+ * @file wad_builder.cpp
+ * @authors quak
+ * @brief Defines members of the WadBuilder class.
+ */
+
+#include "wad_builder.hpp"
+#include <fstream> /* std::ofstream */
+#include <limits>  /* std::numeric_limits */
+#include <sstream> /* std::stringstream */
+
+namespace woop {
+WadBuilder::WadBuilder(WadType wad_type) : type(wad_type) {
+  if (type == WadType::Unloaded)
+    throw WadException(WadException::Type::InvalidHeader,
+                       "Can't build a wad without a type");
+}
+
+WadBuilder& WadBuilder::add_lump(const std::string& name,
+                                 std::vector<std::byte> data) {
+  if (name.empty() || name.size() > sizeof(WadEntry::name))
+    throw WadException(WadException::Type::InvalidDirectory,
+                       "Lump names must be between 1 and 8 characters");
+  if (data.size() >
+      static_cast<std::size_t>(std::numeric_limits<int32_t>::max()))
+    throw WadException(WadException::Type::InvalidDirectory,
+                       "Lump " + name + " is too large to be stored in a wad");
+  lumps.emplace_back(Lump{name, std::move(data)});
+  return *this;
+}
+
+void WadBuilder::write(std::ostream& stream) const {
+  // Lumps are stored directly after the header, followed by the directory
+  std::vector<WadEntry> directory;
+  directory.reserve(lumps.size());
+  std::size_t offset = sizeof(WadHeader);
+  for (const auto& lump : lumps) {
+    WadEntry entry{};
+    entry.offset = static_cast<int32_t>(offset);
+    entry.size = static_cast<int32_t>(lump.data.size());
+    std::memcpy(entry.name, lump.name.data(), lump.name.size());
+    directory.emplace_back(entry);
+    offset += lump.data.size();
+  }
+  if (offset > static_cast<std::size_t>(std::numeric_limits<int32_t>::max()))
+    throw WadException(WadException::Type::InvalidDirectory,
+                       "Wad is too large to be addressed by its directory");
+
+  WadHeader header{};
+  std::memcpy(header.type, (type == WadType::Internal) ? "IWAD" : "PWAD",
+              sizeof(header.type));
+  header.num_lumps = static_cast<int32_t>(lumps.size());
+  header.dir_offset = static_cast<int32_t>(offset);
+
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& lump : lumps) {
+    stream.write(reinterpret_cast<const char*>(lump.data.data()),
+                 static_cast<std::streamsize>(lump.data.size()));
+  }
+  stream.write(reinterpret_cast<const char*>(directory.data()),
+               static_cast<std::streamsize>(directory.size() *
+                                            sizeof(WadEntry)));
+}
+void WadBuilder::write(const std::filesystem::path& path) const {
+  std::ofstream file(path, std::ofstream::binary);
+  if (!file.is_open())
+    throw WadException(WadException::Type::FileNotFound,
+                       "Could not create wad at path " + path.string());
+  write(file);
+}
+
+Wad WadBuilder::build() const {
+  std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+  write(stream);
+  return Wad{stream};
+}
+}  // namespace woop
@@ -7,16 +7,19 @@
 #include "window.hpp"
 #include "GLFW/glfw3.h"
 #include "log.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
 
 namespace woop {
-Window::Window(const WindowConfig& cfg) : config(cfg) {
+Window::Window(const WindowConfig& cfg)
+    : config(cfg), limiter(cfg.max_fps) {
   if (num_windows <= 0)
     init_glfw();
   init_window();
   if (!glad_initialized)
     init_glad();
   set_callbacks();
+  set_vsync(config.vsync);
   ++num_windows;
 
   // Set viewport size
@@ -50,6 +53,30 @@ float Window::get_aspect_ratio() const {
                           "Window has no vertical size (is it minimized?)");
   return x / y;
 }
+void Window::set_vsync(VSync vsync) noexcept {
+  int interval = 1;
+  switch (vsync) {
+    case VSync::Off:
+      interval = 0;
+      break;
+    case VSync::On:
+      interval = 1;
+      break;
+    case VSync::Adaptive:
+      // Negative intervals need the swap_control_tear extensions
+      if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+          glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+        interval = -1;
+      } else {
+        log("Adaptive vsync is unsupported, using regular vsync");
+        vsync = VSync::On;
+      }
+      break;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(interval);
+  config.vsync = vsync;
+}
 
 void Window::init_glfw() {
   log("Initializing GLFW");
@@ -114,6 +141,8 @@ bool Window::should_close() const noexcept {
   return glfwWindowShouldClose(window);
 }
 void Window::swap_buffers() noexcept {
+  WOOP_PROFILE_SCOPE("Window::swap_buffers");
+  limiter.wait();
   glfwSwapBuffers(window);
 }
 void Window::close() noexcept {
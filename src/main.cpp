@@ -5,17 +5,25 @@
  * config data, and starting the simulation.
  */
 
-#include "exception.hpp"   /* woop::Exception */
-#include "level.hpp"       /* woop::Level */
-#include "log.hpp"         /* woop::log, woop::log_error, woop::log_fatal */
-#include "utils.hpp"       /* UNUSED_PARAMETER */
-#include "window.hpp"      /* woop::Window */
-#include "camera.hpp"      /* woop::Camera */
-#include "renderer.hpp"    /* woop::Renderer */
-#include "player.hpp"      /* woop::Player */
-#include "wad.hpp"         /* woop::Wad */
-#include "config.hpp"      /* Configuration parsing */
-#include "toml++/toml.hpp" /* toml::table  */
+#include "exception.hpp"      /* woop::Exception */
+#include "level.hpp"          /* woop::Level */
+#include "log.hpp"            /* woop::log, woop::log_error, woop::log_fatal */
+#include "utils.hpp"          /* UNUSED_PARAMETER */
+#include "window.hpp"         /* woop::Window */
+#include "camera.hpp"         /* woop::Camera */
+#include "renderer.hpp"       /* woop::Renderer */
+#include "render_thread.hpp"  /* woop::RenderThread */
+#include "player.hpp"         /* woop::Player */
+#include "fixed_timestep.hpp" /* woop::FixedTimestep */
+#include "pvs.hpp"            /* woop::Pvs */
+#include "thread_pool.hpp"    /* woop::ThreadPool */
+#include "wad.hpp"            /* woop::Wad */
+#include "sprite.hpp"         /* woop::SpriteSet */
+#include "profiler.hpp"       /* woop::Profiler, WOOP_PROFILE_SCOPE */
+#include "config.hpp"         /* Configuration parsing */
+#include "toml++/toml.hpp"    /* toml::table  */
+#include <memory>             /* std::unique_ptr */
+#include <optional>           /* std::optional */
 
 woop::Window create_window(const toml::table& table) {
   woop::WindowConfig cfg = config::get_window_config(table);
@@ -31,6 +39,7 @@ woop::Renderer create_renderer(woop::Window& window,
                                woop::Camera& camera,
                                const toml::table& table) {
   woop::RendererConfig cfg = config::get_renderer_config(table);
+  woop::Shader::set_binary_cache(config::get_shader_cache(table));
   return woop::Renderer(window, camera, cfg);
 }
 
@@ -41,9 +50,40 @@ woop::Player create_player(woop::Camera& camera,
   return woop::Player{camera, level, cfg};
 }
 
-void update_shader_properties(woop::Renderer& renderer) {
-  woop::Shader& shader = renderer.get_shader();
-  shader.set_uniform("u_time", static_cast<float>(glfwGetTime()));
+/**
+ * @brief Gives a level its PVS, reading it from the level cache, or computing
+ * (and caching) it if it isn't there.
+ */
+void load_pvs(woop::Level& level, const toml::table& table) {
+  if (!config::get_renderer_config(table).pvs_culling)
+    return;
+  std::filesystem::path cache = config::get_level_cache(table);
+  if (!cache.empty()) {
+    if (std::optional<woop::Pvs> pvs = woop::Pvs::load(cache, level)) {
+      level.set_pvs(std::move(*pvs));
+      return;
+    }
+  }
+  woop::log("Computing PVS for ", level.get_name(), "...");
+  woop::ThreadPool pool;
+  woop::Pvs pvs = woop::Pvs::compute(level, pool);
+  if (!cache.empty())
+    pvs.save(cache, level);
+  level.set_pvs(std::move(pvs));
+}
+
+/**
+ * @brief Writes a trace once the last frame of its range has been drawn.
+ */
+void update_profiler(const woop::ProfilerConfig& cfg) {
+  if (cfg.trace_path.empty() || woop::Profiler::get_frame() != cfg.last_frame)
+    return;
+#ifndef WOOP_ENABLE_PROFILING
+  woop::log_warning("Writing an empty trace (profiling is disabled)");
+#endif
+  woop::Profiler::write_trace(cfg.trace_path, cfg.first_frame, cfg.last_frame);
+  woop::log("Wrote trace of frames ", cfg.first_frame, "-", cfg.last_frame,
+            " to ", cfg.trace_path);
 }
 
 /**
@@ -60,27 +100,60 @@ void run_loop() {
   /* Level data */
   woop::Wad wad = config::get_wad(table);
   woop::Level level = config::get_level(wad, table);
+  load_pvs(level, table);
+  woop::SpriteSet sprites(wad);
+  renderer.set_sprites(sprites);
+  renderer.set_light_table(config::get_light_table(wad, table));
 
   /* Player */
   woop::Player player = create_player(camera, level, table);
 
-  float time = glfwGetTime();
+  /* Simulation */
+  woop::FixedTimestep timestep(config::get_timestep_config(table));
+
+  /* Profiler */
+  woop::ProfilerConfig profiler_cfg = config::get_profiler_config(table);
+
+  /* Render thread */
+  std::unique_ptr<woop::RenderThread> render_thread;
+  if (renderer.get_frames_in_flight() > 0)
+    render_thread = std::make_unique<woop::RenderThread>(
+        renderer, renderer.get_frames_in_flight());
+
+  double time = glfwGetTime();
   while (!window.should_close()) {
+    update_profiler(profiler_cfg);
+    woop::Profiler::next_frame();
+    WOOP_PROFILE_SCOPE("Frame");
+
     /* Calculate time since last update */
-    float dt = glfwGetTime() - time;
-    time = glfwGetTime();
+    double now = glfwGetTime();
+    double dt = now - time;
+    time = now;
     glfwPollEvents();
 
-    /* Move player */
-    player.update(dt);
-
-    /* Update shader uniforms */
-    update_shader_properties(renderer);
+    /* Run simulation ticks, then place the camera between the last two */
+    unsigned ticks = timestep.advance(dt);
+    for (unsigned i = 0; i < ticks; ++i)
+      player.tick(timestep.get_tick_length());
+    player.interpolate(timestep.get_alpha());
 
     /* Draw level */
-    woop::Frame frame = renderer.begin_frame();
-    frame.draw(woop::DrawMode::Solid, player.get_level().get_root_node());
+    if (render_thread) {
+      render_thread->submit(player.get_level());
+      render_thread->present();
+      continue;
+    }
+    woop::Frame frame = renderer.begin_frame(player.get_level());
+    {
+      WOOP_PROFILE_SCOPE("BSP traversal");
+      frame.draw(woop::DrawMode::Solid, player.get_level());
+    }
   }
+  if (render_thread)
+    render_thread->flush();
+  woop::log("Frame pacing: ",
+            window.get_frame_limiter().get_stats().to_string());
 }
 
 int main(int argc, const char* argv[]) {
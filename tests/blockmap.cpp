@@ -0,0 +1,126 @@
+/**
+ * @file blockmap.cpp
+ * @authors quak
+ * @brief Tests for the blockmap and collisions against it.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "blockmap.hpp"
+#include "collision.hpp"
+#include "generated_maps.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+
+TEST(Blockmap, Build) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 30;
+  cfg.wall_detail = 3;
+  woop::Wad wad = generate_map(cfg);
+  woop::Level level(wad, "MAP01");
+  const woop::Blockmap& blockmap = level.get_blockmap();
+  EXPECT_GT(blockmap.get_columns(), 0u);
+  EXPECT_GT(blockmap.get_rows(), 0u);
+
+  // Every line is found from the blocks around its midpoint
+  const std::vector<woop::Linedef>& linedefs = level.get_linedefs();
+  for (uint32_t i = 0; i < linedefs.size(); ++i) {
+    glm::vec2 mid = (linedefs[i].start + linedefs[i].end) / 2.0f;
+    bool found = false;
+    blockmap.for_each_line(mid - 1.0f, mid + 1.0f, [&](uint32_t line) {
+      found = found || line == i;
+    });
+    EXPECT_TRUE(found) << "Linedef " << i;
+  }
+}
+
+TEST(Blockmap, Lump) {
+  woop::Wad generated = generate_rooms(false);
+  woop::Level level(generated, "MAP01");
+  std::vector<uint16_t> words = level.get_blockmap().to_lump();
+
+  woop::WadBuilder builder;
+  builder.add_lump("BLOCKMAP", words);
+  woop::Wad wad = builder.build();
+  woop::Blockmap blockmap = woop::Blockmap::from_lump(
+      wad.get_lump("BLOCKMAP"), level.get_linedefs().size());
+  EXPECT_EQ(blockmap.to_lump(), words);
+  EXPECT_EQ(blockmap.get_origin(), level.get_blockmap().get_origin());
+
+  // Lines that don't exist
+  EXPECT_THROW(woop::Blockmap::from_lump(wad.get_lump("BLOCKMAP"), 1),
+               woop::LevelException);
+  // Truncated lists
+  words.pop_back();
+  woop::WadBuilder truncated;
+  truncated.add_lump("BLOCKMAP", words);
+  woop::Wad truncated_wad = truncated.build();
+  EXPECT_THROW(woop::Blockmap::from_lump(truncated_wad.get_lump("BLOCKMAP"),
+                                         level.get_linedefs().size()),
+               woop::LevelException);
+}
+
+TEST(Collider, Walls) {
+  woop::Wad wad = generate_rooms(true);
+  woop::Level level(wad, "MAP01");
+  woop::Collider collider(level);
+  const float radius = collider.get_body().radius;
+  EXPECT_FALSE(collider.check_position({-128.0f, 0.0f}, 0.0f).blocked);
+  woop::PositionCheck check = collider.check_position({-8.0f, 0.0f}, 0.0f);
+  EXPECT_TRUE(check.blocked);
+  EXPECT_NE(check.blocking_line, nullptr);
+
+  // Moving straight into the wall stops the body's edge at it
+  glm::vec2 position =
+      collider.slide_move({-128.0f, 0.0f}, {200.0f, 0.0f}, 0.0f);
+  EXPECT_LE(position.x, -radius);
+  EXPECT_GT(position.x, -radius - 8.0f);
+  EXPECT_FLOAT_EQ(position.y, 0.0f);
+
+  // Moving diagonally slides along it
+  position = collider.slide_move({-128.0f, 0.0f}, {200.0f, 50.0f}, 0.0f);
+  EXPECT_LE(position.x, -radius);
+  EXPECT_GT(position.x, -radius - 8.0f);
+  EXPECT_NEAR(position.y, 50.0f, 0.01f);
+
+  // Corners stop both axes
+  position = collider.slide_move({-128.0f, 0.0f}, {500.0f, 500.0f}, 0.0f);
+  EXPECT_LE(position.x, -radius);
+  EXPECT_LE(position.y, 128.0f - radius);
+}
+
+TEST(Collider, Openings) {
+  woop::Wad wad = generate_rooms(false);
+  woop::Level level(wad, "MAP01");
+  const float floor = level.get_sector({-128.0f, 0.0f}).floor.height;
+  const float other_floor = level.get_sector({128.0f, 0.0f}).floor.height;
+
+  // Small bodies pass through the window between the rooms
+  woop::Body small;
+  small.height = 1.0f;
+  small.max_step = 1000.0f;
+  woop::Collider passes(level, small);
+  glm::vec2 position =
+      passes.slide_move({-128.0f, 0.0f}, {256.0f, 0.0f}, floor);
+  EXPECT_NEAR(position.x, 128.0f, 0.01f);
+  EXPECT_EQ(passes.check_position({0.0f, 0.0f}, floor).floor,
+            std::max(floor, other_floor));
+
+  // Bodies taller than the window don't
+  woop::Body tall;
+  tall.height = 1000.0f;
+  woop::Collider blocked(level, tall);
+  position = blocked.slide_move({-128.0f, 0.0f}, {256.0f, 0.0f}, floor);
+  EXPECT_LE(position.x, -tall.radius);
+
+  // Neither do bodies that can't step up, or drop down, to the other room
+  woop::Body climber = small;
+  climber.max_step = -1.0f;
+  EXPECT_TRUE(woop::Collider(level, climber)
+                  .check_position({0.0f, 0.0f}, floor - 8.0f)
+                  .blocked);
+  woop::Body faller = small;
+  faller.max_drop_off = -1.0f;
+  EXPECT_TRUE(woop::Collider(level, faller)
+                  .check_position({0.0f, 0.0f}, floor)
+                  .blocked);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file fixed_timestep.cpp
+ * @authors quak
+ * @brief Tests for splitting frame times into fixed simulation ticks.
+ */
+
+#include "fixed_timestep.hpp"
+#include "exception.hpp"
+#include "gtest/gtest.h"
+
+TEST(FixedTimestep, Ticks) {
+  woop::FixedTimestep timestep(woop::TimestepConfig{10.0, 8});
+  EXPECT_FLOAT_EQ(timestep.get_tick_length(), 0.1f);
+
+  // Short frames run no ticks until a whole tick has passed
+  EXPECT_EQ(timestep.advance(0.04), 0u);
+  EXPECT_NEAR(timestep.get_alpha(), 0.4f, 1e-5f);
+  EXPECT_EQ(timestep.advance(0.04), 0u);
+  EXPECT_EQ(timestep.advance(0.04), 1u);
+  EXPECT_NEAR(timestep.get_alpha(), 0.2f, 1e-5f);
+  // Long frames run several
+  EXPECT_EQ(timestep.advance(0.35), 3u);
+  EXPECT_NEAR(timestep.get_alpha(), 0.7f, 1e-5f);
+  EXPECT_EQ(timestep.get_tick(), 4u);
+}
+
+TEST(FixedTimestep, FrameRateIndependent) {
+  // The same span of time runs the same number of ticks at any frame rate
+  for (int fps : {30, 60, 144, 1000}) {
+    woop::FixedTimestep timestep(woop::TimestepConfig{35.0, 8});
+    unsigned ticks = 0;
+    for (int frame = 0; frame < fps * 2; ++frame)
+      ticks += timestep.advance(1.0 / fps);
+    EXPECT_NEAR(static_cast<double>(ticks), 70.0, 1.0) << fps << " fps";
+  }
+}
+
+TEST(FixedTimestep, Hitches) {
+  woop::FixedTimestep timestep(woop::TimestepConfig{35.0, 4});
+  // A one second hitch only runs the maximum number of ticks
+  EXPECT_EQ(timestep.advance(1.0), 4u);
+  EXPECT_EQ(timestep.get_dropped_ticks(), 31u);
+  EXPECT_LT(timestep.get_alpha(), 1.0f);
+  // Negative frame times (e.g. clock adjustments) are ignored
+  EXPECT_EQ(timestep.advance(-1.0), 0u);
+
+  EXPECT_THROW(woop::FixedTimestep(woop::TimestepConfig{0.0, 4}),
+               woop::Exception);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file frame_arena.cpp
+ * @authors quak
+ * @brief Tests for the per-frame bump allocator.
+ */
+
+#include "frame_arena.hpp"
+#include "gtest/gtest.h"
+#include <cstdint>
+
+TEST(FrameArena, Alignment) {
+  woop::FrameArena arena(1024);
+  arena.allocate(1, 1);
+  for (std::size_t alignment : {2, 4, 8, 16}) {
+    void* ptr = arena.allocate(3, alignment);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0u);
+  }
+  EXPECT_EQ(arena.get_overflow_count(), 0u);
+  EXPECT_LE(arena.get_used(), arena.get_capacity());
+}
+
+TEST(FrameArena, Reset) {
+  woop::FrameArena arena(64);
+  void* first = arena.allocate(16, 8);
+  arena.reset();
+  EXPECT_EQ(arena.get_used(), 0u);
+  EXPECT_EQ(arena.allocate(16, 8), first);
+}
+
+TEST(FrameArena, Overflow) {
+  woop::FrameArena arena(64);
+  arena.allocate(48, 8);
+  // Too large for what's left of the block
+  void* overflow = arena.allocate(32, 8);
+  EXPECT_NE(overflow, nullptr);
+  EXPECT_EQ(arena.get_overflow_count(), 1u);
+  EXPECT_EQ(arena.get_used(), 80u);
+
+  // The next frame fits in the main block
+  arena.reset();
+  EXPECT_EQ(arena.get_overflow_count(), 0u);
+  EXPECT_GE(arena.get_capacity(), 80u);
+  arena.allocate(48, 8);
+  arena.allocate(32, 8);
+  EXPECT_EQ(arena.get_overflow_count(), 0u);
+}
+
+TEST(FrameArena, Vector) {
+  woop::FrameArena arena(4096);
+  woop::ArenaVector<int> values{woop::ArenaAllocator<int>(arena)};
+  for (int i = 0; i < 100; ++i)
+    values.push_back(i);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(values[static_cast<std::size_t>(i)], i);
+  EXPECT_GE(arena.get_used(), 100 * sizeof(int));
+
+  // Capacity is kept when cleared, so refilling doesn't allocate
+  std::size_t used = arena.get_used();
+  values.clear();
+  values.assign(100, 1);
+  EXPECT_EQ(arena.get_used(), used);
+}
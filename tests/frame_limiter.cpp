@@ -0,0 +1,54 @@
+/**
+ * @file frame_limiter.cpp
+ * @authors quak
+ * @brief Tests for capping the frame rate and measuring frame pacing.
+ */
+
+#include "frame_limiter.hpp"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <thread>
+
+TEST(FrameLimiter, Cap) {
+  using namespace std::chrono_literals;
+  woop::FrameLimiter limiter(200.0);
+  EXPECT_EQ(limiter.get_max_fps(), 200.0);
+
+  auto start = woop::FrameLimiter::Clock::now();
+  for (int i = 0; i < 21; ++i)
+    limiter.wait();
+  auto elapsed = woop::FrameLimiter::Clock::now() - start;
+  // 20 frame intervals of 5 ms each, never shorter
+  EXPECT_GE(elapsed, 100ms);
+
+  woop::FramePacingStats stats = limiter.get_stats();
+  EXPECT_EQ(stats.frames, 20u);
+  EXPECT_GE(stats.mean_frame_time, 4.99);
+  EXPECT_GE(stats.max_frame_time, stats.mean_frame_time);
+  EXPECT_GE(stats.jitter, 0.0);
+
+  limiter.reset_stats();
+  EXPECT_EQ(limiter.get_stats().frames, 0u);
+}
+
+TEST(FrameLimiter, LateFrames) {
+  using namespace std::chrono_literals;
+  woop::FrameLimiter limiter(1000.0);
+  limiter.wait();
+  // Missing a deadline restarts the schedule instead of rushing to catch up
+  std::this_thread::sleep_for(5ms);
+  limiter.wait();
+  auto start = woop::FrameLimiter::Clock::now();
+  limiter.wait();
+  EXPECT_GE(woop::FrameLimiter::Clock::now() - start, 900us);
+  EXPECT_EQ(limiter.get_stats().late_frames, 1u);
+}
+
+TEST(FrameLimiter, Uncapped) {
+  woop::FrameLimiter limiter;
+  for (int i = 0; i < 3; ++i)
+    limiter.wait();
+  // Pacing is still measured
+  EXPECT_EQ(limiter.get_stats().frames, 2u);
+  EXPECT_EQ(limiter.get_stats().late_frames, 0u);
+}
@@ -0,0 +1,58 @@
+/**
+ * @file generated_maps.hpp
+ * @authors quak
+ * @brief Fixtures shared by the tests that run on generated maps, along with
+ * brute-force checks to compare the engine's answers against.
+ */
+
+#pragma once
+
+#include "level.hpp"
+#include "map_generator.hpp"
+#include "wad_builder.hpp"
+#include "glm/vec2.hpp"
+#include <optional>
+
+/**
+ * @brief Generates a map named "MAP01", in a wad of its own.
+ */
+inline woop::Wad generate_map(const woop::MapGeneratorConfig& cfg) {
+  woop::WadBuilder builder;
+  woop::MapGenerator(cfg).generate(builder, "MAP01");
+  return builder.build();
+}
+
+/**
+ * @brief Generates a row of two rooms, each spanning 256x256 units. The left
+ * room spans x from -256 to 0, the right one from 0 to 256.
+ * @param solid Whether the wall between the rooms is solid
+ */
+inline woop::Wad generate_rooms(bool solid) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 2;
+  cfg.room_density = solid ? 1.0f : 0.0f;
+  return generate_map(cfg);
+}
+
+/**
+ * @brief Returns the fraction along the segment from `from` to `to` at which
+ * it crosses a line, or nothing if it doesn't. Crossings at either end of the
+ * segment or the line count.
+ */
+inline std::optional<float> get_line_crossing(const woop::Linedef& line,
+                                              const glm::vec2& from,
+                                              const glm::vec2& to) {
+  auto cross = [](const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+  };
+  glm::vec2 delta = to - from;
+  glm::vec2 wall = line.end - line.start;
+  float denominator = cross(delta, wall);
+  if (denominator == 0.0f)
+    return std::nullopt;
+  float t = cross(line.start - from, wall) / denominator;
+  float u = cross(line.start - from, delta) / denominator;
+  if (t < 0.0f || t > 1.0f || u < 0.0f || u > 1.0f)
+    return std::nullopt;
+  return t;
+}
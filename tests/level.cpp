@@ -2,18 +2,29 @@
  * @file level.cpp
  * @authors quak
  * @brief Tests level loading and basic BSP navigation.
- * @note These tests require an official DOOM wad to run.
+ * @note Tests that open get_wad() require an official DOOM wad to run. The
+ * others use generated maps.
  */
 
 #include "level.hpp"
+#include "generated_maps.hpp"
 #include "glm/fwd.hpp"
 #include "gtest/gtest.h"
+#include <algorithm>
 
 constexpr const char* wad_path = "wads/doom1.wad";
 
-const woop::Wad wad(wad_path);
+/**
+ * @brief Returns the wad shared by all tests, loading it on first use (so
+ * tests that don't need it can still run without it).
+ */
+const woop::Wad& get_wad() {
+  static const woop::Wad wad(wad_path);
+  return wad;
+}
 
 TEST(Levels, Open) {
+  const woop::Wad& wad = get_wad();
   // Constructor
   {
     woop::Level level(wad, "E1M1");
@@ -33,6 +44,7 @@ TEST(Levels, Open) {
 }
 
 TEST(Levels, Close) {
+  const woop::Wad& wad = get_wad();
   // Closing level normally
   {
     woop::Level level(wad, "E1M1");
@@ -49,6 +61,7 @@ TEST(Levels, Close) {
 }
 
 TEST(Levels, BSP) {
+  const woop::Wad& wad = get_wad();
   // Traversing BSP should always terminate in a subsector.
   {
     woop::Level level(wad, "E1M1");
@@ -72,4 +85,75 @@ TEST(Levels, BSP) {
       }
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(Levels, Reject) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 3;
+  woop::Wad generated = generate_map(cfg);
+  // Without a REJECT lump, every sector can see every other
+  {
+    woop::Level level(generated, "MAP01");
+    for (std::size_t a = 0; a < 3; ++a) {
+      for (std::size_t b = 0; b < 3; ++b)
+        EXPECT_TRUE(level.can_see(a, b));
+    }
+  }
+  // Bits are stored row by row, least significant bit first. Sector 0 can't
+  // see sector 2 (bit 2), and sector 2 can't see sector 1 (bit 7).
+  woop::WadBuilder builder;
+  for (const woop::Lump& lump : generated)
+    builder.add_lump(lump.name, lump.data);
+  builder.add_lump("REJECT", std::vector<uint8_t>{0x84, 0x00});
+  woop::Wad wad = builder.build();
+  woop::Level level(wad, "MAP01");
+  const std::vector<woop::Sector>& sectors = level.get_sectors();
+  EXPECT_FALSE(level.can_see(0, 2));
+  EXPECT_FALSE(level.can_see(sectors[2], sectors[1]));
+  EXPECT_TRUE(level.can_see(2, 0));
+  EXPECT_TRUE(level.can_see(sectors[1], sectors[1]));
+  EXPECT_EQ(level.get_sector_index(sectors[2]), 2u);
+}
+
+TEST(Levels, Connectivity) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 20;
+  cfg.room_density = 0.0f;
+  woop::Wad wad = generate_map(cfg);
+  woop::Level level(wad, "MAP01");
+
+  // Subsectors know their sector, and hold every seg facing it
+  for (const woop::Subsector& subsector : level.get_subsectors()) {
+    ASSERT_NE(subsector.sector, nullptr);
+    for (const woop::Seg& seg : subsector.segs) {
+      if (seg.sidedef)
+        EXPECT_EQ(&seg.sidedef->sector_facing, subsector.sector);
+    }
+  }
+  // Sectors list every line with a side facing them
+  std::size_t sides = 0;
+  for (const woop::Linedef& line : level.get_linedefs())
+    sides += (line.front ? 1 : 0) + (line.back ? 1 : 0);
+  std::size_t listed = 0;
+  for (const woop::Sector& sector : level.get_sectors()) {
+    listed += sector.lines.size();
+    for (const woop::Linedef* line : sector.lines) {
+      EXPECT_TRUE((line->front && &line->front->sector_facing == &sector) ||
+                  (line->back && &line->back->sector_facing == &sector));
+    }
+    // Neighbors are listed once, on both sides
+    for (const woop::Sector* neighbor : sector.neighbors) {
+      EXPECT_NE(neighbor, &sector);
+      EXPECT_EQ(std::count(sector.neighbors.begin(), sector.neighbors.end(),
+                           neighbor),
+                1);
+      EXPECT_NE(std::find(neighbor->neighbors.begin(),
+                          neighbor->neighbors.end(), &sector),
+                neighbor->neighbors.end());
+    }
+  }
+  EXPECT_EQ(listed, sides);
+  // Without solid walls, every room opens onto a neighbor
+  for (const woop::Sector& sector : level.get_sectors())
+    EXPECT_FALSE(sector.neighbors.empty());
+}
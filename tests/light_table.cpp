@@ -0,0 +1,73 @@
+/**
+ * @file light_table.cpp
+ * @authors quak
+ * @brief Tests for building light tables and shading colors.
+ * @note Lumps are built in memory, so these don't require any external wads.
+ */
+
+#include "light_table.hpp"
+#include "wad_builder.hpp"
+#include "gtest/gtest.h"
+
+TEST(LightTable, Shades) {
+  woop::LightTable table(woop::Pixel{0, 0, 0, 255}, 1.0f);
+  // Full bright sectors never fade
+  EXPECT_EQ(table.get_shade(255, 0.0f), 0);
+  EXPECT_EQ(table.get_shade(255, 10.0f), 0);
+  // Dark sectors are darkest far away
+  EXPECT_EQ(table.get_shade(0, 0.0f), woop::shade_count - 1);
+  // Shades get brighter with light level and proximity
+  for (int light = 0; light < 255; light += 8) {
+    EXPECT_GE(table.get_shade(light, 0.5f), table.get_shade(light + 8, 0.5f));
+    EXPECT_GE(table.get_shade(light, 0.5f), table.get_shade(light, 1.0f));
+  }
+  // Out of range values are clamped
+  EXPECT_EQ(table.get_shade(-100, 0.5f), table.get_shade(0, 0.5f));
+  EXPECT_EQ(table.get_shade(1000, 0.5f), table.get_shade(255, 0.5f));
+}
+
+TEST(LightTable, FogRamp) {
+  woop::Pixel color{200, 100, 50, 255};
+  woop::Pixel fog{0, 0, 100, 255};
+  woop::ColorRamp ramp = woop::LightTable(fog, 1.0f).get_ramp(color);
+  EXPECT_EQ(ramp.front(), color);
+  EXPECT_EQ(ramp.back(), fog);
+
+  // No fog: every shade is the same
+  ramp = woop::LightTable(fog, 0.0f).get_ramp(color);
+  for (const auto& shade : ramp)
+    EXPECT_EQ(shade, color);
+}
+
+TEST(LightTable, Colormap) {
+  // Palette of grays, and colormaps that darken by one index per shade
+  std::vector<uint8_t> playpal;
+  for (int i = 0; i < 256; ++i)
+    playpal.insert(playpal.end(), 3, static_cast<uint8_t>(i));
+  std::vector<uint8_t> colormap;
+  for (int shade = 0; shade < 34; ++shade) {
+    for (int i = 0; i < 256; ++i)
+      colormap.emplace_back(static_cast<uint8_t>(std::max(i - shade, 0)));
+  }
+  woop::WadBuilder builder;
+  builder.add_lump("PLAYPAL", playpal).add_lump("COLORMAP", colormap);
+  woop::LightTable table(builder.build());
+  EXPECT_TRUE(table.uses_colormap());
+
+  // Colors are matched to the closest palette entry
+  woop::ColorRamp ramp = table.get_ramp(woop::Pixel{101, 99, 100, 255});
+  for (std::size_t shade = 0; shade < woop::shade_count; ++shade) {
+    auto gray = static_cast<unsigned char>(100 - shade);
+    EXPECT_EQ(ramp[shade], (woop::Pixel{gray, gray, gray, 255}));
+  }
+}
+
+TEST(LightTable, InvalidLumps) {
+  woop::WadBuilder builder;
+  builder.add_lump("PLAYPAL", std::vector<uint8_t>(768))
+      .add_lump("COLORMAP", std::vector<uint8_t>(256));
+  EXPECT_THROW(woop::LightTable{builder.build()}, woop::LightTableException);
+  // Missing lumps
+  EXPECT_THROW(woop::LightTable{woop::WadBuilder{}.add_lump("X").build()},
+               woop::WadException);
+}
@@ -0,0 +1,161 @@
+/**
+ * @file map_generator.cpp
+ * @authors quak
+ * @brief Tests for building wads in memory and generating maps.
+ * @note Unlike other tests, these don't require any external wads.
+ */
+
+#include "map_generator.hpp"
+#include "wad_builder.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <sstream>
+
+TEST(WadBuilder, RoundTrip) {
+  woop::WadBuilder builder(woop::WadType::Internal);
+  std::vector<int16_t> values = {1, 2, 3, -4};
+  builder.add_lump("MARKER").add_lump("VALUES", values);
+  EXPECT_EQ(builder.get_num_lumps(), 2);
+
+  // Building directly
+  {
+    woop::Wad wad = builder.build();
+    EXPECT_TRUE(wad.is_open());
+    EXPECT_EQ(wad.get_type(), woop::WadType::Internal);
+    EXPECT_EQ(wad.get_lump("MARKER").data.size(), 0);
+    EXPECT_EQ(wad.get_lump("MARKER", "VALUES").get_data_as<int16_t>(), values);
+  }
+  // Writing to a stream, then reading it back
+  {
+    std::stringstream stream;
+    builder.write(stream);
+    woop::Wad wad;
+    wad.open(stream);
+    EXPECT_EQ(wad.get_num_lumps(), 2);
+    EXPECT_EQ(wad.get_lump("VALUES").get_data_as<int16_t>(), values);
+  }
+}
+
+TEST(WadBuilder, InvalidLumps) {
+  woop::WadBuilder builder;
+  EXPECT_THROW(builder.add_lump(""), woop::WadException);
+  EXPECT_THROW(builder.add_lump("TOOLONGNAME"), woop::WadException);
+  EXPECT_THROW(woop::WadBuilder{woop::WadType::Unloaded}, woop::WadException);
+}
+
+TEST(MapGenerator, Open) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 50;
+  cfg.thing_count = 10;
+  woop::WadBuilder builder;
+  woop::MapGenerator(cfg).generate(builder, "MAP01");
+  woop::Wad wad = builder.build();
+
+  woop::Level level(wad, "MAP01");
+  EXPECT_TRUE(level.is_open());
+  // Player start + scattered things
+  EXPECT_EQ(level.get_things().size(), 11);
+  EXPECT_EQ(level.get_things().front().type, 1);
+
+  // Revisions change with the level's data, and are unique across levels
+  uint64_t revision = level.get_revision();
+  level.mark_changed();
+  EXPECT_NE(level.get_revision(), revision);
+  revision = level.get_revision();
+  level.open(wad, "MAP01");
+  EXPECT_NE(level.get_revision(), revision);
+  EXPECT_NE(woop::Level(wad, "MAP01").get_revision(), level.get_revision());
+}
+
+TEST(MapGenerator, Deterministic) {
+  woop::MapGeneratorConfig cfg;
+  cfg.seed = 1234;
+  std::stringstream first;
+  std::stringstream second;
+  {
+    woop::WadBuilder builder;
+    woop::MapGenerator(cfg).generate(builder, "MAP01");
+    builder.write(first);
+  }
+  {
+    woop::WadBuilder builder;
+    woop::MapGenerator(cfg).generate(builder, "MAP01");
+    builder.write(second);
+  }
+  EXPECT_EQ(first.str(), second.str());
+}
+
+TEST(MapGenerator, BSP) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 37;
+  cfg.wall_detail = 3;
+  woop::WadBuilder builder;
+  woop::MapGenerator(cfg).generate(builder, "MAP01");
+  woop::Wad wad = builder.build();
+  woop::Level level(wad, "MAP01");
+
+  // Every room's center should resolve to the subsector surrounding it
+  for (const auto& thing : level.get_things()) {
+    const woop::Subsector& subsector = level.get_subsector(thing.position);
+    ASSERT_FALSE(subsector.segs.empty());
+    // Things are sorted into the subsector containing them
+    EXPECT_NE(std::find(subsector.things.begin(), subsector.things.end(),
+                        &thing),
+              subsector.things.end());
+    glm::vec2 min = subsector.segs.front().start;
+    glm::vec2 max = subsector.segs.front().start;
+    for (const woop::Seg& seg : subsector.segs) {
+      ASSERT_NE(seg.sidedef, nullptr);
+      EXPECT_EQ(&seg.sidedef->sector_facing, subsector.sector);
+      min = glm::min(min, glm::min(seg.start, seg.end));
+      max = glm::max(max, glm::max(seg.start, seg.end));
+    }
+    EXPECT_GT(thing.position.x, min.x);
+    EXPECT_GT(thing.position.y, min.y);
+    EXPECT_LT(thing.position.x, max.x);
+    EXPECT_LT(thing.position.y, max.y);
+  }
+}
+
+TEST(MapGenerator, Limits) {
+  woop::WadBuilder builder;
+  // Too few sectors
+  {
+    woop::MapGeneratorConfig cfg;
+    cfg.sector_count = 1;
+    EXPECT_THROW(woop::MapGenerator(cfg).generate(builder, "MAP01"),
+                 woop::LevelException);
+  }
+  // More linedefs than the vanilla format can index
+  {
+    woop::MapGeneratorConfig cfg;
+    cfg.sector_count = 4096;
+    cfg.open_area_size = 64;
+    cfg.wall_detail = 8;
+    EXPECT_THROW(woop::MapGenerator(cfg).generate(builder, "MAP01"),
+                 woop::LevelException);
+  }
+  // Map too large to be addressed with int16 coordinates
+  {
+    woop::MapGeneratorConfig cfg;
+    cfg.sector_count = 1024;
+    cfg.open_area_size = 2048;
+    EXPECT_THROW(woop::MapGenerator(cfg).generate(builder, "MAP01"),
+                 woop::LevelException);
+  }
+  // More segs than an int16 can index, which vanilla lumps hold as uint16
+  {
+    woop::MapGeneratorConfig cfg;
+    cfg.sector_count = 2500;
+    cfg.room_density = 0.0f;
+    cfg.wall_detail = 4;
+    woop::WadBuilder large;
+    woop::MapGenerator(cfg).generate(large, "MAP01");
+    woop::Wad wad = large.build();
+    woop::Level level(wad, "MAP01");
+    EXPECT_GT(level.get_subsectors().back().segs.end() -
+                  level.get_subsectors().front().segs.begin(),
+              32767);
+    EXPECT_FALSE(level.has_built_nodes());
+  }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file node_builder.cpp
+ * @authors quak
+ * @brief Tests for building BSP trees.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "node_builder.hpp"
+#include "generated_maps.hpp"
+#include "thread_pool.hpp"
+#include "glm/geometric.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+woop::MapGeneratorConfig get_map_config() {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 40;
+  cfg.wall_detail = 3;
+  cfg.thing_count = 40;
+  cfg.seed = 7;
+  return cfg;
+}
+
+/**
+ * @brief Returns a copy of a wad with empty SEGS, SSECTORS, and NODES lumps.
+ */
+woop::Wad strip_nodes(const woop::Wad& wad) {
+  woop::WadBuilder builder;
+  for (const woop::Lump& lump : wad) {
+    if (lump.name == "SEGS" || lump.name == "SSECTORS" || lump.name == "NODES")
+      builder.add_lump(lump.name);
+    else
+      builder.add_lump(lump.name, lump.data);
+  }
+  return builder.build();
+}
+
+/**
+ * @brief Returns the lines of a loaded level, for building trees directly.
+ */
+std::vector<woop::NodeBuilder::Line> get_lines(
+    const woop::Level& level,
+    std::vector<glm::vec2>& vertices) {
+  std::map<const glm::vec2*, uint32_t> indices;
+  auto get_index = [&](const glm::vec2& vertex) {
+    auto [it, added] =
+        indices.emplace(&vertex, static_cast<uint32_t>(vertices.size()));
+    if (added)
+      vertices.push_back(vertex);
+    return it->second;
+  };
+  auto get_sector = [&](const woop::Sidedef* side) {
+    return side ? static_cast<int32_t>(
+                      level.get_sector_index(side->sector_facing))
+                : -1;
+  };
+  std::vector<woop::NodeBuilder::Line> lines;
+  for (const woop::Linedef& line : level.get_linedefs()) {
+    lines.push_back({get_index(line.start), get_index(line.end),
+                     get_sector(line.front), get_sector(line.back)});
+  }
+  return lines;
+}
+
+/**
+ * @brief Returns the number of nodes on the longest path from a child down to
+ * a subsector.
+ */
+int get_depth(const woop::BspTree& tree, uint32_t child) {
+  if (child & woop::BspTree::subsector_bit)
+    return 0;
+  const woop::BspTree::Node& node = tree.nodes[child];
+  return 1 + std::max(get_depth(tree, node.right_child),
+                      get_depth(tree, node.left_child));
+}
+}  // namespace
+
+TEST(NodeBuilder, MissingNodes) {
+  woop::Wad original_wad = generate_map(get_map_config());
+  woop::Wad stripped_wad = strip_nodes(original_wad);
+  woop::Level original(original_wad, "MAP01");
+  woop::Level built(stripped_wad, "MAP01");
+  EXPECT_FALSE(original.has_built_nodes());
+  EXPECT_TRUE(built.has_built_nodes());
+  EXPECT_NE(original.get_checksum(), built.get_checksum());
+
+  // Both trees put things in the same sectors
+  ASSERT_FALSE(original.get_things().empty());
+  for (const woop::Thing& thing : original.get_things()) {
+    EXPECT_EQ(original.get_sector_index(original.get_sector(thing.position)),
+              built.get_sector_index(built.get_sector(thing.position)));
+  }
+}
+
+TEST(NodeBuilder, Subsectors) {
+  woop::Wad wad = generate_map(get_map_config());
+  woop::LevelConfig cfg;
+  cfg.rebuild_nodes = true;
+  woop::Level level(wad, "MAP01", cfg);
+  ASSERT_TRUE(level.has_built_nodes());
+
+  std::map<const woop::Sidedef*, float> side_lengths;
+  for (const woop::Subsector& subsector : level.get_subsectors()) {
+    ASSERT_FALSE(subsector.segs.empty());
+    for (const woop::Seg& seg : subsector.segs) {
+      // Subsectors face a single sector
+      EXPECT_EQ(&seg.sidedef->sector_facing, subsector.sector);
+      side_lengths[seg.sidedef] += glm::length(seg.end - seg.start);
+      // And are convex, so no seg lies behind another
+      glm::vec2 delta = seg.end - seg.start;
+      for (const woop::Seg& other : subsector.segs) {
+        for (const glm::vec2& point : {other.start, other.end}) {
+          glm::vec2 offset = point - seg.start;
+          EXPECT_GT((offset.x * delta.y - offset.y * delta.x) /
+                        glm::length(delta),
+                    -0.1f);
+        }
+      }
+    }
+  }
+  // Segs cover every side of every line exactly once
+  for (const woop::Linedef& line : level.get_linedefs()) {
+    float length = glm::length(line.end - line.start);
+    for (const woop::Sidedef* side : {line.front, line.back}) {
+      if (side)
+        EXPECT_NEAR(side_lengths[side], length, 0.01f);
+    }
+  }
+}
+
+TEST(NodeBuilder, Heuristics) {
+  woop::Wad wad = generate_map(get_map_config());
+  woop::Level level(wad, "MAP01");
+  std::vector<glm::vec2> vertices;
+  std::vector<woop::NodeBuilder::Line> lines = get_lines(level, vertices);
+
+  // Trees don't depend on how partitions were scored
+  woop::ThreadPool serial(1);
+  woop::ThreadPool parallel(4);
+  woop::BspTree a = woop::NodeBuilder().build(vertices, lines, serial);
+  woop::BspTree b = woop::NodeBuilder().build(vertices, lines, parallel);
+  ASSERT_EQ(a.segs.size(), b.segs.size());
+  ASSERT_EQ(a.nodes.size(), b.nodes.size());
+  for (std::size_t i = 0; i < a.nodes.size(); ++i) {
+    EXPECT_EQ(a.nodes[i].partition_start, b.nodes[i].partition_start);
+    EXPECT_EQ(a.nodes[i].partition_delta, b.nodes[i].partition_delta);
+    EXPECT_EQ(a.nodes[i].right_child, b.nodes[i].right_child);
+  }
+
+  // Ignoring balance gives deeper trees
+  woop::NodeBuilderConfig unbalanced;
+  unbalanced.balance_cost = 0;
+  woop::BspTree c =
+      woop::NodeBuilder(unbalanced).build(vertices, lines, parallel);
+  EXPECT_GT(get_depth(c, static_cast<uint32_t>(c.nodes.size() - 1)),
+            get_depth(a, static_cast<uint32_t>(a.nodes.size() - 1)));
+
+  // Lines must refer to vertices that exist
+  lines.push_back({0, static_cast<uint32_t>(vertices.size()), 0, -1});
+  EXPECT_THROW(woop::NodeBuilder().build(vertices, lines, serial),
+               woop::LevelException);
+}
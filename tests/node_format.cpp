@@ -0,0 +1,275 @@
+/**
+ * @file node_format.cpp
+ * @authors quak
+ * @brief Tests for reading BSP trees stored in extended node formats.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "node_format.hpp"
+#include "generated_maps.hpp"
+#include "glm/geometric.hpp"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * @brief A generated map, along with the tree read from its vanilla lumps.
+ */
+struct GeneratedMap {
+  woop::Wad wad;
+  std::vector<glm::vec2> vertices;
+  std::vector<woop::NodeBuilder::Line> lines;
+  woop::BspTree tree;
+};
+
+GeneratedMap read_generated_map() {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 20;
+  cfg.wall_detail = 2;
+  cfg.thing_count = 20;
+  GeneratedMap map{generate_map(cfg), {}, {}, {}};
+
+  const woop::Lump& vertices = map.wad.get_lump("MAP01", "VERTEXES");
+  for (const auto& vertex : vertices.get_data_as<woop::Level::RawVertex>())
+    map.vertices.push_back({vertex.x_pos, vertex.y_pos});
+  const woop::Lump& lines = map.wad.get_lump("MAP01", "LINEDEFS");
+  for (const auto& line : lines.get_data_as<woop::Level::RawLinedef>())
+    map.lines.push_back({line.start_vertex, line.end_vertex, -1, -1});
+  map.tree = *woop::read_node_lumps(map.wad.get_lump("MAP01", "SEGS").data,
+                                    map.wad.get_lump("MAP01", "SSECTORS").data,
+                                    map.wad.get_lump("MAP01", "NODES").data,
+                                    map.vertices, map.lines);
+  return map;
+}
+
+/**
+ * @brief Returns a copy of a generated map's wad with new SEGS, SSECTORS, and
+ * NODES lumps.
+ */
+woop::Wad replace_nodes(const woop::Wad& wad,
+                        const std::vector<std::byte>& segs,
+                        const std::vector<std::byte>& subsectors,
+                        const std::vector<std::byte>& nodes) {
+  woop::WadBuilder builder;
+  for (const woop::Lump& lump : wad) {
+    if (lump.name == "SEGS")
+      builder.add_lump(lump.name, segs);
+    else if (lump.name == "SSECTORS")
+      builder.add_lump(lump.name, subsectors);
+    else if (lump.name == "NODES")
+      builder.add_lump(lump.name, nodes);
+    else
+      builder.add_lump(lump.name, lump.data);
+  }
+  return builder.build();
+}
+
+/**
+ * @brief Writes a tree in an extended format. GL formats expect each
+ * subsector's segs to be in order around it, and mark minisegs with a linedef
+ * of 0xffffffff.
+ */
+std::vector<std::byte> write_extended_nodes(const woop::BspTree& tree,
+                                            std::size_t vertex_count,
+                                            woop::NodeFormat format) {
+  std::vector<std::byte> data;
+  auto write = [&](auto value) {
+    std::size_t size = data.size();
+    data.resize(size + sizeof(value));
+    std::memcpy(data.data() + size, &value, sizeof(value));
+  };
+  auto write_fixed = [&](float value) {
+    write(static_cast<int32_t>(value * 65536.0f));
+  };
+  const char* signatures[] = {"", "XNOD", "XGLN", "XGL2", "XGL3"};
+  for (const char* c = signatures[static_cast<int>(format)]; *c; ++c)
+    write(*c);
+
+  write(static_cast<uint32_t>(vertex_count));
+  write(static_cast<uint32_t>(tree.vertices.size()));
+  for (const glm::vec2& vertex : tree.vertices) {
+    write_fixed(vertex.x);
+    write_fixed(vertex.y);
+  }
+  write(static_cast<uint32_t>(tree.subsectors.size()));
+  for (const woop::BspTree::Subsector& subsector : tree.subsectors)
+    write(subsector.seg_count);
+  write(static_cast<uint32_t>(tree.segs.size()));
+  for (const woop::BspTree::Seg& seg : tree.segs) {
+    write(seg.start_vertex);
+    // GL formats store the partner seg instead of the end vertex
+    write(format == woop::NodeFormat::XNOD ? seg.end_vertex : 0xffffffffu);
+    if (format == woop::NodeFormat::XGL2 || format == woop::NodeFormat::XGL3)
+      write(seg.linedef);
+    else
+      write(static_cast<uint16_t>(seg.linedef));
+    write(static_cast<uint8_t>(seg.back));
+  }
+  write(static_cast<uint32_t>(tree.nodes.size()));
+  for (const woop::BspTree::Node& node : tree.nodes) {
+    if (format == woop::NodeFormat::XGL3) {
+      write_fixed(node.partition_start.x);
+      write_fixed(node.partition_start.y);
+      write_fixed(node.partition_delta.x);
+      write_fixed(node.partition_delta.y);
+    } else {
+      write(static_cast<int16_t>(node.partition_start.x));
+      write(static_cast<int16_t>(node.partition_start.y));
+      write(static_cast<int16_t>(node.partition_delta.x));
+      write(static_cast<int16_t>(node.partition_delta.y));
+    }
+    for (int i = 0; i < 8; ++i)
+      write(int16_t{0});  // Bounding boxes
+    write(node.right_child);
+    write(node.left_child);
+  }
+  return data;
+}
+
+/**
+ * @brief Sorts each subsector's segs so that each one starts where the last
+ * one ended, like GL nodes expect. Rooms of generated maps are closed, so
+ * this doesn't need minisegs.
+ */
+void sort_around_subsectors(woop::BspTree& tree) {
+  for (const woop::BspTree::Subsector& subsector : tree.subsectors) {
+    woop::BspTree::Seg* first = tree.segs.data() + subsector.first_seg;
+    woop::BspTree::Seg* last = first + subsector.seg_count;
+    for (woop::BspTree::Seg* seg = first; seg + 1 < last; ++seg) {
+      for (woop::BspTree::Seg* next = seg + 1; next < last; ++next) {
+        if (next->start_vertex == seg->end_vertex) {
+          std::swap(*next, seg[1]);
+          break;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Expects two levels to put things in the same sectors.
+ */
+void expect_same_sectors(const woop::Level& a, const woop::Level& b) {
+  ASSERT_FALSE(a.get_things().empty());
+  for (const woop::Thing& thing : a.get_things()) {
+    EXPECT_EQ(a.get_sector_index(a.get_sector(thing.position)),
+              b.get_sector_index(b.get_sector(thing.position)));
+  }
+}
+}  // namespace
+
+TEST(NodeFormat, Signatures) {
+  auto get_format = [](const std::string& data) {
+    std::vector<std::byte> lump(data.size());
+    std::memcpy(lump.data(), data.data(), data.size());
+    return woop::get_node_format(lump);
+  };
+  EXPECT_EQ(get_format(""), woop::NodeFormat::Vanilla);
+  EXPECT_EQ(get_format("XNO"), woop::NodeFormat::Vanilla);
+  EXPECT_EQ(get_format("XNOD...."), woop::NodeFormat::XNOD);
+  EXPECT_EQ(get_format("XGLN"), woop::NodeFormat::XGLN);
+  EXPECT_EQ(get_format("XGL2"), woop::NodeFormat::XGL2);
+  EXPECT_EQ(get_format("XGL3"), woop::NodeFormat::XGL3);
+  EXPECT_EQ(get_format("ZNOD"), woop::NodeFormat::Compressed);
+  EXPECT_EQ(get_format("ZGL3"), woop::NodeFormat::Compressed);
+}
+
+TEST(NodeFormat, XNOD) {
+  GeneratedMap map = read_generated_map();
+  woop::Level vanilla(map.wad, "MAP01");
+
+  // Split the first seg at a fractional vertex, which vanilla nodes can't
+  // store
+  woop::BspTree tree = map.tree;
+  woop::BspTree::Seg seg = tree.segs.front();
+  glm::vec2 start = map.vertices[seg.start_vertex];
+  glm::vec2 split = start + (map.vertices[seg.end_vertex] - start) * 0.3f;
+  tree.vertices.push_back(split);
+  auto split_vertex = static_cast<uint32_t>(map.vertices.size());
+  tree.segs.front().end_vertex = split_vertex;
+  seg.start_vertex = split_vertex;
+  tree.segs.insert(tree.segs.begin() + 1, seg);
+  tree.subsectors.front().seg_count++;
+  for (std::size_t i = 1; i < tree.subsectors.size(); ++i)
+    tree.subsectors[i].first_seg++;
+
+  std::vector<std::byte> nodes =
+      write_extended_nodes(tree, map.vertices.size(), woop::NodeFormat::XNOD);
+  woop::Wad wad = replace_nodes(map.wad, {}, {}, nodes);
+  woop::Level level(wad, "MAP01");
+  EXPECT_FALSE(level.has_built_nodes());
+  ASSERT_EQ(level.get_subsectors().size(), vanilla.get_subsectors().size());
+  expect_same_sectors(vanilla, level);
+
+  // Both halves of the split seg are kept, and the second one's offset is
+  // measured from the start of the line
+  const woop::Subsector& subsector = level.get_subsectors().front();
+  ASSERT_EQ(subsector.segs.size(),
+            vanilla.get_subsectors().front().segs.size() + 1);
+  EXPECT_EQ(subsector.segs[0].end, split);
+  EXPECT_EQ(subsector.segs[1].start, split);
+  EXPECT_EQ(&subsector.segs[0].linedef, &subsector.segs[1].linedef);
+  EXPECT_EQ(subsector.segs[1].offset,
+            static_cast<int16_t>(glm::length(split - start)));
+  EXPECT_NEAR(subsector.segs[1].angle,
+              vanilla.get_subsectors().front().segs[0].angle, 0.1f);
+
+  // Truncated lumps are rejected
+  nodes.resize(nodes.size() - 1);
+  woop::Wad truncated = replace_nodes(map.wad, {}, {}, nodes);
+  EXPECT_THROW(woop::Level(truncated, "MAP01"), woop::LevelException);
+}
+
+TEST(NodeFormat, GLNodes) {
+  GeneratedMap map = read_generated_map();
+  woop::Level vanilla(map.wad, "MAP01");
+  woop::BspTree tree = map.tree;
+  sort_around_subsectors(tree);
+
+  for (woop::NodeFormat format : {woop::NodeFormat::XGLN,
+                                  woop::NodeFormat::XGL2,
+                                  woop::NodeFormat::XGL3}) {
+    std::vector<std::byte> subsectors =
+        write_extended_nodes(tree, map.vertices.size(), format);
+    woop::Wad wad = replace_nodes(map.wad, {}, subsectors, {});
+    woop::Level level(wad, "MAP01");
+    EXPECT_FALSE(level.has_built_nodes());
+    expect_same_sectors(vanilla, level);
+    // Segs end where the next one starts
+    for (std::size_t i = 0; i < level.get_subsectors().size(); ++i) {
+      const woop::Subsector& subsector = level.get_subsectors()[i];
+      ASSERT_EQ(subsector.segs.size(),
+                vanilla.get_subsectors()[i].segs.size());
+      for (std::size_t j = 0; j < subsector.segs.size(); ++j) {
+        EXPECT_EQ(subsector.segs[j].end,
+                  subsector.segs[(j + 1) % subsector.segs.size()].start);
+      }
+    }
+  }
+
+  // Minisegs are dropped
+  woop::BspTree minisegs = tree;
+  minisegs.segs.front().linedef = 0xffffffffu;
+  woop::Wad wad = replace_nodes(
+      map.wad, {}, {},
+      write_extended_nodes(minisegs, map.vertices.size(),
+                           woop::NodeFormat::XGL2));
+  // Written as XGL2, but found in NODES
+  woop::Level level(wad, "MAP01");
+  EXPECT_FALSE(level.has_built_nodes());
+  EXPECT_EQ(level.get_subsectors().front().segs.size(),
+            vanilla.get_subsectors().front().segs.size() - 1);
+
+  // Subsectors made only of minisegs have no sector, so the tree is rebuilt
+  for (uint32_t i = 0; i < minisegs.subsectors.front().seg_count; ++i)
+    minisegs.segs[i].linedef = 0xffffffffu;
+  wad = replace_nodes(map.wad, {},
+                      write_extended_nodes(minisegs, map.vertices.size(),
+                                           woop::NodeFormat::XGL2),
+                      {});
+  level.open(wad, "MAP01");
+  EXPECT_TRUE(level.has_built_nodes());
+  expect_same_sectors(vanilla, level);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file point_locator.cpp
+ * @authors quak
+ * @brief Tests for finding subsectors from nearby ones.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "point_locator.hpp"
+#include "generated_maps.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+woop::MapGeneratorConfig get_map_config() {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 40;
+  cfg.wall_detail = 3;
+  cfg.seed = 11;
+  return cfg;
+}
+
+/**
+ * @brief Returns random points spread over the level, and a little past it.
+ */
+std::vector<glm::vec2> get_random_points(const woop::Level& level,
+                                         std::size_t count) {
+  glm::vec2 min(0.0f);
+  glm::vec2 max(0.0f);
+  for (const woop::Linedef& line : level.get_linedefs()) {
+    min = glm::min(min, glm::min(line.start, line.end));
+    max = glm::max(max, glm::max(line.start, line.end));
+  }
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> x(min.x - 100.0f, max.x + 100.0f);
+  std::uniform_real_distribution<float> y(min.y - 100.0f, max.y + 100.0f);
+  std::vector<glm::vec2> points;
+  for (std::size_t i = 0; i < count; ++i)
+    points.push_back({x(rng), y(rng)});
+  return points;
+}
+}  // namespace
+
+TEST(PointLocator, Walk) {
+  woop::Wad wad = generate_map(get_map_config());
+  woop::Level level(wad, "MAP01");
+  const woop::PointLocator& locator = level.get_locator();
+  std::vector<glm::vec2> points = get_random_points(level, 2000);
+
+  // Walking along a path, from far away hints, and from every subsector
+  const woop::Subsector* previous = &level.get_subsector(points[0]);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    const woop::Subsector& expected = level.get_subsector(points[i]);
+    glm::vec2 step = points[i] + glm::vec2(8.0f, -5.0f);
+    EXPECT_EQ(&locator.locate(step, *previous), &level.get_subsector(step));
+    EXPECT_EQ(&locator.locate(points[i], *previous), &expected);
+    const woop::Subsector& hint =
+        level.get_subsectors()[i % level.get_subsectors().size()];
+    EXPECT_EQ(&locator.locate(points[i], hint), &expected);
+    previous = &expected;
+  }
+}
+
+TEST(PointLocator, Batch) {
+  woop::Wad wad = generate_map(get_map_config());
+  woop::Level level(wad, "MAP01");
+  std::vector<glm::vec2> points = get_random_points(level, 5000);
+  std::vector<const woop::Subsector*> out(points.size(), nullptr);
+  level.get_locator().locate(
+      woop::Span<const glm::vec2>(points.data(), points.size()),
+      woop::Span<const woop::Subsector*>(out.data(), out.size()));
+  for (std::size_t i = 0; i < points.size(); ++i)
+    EXPECT_EQ(out[i], &level.get_subsector(points[i]));
+
+  // Things are sorted with the batched search when the level opens
+  for (const woop::Thing& thing : level.get_things()) {
+    const woop::Subsector& subsector = level.get_subsector(thing.position);
+    EXPECT_NE(std::find(subsector.things.begin(), subsector.things.end(),
+                        &thing),
+              subsector.things.end());
+  }
+}
+
+TEST(PointLocator, Closed) {
+  woop::PointLocator locator;
+  EXPECT_THROW(locator.locate({0.0f, 0.0f}), woop::BSPException);
+}
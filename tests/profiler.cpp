@@ -0,0 +1,71 @@
+/**
+ * @file profiler.cpp
+ * @authors quak
+ * @brief Tests for recording and exporting profiling zones.
+ */
+
+#include "profiler.hpp"
+#include "gtest/gtest.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+/**
+ * @brief Writes a trace of the given frames, returning its contents.
+ */
+std::string get_trace(uint64_t first_frame, uint64_t last_frame) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "woop_test_trace.json";
+  woop::Profiler::write_trace(path, first_frame, last_frame);
+  std::ifstream file(path);
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  std::filesystem::remove(path);
+  return stream.str();
+}
+
+TEST(Profiler, Zones) {
+  woop::Profiler::clear();
+  woop::Profiler::next_frame();
+  uint64_t frame = woop::Profiler::get_frame();
+  {
+    woop::ProfileZone outer("outer");
+    woop::ProfileZone inner("inner \"quoted\"");
+  }
+  std::string trace = get_trace(frame, frame);
+  EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"outer\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"inner \\\"quoted\\\"\""),
+            std::string::npos);
+  // Parents are listed before their children
+  EXPECT_LT(trace.find("outer"), trace.find("inner"));
+}
+
+TEST(Profiler, FrameRange) {
+  woop::Profiler::clear();
+  woop::Profiler::next_frame();
+  uint64_t first = woop::Profiler::get_frame();
+  { woop::ProfileZone zone("first"); }
+  woop::Profiler::next_frame();
+  { woop::ProfileZone zone("second"); }
+
+  std::string trace = get_trace(first + 1, first + 1);
+  EXPECT_EQ(trace.find("\"first\""), std::string::npos);
+  EXPECT_NE(trace.find("\"second\""), std::string::npos);
+}
+
+TEST(Profiler, Threads) {
+  woop::Profiler::clear();
+  uint64_t frame = woop::Profiler::get_frame();
+  std::thread worker([]() { woop::ProfileZone zone("worker"); });
+  worker.join();
+  // Zones outlive the thread that recorded them
+  std::string trace = get_trace(frame, frame);
+  EXPECT_NE(trace.find("\"worker\""), std::string::npos);
+}
+
+TEST(Profiler, InvalidPath) {
+  EXPECT_THROW(woop::Profiler::write_trace("path/to/an/invalid/trace.json", 0,
+                                           0),
+               woop::ProfilerException);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file pvs.cpp
+ * @authors quak
+ * @brief Tests for computing and caching potentially visible sets.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "pvs.hpp"
+#include "generated_maps.hpp"
+#include "thread_pool.hpp"
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <random>
+
+namespace {
+woop::MapGeneratorConfig get_map_config(unsigned sectors, float room_density) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = sectors;
+  cfg.room_density = room_density;
+  cfg.wall_detail = 2;
+  cfg.seed = 7;
+  return cfg;
+}
+
+/**
+ * @brief Returns true if a line segment crosses a one-sided linedef.
+ */
+bool is_sight_blocked(const woop::Level& level,
+                      const glm::vec2& from,
+                      const glm::vec2& to) {
+  for (const woop::Linedef& line : level.get_linedefs()) {
+    if (!line.back && get_line_crossing(line, from, to))
+      return true;
+  }
+  return false;
+}
+}  // namespace
+
+TEST(Pvs, SolidRooms) {
+  woop::Wad wad = generate_map(get_map_config(9, 1.0f));
+  woop::Level level(wad, "MAP01");
+  woop::ThreadPool pool;
+  woop::Pvs pvs = woop::Pvs::compute(level, pool);
+  ASSERT_FALSE(pvs.is_empty());
+  EXPECT_EQ(pvs.get_stats().portals, 0u);
+
+  // Rooms are closed off, so each only sees itself
+  std::size_t count = level.get_subsectors().size();
+  for (std::size_t a = 0; a < count; ++a) {
+    for (std::size_t b = 0; b < count; ++b)
+      EXPECT_EQ(pvs.is_visible(a, b), a == b);
+  }
+  // Nodes are visible if any subsector below them is
+  const woop::Node& root = level.get_root_node();
+  EXPECT_TRUE(pvs.is_node_visible(0, level.get_node_index(root)));
+}
+
+TEST(Pvs, Conservative) {
+  woop::Wad wad = generate_map(get_map_config(36, 0.5f));
+  woop::Level level(wad, "MAP01");
+  woop::ThreadPool pool;
+  woop::Pvs pvs = woop::Pvs::compute(level, pool);
+  std::size_t count = level.get_subsectors().size();
+  EXPECT_GT(pvs.get_stats().portals, 0u);
+  // Some rooms are hidden from others
+  EXPECT_LT(pvs.get_stats().average_visible, static_cast<double>(count));
+
+  // Every pair of points with a clear line of sight must be in the set
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> coordinate(-760.0f, 760.0f);
+  unsigned visible_pairs = 0;
+  for (int i = 0; i < 2000; ++i) {
+    glm::vec2 from = {coordinate(rng), coordinate(rng)};
+    glm::vec2 to = {coordinate(rng), coordinate(rng)};
+    if (is_sight_blocked(level, from, to))
+      continue;
+    ++visible_pairs;
+    std::size_t a = level.get_subsector_index(level.get_subsector(from));
+    std::size_t b = level.get_subsector_index(level.get_subsector(to));
+    EXPECT_TRUE(pvs.is_visible(a, b)) << a << " -> " << b;
+    EXPECT_TRUE(pvs.is_visible(b, a)) << b << " -> " << a;
+  }
+  EXPECT_GT(visible_pairs, 100u);
+}
+
+TEST(Pvs, Cache) {
+  woop::Wad wad = generate_map(get_map_config(16, 0.5f));
+  woop::Level level(wad, "MAP01");
+  woop::ThreadPool pool(0);
+  woop::Pvs pvs = woop::Pvs::compute(level, pool);
+
+  std::filesystem::path cache =
+      std::filesystem::temp_directory_path() / "woop_pvs_test";
+  std::filesystem::remove_all(cache);
+  EXPECT_FALSE(woop::Pvs::load(cache, level).has_value());
+  ASSERT_TRUE(pvs.save(cache, level));
+  std::optional<woop::Pvs> loaded = woop::Pvs::load(cache, level);
+  ASSERT_TRUE(loaded.has_value());
+  std::size_t count = level.get_subsectors().size();
+  for (std::size_t a = 0; a < count; ++a) {
+    for (std::size_t b = 0; b < count; ++b)
+      EXPECT_EQ(loaded->is_visible(a, b), pvs.is_visible(a, b));
+  }
+
+  // Sets aren't loaded for other geometry
+  woop::Wad other_wad = generate_map(get_map_config(17, 0.5f));
+  woop::Level other(other_wad, "MAP01");
+  EXPECT_FALSE(woop::Pvs::load(cache, other).has_value());
+  std::filesystem::remove_all(cache);
+}
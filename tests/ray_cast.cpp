@@ -0,0 +1,171 @@
+/**
+ * @file ray_cast.cpp
+ * @authors quak
+ * @brief Tests for tracing rays and lines of sight through levels.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "ray_cast.hpp"
+#include "generated_maps.hpp"
+#include "thread_pool.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+/**
+ * @brief Returns the fraction along a ray where it first crosses a line that
+ * blocks it, or 1 if none do. Every line in the level is tested.
+ */
+float get_first_blocking_line(const woop::Level& level, const woop::Ray& ray) {
+  float first = 1.0f;
+  for (const woop::Linedef& line : level.get_linedefs()) {
+    std::optional<float> crossing = get_line_crossing(line, ray.start, ray.end);
+    if (!crossing || *crossing > first)
+      continue;
+    float t = *crossing;
+    if (line.front && line.back) {
+      const woop::Sector& front = line.front->sector_facing;
+      const woop::Sector& back = line.back->sector_facing;
+      float z = ray.start_z + (ray.end_z - ray.start_z) * t;
+      if (z <= std::min(front.ceiling.height, back.ceiling.height) &&
+          z >= std::max(front.floor.height, back.floor.height))
+        continue;
+    }
+    first = t;
+  }
+  return first;
+}
+}  // namespace
+
+TEST(RayCaster, Walls) {
+  woop::Wad wad = generate_rooms(true);
+  woop::Level level(wad, "MAP01");
+  woop::RayCaster caster(level);
+  const woop::Sector& sector = level.get_sector({-128.0f, 0.0f});
+  float z = (sector.floor.height + sector.ceiling.height) / 2.0f;
+
+  // Rays inside a room don't hit anything
+  woop::RayHit hit = caster.cast({{-200.0f, -50.0f}, {-50.0f, 50.0f}, z, z});
+  EXPECT_FALSE(hit.is_hit());
+  EXPECT_EQ(hit.fraction, 1.0f);
+
+  // The wall between the rooms stops rays crossing it
+  hit = caster.cast({{-128.0f, 0.0f}, {128.0f, 0.0f}, z, z});
+  ASSERT_EQ(hit.surface, woop::RayHit::Surface::Wall);
+  EXPECT_NEAR(hit.fraction, 0.5f, 0.001f);
+  EXPECT_NEAR(hit.position.x, 0.0f, 0.1f);
+  ASSERT_NE(hit.seg, nullptr);
+  EXPECT_EQ(hit.seg->linedef.back, nullptr);
+  EXPECT_EQ(hit.subsector, &level.get_subsector({-128.0f, 0.0f}));
+  EXPECT_FALSE(caster.has_line_of_sight({-128.0f, 0.0f}, z, {128.0f, 0.0f}, z));
+
+  // So do the outer walls
+  hit = caster.cast({{-128.0f, 0.0f}, {-128.0f, 1000.0f}, z, z});
+  EXPECT_EQ(hit.surface, woop::RayHit::Surface::Wall);
+  EXPECT_NEAR(hit.position.y, 128.0f, 0.1f);
+}
+
+TEST(RayCaster, Openings) {
+  woop::Wad wad = generate_rooms(false);
+  woop::Level level(wad, "MAP01");
+  woop::RayCaster caster(level);
+  const woop::Sector& left = level.get_sector({-128.0f, 0.0f});
+  const woop::Sector& right = level.get_sector({128.0f, 0.0f});
+  float top = std::min(left.ceiling.height, right.ceiling.height);
+  float bottom = std::max(left.floor.height, right.floor.height);
+  ASSERT_LT(bottom, top);
+
+  // Through the opening between the rooms
+  float z = (top + bottom) / 2.0f;
+  EXPECT_FALSE(caster.cast({{-128.0f, 0.0f}, {128.0f, 0.0f}, z, z}).is_hit());
+  EXPECT_TRUE(caster.has_line_of_sight({-128.0f, 0.0f}, z, {128.0f, 0.0f}, z));
+
+  // Above and below it, if the rooms leave any wall there
+  if (top < left.ceiling.height) {
+    float high = (top + left.ceiling.height) / 2.0f;
+    woop::RayHit hit =
+        caster.cast({{-128.0f, 0.0f}, {128.0f, 0.0f}, high, high});
+    EXPECT_EQ(hit.surface, woop::RayHit::Surface::Upper);
+    EXPECT_NEAR(hit.position.x, 0.0f, 0.1f);
+  }
+  if (bottom > left.floor.height) {
+    float low = (bottom + left.floor.height) / 2.0f;
+    woop::RayHit hit = caster.cast({{-128.0f, 0.0f}, {128.0f, 0.0f}, low, low});
+    EXPECT_EQ(hit.surface, woop::RayHit::Surface::Lower);
+  }
+
+  // Rays heading down stop at the floor
+  woop::RayHit hit = caster.cast(
+      {{-200.0f, 0.0f}, {-100.0f, 0.0f}, left.floor.height + 10.0f,
+       left.floor.height - 10.0f});
+  EXPECT_EQ(hit.surface, woop::RayHit::Surface::Floor);
+  EXPECT_NEAR(hit.position.x, -150.0f, 0.1f);
+  EXPECT_NEAR(hit.z, left.floor.height, 0.01f);
+
+  // REJECT tables hide sectors without tracing
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 2;
+  cfg.room_density = 0.0f;
+  woop::WadBuilder builder;
+  woop::MapGenerator(cfg).generate(builder, "MAP01");
+  builder.add_lump("REJECT", std::vector<uint8_t>{0x06});
+  woop::Wad rejected = builder.build();
+  woop::Level hidden(rejected, "MAP01");
+  EXPECT_FALSE(woop::RayCaster(hidden).has_line_of_sight(
+      {-128.0f, 0.0f}, z, {128.0f, 0.0f}, z));
+}
+
+TEST(RayCaster, Batch) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 30;
+  cfg.wall_detail = 2;
+  cfg.thing_count = 40;
+  woop::Wad wad = generate_map(cfg);
+  woop::Level level(wad, "MAP01");
+  woop::RayCaster caster(level);
+
+  // Rays between random things' positions
+  std::vector<woop::Ray> rays;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> offset(-100.0f, 100.0f);
+  const std::vector<woop::Thing>& things = level.get_things();
+  for (std::size_t i = 0; i < 500; ++i) {
+    const woop::Thing& from = things[rng() % things.size()];
+    const woop::Thing& to = things[rng() % things.size()];
+    float from_z = level.get_sector(from.position).floor.height + 40.0f;
+    float to_z = level.get_sector(to.position).floor.height + 40.0f;
+    rays.push_back({from.position + glm::vec2(offset(rng), offset(rng)),
+                    to.position, from_z, to_z});
+  }
+  std::vector<woop::RayHit> serial(rays.size());
+  std::vector<woop::RayHit> parallel(rays.size());
+  woop::ThreadPool pool(3);
+  caster.cast(woop::Span<const woop::Ray>(rays.data(), rays.size()),
+              woop::Span<woop::RayHit>(serial.data(), serial.size()));
+  caster.cast(woop::Span<const woop::Ray>(rays.data(), rays.size()),
+              woop::Span<woop::RayHit>(parallel.data(), parallel.size()),
+              pool);
+  std::size_t hits = 0;
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    woop::RayHit single = caster.cast(rays[i]);
+    EXPECT_EQ(serial[i].surface, single.surface);
+    EXPECT_EQ(serial[i].fraction, single.fraction);
+    EXPECT_EQ(parallel[i].surface, single.surface);
+    EXPECT_EQ(parallel[i].seg, single.seg);
+    hits += single.is_hit() ? 1 : 0;
+    // Walls are the first blocking lines along the ray, found by testing
+    // every line. Floors and ceilings come before any of them.
+    float wall = get_first_blocking_line(level, rays[i]);
+    if (single.surface == woop::RayHit::Surface::None)
+      EXPECT_EQ(wall, 1.0f);
+    else if (single.surface == woop::RayHit::Surface::Floor ||
+             single.surface == woop::RayHit::Surface::Ceiling)
+      EXPECT_GE(wall, single.fraction - 0.001f);
+    else
+      EXPECT_NEAR(wall, single.fraction, 0.001f);
+  }
+  // A mix of clear and blocked rays
+  EXPECT_GT(hits, 0u);
+  EXPECT_LT(hits, rays.size());
+}
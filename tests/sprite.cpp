@@ -0,0 +1,161 @@
+/**
+ * @file sprite.cpp
+ * @authors quak
+ * @brief Tests for decoding patches and indexing sprites.
+ * @note Sprites are built in memory, so these don't require any external wads.
+ */
+
+#include "sprite.hpp"
+#include "wad_builder.hpp"
+#include "gtest/gtest.h"
+
+/**
+ * @brief A run of opaque texels in a patch column.
+ */
+struct Post {
+  uint8_t top;
+  std::vector<uint8_t> texels;
+};
+
+/**
+ * @brief Encodes a patch in Doom's picture format.
+ */
+std::vector<std::byte> make_patch(int16_t width,
+                                  int16_t height,
+                                  int16_t left_offset,
+                                  int16_t top_offset,
+                                  const std::vector<std::vector<Post>>& columns) {
+  std::vector<uint8_t> data;
+  auto push_int = [&](auto value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+  };
+  push_int(width);
+  push_int(height);
+  push_int(left_offset);
+  push_int(top_offset);
+
+  std::size_t offsets_start = data.size();
+  data.resize(data.size() + columns.size() * sizeof(int32_t));
+  for (std::size_t x = 0; x < columns.size(); ++x) {
+    int32_t offset = static_cast<int32_t>(data.size());
+    std::memcpy(data.data() + offsets_start + x * sizeof(int32_t), &offset,
+                sizeof(offset));
+    for (const auto& post : columns[x]) {
+      data.push_back(post.top);
+      data.push_back(static_cast<uint8_t>(post.texels.size()));
+      data.push_back(0);
+      data.insert(data.end(), post.texels.begin(), post.texels.end());
+      data.push_back(0);
+    }
+    data.push_back(0xff);
+  }
+
+  std::vector<std::byte> out(data.size());
+  std::memcpy(out.data(), data.data(), data.size());
+  return out;
+}
+
+/**
+ * @brief Returns a 1x1 opaque patch.
+ */
+std::vector<std::byte> make_pixel() {
+  return make_patch(1, 1, 0, 0, {{Post{0, {1}}}});
+}
+
+TEST(Patch, Decode) {
+  woop::Lump lump{"TROOA1", make_patch(2, 4, 1, 3,
+                                       {
+                                           {Post{0, {5, 6}}},
+                                           {Post{1, {7}}, Post{3, {8}}},
+                                       })};
+  woop::Patch patch(lump);
+  EXPECT_EQ(patch.get_name(), "TROOA1");
+  EXPECT_EQ(patch.get_width(), 2);
+  EXPECT_EQ(patch.get_height(), 4);
+  EXPECT_EQ(patch.get_left_offset(), 1);
+  EXPECT_EQ(patch.get_top_offset(), 3);
+
+  EXPECT_EQ(patch.get_texel(0, 0), 5);
+  EXPECT_EQ(patch.get_texel(0, 1), 6);
+  EXPECT_EQ(patch.get_texel(0, 2), woop::Patch::transparent);
+  EXPECT_EQ(patch.get_texel(0, 3), woop::Patch::transparent);
+  EXPECT_EQ(patch.get_texel(1, 0), woop::Patch::transparent);
+  EXPECT_EQ(patch.get_texel(1, 1), 7);
+  EXPECT_EQ(patch.get_texel(1, 2), woop::Patch::transparent);
+  EXPECT_EQ(patch.get_texel(1, 3), 8);
+}
+
+TEST(Patch, Invalid) {
+  // Missing header
+  EXPECT_THROW(woop::Patch(woop::Lump{"BAD", std::vector<std::byte>(4)}),
+               woop::SpriteException);
+  // Missing column offsets
+  {
+    std::vector<std::byte> data = make_pixel();
+    data.resize(10);
+    EXPECT_THROW(woop::Patch(woop::Lump{"BAD", data}), woop::SpriteException);
+  }
+  // Unterminated column
+  {
+    std::vector<std::byte> data = make_pixel();
+    data.pop_back();
+    EXPECT_THROW(woop::Patch(woop::Lump{"BAD", data}), woop::SpriteException);
+  }
+  // Invalid size
+  EXPECT_THROW(woop::Patch(woop::Lump{"BAD", make_patch(0, 1, 0, 0, {})}),
+               woop::SpriteException);
+}
+
+TEST(SpriteSet, Frames) {
+  woop::WadBuilder builder;
+  builder.add_lump("TROOC0", make_pixel())
+      .add_lump("S_START")
+      .add_lump("TROOA1", make_pixel())
+      .add_lump("TROOA2A8", make_pixel())
+      .add_lump("TROOB0", make_pixel())
+      .add_lump("S_END");
+  woop::Wad wad = builder.build();
+  woop::SpriteSet sprites(wad);
+  EXPECT_EQ(sprites.get_num_patches(), 3);
+
+  // Rotations
+  const woop::SpriteFrame* frame = sprites.get_frame("TROO", 'A');
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(frame->sprite, "TROO");
+  EXPECT_EQ(frame->patches[0]->get_name(), "TROOA1");
+  EXPECT_FALSE(frame->flipped[0]);
+  EXPECT_EQ(frame->patches[1]->get_name(), "TROOA2A8");
+  EXPECT_FALSE(frame->flipped[1]);
+  EXPECT_EQ(frame->patches[7], frame->patches[1]);
+  EXPECT_TRUE(frame->flipped[7]);
+  EXPECT_EQ(frame->patches[2], nullptr);
+
+  // A single rotation is used for every angle
+  frame = sprites.get_frame("TROO", 'B');
+  ASSERT_NE(frame, nullptr);
+  for (const woop::Patch* patch : frame->patches)
+    EXPECT_EQ(patch->get_name(), "TROOB0");
+
+  // Lumps outside of the sprite namespace are ignored
+  EXPECT_EQ(sprites.get_frame("TROO", 'C'), nullptr);
+}
+
+TEST(SpriteSet, Empty) {
+  woop::WadBuilder builder;
+  builder.add_lump("TROOA0", make_pixel());
+  woop::SpriteSet sprites(builder.build());
+  EXPECT_EQ(sprites.get_num_patches(), 0);
+  EXPECT_EQ(sprites.get_frame("TROO", 'A'), nullptr);
+}
+
+TEST(SpriteSet, ThingSprites) {
+  const woop::ThingSprite* imp = woop::SpriteSet::get_thing_sprite(3001);
+  ASSERT_NE(imp, nullptr);
+  EXPECT_STREQ(imp->sprite, "TROO");
+  EXPECT_EQ(imp->frame, 'A');
+  EXPECT_FALSE(imp->hanging);
+  EXPECT_TRUE(woop::SpriteSet::get_thing_sprite(63)->hanging);
+  // Player starts are never drawn
+  EXPECT_EQ(woop::SpriteSet::get_thing_sprite(1), nullptr);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file spsc_queue.cpp
+ * @authors quak
+ * @brief Tests for the single-producer, single-consumer queue.
+ */
+
+#include "spsc_queue.hpp"
+#include "gtest/gtest.h"
+#include <thread>
+
+TEST(SpscQueue, Bounded) {
+  woop::SpscQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 3u);
+  EXPECT_TRUE(queue.empty());
+
+  int value = 0;
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_TRUE(queue.push(3));
+  EXPECT_FALSE(queue.push(4));
+
+  // Values come out in order, wrapping around the buffer
+  for (int i = 1; i <= 10; ++i) {
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+    EXPECT_TRUE(queue.push(i + 3));
+  }
+}
+
+TEST(SpscQueue, Threads) {
+  constexpr int count = 100'000;
+  woop::SpscQueue<int> queue(16);
+  std::thread producer([&]() {
+    for (int i = 0; i < count; ++i) {
+      while (!queue.push(i))
+        std::this_thread::yield();
+    }
+  });
+  int expected = 0;
+  while (expected < count) {
+    int value = 0;
+    if (queue.pop(value)) {
+      EXPECT_EQ(value, expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,139 @@
+/**
+ * @file task_graph.cpp
+ * @authors quak
+ * @brief Tests for running dependent tasks on a thread pool, and for loading
+ * levels with them.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "task_graph.hpp"
+#include "generated_maps.hpp"
+#include "thread_pool.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(TaskGraph, Dependencies) {
+  // Diamond: b and c depend on a, and d depends on both
+  for (unsigned workers : {0u, 3u}) {
+    woop::ThreadPool pool(workers);
+    woop::TaskGraph graph;
+    std::mutex mutex;
+    std::vector<char> order;
+    auto record = [&](char task) {
+      return [&, task]() {
+        std::lock_guard lock(mutex);
+        order.push_back(task);
+      };
+    };
+    auto a = graph.add_task("a", record('a'));
+    auto b = graph.add_task("b", record('b'), {a});
+    auto c = graph.add_task("c", record('c'), {a});
+    graph.add_task("d", record('d'), {b, c});
+    // Graphs can be run more than once
+    for (int run = 0; run < 3; ++run) {
+      order.clear();
+      graph.run(pool);
+      ASSERT_EQ(order.size(), 4);
+      EXPECT_EQ(order.front(), 'a');
+      EXPECT_EQ(order.back(), 'd');
+    }
+
+    const auto& timings = graph.get_timings();
+    ASSERT_EQ(timings.size(), 4);
+    EXPECT_STREQ(timings[3].name, "d");
+    EXPECT_GE(timings[3].start_ms,
+              timings[1].start_ms + timings[1].duration_ms);
+  }
+
+  // Tasks can't depend on themselves or later tasks
+  woop::TaskGraph graph;
+  auto a = graph.add_task("a", []() {});
+  EXPECT_THROW(graph.add_task("b", []() {}, {a + 1}),
+               woop::TaskGraphException);
+  EXPECT_EQ(graph.get_task_count(), 1);
+}
+
+TEST(TaskGraph, Parallel) {
+  // Independent tasks overlap
+  woop::ThreadPool pool(3);
+  woop::TaskGraph graph;
+  std::atomic<int> running{0};
+  std::atomic<int> most_running{0};
+  for (int i = 0; i < 4; ++i) {
+    graph.add_task("sleep", [&]() {
+      int now = ++running;
+      int most = most_running;
+      while (now > most && !most_running.compare_exchange_weak(most, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      --running;
+    });
+  }
+  graph.run(pool);
+  EXPECT_GT(most_running, 1);
+}
+
+TEST(TaskGraph, Exceptions) {
+  woop::ThreadPool pool(2);
+  woop::TaskGraph graph;
+  bool skipped = true;
+  auto a = graph.add_task("a", []() { throw std::runtime_error("a"); });
+  graph.add_task("b", [&]() { skipped = false; }, {a});
+  EXPECT_THROW(graph.run(pool), std::runtime_error);
+  EXPECT_TRUE(skipped);
+  EXPECT_EQ(graph.get_timings()[1].duration_ms, 0.0);
+}
+
+TEST(TaskGraph, Level) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 200;
+  cfg.wall_detail = 3;
+  cfg.thing_count = 100;
+  woop::Wad wad = generate_map(cfg);
+
+  woop::LevelConfig serial_cfg;
+  serial_cfg.parallel_load = false;
+  woop::Level serial(wad, "MAP01", serial_cfg);
+  woop::Level parallel(wad, "MAP01");
+
+  // Loading in parallel gives the same level
+  EXPECT_EQ(parallel.get_checksum(), serial.get_checksum());
+  ASSERT_EQ(parallel.get_sectors().size(), serial.get_sectors().size());
+  for (std::size_t i = 0; i < serial.get_sectors().size(); ++i) {
+    EXPECT_EQ(parallel.get_sectors()[i].lines.size(),
+              serial.get_sectors()[i].lines.size());
+    EXPECT_EQ(parallel.get_sectors()[i].neighbors.size(),
+              serial.get_sectors()[i].neighbors.size());
+  }
+  EXPECT_EQ(parallel.get_subsectors().size(), serial.get_subsectors().size());
+  ASSERT_EQ(parallel.get_things().size(), serial.get_things().size());
+  for (const woop::Thing& thing : serial.get_things()) {
+    EXPECT_EQ(serial.get_sector_index(serial.get_sector(thing.position)),
+              parallel.get_sector_index(parallel.get_sector(thing.position)));
+  }
+
+  // Every stage is timed
+  const auto& timings = parallel.get_load_timings();
+  ASSERT_FALSE(timings.empty());
+  bool found_nodes = false;
+  for (const woop::TaskTiming& timing : timings) {
+    EXPECT_GE(timing.duration_ms, 0.0);
+    found_nodes = found_nodes || std::strcmp(timing.name, "nodes") == 0;
+  }
+  EXPECT_TRUE(found_nodes);
+
+  // Errors in any stage are reported
+  woop::WadBuilder broken;
+  for (const woop::Lump& lump : wad) {
+    broken.add_lump(lump.name, lump.name == "SSECTORS"
+                                   ? std::vector<std::byte>(3)
+                                   : lump.data);
+  }
+  EXPECT_THROW(woop::Level(broken.build(), "MAP01"), woop::LevelException);
+}
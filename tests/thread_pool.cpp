@@ -0,0 +1,57 @@
+/**
+ * @file thread_pool.cpp
+ * @authors quak
+ * @brief Tests for running parallel loops on a thread pool.
+ */
+
+#include "thread_pool.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPool, ParallelFor) {
+  woop::ThreadPool pool(3);
+  EXPECT_EQ(pool.get_worker_count(), 3u);
+  std::vector<int> values(1000, 0);
+  // Loops can be run more than once
+  for (int run = 0; run < 10; ++run) {
+    pool.parallel_for(values.size(), [&](std::size_t i) { ++values[i]; });
+  }
+  for (int value : values)
+    EXPECT_EQ(value, 10);
+}
+
+TEST(ThreadPool, Serial) {
+  // Without workers, loops run in order on the calling thread
+  woop::ThreadPool pool(0);
+  std::vector<std::size_t> order;
+  pool.parallel_for(5, [&](std::size_t i) { order.push_back(i); });
+  EXPECT_EQ(order, (std::vector<std::size_t>{0, 1, 2, 3, 4}));
+}
+
+TEST(ThreadPool, Nested) {
+  woop::ThreadPool pool(2);
+  std::atomic<int> count{0};
+  pool.parallel_for(4, [&](std::size_t) {
+    pool.parallel_for(4, [&](std::size_t) { ++count; });
+  });
+  EXPECT_EQ(count, 16);
+}
+
+TEST(ThreadPool, Exceptions) {
+  woop::ThreadPool pool(2);
+  std::atomic<int> count{0};
+  EXPECT_THROW(pool.parallel_for(100,
+                                 [&](std::size_t i) {
+                                   ++count;
+                                   if (i == 50)
+                                     throw std::runtime_error("job failed");
+                                 }),
+               std::runtime_error);
+  // Every job still runs
+  EXPECT_EQ(count, 100);
+  // The pool is usable afterwards
+  pool.parallel_for(10, [&](std::size_t) { ++count; });
+  EXPECT_EQ(count, 110);
+}
@@ -0,0 +1,192 @@
+/**
+ * @file udmf.cpp
+ * @authors quak
+ * @brief Tests for reading levels stored in the Universal Doom Map Format.
+ * @note These use generated maps, and don't require any external wads.
+ */
+
+#include "udmf.hpp"
+#include "generated_maps.hpp"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * @brief Returns the configuration of the same map in the given format.
+ */
+woop::MapGeneratorConfig get_map_config(woop::MapFormat format) {
+  woop::MapGeneratorConfig cfg;
+  cfg.sector_count = 30;
+  cfg.wall_detail = 2;
+  cfg.thing_count = 20;
+  cfg.format = format;
+  return cfg;
+}
+
+/**
+ * @brief Wraps a TEXTMAP in a wad, and opens it as a level.
+ */
+woop::Level open_textmap(const std::string& text) {
+  std::vector<std::byte> data(text.size());
+  for (std::size_t i = 0; i < text.size(); ++i)
+    data[i] = static_cast<std::byte>(text[i]);
+  woop::WadBuilder builder;
+  builder.add_lump("MAP01").add_lump("TEXTMAP", data).add_lump("ENDMAP");
+  return woop::Level(builder.build(), "MAP01");
+}
+}  // namespace
+
+TEST(Udmf, Tokenizer) {
+  woop::UdmfTokenizer tokenizer(
+      "thing // Comment\n"
+      "{ x = -0x1F; y = 1.5e2; /* Multi-line\n comment */ s = \"a\\\"b\"; }");
+  using Type = woop::UdmfToken::Type;
+  const std::pair<Type, std::string> expected[] = {
+      {Type::Identifier, "thing"}, {Type::Symbol, "{"},
+      {Type::Identifier, "x"},     {Type::Symbol, "="},
+      {Type::Integer, "-0x1F"},    {Type::Symbol, ";"},
+      {Type::Identifier, "y"},     {Type::Symbol, "="},
+      {Type::Float, "1.5e2"},      {Type::Symbol, ";"},
+      {Type::Identifier, "s"},     {Type::Symbol, "="},
+      {Type::String, "a\\\"b"},    {Type::Symbol, ";"},
+      {Type::Symbol, "}"},
+  };
+  for (const auto& [type, text] : expected) {
+    woop::UdmfToken token = tokenizer.next();
+    EXPECT_EQ(token.type, type);
+    EXPECT_EQ(token.text, text);
+  }
+  woop::UdmfToken end = tokenizer.next();
+  EXPECT_EQ(end.type, Type::End);
+  EXPECT_EQ(end.line, 3);
+
+  // Errors name the line they're on
+  woop::UdmfTokenizer unterminated("x = 1;\n\"text");
+  unterminated.next();
+  unterminated.next();
+  unterminated.next();
+  unterminated.next();
+  try {
+    unterminated.next();
+    FAIL() << "Unterminated string was read";
+  } catch (const woop::LevelException& exception) {
+    EXPECT_NE(std::string(exception.what()).find("line 2"),
+              std::string::npos);
+  }
+  EXPECT_THROW(woop::UdmfTokenizer("/* x").next(), woop::LevelException);
+  EXPECT_THROW(woop::UdmfTokenizer("#").next(), woop::LevelException);
+}
+
+TEST(Udmf, Parse) {
+  woop::UdmfMap map = woop::parse_udmf(
+      "Namespace = \"doom\";\n"
+      "vertex { x = 0; y = 0.5; }\n"
+      "vertex { X = 64; Y = 0; }\n"
+      "linedef { v1 = 0; v2 = 1; sidefront = 0; blocking = true;\n"
+      "          dontdraw = true; secret = false; special = 1; }\n"
+      "sidedef { sector = 0; texturemiddle = \"STARTAN3\"; }\n"
+      "sector { texturefloor = \"FLAT14\"; textureceiling = \"CEIL3_5\";\n"
+      "         heightceiling = 128; }\n"
+      "thing { x = 32; y = 16; type = 1; skill2 = true; skill4 = true;\n"
+      "        single = true; }\n"
+      "thing { x = 8; y = 8; type = 3004; ambush = true; }\n"
+      "unknown { field = 1; }\n");
+  EXPECT_EQ(map.name_space, "doom");
+  ASSERT_EQ(map.vertices.size(), 2);
+  EXPECT_EQ(map.vertices[0], glm::vec2(0.0f, 0.5f));
+  EXPECT_EQ(map.vertices[1], glm::vec2(64.0f, 0.0f));
+
+  // Missing fields take their default values, and flags use the binary bits
+  ASSERT_EQ(map.linedefs.size(), 1);
+  EXPECT_EQ(map.linedefs[0].flags, 0x0081);
+  EXPECT_EQ(map.linedefs[0].back_sidedef, -1);
+  ASSERT_EQ(map.sidedefs.size(), 1);
+  EXPECT_EQ(map.sidedefs[0].middle_name, "STARTAN3");
+  EXPECT_EQ(map.sidedefs[0].upper_name, "-");
+  ASSERT_EQ(map.sectors.size(), 1);
+  EXPECT_EQ(map.sectors[0].floor_height, 0);
+  EXPECT_EQ(map.sectors[0].ceiling_height, 128);
+  EXPECT_EQ(map.sectors[0].light_level, 160);
+  ASSERT_EQ(map.things.size(), 2);
+  EXPECT_EQ(map.things[0].flags, 0x0005);
+  EXPECT_EQ(map.things[1].flags, 0x0018);
+
+  // Blocks missing a required field, and malformed values, are rejected
+  EXPECT_THROW(woop::parse_udmf("vertex { x = 0; }"), woop::LevelException);
+  EXPECT_THROW(woop::parse_udmf("vertex { x = 0; y = \"0\"; }"),
+               woop::LevelException);
+  EXPECT_THROW(woop::parse_udmf("vertex { x = 0; y = 09; }"),
+               woop::LevelException);
+  EXPECT_THROW(woop::parse_udmf("vertex { x = 0 y = 0; }"),
+               woop::LevelException);
+  EXPECT_THROW(woop::parse_udmf("vertex { x = 0; y = 0;"),
+               woop::LevelException);
+}
+
+TEST(Udmf, Level) {
+  woop::Wad binary_wad = generate_map(get_map_config(woop::MapFormat::Doom));
+  woop::Wad udmf_wad = generate_map(get_map_config(woop::MapFormat::Udmf));
+  EXPECT_NO_THROW(udmf_wad.get_lump("MAP01", "TEXTMAP"));
+  woop::Level binary(binary_wad, "MAP01");
+  woop::Level udmf(udmf_wad, "MAP01");
+  EXPECT_FALSE(udmf.has_built_nodes());
+
+  // Both formats describe the same level
+  ASSERT_EQ(udmf.get_sectors().size(), binary.get_sectors().size());
+  for (std::size_t i = 0; i < udmf.get_sectors().size(); ++i) {
+    const woop::Sector& a = binary.get_sectors()[i];
+    const woop::Sector& b = udmf.get_sectors()[i];
+    EXPECT_EQ(a.floor.height, b.floor.height);
+    EXPECT_EQ(a.ceiling.texture, b.ceiling.texture);
+    EXPECT_EQ(a.light_level, b.light_level);
+    EXPECT_EQ(a.lines.size(), b.lines.size());
+    EXPECT_EQ(a.neighbors.size(), b.neighbors.size());
+  }
+  ASSERT_EQ(udmf.get_linedefs().size(), binary.get_linedefs().size());
+  for (std::size_t i = 0; i < udmf.get_linedefs().size(); ++i) {
+    const woop::Linedef& a = binary.get_linedefs()[i];
+    const woop::Linedef& b = udmf.get_linedefs()[i];
+    EXPECT_EQ(a.start, b.start);
+    EXPECT_EQ(a.end, b.end);
+    EXPECT_EQ(a.flags, b.flags);
+    EXPECT_EQ(a.back == nullptr, b.back == nullptr);
+    EXPECT_EQ(a.front->middle_name, b.front->middle_name);
+  }
+  ASSERT_EQ(udmf.get_subsectors().size(), binary.get_subsectors().size());
+  for (std::size_t i = 0; i < udmf.get_subsectors().size(); ++i) {
+    EXPECT_EQ(udmf.get_subsectors()[i].segs.size(),
+              binary.get_subsectors()[i].segs.size());
+  }
+  ASSERT_EQ(udmf.get_things().size(), binary.get_things().size());
+  for (std::size_t i = 0; i < udmf.get_things().size(); ++i) {
+    const woop::Thing& a = binary.get_things()[i];
+    const woop::Thing& b = udmf.get_things()[i];
+    EXPECT_EQ(a.position, b.position);
+    EXPECT_EQ(a.angle, b.angle);
+    EXPECT_EQ(a.flags, b.flags);
+    EXPECT_EQ(binary.get_sector_index(binary.get_sector(a.position)),
+              udmf.get_sector_index(udmf.get_sector(b.position)));
+  }
+
+  // Levels without ZNODES get a new tree
+  woop::Level built = open_textmap(
+      "namespace = \"doom\";\n"
+      "vertex { x = 0; y = 0; } vertex { x = 0; y = 64; }\n"
+      "vertex { x = 64; y = 64; } vertex { x = 64; y = 0; }\n"
+      "linedef { v1 = 0; v2 = 1; sidefront = 0; }\n"
+      "linedef { v1 = 1; v2 = 2; sidefront = 0; }\n"
+      "linedef { v1 = 2; v2 = 3; sidefront = 0; }\n"
+      "linedef { v1 = 3; v2 = 0; sidefront = 0; }\n"
+      "sidedef { sector = 0; }\n"
+      "sector { texturefloor = \"FLAT14\"; textureceiling = \"CEIL3_5\"; }\n"
+      "thing { x = 32; y = 32; type = 1; }\n");
+  EXPECT_TRUE(built.has_built_nodes());
+  EXPECT_EQ(built.get_sector_index(built.get_sector({32.0f, 32.0f})), 0);
+  EXPECT_EQ(built.get_sectors()[0].lines.size(), 4);
+
+  // Records referring to missing ones are rejected
+  EXPECT_THROW(open_textmap("vertex { x = 0; y = 0; }\n"
+                            "linedef { v1 = 0; v2 = 1; sidefront = 0; }\n"),
+               woop::LevelException);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file pvs.cpp
+ * @authors quak
+ * @brief Computes the potentially visible sets of a wad's levels ahead of
+ * time, and writes them to a level cache that the engine reads them from.
+ *
+ * Usage: woop_pvs <wad> <cache directory> [levels...]
+ * Every level in the wad is processed if none are given.
+ */
+
+#include "level.hpp"       /* woop::Level */
+#include "log.hpp"         /* woop::log, woop::log_fatal */
+#include "pvs.hpp"         /* woop::Pvs */
+#include "thread_pool.hpp" /* woop::ThreadPool */
+#include "wad.hpp"         /* woop::Wad */
+#include <chrono>          /* std::chrono::steady_clock */
+#include <cstdio>          /* std::printf */
+#include <string>          /* std::string */
+#include <vector>          /* std::vector */
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Returns the names of every level in a wad (markers followed by a
+ * THINGS lump).
+ */
+std::vector<std::string> find_levels(const woop::Wad& wad) {
+  std::vector<std::string> levels;
+  for (auto it = wad.begin(); it != wad.end(); ++it) {
+    auto next = it + 1;
+    if (next != wad.end() && next->name == "THINGS")
+      levels.push_back(it->name);
+  }
+  return levels;
+}
+
+int main(int argc, const char* argv[]) {
+  if (argc < 3) {
+    std::printf("Usage: %s <wad> <cache directory> [levels...]\n", argv[0]);
+    return 1;
+  }
+  try {
+    woop::Wad wad(argv[1]);
+    std::filesystem::path cache = argv[2];
+    std::vector<std::string> levels(argv + 3, argv + argc);
+    if (levels.empty())
+      levels = find_levels(wad);
+
+    woop::ThreadPool pool;
+    std::printf("%8s %12s %10s %12s %10s\n", "level", "subsectors",
+                "portals", "avg visible", "time");
+    for (const std::string& name : levels) {
+      woop::Level level(wad, name);
+      Clock::time_point start = Clock::now();
+      woop::Pvs pvs = woop::Pvs::compute(level, pool);
+      std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+      const woop::Pvs::Stats& stats = pvs.get_stats();
+      std::printf("%8s %12zu %10zu %12.1f %8.1fms\n", name.c_str(),
+                  stats.subsectors, stats.portals, stats.average_visible,
+                  elapsed.count());
+      if (!pvs.save(cache, level)) {
+        woop::log_fatal("Could not write ", name, "'s PVS to ",
+                        cache.string());
+        return 1;
+      }
+    }
+  } catch (woop::Exception& exception) {
+    woop::log_fatal("Exception caught: ", exception.what());
+    return 1;
+  }
+  return 0;
+}